@@ -30,6 +30,22 @@ def collect_composite_headers(zen_composites):
             header_files.append(header_file)
     return header_files, composite_includes
 
+# Returns the number of lines of a preprocessor conditional starting at lines[start]
+# if it guards nothing but standard #includes (like a platform-specific intrinsics
+# header), the #defines that tell the code about them and comments, or 0 otherwise.
+# Such a block has to be moved to the top of kaizen.h as a whole, since hoisting
+# only the #include out of it would make it unconditional.
+def guarded_include_block_length(lines, start):
+    if not re.match(r'#\s*if', lines[start]):
+        return 0
+    for end in range(start + 1, len(lines)):
+        line = lines[end].strip()
+        if re.match(r'#\s*endif', line):
+            return end - start + 1
+        if not (re.match(r'#include\s+[<](.*)[>]', line) or re.match(r'#\s*(elif|else|define)', line) or line.startswith('//')):
+            return 0
+    return 0
+
 # Separates license, include directives and code
 def parse_header_file(header_file):
     include_directives = set()
@@ -37,7 +53,12 @@ def parse_header_file(header_file):
     with open(header_file, 'r') as input_file:
         lines = input_file.readlines()
         skipping_license = True # to skip license comments at the top of files
-        for line in lines:
+        skip_lines = 0          # to skip lines already consumed as a guarded include block
+        for idx, line in enumerate(lines):
+            if skip_lines:
+                skip_lines -= 1
+                continue
+
             if skipping_license:
                 if line.strip().startswith('//'):
                     continue # license part, so skip
@@ -46,6 +67,12 @@ def parse_header_file(header_file):
 
             if PRAGMA_ONCE in line:
                 continue
+
+            block_length = guarded_include_block_length(lines, idx)
+            if block_length:
+                include_directives.add(''.join(lines[idx:idx + block_length]).strip())
+                skip_lines = block_length - 1
+                continue
             
             # If line #includes any non-standard C++ headers (like Kaizen-internal), skip it
             if re.match(r'#include\s+"(.*)"', line):
@@ -171,7 +198,8 @@ if __name__ == '__main__':
 
     # Process 'alpha.h' separately and ensure its content is added first
     if alpha_header:
-        _, alpha_content = parse_header_file(alpha_header)
+        alpha_includes, alpha_content = parse_header_file(alpha_header)
+        all_include_directives.update(alpha_includes)
         all_code_content.extend(alpha_content) # ensure alpha.h content is first
     
     # Process regular headers
@@ -54,18 +54,43 @@ int main(int argc, char* argv[])
 
 	// Since the order of these tests doesn't matter, their
 	// calls are listed in descending length for aesthetics
+	main_test_concurrent_hash_map();
 	main_test_cmd_args(argc, argv);
 	main_test_unordered_multiset();
 	main_test_unordered_multimap();
 	main_test_priority_queue();
 	main_test_unordered_set();
 	main_test_unordered_map();
+	main_test_flat_multimap();
+	main_test_flat_multiset();
+	main_test_flat_hash_set();
+	main_test_flat_hash_map();
+	main_test_mapped_vector();
+	main_test_interval_tree();
 	main_test_forward_list();
+	main_test_small_vector();
+	main_test_bloom_filter();
+	main_test_set_algebra();
+	main_test_mpmc_queue();
+	main_test_ring_deque();
+	main_test_radix_trie();
+	main_test_persistent();
+	main_test_soa_vector();
+	main_test_spsc_ring();
+	main_test_dary_heap();
+	main_test_node_pool();
+	main_test_btree_set();
+	main_test_btree_map();
 	main_test_multiset();
 	main_test_multimap();
+	main_test_flat_set();
+	main_test_flat_map();
+	main_test_slot_map();
     main_test_version();
 	main_test_string();
 	main_test_vector();
+	main_test_static();
+	main_test_bitset();
 	main_test_array();
 	main_test_deque();
 	main_test_stack();
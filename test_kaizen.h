@@ -24,14 +24,32 @@
 
 // Since the order of these #includes doesn't matter,
 // they're sorted in descending length for aesthetics
+#include "tests/test_concurrent_hash_map.h"
 #include "tests/test_unordered_set.h"
 #include "tests/test_unordered_map.h"
+#include "tests/test_mapped_vector.h"
+#include "tests/test_interval_tree.h"
 #include "tests/test_uncompilable.h"
 #include "tests/test_forward_list.h"
+#include "tests/test_small_vector.h"
+#include "tests/test_bloom_filter.h"
+#include "tests/test_set_algebra.h"
+#include "tests/test_mpmc_queue.h"
+#include "tests/test_ring_deque.h"
+#include "tests/test_radix_trie.h"
+#include "tests/test_persistent.h"
+#include "tests/test_soa_vector.h"
+#include "tests/test_flat_hash.h"
+#include "tests/test_spsc_ring.h"
+#include "tests/test_dary_heap.h"
+#include "tests/test_node_pool.h"
 #include "tests/test_cmd_args.h"
+#include "tests/test_slot_map.h"
 #include "tests/test_version.h"
 #include "tests/test_string.h"
 #include "tests/test_vector.h"
+#include "tests/test_static.h"
+#include "tests/test_bitset.h"
 #include "tests/test_array.h"
 #include "tests/test_deque.h"
 #include "tests/test_stack.h"
@@ -40,9 +58,11 @@
 #include "tests/test_timer.h"
 #include "tests/test_point.h"
 #include "tests/test_deref.h"
+#include "tests/test_btree.h"
 #include "tests/test_file.h"
 #include "tests/test_list.h"
 #include "tests/test_cloc.h"
+#include "tests/test_flat.h"
 #include "tests/test_set.h"
 #include "tests/test_map.h"
 #include "tests/test_in.h"
@@ -0,0 +1,147 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "kaizen.h" // test using generated header: jump with the parachute you folded
+
+void test_bitset_basics()
+{
+    BEGIN_SUBTEST;
+
+    zen::bitset b(1000);
+    ZEN_EXPECT(b.size() == 1000 && b.none() && b.count() == 0);
+    ZEN_EXPECT(b.words().size() == 16 && b.capacity() == 1024);
+
+    b.set(0).set(63).set(64).set(999);
+    ZEN_EXPECT(b.test(63) && b[64] && !b[65] && b.count() == 4);
+    ZEN_EXPECT(b.contains(999) && !b.contains(1000));
+    ZEN_EXPECT_THROW(b.at(1000), std::out_of_range);
+
+    b.flip(0).reset(63);
+    ZEN_EXPECT(b.count() == 2 && !b[0]);
+
+    // The bits past the size stay zero through flipping and shrinking
+    b.flip();
+    ZEN_EXPECT(b.count() == 998 && !b.all());
+    b.resize(64);
+    ZEN_EXPECT(b.count() == 64);
+    b.resize(200);
+    ZEN_EXPECT(b.count() == 64 && !b[64] && !b[199]);
+    b.resize(300, true);
+    ZEN_EXPECT(b.count() == 164 && b[200] && b[299]);
+    b.set();
+    ZEN_EXPECT(b.all() && b.count() == 300);
+
+    zen::bitset c = { true, false, true };
+    c.push_back(true);
+    ZEN_EXPECT(c.size() == 4 && c.count() == 3 && c.words()[0] == 0b1101);
+
+    zen::bitset d = c;
+    ZEN_EXPECT(d == c);
+    d.reset(0);
+    ZEN_EXPECT(d != c);
+    c.clear();
+    ZEN_EXPECT(c.is_empty() && c.none() && c.find_first() == zen::bitset::npos);
+}
+
+void test_bitset_operations()
+{
+    BEGIN_SUBTEST;
+
+    const std::size_t n = 10'000;
+    zen::bitset evens(n), threes(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        evens.set(i, i % 2 == 0);
+        threes.set(i, i % 3 == 0);
+    }
+
+    ZEN_EXPECT((evens & threes).count() == 1667); // multiples of 6
+    ZEN_EXPECT((evens | threes).count() == 6667);
+    ZEN_EXPECT((evens ^ threes).count() == 5000);
+    ZEN_EXPECT((evens - threes).count() == 3333);
+    ZEN_EXPECT((~evens).count() == 5000);
+
+    ZEN_EXPECT(evens.intersects(threes));
+    ZEN_EXPECT((evens & threes).is_subset_of(threes) && !evens.is_subset_of(threes));
+
+    using zen::bitset;
+    ZEN_EXPECT_THROW(evens &= bitset(n + 1), std::invalid_argument);
+}
+
+void test_bitset_find()
+{
+    BEGIN_SUBTEST;
+
+    zen::bitset b(5000);
+    const std::vector<std::size_t> positions = { 3, 64, 65, 1000, 4095, 4999 };
+    for (std::size_t i : positions)
+        b.set(i);
+
+    ZEN_EXPECT(b.find_first() == 3);
+    ZEN_EXPECT(b.find_next(3) == 64 && b.find_next(65) == 1000);
+    ZEN_EXPECT(b.find_next(4999) == zen::bitset::npos);
+
+    std::vector<std::size_t> found;
+    for (std::size_t i : b.ones())
+        found.push_back(i);
+    ZEN_EXPECT(found == positions);
+}
+
+void test_bitset_rank_select()
+{
+    BEGIN_SUBTEST;
+
+    zen::bitset b(3000);
+    for (std::size_t i = 0; i < 3000; i += 7)
+        b.set(i);
+
+    zen::rank_select rs(b);
+    ZEN_EXPECT(rs.count() == b.count() && rs.count() == 429);
+    ZEN_EXPECT(rs.rank(0) == 0 && rs.rank(1) == 1 && rs.rank(7) == 1 && rs.rank(8) == 2);
+    ZEN_EXPECT(rs.rank(3000) == 429);
+
+    bool all_right = true;
+    for (std::size_t k = 0; k < rs.count(); ++k)
+        all_right = all_right && rs.select(k) == 7 * k && rs.rank(rs.select(k)) == k;
+    ZEN_EXPECT(all_right);
+    ZEN_EXPECT(rs.select(429) == zen::rank_select::npos);
+
+    // Long runs of empty lines are skipped over
+    zen::bitset sparse(100'000);
+    sparse.set(5).set(60'000).set(99'999);
+    zen::rank_select ss(sparse);
+    ZEN_EXPECT(ss.select(1) == 60'000 && ss.select(2) == 99'999 && ss.rank(60'001) == 2);
+}
+
+void main_test_bitset()
+{
+    BEGIN_TEST;
+    test_bitset_basics();
+    test_bitset_operations();
+    test_bitset_find();
+    test_bitset_rank_select();
+}
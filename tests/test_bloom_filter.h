@@ -0,0 +1,140 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <stdexcept>
+#include <sstream>
+#include <string>
+
+#include "kaizen.h" // test using generated header: jump with the parachute you folded
+
+void test_bloom_filter_fp_rate()
+{
+    BEGIN_SUBTEST;
+
+    // No false negatives, and false positives close to the configured rate
+    for (double rate : { 0.1, 0.01, 0.001 }) {
+        zen::bloom_filter<int> f(10'000, rate);
+        for (int i = 0; i < 10'000; ++i)
+            f.insert(i);
+
+        bool no_false_negatives = true;
+        for (int i = 0; i < 10'000; ++i)
+            no_false_negatives = no_false_negatives && f.may_contain(i);
+
+        int false_positives = 0;
+        for (int i = 10'000; i < 210'000; ++i)
+            false_positives += f.may_contain(i);
+        const double measured = false_positives / 200'000.0;
+
+        ZEN_EXPECT(no_false_negatives);
+        ZEN_EXPECT(measured < 1.5 * rate);
+        ZEN_EXPECT(f.estimated_fp_rate() <= rate * 1.01);
+    }
+
+    // Lower rates take more bits
+    ZEN_EXPECT(zen::bloom_filter<int>(1000, 0.001).bit_count() > zen::bloom_filter<int>(1000, 0.01).bit_count());
+    using filter = zen::bloom_filter<int>;
+    ZEN_EXPECT_THROW(filter(1000, 0.0), std::invalid_argument);
+    ZEN_EXPECT_THROW(filter(1000, 1.0), std::invalid_argument);
+}
+
+void test_bloom_filter_merge_and_save()
+{
+    BEGIN_SUBTEST;
+
+    zen::bloom_filter<std::string> a(1000), b(1000);
+    a.insert("apple");
+    b.insert("banana");
+    ZEN_EXPECT(!a.may_contain("banana"));
+    a.merge(b);
+    ZEN_EXPECT(a.may_contain("apple") && a.may_contain("banana") && a.inserted_count() == 2);
+
+    using filter = zen::bloom_filter<std::string>;
+    filter c(100'000);
+    ZEN_EXPECT_THROW(c.merge(a), std::invalid_argument);
+
+    std::stringstream ss;
+    a.save(ss);
+    const auto loaded = filter::load(ss);
+    ZEN_EXPECT(loaded == a && loaded.may_contain("banana") && loaded.inserted_count() == 2);
+
+    std::stringstream garbage("not a filter");
+    ZEN_EXPECT_THROW(filter::load(garbage), std::runtime_error);
+
+    // A valid header with an absurd block count is rejected before anything is allocated
+    std::string header = ss.str().substr(0, 8);
+    header.append(8, '\xFF');   // blocks
+    header.append(8, '\0');     // inserted
+    header.append(64, '\0');    // one block's worth of data
+    std::stringstream huge(header);
+    ZEN_EXPECT_THROW(filter::load(huge), std::runtime_error);
+
+    // And so is one that fits in memory but not in what is left of the stream
+    header.replace(8, 8, "\x00\x00\x00\x01\x00\x00\x00\x00", 8); // 2^24 blocks, 1 GB
+    std::stringstream short_of_data(header);
+    ZEN_EXPECT_THROW(filter::load(short_of_data), std::runtime_error);
+
+    // Also when the stream cannot tell how much is left, which is then read a chunk at a time
+    struct no_seek_buf : std::stringbuf {
+        using std::stringbuf::stringbuf;
+        pos_type seekoff(off_type, std::ios::seekdir, std::ios::openmode) override { return pos_type(-1); }
+    } nsb(header);
+    std::istream piped(&nsb);
+    ZEN_EXPECT_THROW(filter::load(piped), std::runtime_error);
+
+    a.clear();
+    ZEN_EXPECT(a.is_empty() && !a.may_contain("apple"));
+}
+
+void test_filtered_set()
+{
+    BEGIN_SUBTEST;
+
+    zen::filtered_set<zen::hash_set<int>> s(100);
+    for (int i = 0; i < 1000; i += 2) // outgrows the filter, which is rebuilt larger
+        s.insert(i);
+
+    const bool again = s.insert(0);
+    ZEN_EXPECT(s.size() == 500 && !again);
+    ZEN_EXPECT(s.contains(998) && !s.contains(999));
+    ZEN_EXPECT(s.filter().bit_count() > zen::bloom_filter<int>(100).bit_count());
+
+    const auto erased = s.erase(998);
+    const auto absent = s.erase(999);
+    ZEN_EXPECT(erased == 1 && absent == 0 && !s.contains(998));
+    s.rebuild();
+    ZEN_EXPECT(s.contains(996) && s.size() == 499);
+
+    zen::filtered_set<zen::flat_hash_set<std::string>> words = { "one", "two" };
+    ZEN_EXPECT(words.contains("two") && !words.contains("three"));
+}
+
+void main_test_bloom_filter()
+{
+    BEGIN_TEST;
+    test_bloom_filter_fp_rate();
+    test_bloom_filter_merge_and_save();
+    test_filtered_set();
+}
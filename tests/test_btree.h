@@ -0,0 +1,191 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <stdexcept>
+#include <vector>
+#include <random>
+#include <map>
+#include <set>
+
+#include "kaizen.h" // test using generated header: jump with the parachute you folded
+
+#include "../internal.h"
+
+void test_btree_set_basics()
+{
+    BEGIN_SUBTEST;
+
+    zen::btree_set<int> x = { 3, 1, 2, 2 };
+    const auto [it, inserted] = x.insert(0);
+    const auto [jt, again]    = x.insert(0);
+
+    ZEN_EXPECT(inserted && !again && *it == 0 && it == jt);
+    ZEN_EXPECT(silent_print(x) == "[0, 1, 2, 3]");
+    ZEN_EXPECT( x.contains(3));
+    ZEN_EXPECT(!x.contains(7));
+    ZEN_EXPECT(*x.lower_bound(2) == 2 && *x.upper_bound(2) == 3 && x.upper_bound(3) == x.end());
+    ZEN_EXPECT(*x.rbegin() == 3 && *std::prev(x.end()) == 3);
+
+    const size_t erased = x.erase(1);
+    ZEN_EXPECT(erased == 1 && x.size() == 3 && x.height() == 1);
+    ZEN_EXPECT(zen::is_empty(x) == x.is_empty());
+
+    zen::btree_set<std::string, std::less<>> words = { "apple", "banana", "cherry" };
+    ZEN_EXPECT(words.contains(std::string_view("banana")) && words.count(std::string_view("kiwi")) == 0);
+}
+
+void test_btree_set_against_std()
+{
+    BEGIN_SUBTEST;
+
+    // Random inserts and erases that split, borrow and merge nodes at every level
+    std::mt19937 rng(7);
+    zen::btree_set<int> x;
+    std::set<int>       s;
+    bool all_right = true;
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 20'000; ++i) {
+            const int k = static_cast<int>(rng() % 30'000);
+            all_right = all_right && x.insert(k).second == s.insert(k).second;
+        }
+        for (int i = 0; i < 25'000; ++i) {
+            const int k = static_cast<int>(rng() % 30'000);
+            all_right = all_right && x.erase(k) == s.erase(k);
+        }
+        all_right = all_right && x.size() == s.size() && std::equal(x.begin(), x.end(), s.begin(), s.end());
+    }
+    ZEN_EXPECT(all_right);
+    ZEN_EXPECT(std::equal(x.rbegin(), x.rend(), s.rbegin(), s.rend()));
+
+    // Erasing by iterator returns the next one
+    auto it = x.begin();
+    while (it != x.end())
+        it = *it % 2 ? x.erase(it) : std::next(it);
+    ZEN_EXPECT(std::all_of(x.begin(), x.end(), [](int k) { return k % 2 == 0; }));
+
+    x.erase(x.begin(), x.end());
+    ZEN_EXPECT(x.is_empty() && x.begin() == x.end() && x.height() == 0);
+}
+
+void test_btree_bulk_load()
+{
+    BEGIN_SUBTEST;
+
+    std::vector<int> sorted;
+    for (int i = 0; i < 100'000; ++i)
+        sorted.push_back(i / 2); // every key twice
+
+    zen::btree_set<int>      x(zen::presorted{}, sorted.begin(), sorted.end());
+    zen::btree_multiset<int> y(zen::presorted{}, sorted.begin(), sorted.end());
+    ZEN_EXPECT(x.size() == 50'000 && y.size() == 100'000);
+    ZEN_EXPECT(std::equal(y.begin(), y.end(), sorted.begin(), sorted.end()));
+    ZEN_EXPECT(x.height() == 4 && y.count(777) == 2);
+
+    // Loaded trees are full, yet take inserts and erases as usual
+    for (int i = 0; i < 50'000; i += 3)
+        x.erase(i);
+    for (int i = 0; i < 50'000; i += 5)
+        x.insert(i);
+    std::set<int> s;
+    for (int i = 0; i < 50'000; ++i)
+        if (i % 3 || i % 5 == 0)
+            s.insert(i);
+    ZEN_EXPECT(std::equal(x.begin(), x.end(), s.begin(), s.end()));
+
+    const std::vector<int> unsorted = { 1, 3, 2 };
+    using set = zen::btree_set<int>;
+    ZEN_EXPECT_THROW(set(zen::presorted{}, unsorted.begin(), unsorted.end()), std::invalid_argument);
+
+    zen::btree_set<int> copy = x;
+    ZEN_EXPECT(copy == x && copy.size() == s.size());
+}
+
+void main_test_btree_set()
+{
+    BEGIN_TEST;
+    test_btree_set_basics();
+    test_btree_set_against_std();
+    test_btree_bulk_load();
+}
+
+void test_btree_multimap_against_std()
+{
+    BEGIN_SUBTEST;
+
+    std::mt19937 rng(11);
+    zen::btree_multimap<int, int> x;
+    std::multimap<int, int>       m;
+    for (int i = 0; i < 30'000; ++i) {
+        const int k = static_cast<int>(rng() % 500);
+        x.emplace(k, i);
+        m.emplace(k, i);
+    }
+    for (int i = 0; i < 200; ++i) {
+        const int k = static_cast<int>(rng() % 500);
+        x.erase(k);
+        m.erase(k);
+    }
+
+    // Equal keys keep their insertion order, as in std::multimap
+    const bool same = std::equal(x.begin(), x.end(), m.begin(), m.end(),
+        [](const auto& a, const auto& b) { return a.first == b.first && a.second == b.second; });
+    ZEN_EXPECT(same && x.size() == m.size());
+
+    bool counts_match = true;
+    for (int k = 0; k < 500; ++k) {
+        auto [lo, hi] = x.equal_range(k);
+        counts_match = counts_match && static_cast<size_t>(std::distance(lo, hi)) == m.count(k) && x.count(k) == m.count(k);
+    }
+    ZEN_EXPECT(counts_match);
+
+    const auto values = x.values(42);
+    ZEN_EXPECT(values.size() == m.count(42) && std::equal(values.begin(), values.end(), zen::values_view(m.equal_range(42)).begin()));
+}
+
+void main_test_btree_map()
+{
+    BEGIN_TEST;
+
+    zen::btree_map<zen::string, int> x = { {"b", 2}, {"a", 1} };
+    x["c"] = 3;
+    x.insert_or_assign("a", 10);
+    const auto [it, inserted] = x.try_emplace("b", 20);
+
+    ZEN_EXPECT(!inserted && it->second == 2);
+    ZEN_EXPECT(x.at("a") == 10 && x.size() == 3);
+    ZEN_EXPECT(x.begin()->first == "a" && x.rbegin()->first == "c");
+    ZEN_EXPECT_THROW(x.at("z"), std::out_of_range);
+
+    zen::btree_map<int, int> squares;
+    for (int i = 0; i < 10'000; ++i)
+        squares[i] = i * i; // ascending keys fill the leaves up
+    ZEN_EXPECT(squares.at(99) == 9801 && squares.size() == 10'000);
+    int sum = 0;
+    for (auto i = squares.lower_bound(10); i != squares.upper_bound(12); ++i)
+        sum += i->second;
+    ZEN_EXPECT(sum == 100 + 121 + 144);
+
+    test_btree_multimap_against_std();
+}
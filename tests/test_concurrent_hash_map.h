@@ -0,0 +1,161 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "kaizen.h" // test using generated header: jump with the parachute you folded
+
+void test_concurrent_hash_map_single_thread()
+{
+    BEGIN_SUBTEST;
+    zen::concurrent_hash_map<std::string, int> m(5);
+
+    ZEN_EXPECT(m.shard_count() == 8); // rounded up to a power of two
+    ZEN_EXPECT(m.is_empty());
+
+    const bool inserted1 = m.insert("a", 1);
+    const bool inserted2 = m.insert("a", 2);
+    ZEN_EXPECT(inserted1 && !inserted2);
+    ZEN_EXPECT(m.find("a") == 1);
+    ZEN_EXPECT(!m.find("b").has_value());
+
+    const bool assigned = !m.insert_or_assign("a", 3);
+    ZEN_EXPECT(assigned && m.find("a") == 3);
+
+    const bool upserted1 = m.upsert("b", [](int& n) { n += 10; }, 1);
+    const bool upserted2 = m.upsert("b", [](int& n) { n += 10; }, 1);
+    ZEN_EXPECT(upserted1 && !upserted2);
+    ZEN_EXPECT(m.find("b") == 11);
+
+    int made = 0;
+    const int c1 = m.compute_if_absent("c", [&] { ++made; return 7; });
+    const int c2 = m.compute_if_absent("c", [&] { ++made; return 8; });
+    ZEN_EXPECT(c1 == 7 && c2 == 7 && made == 1);
+
+    int seen = 0;
+    const bool visited = m.cvisit("c", [&](const int& n) { seen = n; });
+    const bool missed  = m.visit("z", [&](int& n) { seen = n; });
+    ZEN_EXPECT(visited && !missed && seen == 7);
+
+    ZEN_EXPECT(m.size() == 3 && m.contains("b"));
+
+    const bool kept   = !m.erase_if("b", [](const int& n) { return n < 10; });
+    const bool erased = m.erase_if("b", [](const int& n) { return n > 10; });
+    ZEN_EXPECT(kept && erased && !m.contains("b"));
+
+    int sum = 0;
+    m.visit_all([](const std::string&, int& n) { n *= 2; });
+    m.cvisit_all([&](const std::string&, const int& n) { sum += n; });
+    ZEN_EXPECT(sum == 2 * (3 + 7));
+
+    m.clear();
+    ZEN_EXPECT(m.is_empty());
+    using map = zen::concurrent_hash_map<int, int>;
+    ZEN_EXPECT_THROW(map(0), std::invalid_argument);
+
+    // Shards can also be node-based maps
+    zen::concurrent_hash_map<int, int, std::hash<int>, std::equal_to<int>, std::allocator<std::pair<const int, int>>, zen::node_based> n(2);
+    ZEN_STATIC_ASSERT((std::is_same_v<decltype(n)::shard_map, zen::unordered_map<int, int>>), "zen::node_based SHARDS MUST BE zen::unordered_map");
+    n.upsert(1, [](int& x) { ++x; }, 1);
+    n.upsert(1, [](int& x) { ++x; }, 1);
+    ZEN_EXPECT(n.find(1) == 2 && n.snapshot().size() == 1);
+}
+
+void test_concurrent_hash_map_counting()
+{
+    BEGIN_SUBTEST;
+    zen::concurrent_hash_map<int, long long> counts;
+
+    // Every thread counts the same keys, so the shards are heavily contended
+    const int T = 8, N = 10'000, KEYS = 100;
+    std::vector<std::thread> threads;
+    for (int t : zen::in(T)) {
+        threads.emplace_back([&counts, t] {
+            for (int i : zen::in(N))
+                counts.upsert((i + t) % KEYS, [](long long& n) { ++n; }, 1LL);
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    ZEN_EXPECT(counts.size() == KEYS);
+
+    long long total = 0;
+    bool all_equal = true;
+    counts.cvisit_all([&](int, long long n) { total += n; all_equal = all_equal && n == T * N / KEYS; });
+    ZEN_EXPECT(total == T * N);
+    ZEN_EXPECT(all_equal);
+}
+
+void test_concurrent_hash_map_snapshot()
+{
+    BEGIN_SUBTEST;
+    zen::concurrent_hash_map<int, int> m(16);
+    for (int i : zen::in(1000))
+        m.insert(i, i * i);
+
+    auto snap = m.snapshot(4);
+    std::sort(snap.begin(), snap.end());
+    ZEN_EXPECT(snap.size() == 1000);
+    ZEN_EXPECT(snap.front() == std::make_pair(0, 0) && snap.back() == std::make_pair(999, 999 * 999));
+
+    std::atomic<long long> sum = 0;
+    m.parallel_cvisit_all([&](int k, int) { sum += k; }, 4);
+    ZEN_EXPECT(sum == 999 * 1000 / 2);
+
+    // A snapshot taken while writers are busy sees whole updates only: each writer
+    // moves one unit from key 0 to key 1 per step, so the total never changes
+    zen::concurrent_hash_map<int, int> m2(2);
+    m2.insert(0, 1000);
+    m2.insert(1, 0);
+    std::thread writer([&m2] {
+        for (int i : zen::in(1000)) {
+            m2.visit(0, [](int& n) { --n; });
+            m2.visit(1, [](int& n) { ++n; });
+            (void) i;
+        }
+    });
+    bool consistent = true;
+    for (int i : zen::in(100)) {
+        const auto s = m2.snapshot();
+        int total = 0;
+        for (const auto& [k, v] : s) total += v;
+        consistent = consistent && total >= 999 && total <= 1000; // at most one unit in flight
+        (void) i;
+    }
+    writer.join();
+    ZEN_EXPECT(consistent);
+    ZEN_EXPECT(m2.find(0) == 0 && m2.find(1) == 1000);
+}
+
+void main_test_concurrent_hash_map()
+{
+    BEGIN_TEST;
+    test_concurrent_hash_map_single_thread();
+    test_concurrent_hash_map_counting();
+    test_concurrent_hash_map_snapshot();
+}
@@ -0,0 +1,154 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <functional>
+#include <climits>
+#include <string>
+#include <vector>
+
+#include "kaizen.h" // test using generated header: jump with the parachute you folded
+
+void test_dary_heap_order()
+{
+    BEGIN_SUBTEST;
+
+    // Scattered values, heapified at once and then drained
+    std::vector<int> v;
+    for (int i : zen::in(1000))
+        v.push_back((i * 7919) % 1000);
+
+    zen::dary_heap<int> h(v.begin(), v.end());
+    ZEN_EXPECT(h.size() == 1000 && h.top() == 999);
+
+    std::vector<int> drained;
+    while (!h.is_empty())
+        drained.push_back(h.extract_top());
+    ZEN_EXPECT(std::is_sorted(drained.rbegin(), drained.rend()) && drained.size() == 1000);
+
+    // Pushing one by one, in bulk and replacing the top, with the smallest on top
+    zen::dary_heap<int, 3, std::greater<int>> g = { 5, 8, 2 };
+    g.push(7);
+    g.push(v.begin(), v.begin() + 10);
+    ZEN_EXPECT(g.top() == 0 && g.size() == 14);
+    g.replace_top(6);
+    ZEN_EXPECT(g.top() == 2);
+    g.pop();
+    ZEN_EXPECT(g.top() == 5);
+    ZEN_EXPECT(zen::dary_heap<int>::arity() == 4);
+
+    // The last element isn't moved onto itself on its way out
+    zen::dary_heap<std::string> one = { std::string(100, 'x') };
+    const std::string last = one.extract_top();
+    ZEN_EXPECT(last == std::string(100, 'x') && one.is_empty());
+}
+
+void test_priority_queue_heapify()
+{
+    BEGIN_SUBTEST;
+    zen::priority_queue<int> q(zen::ints{ 3, 9, 1, 7, 5 });
+    std::vector<int> drained;
+    while (!q.is_empty()) {
+        drained.push_back(q.top());
+        q.pop();
+    }
+    ZEN_EXPECT((drained == std::vector<int>{ 9, 7, 5, 3, 1 }));
+}
+
+void test_addressable_dary_heap()
+{
+    BEGIN_SUBTEST;
+    zen::addressable_dary_heap<int, 4, std::greater<int>> h; // smallest on top
+
+    std::vector<decltype(h)::handle> handles;
+    for (int i : zen::in(20))
+        handles.push_back(h.push(100 + i));
+
+    h.update(handles[15], 1); // decrease-key
+    ZEN_EXPECT(h.top() == 1 && h.top_handle() == handles[15]);
+
+    h.update(handles[15], 500); // and back down
+    ZEN_EXPECT(h.top() == 100 && h[handles[15]] == 500);
+
+    h.erase(handles[0]);
+    h.erase(handles[7]);
+    ZEN_EXPECT(!h.contains(handles[0]) && h.contains(handles[1]) && h.size() == 18);
+    ZEN_EXPECT_THROW(h.erase(handles[0]), std::out_of_range);
+
+    std::vector<int> drained;
+    while (!h.is_empty())
+        drained.push_back(h.extract_top());
+    ZEN_EXPECT(std::is_sorted(drained.begin(), drained.end()) && drained.back() == 500);
+    ZEN_EXPECT(std::find(drained.begin(), drained.end(), 107) == drained.end());
+}
+
+void test_addressable_dary_heap_dijkstra()
+{
+    BEGIN_SUBTEST;
+
+    // Shortest paths with decrease-key instead of pushing duplicates and skipping stale ones
+    struct edge { int to, weight; };
+    const std::vector<std::vector<edge>> graph = {
+        { {1, 4}, {2, 1} },         // 0
+        { {3, 1} },                 // 1
+        { {1, 2}, {3, 5} },         // 2
+        { {4, 3} },                 // 3
+        {},                         // 4
+    };
+
+    using entry = std::pair<int, int>; // distance, vertex
+    zen::addressable_dary_heap<entry, 4, std::greater<entry>> queue;
+    std::vector<decltype(queue)::handle> handle_of(graph.size());
+    std::vector<int> dist(graph.size(), INT_MAX);
+
+    dist[0] = 0;
+    for (int v : zen::in(static_cast<int>(graph.size())))
+        handle_of[v] = queue.push({ dist[v], v });
+
+    int pops = 0;
+    while (!queue.is_empty()) {
+        const auto [d, u] = queue.extract_top();
+        ++pops;
+        if (d == INT_MAX)
+            break;
+        for (const auto& e : graph[u]) {
+            if (d + e.weight < dist[e.to] && queue.contains(handle_of[e.to])) {
+                dist[e.to] = d + e.weight;
+                queue.update(handle_of[e.to], { dist[e.to], e.to });
+            }
+        }
+    }
+
+    ZEN_EXPECT((dist == std::vector<int>{ 0, 3, 1, 4, 7 }));
+    ZEN_EXPECT(pops == 5); // each vertex exactly once
+}
+
+void main_test_dary_heap()
+{
+    BEGIN_TEST;
+    test_dary_heap_order();
+    test_priority_queue_heapify();
+    test_addressable_dary_heap();
+    test_addressable_dary_heap_dijkstra();
+}
@@ -0,0 +1,143 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "kaizen.h" // test using generated header: jump with the parachute you folded
+
+#include "../internal.h"
+
+void test_flat_set_bulk_insert()
+{
+    BEGIN_SUBTEST;
+    zen::flat_set<int> x = { 5, 1, 3 };
+
+    const std::vector<int> more = { 4, 3, 2, 6, 2 };
+    x.insert(more.begin(), more.end());
+
+    ZEN_EXPECT(silent_print(x) == "[1, 2, 3, 4, 5, 6]");
+    ZEN_EXPECT(std::is_sorted(x.sequence().begin(), x.sequence().end()));
+
+    zen::flat_set<int> adopted(std::vector<int>{ 9, 7, 7, 8 });
+    ZEN_EXPECT(silent_print(adopted) == "[7, 8, 9]");
+}
+
+void test_flat_set_heterogeneous_lookup()
+{
+    BEGIN_SUBTEST;
+    zen::flat_set<std::string, std::less<>> x = { "apple", "banana", "cherry" };
+
+    const std::string_view sv = "banana";
+    ZEN_EXPECT(x.contains(sv));
+    ZEN_EXPECT(x.find("cherry") != x.end());
+    ZEN_EXPECT(x.count(std::string_view("kiwi")) == 0);
+    ZEN_EXPECT(x.lower_bound(std::string_view("b"))->front() == 'b');
+}
+
+void main_test_flat_set()
+{
+    BEGIN_TEST;
+
+    zen::flat_set<int> x = { 3, 1, 2, 2 };
+    const auto [it, inserted] = x.insert(0);
+    const auto [jt, again]    = x.insert(0);
+
+    ZEN_EXPECT(inserted && !again && *it == 0 && it == jt);
+    ZEN_EXPECT(silent_print(x) == "[0, 1, 2, 3]");
+    ZEN_EXPECT( x.contains(3));
+    ZEN_EXPECT(!x.contains(7));
+
+    auto [lo, hi] = x.equal_range(2);
+    ZEN_EXPECT(hi - lo == 1 && *lo == 2);
+
+    const size_t erased = x.erase(1);
+    ZEN_EXPECT(erased == 1 && x.size() == 3);
+    ZEN_EXPECT(zen::is_empty(x) == x.is_empty());
+
+    test_flat_set_bulk_insert();
+    test_flat_set_heterogeneous_lookup();
+}
+
+void main_test_flat_multiset()
+{
+    BEGIN_TEST;
+
+    zen::flat_multiset<zen::string> x = { "1", "1", "3", "4", "4" };
+    x.insert("0");
+    x.insert("4");
+
+    ZEN_EXPECT(silent_print(x) == "[\"0\", \"1\", \"1\", \"3\", \"4\", \"4\", \"4\"]");
+    ZEN_EXPECT(x.count("4") == 3);
+    ZEN_EXPECT(x.contains("0"));
+    ZEN_EXPECT(zen::is_empty(x) == x.is_empty());
+}
+
+void main_test_flat_map()
+{
+    BEGIN_TEST;
+
+    zen::flat_map<zen::string, int> m = { {"B", 2}, {"A", 1}, {"C", 3}, {"A", 100} };
+    m["D"] = 4;
+    m["A"] += 10;
+
+    ZEN_EXPECT(silent_print(m) == "[{\"A\", 11}, {\"B\", 2}, {\"C\", 3}, {\"D\", 4}]");
+    ZEN_EXPECT( m.contains("B"));
+    ZEN_EXPECT(!m.contains("X"));
+    ZEN_EXPECT(m.at("C") == 3);
+    ZEN_EXPECT_THROW(m.at("X"), std::out_of_range);
+
+    const auto [it, inserted] = m.try_emplace("B", 200);
+    ZEN_EXPECT(!inserted && it->second == 2);
+    m.insert_or_assign("B", 200);
+    ZEN_EXPECT(m["B"] == 200);
+
+    // Bulk insertion keeps the existing values, like std::map::insert()
+    const std::vector<std::pair<zen::string, int>> more = { {"E", 5}, {"A", -1}, {"F", 6} };
+    m.insert(more.begin(), more.end());
+    ZEN_EXPECT(m.size() == 6 && m["A"] == 11 && m["F"] == 6);
+
+    ZEN_EXPECT(zen::is_empty(m) == m.is_empty());
+}
+
+void main_test_flat_multimap()
+{
+    BEGIN_TEST;
+
+    zen::flat_multimap<zen::string, zen::string> mss = { {"B", "4"}, {"A", "1"}, {"A", "2"}, {"B", "5"}, {"A", "3"} };
+    mss.insert({ "D", "6" });
+    mss.insert({ "D", "7" });
+
+    // Values of equal keys stay in insertion order
+    ZEN_EXPECT(silent_print(mss) == "[{\"A\", \"1\"}, {\"A\", \"2\"}, {\"A\", \"3\"}, {\"B\", \"4\"}, {\"B\", \"5\"}, {\"D\", \"6\"}, {\"D\", \"7\"}]");
+    ZEN_EXPECT(mss.count("A") == 3 && mss.count("D") == 2);
+    ZEN_EXPECT(!mss.contains("X"));
+
+    auto [lo, hi] = mss.equal_range("B");
+    ZEN_EXPECT(hi - lo == 2 && lo->second == "4");
+
+    // A random-access view over the adjacent values of a key
+    auto a = mss.values("A");
+    ZEN_EXPECT(a.size() == 3 && a[2] == "3" && a.end() - a.begin() == 3);
+    ZEN_EXPECT(&a[1] == &(mss.begin() + 1)->second);
+
+    ZEN_EXPECT(zen::is_empty(mss) == mss.is_empty());
+}
@@ -0,0 +1,159 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "kaizen.h" // test using generated header: jump with the parachute you folded
+
+#include "../internal.h"
+
+// Hashes everything to the same few values to force long probe sequences
+struct colliding_hash {
+    size_t operator()(int x) const { return static_cast<size_t>(x % 3); }
+};
+
+struct transparent_string_hash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const { return std::hash<std::string_view>()(s); }
+};
+
+void test_flat_hash_set_collisions_and_erasure()
+{
+    BEGIN_SUBTEST;
+    zen::flat_hash_set<int, colliding_hash> x;
+    for (int i : zen::in(100))
+        x.insert(i);
+
+    ZEN_EXPECT(x.size() == 100);
+    ZEN_EXPECT(std::all_of(zen::in(100).begin(), zen::in(100).end(), [&](int i) { return x.contains(i); }));
+
+    for (int i : zen::in(0, 100, 2))
+        x.erase(i);
+
+    ZEN_EXPECT(x.size() == 50);
+    ZEN_EXPECT(!x.contains(10) && x.contains(11));
+    ZEN_EXPECT(std::distance(x.begin(), x.end()) == 50);
+
+    // Reinserting into slots left behind by erasure
+    for (int i : zen::in(0, 100, 2))
+        x.insert(i);
+    ZEN_EXPECT(x.size() == 100 && x.contains(10));
+}
+
+void test_flat_hash_set_load_factor()
+{
+    BEGIN_SUBTEST;
+    zen::flat_hash_set<int> x;
+    x.max_load_factor(0.5f);
+    for (int i : zen::in(1000))
+        x.insert(i);
+
+    ZEN_EXPECT(x.load_factor() <= 0.5f);
+    ZEN_EXPECT(x.capacity() >= 2000);
+    ZEN_EXPECT_THROW(x.max_load_factor(1.5f), std::invalid_argument);
+
+    x.reserve(10'000);
+    const auto cap = x.capacity();
+    for (int i : zen::in(1000, 5000))
+        x.insert(i);
+    ZEN_EXPECT(x.capacity() == cap); // no rehashing after reserve()
+
+    x.clear();
+    ZEN_EXPECT(x.is_empty() && !x.contains(1));
+}
+
+void test_flat_hash_set_heterogeneous_lookup()
+{
+    BEGIN_SUBTEST;
+    zen::flat_hash_set<std::string, transparent_string_hash, std::equal_to<>> x = { "apple", "banana" };
+
+    const std::string_view sv = "banana";
+    ZEN_EXPECT(x.contains(sv));
+    ZEN_EXPECT(x.find(std::string_view("apple")) != x.end());
+    ZEN_EXPECT(x.count(std::string_view("kiwi")) == 0);
+}
+
+void main_test_flat_hash_set()
+{
+    BEGIN_TEST;
+
+    zen::flat_hash_set<zen::string, zen::string_hash> x = { "1", "2", "3", "3" };
+    const auto [it, inserted] = x.insert("4");
+    const auto [jt, again]    = x.insert("4");
+
+    ZEN_EXPECT(inserted && !again && *it == "4" && it == jt);
+    ZEN_EXPECT(x.size() == 4);
+    ZEN_EXPECT( x.contains("1"));
+    ZEN_EXPECT(!x.contains("7"));
+    ZEN_EXPECT(zen::is_empty(x) == x.is_empty());
+
+    zen::flat_hash_set<zen::string, zen::string_hash> copy = x;
+    ZEN_EXPECT(copy == x);
+    copy.erase("1");
+    ZEN_EXPECT(copy != x && copy.size() == 3);
+
+    test_flat_hash_set_collisions_and_erasure();
+    test_flat_hash_set_load_factor();
+    test_flat_hash_set_heterogeneous_lookup();
+}
+
+void main_test_flat_hash_map()
+{
+    BEGIN_TEST;
+
+    zen::flat_hash_map<zen::string, int, zen::string_hash> m = { {"A", 1}, {"B", 2}, {"C", 3} };
+    m["D"] = 4;
+    m["A"] += 10;
+
+    ZEN_EXPECT(m.size() == 4);
+    ZEN_EXPECT(m["A"] == 11);
+    ZEN_EXPECT(m.at("D") == 4);
+    ZEN_EXPECT( m.contains("B"));
+    ZEN_EXPECT(!m.contains("X"));
+    ZEN_EXPECT_THROW(m.at("X"), std::out_of_range);
+
+    const auto [it, inserted] = m.try_emplace("B", 200);
+    ZEN_EXPECT(!inserted && it->second == 2);
+    m.insert_or_assign("B", 200);
+    ZEN_EXPECT(m["B"] == 200);
+
+    int sum = 0;
+    for (const auto& [k, v] : m)
+        sum += v;
+    ZEN_EXPECT(sum == 11 + 200 + 3 + 4);
+
+    // Moving leaves the source empty but usable
+    auto moved = std::move(m);
+    ZEN_EXPECT(moved.size() == 4 && m.is_empty());
+    m["Z"] = 26;
+    ZEN_EXPECT(m.size() == 1);
+
+    // zen::hash_map opting into the Swiss table engine
+    zen::hash_map<int, int, std::hash<int>, std::equal_to<int>, std::allocator<std::pair<const int, int>>, zen::open_addressing> h;
+    ZEN_STATIC_ASSERT((std::is_same_v<decltype(h), zen::flat_hash_map<int, int>>), "zen::hash_map OPEN ADDRESSING POLICY");
+    ZEN_STATIC_ASSERT((std::is_same_v<zen::hash_map<int, int>, zen::unordered_map<int, int>>), "zen::hash_map DEFAULT POLICY");
+    for (int i : zen::in(1000))
+        h[i] = i * i;
+    ZEN_EXPECT(h.size() == 1000 && h[999] == 999 * 999);
+
+    ZEN_EXPECT(zen::is_empty(m) == m.is_empty());
+}
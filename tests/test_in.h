@@ -2,6 +2,175 @@
 
 #include "kaizen.h" // test using generated header: jump with the parachute you folded
 
+#include <climits>
+#include <numeric>
+#include <ranges>
+#include <thread>
+
+void test_in_arithmetic_types()
+{
+    BEGIN_SUBTEST;
+
+    std::string sd, su, sc;
+    for (double   x : zen::in(0.0, 1.0, 0.25))   sd += std::to_string(x).substr(0, 4) + " ";
+    for (unsigned x : zen::in(5u, 0u, -2))       su += std::to_string(x) + " ";
+    for (char     c : zen::in('a', char('f')))   sc += c;
+
+    ZEN_EXPECT(sd == "0.00 0.25 0.50 0.75 ");
+    ZEN_EXPECT(su == "5 3 1 ");
+    ZEN_EXPECT(sc == "abcde");
+
+    ZEN_EXPECT(zen::in(0.0, 1.0, 0.3).size() == 4);  // 0.0 0.3 0.6 0.9
+    ZEN_EXPECT(zen::in(0.0, 1.0, -0.3).is_empty());
+    ZEN_EXPECT((std::is_same_v<decltype(zen::in(0, 10.0)), zen::in<double>>));
+    ZEN_EXPECT((std::is_same_v<decltype(zen::in(size_t(10))), zen::in<size_t>>));
+    ZEN_EXPECT_THROW(zen::in(0, 10, 0), std::invalid_argument);
+}
+
+void test_in_overflow_safety()
+{
+    BEGIN_SUBTEST;
+
+    // A naive n += step would overflow past INT_MAX in both of these
+    ZEN_EXPECT(zen::in(INT_MAX - 3, INT_MAX, 2).size() == 2);
+    ZEN_EXPECT(zen::in(INT_MIN, INT_MAX, INT_MAX).size() == 3);
+    ZEN_EXPECT(zen::in(INT_MIN, INT_MAX, INT_MAX)[2] == INT_MAX - 1);
+    ZEN_EXPECT(zen::in(INT_MAX, INT_MIN, -1).size() == 0xFFFFFFFFu);
+
+    int last = 0;
+    for (int i : zen::in(INT_MAX - 5, INT_MAX, 3)) last = i;
+    ZEN_EXPECT(last == INT_MAX - 2);
+
+    ZEN_EXPECT(zen::in<std::uint8_t>(0, 255).size() == 255);
+    ZEN_EXPECT(zen::in<std::uint8_t>(255, 0, -128).size() == 2);
+}
+
+void test_in_random_access()
+{
+    BEGIN_SUBTEST;
+
+    using range = zen::in<int>;
+    ZEN_STATIC_ASSERT(std::ranges::random_access_range<range>, "zen::in MUST BE A RANDOM ACCESS RANGE");
+    ZEN_STATIC_ASSERT(std::ranges::sized_range<range>,         "zen::in MUST BE A SIZED RANGE");
+    ZEN_STATIC_ASSERT(std::ranges::random_access_range<zen::in<double>>, "zen::in MUST BE A RANDOM ACCESS RANGE");
+
+    constexpr zen::in r(10, 1, -3); // 10 7 4
+    ZEN_STATIC_ASSERT(r.size() == 3 && r[2] == 4, "zen::in MUST BE USABLE AT COMPILE TIME");
+
+    ZEN_EXPECT(std::distance(r.begin(), r.end()) == 3);
+    ZEN_EXPECT(r.begin()[1] == 7);
+    ZEN_EXPECT(*(r.end() - 1) == 4);
+    ZEN_EXPECT(*std::lower_bound(zen::in(0, 100, 5).begin(), zen::in(0, 100, 5).end(), 42) == 45);
+
+    auto evens = zen::in(100) | std::views::filter([](int i) { return i % 2 == 0; });
+    ZEN_EXPECT(std::ranges::distance(evens) == 50);
+}
+
+void test_in_parallel()
+{
+    BEGIN_SUBTEST;
+
+    // Parallel algorithms dispatch on the iterator category to decide whether a range can be split
+    using category = std::iterator_traits<zen::in<int>::iterator>::iterator_category;
+    ZEN_STATIC_ASSERT((std::is_same_v<category, std::random_access_iterator_tag>), "zen::in MUST BE SPLITTABLE");
+
+    // Split the range into chunks in O(1), just like a parallel algorithm would
+    const auto r = zen::in(1, 10'001);
+    const int  K = 4;
+    std::vector<long long>   sums(K);
+    std::vector<std::thread> threads;
+    for (int k : zen::in(K)) {
+        auto first = r.begin() + static_cast<std::ptrdiff_t>(r.size() *  k      / K);
+        auto last  = r.begin() + static_cast<std::ptrdiff_t>(r.size() * (k + 1) / K);
+        threads.emplace_back([&sums, k, first, last] { sums[k] = std::accumulate(first, last, 0LL); });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    ZEN_EXPECT(std::accumulate(sums.begin(), sums.end(), 0LL) == 50'005'000LL);
+}
+
+void test_in_chunks()
+{
+    BEGIN_SUBTEST;
+
+    const auto r = zen::in(0, 20, 2); // 10 elements
+    std::string s;
+    size_t total = 0;
+    for (size_t k : zen::in(size_t(3))) {
+        const auto part = r.chunk(k, 3);
+        total += part.size();
+        for (int i : part) s += std::to_string(i) + " ";
+        s += "| ";
+    }
+    ZEN_EXPECT(total == r.size());
+    ZEN_EXPECT(s == "0 2 4 6 | 8 10 12 | 14 16 18 | ");
+    ZEN_EXPECT(zen::in(2).chunk(3, 4).is_empty());
+    ZEN_EXPECT_THROW(r.chunk(0, 0), std::out_of_range);
+}
+
+void test_in_nd()
+{
+    BEGIN_SUBTEST;
+
+    std::string s;
+    for (auto [i, j] : zen::in_nd({2, 3}))
+        s += std::to_string(i) + std::to_string(j) + " ";
+    ZEN_EXPECT(s == "00 01 02 10 11 12 ");
+
+    const zen::in_nd r({3, 4, 5});
+    ZEN_STATIC_ASSERT(std::ranges::random_access_range<zen::in_nd<3>>, "zen::in_nd MUST BE A RANDOM ACCESS RANGE");
+    ZEN_EXPECT(r.size() == 60);
+    ZEN_EXPECT((r[59] == std::array<int, 3>{2, 3, 4}));
+    ZEN_EXPECT((r.begin()[21] == std::array<int, 3>{1, 0, 1}));
+    ZEN_EXPECT(std::distance(r.begin(), r.end()) == 60);
+
+    // Stepping must agree with jumping
+    bool agree = true;
+    auto it = r.begin();
+    for (size_t n = 0; n < r.size(); ++n, ++it)
+        agree = agree && *it == r[n];
+    ZEN_EXPECT(agree);
+
+    size_t total = 0;
+    for (size_t k : zen::in(size_t(7)))
+        total += std::distance(r.chunk(k, 7).begin(), r.chunk(k, 7).end());
+    ZEN_EXPECT(total == 60);
+    ZEN_EXPECT((r.chunk(1, 2)[0] == std::array<int, 3>{1, 2, 0}));
+
+    ZEN_EXPECT(zen::in_nd({4, 0}).is_empty());
+    ZEN_EXPECT(zen::in_nd({-1, 4}).is_empty());
+}
+
+void test_in_tiled()
+{
+    BEGIN_SUBTEST;
+
+    // 3x5 grid in 2x2 tiles, the ones on the right and bottom edges cut short
+    std::string s;
+    for (auto [i, j] : zen::tiled(zen::in_nd({3, 5}), {2, 2}))
+        s += std::to_string(i) + std::to_string(j) + " ";
+    ZEN_EXPECT(s == "00 01 10 11 02 03 12 13 04 14 20 21 22 23 24 ");
+
+    const zen::tiled t(zen::in_nd({37, 23}), {8, 8});
+    ZEN_EXPECT(t.size() == 37 * 23);
+    ZEN_EXPECT(t.tile_count() == 5 * 3);
+
+    // Every index is visited exactly once, including across chunks
+    std::vector<int> visits(37 * 23);
+    size_t chunked_size = 0;
+    for (size_t k : zen::in(size_t(4))) {
+        chunked_size += t.chunk(k, 4).size();
+        for (auto [i, j] : t.chunk(k, 4))
+            ++visits[i * 23 + j];
+    }
+    ZEN_EXPECT(chunked_size == t.size());
+    ZEN_EXPECT(std::all_of(visits.begin(), visits.end(), [](int v) { return v == 1; }));
+
+    ZEN_EXPECT(zen::tiled(zen::in_nd({0, 8}), {4, 4}).is_empty());
+    ZEN_EXPECT_THROW(zen::tiled(zen::in_nd({8, 8}), {4, 0}), std::invalid_argument);
+}
+
 void main_test_in()
 {
     BEGIN_TEST;
@@ -26,4 +195,12 @@ void main_test_in()
     ZEN_EXPECT(s4 == "[10, 1, -1): 10 9 8 7 6 5 4 3 2 ");
     ZEN_EXPECT(s5 == "[1, 10, -1): ");
     ZEN_EXPECT(s6 == "[-10, 10, 1): -10 -9 -8 -7 -6 -5 -4 -3 -2 -1 0 1 2 3 4 5 6 7 8 9 ");
+
+    test_in_arithmetic_types();
+    test_in_overflow_safety();
+    test_in_random_access();
+    test_in_parallel();
+    test_in_chunks();
+    test_in_nd();
+    test_in_tiled();
 }
\ No newline at end of file
@@ -0,0 +1,130 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <string>
+#include <random>
+#include <vector>
+
+#include "kaizen.h" // test using generated header: jump with the parachute you folded
+
+void test_interval_tree_queries()
+{
+    BEGIN_SUBTEST;
+
+    zen::interval_tree<int, std::string> windows = { {9, 17, "work"}, {12, 13, "lunch"}, {18, 23, "home"}, {0, 8, "sleep"} };
+    ZEN_EXPECT(windows.size() == 4);
+
+    std::string at_noon;
+    windows.for_each_containing(12, [&](const auto& w) { at_noon += w.value + " "; });
+    ZEN_EXPECT(at_noon == "work lunch "); // in order of lo
+
+    // Intervals are closed, so touching endpoints count
+    ZEN_EXPECT(windows.count_overlapping(17, 18) == 2);
+    ZEN_EXPECT(windows.any_containing(8));
+    ZEN_EXPECT(!windows.any_overlapping(24, 30));
+    ZEN_EXPECT(!windows.any_overlapping(-5, -1));
+    ZEN_EXPECT(windows.containing(13).size() == 2);
+    ZEN_EXPECT(windows.overlapping(0, 100).size() == 4);
+    ZEN_EXPECT(windows.begin()->value == "sleep");
+
+    windows.insert(13, 14, "meeting");
+    ZEN_EXPECT(windows.count_overlapping(13, 13) == 3);
+
+    const auto erased = windows.erase_if([](const auto& w) { return w.value == "work"; });
+    ZEN_EXPECT(erased == 1 && windows.size() == 4);
+    ZEN_EXPECT(windows.count_overlapping(10, 11) == 0);
+
+    windows.clear();
+    ZEN_EXPECT(windows.is_empty() && !windows.any_containing(12));
+}
+
+void test_interval_tree_batch()
+{
+    BEGIN_SUBTEST;
+
+    std::vector<zen::interval_tree<int, int>::interval> ranges;
+    for (int i = 0; i < 100; ++i)
+        ranges.push_back({ i * 10, i * 10 + 14, i }); // each overlaps the next
+
+    const zen::interval_tree<int, int> t(ranges.begin(), ranges.end());
+
+    const std::vector<std::pair<int, int>> queries = { {995, 2000}, {5, 5}, {12, 12}, {-10, -1} };
+    const auto counts = t.count_overlapping(queries);
+    ZEN_EXPECT(counts == std::vector<std::size_t>({ 1, 1, 2, 0 }));
+
+    std::vector<std::vector<int>> found(queries.size());
+    t.for_each_overlapping(queries, [&](std::size_t q, const auto& x) { found[q].push_back(x.value); });
+    ZEN_EXPECT(found[0] == std::vector<int>({ 99 }));
+    ZEN_EXPECT(found[2] == std::vector<int>({ 0, 1 }));
+    ZEN_EXPECT(found[3].empty());
+}
+
+void test_interval_tree_against_scan()
+{
+    BEGIN_SUBTEST;
+
+    std::mt19937 rng(5);
+    bool all_same = true;
+
+    // Every size up to a few levels deep, including those whose right subtrees run short
+    for (int n : { 0, 1, 2, 3, 7, 8, 9, 15, 16, 17, 100, 1'000, 4'097 }) {
+        std::vector<zen::interval_tree<int, int>::interval> xs;
+        for (int i = 0; i < n; ++i) {
+            const int lo  = static_cast<int>(rng() % 10'000);
+            const int len = rng() % 10 == 0 ? static_cast<int>(rng() % 3'000) : static_cast<int>(rng() % 50);
+            xs.push_back({ lo, lo + len, i });
+        }
+        const zen::interval_tree<int, int> t(xs.begin(), xs.end());
+
+        for (int q = 0; q < 200; ++q) {
+            const int lo = static_cast<int>(rng() % 11'000) - 500;
+            const int hi = lo + static_cast<int>(rng() % 200);
+
+            std::vector<int> expected;
+            for (const auto& x : xs)
+                if (x.lo <= hi && lo <= x.hi)
+                    expected.push_back(x.value);
+
+            std::vector<int> got;
+            t.for_each_overlapping(lo, hi, [&](const auto& x) { got.push_back(x.value); });
+
+            std::sort(expected.begin(), expected.end());
+            std::sort(got.begin(), got.end());
+            all_same = all_same && got == expected && t.any_overlapping(lo, hi) == !expected.empty();
+        }
+    }
+    ZEN_EXPECT(all_same);
+}
+
+void main_test_interval_tree()
+{
+    BEGIN_TEST;
+
+    test_interval_tree_queries();
+    test_interval_tree_batch();
+    test_interval_tree_against_scan();
+}
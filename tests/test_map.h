@@ -30,6 +30,28 @@ void test_multimap_zen_std_interchangeability()
     ZEN_EXPECT(zv == sv && sv == zc);
 }
 
+void test_multimap_values()
+{
+    BEGIN_SUBTEST;
+    zen::multimap<zen::string, int> m = { {"A", 1}, {"A", 2}, {"A", 3}, {"B", 4} };
+
+    auto a = m.values("A");
+    ZEN_EXPECT(a.size() == 3 && a.front() == 1 && a.contains(3) && !a.contains(4));
+    ZEN_EXPECT(silent_print(a) == "[1, 2, 3]");
+    ZEN_EXPECT(m.values("X").is_empty());
+
+    // In place, so writes go to the map
+    for (int& v : m.values("A"))
+        v *= 10;
+    ZEN_EXPECT(m.find("A")->second == 10);
+
+    const auto copy = m.values("A").to<zen::vector<int>>();
+    ZEN_EXPECT(copy == zen::vector<int>({ 10, 20, 30 }) && m["A"] == std::vector<int>({ 10, 20, 30 }));
+
+    const zen::unordered_multimap<int, int> u = { {1, 1}, {1, 2}, {2, 3} };
+    ZEN_EXPECT(u.values(1).size() == 2 && u.values(2).front() == 3);
+}
+
 void main_test_map()
 {
     BEGIN_TEST;
@@ -75,4 +97,5 @@ void main_test_multimap()
     ZEN_EXPECT(zen::is_empty(mss) == mss.is_empty());
 
     test_multimap_zen_std_interchangeability();
+    test_multimap_values();
 }
\ No newline at end of file
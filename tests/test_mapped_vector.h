@@ -0,0 +1,156 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <system_error>
+#include <filesystem>
+#include <stdexcept>
+#include <fstream>
+#include <cstdint>
+#include <string>
+
+#include "kaizen.h" // test using generated header: jump with the parachute you folded
+
+#ifdef ZEN_MMAP
+
+// A file in the temp directory that's gone when the test is done with it
+struct scratch_file {
+    explicit scratch_file(const std::string& name) : path(std::filesystem::temp_directory_path() / name) { std::filesystem::remove(path); }
+    ~scratch_file() { std::filesystem::remove(path); }
+    std::filesystem::path path;
+};
+
+void test_mapped_vector_persistence()
+{
+    BEGIN_SUBTEST;
+
+    scratch_file file("zen_test_mapped_vector_persistence.bin");
+
+    {
+        zen::mapped_vector<std::int64_t> v(file.path);
+        ZEN_EXPECT(v.is_empty());
+        for (std::int64_t i = 0; i < 100'000; ++i)
+            v.push_back(i * i);
+        ZEN_EXPECT(v.size() == 100'000);
+        ZEN_EXPECT(v.capacity() >= v.size());
+        ZEN_EXPECT(v[317] == 317 * 317);
+        ZEN_EXPECT(v.back() == std::int64_t{ 99'999 } * 99'999);
+        ZEN_EXPECT(v.contains(81));
+        ZEN_EXPECT(!v.contains(82));
+        ZEN_EXPECT(v.contains([](std::int64_t x) { return x > 9'999'000'000; }));
+        v.sync();
+    }
+
+    // Closed, the file holds exactly the elements
+    ZEN_EXPECT(std::filesystem::file_size(file.path) == 100'000 * sizeof(std::int64_t));
+
+    {
+        zen::mapped_vector<std::int64_t> v(file.path);
+        ZEN_EXPECT(v.size() == 100'000);
+        ZEN_EXPECT(v[99'998] == std::int64_t{ 99'998 } * 99'998);
+
+        v.resize(10);
+        v[0] = -1;
+        const std::int64_t more[] = { 7, 8, 9 };
+        v.append(more);
+        v.pop_back();
+        v.resize(14, 5);
+        ZEN_EXPECT(v.size() == 14 && v[11] == 8 && v[12] == 5 && v[13] == 5);
+
+        v.shrink_to_fit();
+        ZEN_EXPECT(v.capacity() == 14);
+
+        bool threw = false;
+        try { (void)v.at(14); } catch (const std::out_of_range&) { threw = true; }
+        ZEN_EXPECT(threw);
+    }
+
+    {
+        zen::mapped_vector<std::int64_t> v(file.path);
+        ZEN_EXPECT(v.size() == 14 && v.front() == -1 && v[10] == 7);
+
+        v.clear();
+        v.shrink_to_fit();
+        ZEN_EXPECT(v.is_empty() && v.data() == nullptr);
+        v.push_back(42);
+        ZEN_EXPECT(v.size() == 1 && v[0] == 42);
+    }
+}
+
+void test_mapped_vector_read_only()
+{
+    BEGIN_SUBTEST;
+
+    scratch_file file("zen_test_mapped_vector_read_only.bin");
+
+    using column = zen::mapped_vector<double>;
+    column writer(file.path);
+    for (int i = 0; i < 1'000; ++i)
+        writer.push_back(i * 0.5);
+    writer.shrink_to_fit();
+
+    // Both map the same pages, so the reader sees what the writer changes
+    column reader(file.path, column::mode::read_only);
+    ZEN_EXPECT(reader.is_read_only());
+    ZEN_EXPECT(reader.size() == 1'000 && reader[999] == 499.5);
+    writer[999] = -1.0;
+    ZEN_EXPECT(reader[999] == -1.0);
+
+    bool threw_push = false, threw_sync = false;
+    try { reader.push_back(1.0); } catch (const std::logic_error&) { threw_push = true; }
+    try { reader.sync();         } catch (const std::logic_error&) { threw_sync = true; }
+    ZEN_EXPECT(threw_push && threw_sync);
+
+    column moved = std::move(reader);
+    ZEN_EXPECT(moved.size() == 1'000 && reader.is_empty());
+
+    bool threw_missing = false;
+    try { column missing(file.path.string() + ".missing", column::mode::read_only); } catch (const std::system_error&) { threw_missing = true; }
+    ZEN_EXPECT(threw_missing);
+}
+
+void test_mapped_vector_bad_file()
+{
+    BEGIN_SUBTEST;
+
+    scratch_file file("zen_test_mapped_vector_bad_file.bin");
+    std::ofstream(file.path, std::ios::binary) << "12345"; // not a whole number of ints
+
+    bool threw = false;
+    try { zen::mapped_vector<int> v(file.path); } catch (const std::runtime_error&) { threw = true; }
+    ZEN_EXPECT(threw);
+}
+
+#endif // ZEN_MMAP
+
+void main_test_mapped_vector()
+{
+    BEGIN_TEST;
+
+#ifdef ZEN_MMAP
+    test_mapped_vector_persistence();
+    test_mapped_vector_read_only();
+    test_mapped_vector_bad_file();
+#endif
+}
@@ -0,0 +1,151 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "kaizen.h" // test using generated header: jump with the parachute you folded
+
+void test_mpmc_queue_single_thread()
+{
+    BEGIN_SUBTEST;
+    zen::mpmc_queue<std::string> q(3);
+
+    ZEN_EXPECT(q.capacity() == 4); // rounded up to a power of two
+    ZEN_EXPECT(q.is_empty());
+
+    const bool pushed = q.try_push("a") && q.try_push("b") && q.try_emplace(3, 'c') && q.try_push("d");
+    const bool full   = !q.try_push("e");
+    ZEN_EXPECT(pushed && full && q.size() == 4);
+
+    std::string s;
+    const bool popped = q.try_pop(s);
+    ZEN_EXPECT(popped && s == "a");
+    const auto b = q.pop();
+    const auto c = q.pop();
+    ZEN_EXPECT(b == "b" && c == "ccc");
+
+    // Wrapping around the end of the ring
+    q.push("e");
+    q.push("f");
+    const auto d = q.pop();
+    const auto e = q.pop();
+    const auto f = q.pop();
+    ZEN_EXPECT(d == "d" && e == "e" && f == "f");
+
+    const bool empty = !q.try_pop(s);
+    ZEN_EXPECT(empty && q.is_empty());
+
+    using queue = zen::mpmc_queue<int>;
+    ZEN_EXPECT_THROW(queue(0), std::invalid_argument);
+}
+
+void test_mpmc_queue_bulk()
+{
+    BEGIN_SUBTEST;
+    zen::mpmc_queue<int> q(8);
+
+    const std::vector<int> v = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+    const auto pushed1 = q.try_push_bulk(v.begin(), v.end());
+    const auto pushed2 = q.try_push_bulk(v.begin(), v.end());
+    ZEN_EXPECT(pushed1 == 8 && pushed2 == 0); // only as many as fit
+
+    std::vector<int> out;
+    const auto popped1 = q.try_pop_bulk(std::back_inserter(out), 3);
+    const auto popped2 = q.try_pop_bulk(std::back_inserter(out), 100);
+    ZEN_EXPECT(popped1 == 3 && popped2 == 5);
+    ZEN_EXPECT(out == std::vector<int>(v.begin(), v.begin() + 8));
+
+    q.push_bulk(v.begin(), v.begin() + 5);
+    std::vector<int> out2(5);
+    q.pop_bulk(out2.begin(), 5);
+    ZEN_EXPECT(out2 == std::vector<int>(v.begin(), v.begin() + 5));
+}
+
+void test_mpmc_queue_destruction()
+{
+    BEGIN_SUBTEST;
+    auto shared = std::make_shared<int>(0);
+    {
+        zen::mpmc_queue<std::shared_ptr<int>> q(4);
+        q.push(shared);
+        q.push(shared);
+        q.pop();
+        q.push(shared); // the remaining two are destroyed with the queue
+        ZEN_EXPECT(shared.use_count() == 3);
+    }
+    ZEN_EXPECT(shared.use_count() == 1);
+}
+
+void test_mpmc_queue_many_threads()
+{
+    BEGIN_SUBTEST;
+
+    // A small queue makes producers and consumers wait for each other a lot
+    zen::mpmc_queue<int> q(16);
+    const int P = 4, C = 4, N = 20'000;
+
+    std::vector<long long>   sums(C);
+    std::vector<std::thread> threads;
+    for (int p : zen::in(P)) {
+        threads.emplace_back([&q, p] {
+            for (int i : zen::in(1, N + 1)) {
+                if (i % 2 == 0)
+                    q.push(i);
+                else
+                    while (!q.try_push(i)) std::this_thread::yield();
+            }
+            (void) p;
+        });
+    }
+    for (int c : zen::in(C)) {
+        threads.emplace_back([&q, &sums, c] {
+            for (int i : zen::in(N)) {
+                if (i % 2 == 0) {
+                    sums[c] += q.pop();
+                } else {
+                    int x;
+                    while (!q.try_pop(x)) std::this_thread::yield();
+                    sums[c] += x;
+                }
+            }
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    ZEN_EXPECT(std::accumulate(sums.begin(), sums.end(), 0LL) == P * (N * (N + 1LL) / 2));
+    ZEN_EXPECT(q.is_empty());
+}
+
+void main_test_mpmc_queue()
+{
+    BEGIN_TEST;
+    test_mpmc_queue_single_thread();
+    test_mpmc_queue_bulk();
+    test_mpmc_queue_destruction();
+    test_mpmc_queue_many_threads();
+}
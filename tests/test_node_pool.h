@@ -0,0 +1,177 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <thread>
+#include <vector>
+
+#include "kaizen.h" // test using generated header: jump with the parachute you folded
+
+template<class T> using pooled       = zen::node_pool_allocator<T>;
+template<class T> using bulk_pooled  = zen::node_pool_allocator<T, true>;
+
+void test_node_pool_containers()
+{
+    BEGIN_SUBTEST;
+
+    zen::list<int, pooled<int>>                 l = { 3, 1, 2 };
+    zen::forward_list<int, pooled<int>>        fl = { 3, 1, 2 };
+    zen::set<int, std::less<int>, pooled<int>>  s = { 3, 1, 2, 3 };
+    zen::multiset<int, std::less<int>, pooled<int>> ms = { 3, 1, 2, 3 };
+    zen::map<int, std::string, std::less<int>, pooled<std::pair<const int, std::string>>> m;
+    zen::multimap<int, int, std::less<int>, bulk_pooled<std::pair<const int, int>>> mm;
+
+    l.sort();
+    fl.sort();
+    for (int i : zen::in(1000)) {
+        m[i] = std::to_string(i);
+        mm.emplace(i % 10, i);
+    }
+    for (int i : zen::in(0, 1000, 2))
+        m.erase(i);
+
+    ZEN_EXPECT(l.front() == 1 && l.back() == 3 && fl.front() == 1);
+    ZEN_EXPECT(s.size() == 3 && ms.size() == 4);
+    ZEN_EXPECT(m.size() == 500 && m.at(501) == "501");
+    ZEN_EXPECT(mm.count(7) == 100);
+
+    // Copies of a container with its own pool get their own pool, moves take it along
+    auto mm2 = mm;
+    ZEN_EXPECT(mm2.get_allocator() != mm.get_allocator() && mm2.size() == 1000);
+    auto mm3 = std::move(mm2);
+    mm2.clear();
+    mm2.emplace(1, 1); // a moved-from container is still usable
+    ZEN_EXPECT(mm3.size() == 1000 && mm2.size() == 1);
+    ZEN_EXPECT(mm2.get_allocator() != mm3.get_allocator()); // and has a pool of its own again
+}
+
+void test_node_pool_reuse()
+{
+    BEGIN_SUBTEST;
+
+    // Freed blocks are handed out again, last in first out
+    pooled<double> a;
+    double* p = a.allocate(1);
+    a.deallocate(p, 1);
+    double* q = a.allocate(1);
+    ZEN_EXPECT(p == q);
+    a.deallocate(q, 1);
+
+    // Arrays bypass the pool
+    double* arr = a.allocate(100);
+    arr[99] = 1.0;
+    a.deallocate(arr, 100);
+
+    bulk_pooled<double> b, c;
+    ZEN_EXPECT(b != c && b == bulk_pooled<double>(b));
+    ZEN_EXPECT(a == pooled<double>());
+}
+
+void test_node_pool_threads()
+{
+    BEGIN_SUBTEST;
+
+    // Nodes allocated on one thread and freed on another, and threads exiting with free blocks
+    std::vector<zen::list<int, pooled<int>>> lists(4);
+    std::vector<std::thread> threads;
+    for (auto& l : lists)
+        threads.emplace_back([&l] { for (int i : zen::in(10'000)) l.push_back(i); });
+    for (auto& t : threads)
+        t.join();
+    threads.clear();
+
+    for (auto& l : lists)
+        threads.emplace_back([&l] { l.remove_if([](int i) { return i % 2 == 0; }); });
+    for (auto& t : threads)
+        t.join();
+
+    bool all_right = true;
+    for (auto& l : lists)
+        all_right = all_right && l.size() == 5'000 && l.front() == 1;
+    ZEN_EXPECT(all_right);
+}
+
+void test_node_pool_assignment()
+{
+    BEGIN_SUBTEST;
+
+    // Assignments move elements between pools, and leave each container its own
+    zen::list<int, bulk_pooled<int>> a = { 1, 2, 3 };
+    zen::list<int, bulk_pooled<int>> b = { 4 };
+    zen::list<int, bulk_pooled<int>> c;
+    b = a;
+    c = std::move(a);
+    a.clear();
+    a.push_back(5); // a moved-from container is still usable
+    ZEN_EXPECT(b.get_allocator() != a.get_allocator() && c.get_allocator() != a.get_allocator());
+    ZEN_EXPECT(b.get_allocator() != c.get_allocator());
+    ZEN_EXPECT((b == zen::list<int, bulk_pooled<int>>{ 1, 2, 3 } && c == b));
+
+    // So the containers can be used on different threads, as independent ones should be
+    std::vector<std::thread> threads;
+    for (auto* l : { &a, &b, &c })
+        threads.emplace_back([l] {
+            for (int i : zen::in(10'000)) l->push_back(i);
+            l->remove_if([](int i) { return i % 2 == 0; });
+        });
+    for (auto& t : threads)
+        t.join();
+    ZEN_EXPECT(a.size() == 5'001 && b.size() == 5'002 && c.size() == 5'002);
+}
+
+void test_node_pool_teardown()
+{
+    BEGIN_SUBTEST;
+
+    // A container that outlives its thread's free list, since it's constructed before the
+    // free list is (on the first allocation), and thread_locals are destroyed in reverse order
+    std::thread t([] {
+        thread_local zen::list<int, pooled<int>> late;
+        for (int i : zen::in(100))
+            late.push_back(i);
+    });
+    t.join();
+
+    // Its nodes went to the depot, from which the other threads still allocate
+    zen::list<int, pooled<int>> l;
+    for (int i : zen::in(1000))
+        l.push_back(i);
+    ZEN_EXPECT(l.size() == 1000 && l.back() == 999);
+
+    // The same for the main thread: this one is freed at exit, after the free list is gone
+    static zen::list<int, pooled<int>> at_exit;
+    for (int i : zen::in(100))
+        at_exit.push_back(i);
+    ZEN_EXPECT(at_exit.size() == 100);
+}
+
+void main_test_node_pool()
+{
+    BEGIN_TEST;
+    test_node_pool_containers();
+    test_node_pool_reuse();
+    test_node_pool_threads();
+    test_node_pool_assignment();
+    test_node_pool_teardown();
+}
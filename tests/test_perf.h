@@ -1,5 +1,16 @@
 #pragma once
 
+#include <condition_variable>
+#include <type_traits>
+#include <filesystem>
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <thread>
+#include <vector>
+#include <string>
+#include <mutex>
+
 #include "kaizen.h" // test using generated header: jump with the parachute you folded
 
 #include "../internal.h"
@@ -12,6 +23,594 @@
 // variable whose usage scope is limited.
 volatile int sink; // global (see why above) to prevent loop optimization
 
+// Adds to sink with wraparound, since sums of scattered values overflow an int
+template<class T>
+void sink_add(T x) { sink = static_cast<int>(static_cast<unsigned>(sink) + static_cast<unsigned>(x)); }
+
+// Scatters consecutive integers so that the node-based map doesn't get
+// an unrealistic memory locality from the identity std::hash<int>
+int scattered(int i) { return static_cast<int>(static_cast<unsigned>(i) * 2654435761u); }
+
+template<class Map>
+std::string time_lookups(Map& m, const int N)
+{
+    for (int i : zen::in(N))
+        m[scattered(2 * i)] = i;
+
+    zen::timer tm;
+    for (int i : zen::in(2 * N)) { // half of the lookups miss
+        auto it = m.find(scattered(i));
+        if (it != m.end())
+            sink_add(it->second);
+    }
+    return tm.stop().duration_string();
+}
+
+void test_perf_hash_map_lookups()
+{
+    BEGIN_SUBTEST;
+
+    const int N = 10'000; // use 1M for Release/optimized mode
+
+    zen::hash_map<int, int>      node_map;
+    zen::flat_hash_map<int, int> flat_map;
+
+    zen::log("PERF TIME FOR zen::hash_map      LOOKUPS:", time_lookups(node_map, N));
+    zen::log("PERF TIME FOR zen::flat_hash_map LOOKUPS:", time_lookups(flat_map, N));
+}
+
+// Every thread counts N scattered keys that repeat across threads, the way parallel aggregation does
+template<class Count>
+std::string time_counting(Count count, const int N)
+{
+    const int T = std::max(2, static_cast<int>(std::thread::hardware_concurrency()));
+    std::vector<std::thread> threads;
+
+    zen::timer tm;
+    for (int t : zen::in(T)) {
+        threads.emplace_back([&count, t, N] {
+            for (int i : zen::in(N))
+                count(scattered((i * 7 + t) % (N / 2)));
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+    return tm.stop().duration_string();
+}
+
+void test_perf_concurrent_counting()
+{
+    BEGIN_SUBTEST;
+
+    const int N = 10'000; // use 1M for Release/optimized mode
+
+    zen::hash_map<int, int> locked_map;
+    std::mutex              locked_map_mutex;
+    zen::concurrent_hash_map<int, int> sharded_map;
+
+    auto t1 = time_counting([&](int k) { std::lock_guard lock(locked_map_mutex); ++locked_map[k]; }, N);
+    auto t2 = time_counting([&](int k) { sharded_map.upsert(k, [](int& n) { ++n; }, 1); }, N);
+
+    zen::log("PERF TIME FOR zen::hash_map + std::mutex COUNTING:", t1);
+    zen::log("PERF TIME FOR zen::concurrent_hash_map   COUNTING:", t2);
+}
+
+// Hands N integers from each of T producer threads over to as many consumer threads
+template<class Push, class Pop>
+std::string time_handoff(Push push, Pop pop, const int N, const int T = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) / 2))
+{
+    std::vector<std::thread> threads;
+
+    zen::timer tm;
+    for (int t : zen::in(T)) {
+        threads.emplace_back([&push, N] { for (int i : zen::in(N)) push(i); });
+        threads.emplace_back([&pop,  N] { for (int i : zen::in(N)) sink_add(pop() + 0 * i); });
+        (void) t;
+    }
+    for (auto& t : threads)
+        t.join();
+    return tm.stop().duration_string();
+}
+
+void test_perf_queue_handoff()
+{
+    BEGIN_SUBTEST;
+
+    const int N = 10'000; // use 10M for Release/optimized mode
+
+    zen::queue<int>         locked_queue;
+    std::mutex              locked_queue_mutex;
+    std::condition_variable locked_queue_ready;
+    auto locked_push = [&](int x) {
+        { std::lock_guard lock(locked_queue_mutex); locked_queue.push(x); }
+        locked_queue_ready.notify_one();
+    };
+    auto locked_pop = [&] {
+        std::unique_lock lock(locked_queue_mutex);
+        locked_queue_ready.wait(lock, [&] { return !locked_queue.is_empty(); });
+        const int x = locked_queue.front();
+        locked_queue.pop();
+        return x;
+    };
+
+    zen::mpmc_queue<int> lockfree_queue(1024);
+    auto lockfree_push = [&](int x) { lockfree_queue.push(x);       };
+    auto lockfree_pop  = [&]        { return lockfree_queue.pop(); };
+
+    zen::log("PERF TIME FOR zen::queue + std::mutex HANDOFF:", time_handoff(locked_push,   locked_pop,   N));
+    zen::log("PERF TIME FOR zen::mpmc_queue         HANDOFF:", time_handoff(lockfree_push, lockfree_pop, N));
+
+    // A single producer and a single consumer, the only setup a zen::spsc_ring allows
+    zen::spsc_ring<int, 1024> ring;
+    auto ring_push = [&](int x) { while (!ring.try_push(x)) std::this_thread::yield(); };
+    auto ring_pop  = [&] { int x; while (!ring.try_pop(x)) std::this_thread::yield(); return x; };
+
+    zen::log("PERF TIME FOR zen::queue + std::mutex HANDOFF (1:1):", time_handoff(locked_push, locked_pop, N, 1));
+    zen::log("PERF TIME FOR zen::spsc_ring          HANDOFF (1:1):", time_handoff(ring_push,   ring_pop,   N, 1));
+}
+
+// Builds a heap of N scattered integers, then pops them all
+template<class Heap>
+std::string time_heap(const int N)
+{
+    zen::vector<int> v;
+    for (int i : zen::in(N))
+        v.push_back(scattered(i));
+
+    zen::timer tm;
+    Heap h(v.begin(), v.end());
+    while (!h.is_empty()) {
+        sink_add(h.top());
+        h.pop();
+    }
+    return tm.stop().duration_string();
+}
+
+void test_perf_heaps()
+{
+    BEGIN_SUBTEST;
+
+    const int N = 10'000; // use 10M for Release/optimized mode
+
+    zen::log("PERF TIME FOR zen::priority_queue BUILD+DRAIN:", time_heap<zen::priority_queue<int>>(N));
+    zen::log("PERF TIME FOR zen::dary_heap      BUILD+DRAIN:", time_heap<zen::dary_heap<int>>(N));
+}
+
+// Uses a deque as a sliding window of large elements: pushes at the back,
+// pops at the front and reads by index, which is what queues of jobs do
+struct perf_job { int id; char payload[60]; };
+
+template<class Deque>
+std::string time_sliding_window(const int N)
+{
+    Deque d;
+
+    zen::timer tm;
+    for (int i : zen::in(N)) {
+        d.push_back(perf_job{ i, {} });
+        if (d.size() > 1000)
+            d.pop_front();
+        sink_add(d[d.size() / 2].id);
+    }
+    return tm.stop().duration_string();
+}
+
+void test_perf_deques()
+{
+    BEGIN_SUBTEST;
+
+    const int N = 100'000; // use 100M for Release/optimized mode
+
+    zen::log("PERF TIME FOR zen::deque      SLIDING WINDOW:", time_sliding_window<zen::deque<perf_job>>(N));
+    zen::log("PERF TIME FOR zen::ring_deque SLIDING WINDOW:", time_sliding_window<zen::ring_deque<perf_job>>(N));
+}
+
+// Fills a node-based map, erases half of it and destroys it, which is
+// the whole life of a node and so every path through the allocator
+template<class Map>
+std::string time_map_churn(const int N)
+{
+    zen::timer tm;
+    {
+        Map m;
+        for (int i : zen::in(N))
+            m.emplace(scattered(i), i);
+        for (int i : zen::in(0, N, 2))
+            m.erase(scattered(i));
+        sink_add(m.size());
+    } // the destruction is timed too
+    return tm.stop().duration_string();
+}
+
+void test_perf_node_pool()
+{
+    BEGIN_SUBTEST;
+
+    const int N = 100'000; // use 10M for Release/optimized mode
+
+    using pair = std::pair<const int, int>;
+    using std_map  = zen::map<int, int>;
+    using pool_map = zen::map<int, int, std::less<int>, zen::node_pool_allocator<pair>>;
+    using bulk_map = zen::map<int, int, std::less<int>, zen::node_pool_allocator<pair, true>>;
+
+    zen::log("PERF TIME FOR zen::map std::allocator       INSERT+ERASE+DESTROY:", time_map_churn<std_map>(N));
+    zen::log("PERF TIME FOR zen::map node_pool_allocator  INSERT+ERASE+DESTROY:", time_map_churn<pool_map>(N));
+    zen::log("PERF TIME FOR zen::map bulk release pool    INSERT+ERASE+DESTROY:", time_map_churn<bulk_map>(N));
+}
+
+// Intersects two sets over the same domain and counts what is left
+template<class Bits>
+std::string time_intersection(const int N, Bits& a, const Bits& b)
+{
+    zen::timer tm;
+    if constexpr (std::is_same_v<Bits, zen::bitset>) {
+        a &= b;
+        sink_add(a.count());
+    }
+    else {
+        int count = 0;
+        for (int i : zen::in(N)) {
+            a[i] = a[i] && b[i];
+            count += a[i];
+        }
+        sink_add(count);
+    }
+    return tm.stop().duration_string();
+}
+
+void test_perf_bitsets()
+{
+    BEGIN_SUBTEST;
+
+    const int N = 1'000'000; // use 100M for Release/optimized mode
+
+    zen::vector<bool> va(N), vb(N);
+    zen::bitset       ba(N), bb(N);
+    for (int i : zen::in(N)) {
+        va[i] = scattered(i) % 2 == 0;
+        vb[i] = scattered(i) % 3 == 0;
+        ba.set(i, va[i]);
+        bb.set(i, vb[i]);
+    }
+
+    zen::log("PERF TIME FOR zen::vector<bool> AND+COUNT:", time_intersection(N, va, vb));
+    zen::log("PERF TIME FOR zen::bitset       AND+COUNT:", time_intersection(N, ba, bb));
+}
+
+// Looks up keys in an order unrelated to the one they were inserted in, since the nodes
+// of zen::map lie in memory in insertion order, which a real workload doesn't benefit from
+template<class Map>
+std::string time_ordered_lookups(const int N)
+{
+    Map m;
+    zen::vector<int> keys;
+    for (int i : zen::in(N)) {
+        m[scattered(2 * i)] = i;
+        keys.push_back(scattered(2 * i));
+        keys.push_back(scattered(2 * i + 1)); // half of the lookups miss
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+
+    zen::timer tm;
+    for (int k : keys) {
+        auto it = m.find(k);
+        if (it != m.end())
+            sink_add(it->second);
+    }
+    return tm.stop().duration_string();
+}
+
+void test_perf_ordered_maps()
+{
+    BEGIN_SUBTEST;
+
+    const int N = 100'000; // use 10M for Release/optimized mode
+
+    zen::log("PERF TIME FOR zen::map       LOOKUPS:", time_ordered_lookups<zen::map<int, int>>(N));
+    zen::log("PERF TIME FOR zen::btree_map LOOKUPS:", time_ordered_lookups<zen::btree_map<int, int>>(N));
+    zen::log("PERF TIME FOR zen::map       INSERT+ERASE+DESTROY:", time_map_churn<zen::map<int, int>>(N));
+    zen::log("PERF TIME FOR zen::btree_map INSERT+ERASE+DESTROY:", time_map_churn<zen::btree_map<int, int>>(N));
+}
+
+// Sums the values of each key, as index lookups do
+template<class Get>
+std::string time_multimap_lookups(Get get, const int N)
+{
+    zen::timer tm;
+    for (int i : zen::in(N))
+        for (int v : get(i % 100))
+            sink_add(v);
+    return tm.stop().duration_string();
+}
+
+void test_perf_multimap_values()
+{
+    BEGIN_SUBTEST;
+
+    const int N = 10'000; // use 1M for Release/optimized mode
+
+    zen::multimap<int, int>      tree;
+    zen::flat_multimap<int, int> flat;
+    for (int i : zen::in(10'000)) {
+        tree.emplace(i % 100, i);
+        flat.emplace(i % 100, i);
+    }
+
+    zen::log("PERF TIME FOR zen::multimap::operator[] LOOKUPS:",     time_multimap_lookups([&](int k) { return tree[k];        }, N));
+    zen::log("PERF TIME FOR zen::multimap::values() LOOKUPS:",       time_multimap_lookups([&](int k) { return tree.values(k); }, N));
+    zen::log("PERF TIME FOR zen::flat_multimap::values() LOOKUPS:",  time_multimap_lookups([&](int k) { return flat.values(k); }, N));
+}
+
+// Looks up N keys that aren't there in a set of N, the common case of a cache or a join
+template<class Set>
+std::string time_missing_lookups(Set& s, const int N)
+{
+    for (int i : zen::in(N))
+        s.insert(scattered(2 * i));
+
+    zen::timer tm;
+    for (int i : zen::in(N))
+        sink_add(s.contains(scattered(2 * i + 1)));
+    return tm.stop().duration_string();
+}
+
+void test_perf_bloom_filter()
+{
+    BEGIN_SUBTEST;
+
+    const int N = 100'000; // use 10M for Release/optimized mode
+
+    zen::hash_set<int>                    plain;
+    zen::filtered_set<zen::hash_set<int>> filtered(N);
+
+    zen::log("PERF TIME FOR zen::hash_set     MISSING LOOKUPS:", time_missing_lookups(plain,    N));
+    zen::log("PERF TIME FOR zen::filtered_set MISSING LOOKUPS:", time_missing_lookups(filtered, N));
+}
+
+// Counts the keys under each of a thousand prefixes, as autocompletion does
+template<class Count>
+std::string time_prefix_queries(Count count, const int N)
+{
+    zen::timer tm;
+    for (int i : zen::in(N))
+        sink_add(count("/api/v1/" + std::to_string(i % 1000)));
+    return tm.stop().duration_string();
+}
+
+void test_perf_radix_trie()
+{
+    BEGIN_SUBTEST;
+
+    const int N = 10'000; // use 1M for Release/optimized mode
+
+    zen::radix_trie<int>       trie;
+    zen::map<std::string, int> tree;
+    for (int i : zen::in(50'000)) {
+        const std::string key = "/api/v1/" + std::to_string(static_cast<unsigned>(scattered(i)) % 100'000);
+        trie.insert(key, i);
+        tree.emplace(key, i);
+    }
+
+    zen::log("PERF TIME FOR zen::radix_trie PREFIX QUERIES:", time_prefix_queries([&](const std::string& p) { return trie.prefix(p).size(); }, N));
+    zen::log("PERF TIME FOR zen::map        PREFIX QUERIES:", time_prefix_queries([&](const std::string& p) {
+        std::size_t n = 0;
+        for (auto it = tree.lower_bound(p); it != tree.end() && it->first.starts_with(p); ++it)
+            ++n;
+        return n;
+    }, N));
+}
+
+// Publishes N versions of a 10K element state, each one change away from the last
+template<class Publish>
+std::string time_snapshots(Publish publish, const int N)
+{
+    zen::timer tm;
+    for (int i : zen::in(N))
+        sink_add(publish(i));
+    return tm.stop().duration_string();
+}
+
+void test_perf_persistent()
+{
+    BEGIN_SUBTEST;
+
+    const int N = 100; // use 10K for Release/optimized mode
+
+    zen::map<int, int>            map;
+    zen::vector<int>              vec;
+    zen::persistent_map<int, int> pmap;
+    zen::persistent_vector<int>   pvec;
+    for (int i : zen::in(10'000)) {
+        map[i] = i;
+        vec.push_back(i);
+        pmap = pmap.set(i, i);
+        pvec = pvec.push_back(i);
+    }
+
+    zen::log("PERF TIME FOR zen::map            COPIED SNAPSHOTS:", time_snapshots([&](int i) {
+        auto next = map; next[i % 10'000] = i; map = std::move(next); return map.at(0); }, N));
+    zen::log("PERF TIME FOR zen::persistent_map SHARED SNAPSHOTS:", time_snapshots([&](int i) {
+        pmap = pmap.set(i % 10'000, i); return pmap.at(0); }, N));
+    zen::log("PERF TIME FOR zen::vector            COPIED SNAPSHOTS:", time_snapshots([&](int i) {
+        auto next = vec; next[i % 10'000] = i; vec = std::move(next); return vec[0]; }, N));
+    zen::log("PERF TIME FOR zen::persistent_vector SHARED SNAPSHOTS:", time_snapshots([&](int i) {
+        pvec = pvec.set(i % 10'000, i); return pvec[0]; }, N));
+}
+
+#ifdef ZEN_MMAP
+
+// Opens a column of N numbers and reads it through once, as a program starting up does
+void test_perf_mapped_vector()
+{
+    BEGIN_SUBTEST;
+
+    const int N = 1'000'000; // use 100M for Release/optimized mode
+
+    const auto path = std::filesystem::temp_directory_path() / "zen_perf_mapped_vector.bin";
+    std::filesystem::remove(path);
+    {
+        zen::mapped_vector<int> column(path);
+        column.resize(N);
+        for (int i : zen::in(N))
+            column[i] = i;
+    }
+
+    zen::timer tm;
+    {
+        zen::vector<int> loaded(N);
+        std::ifstream(path, std::ios::binary).read(reinterpret_cast<char*>(loaded.data()), N * sizeof(int));
+        for (int x : loaded)
+            sink_add(x);
+    }
+    zen::log("PERF TIME FOR zen::vector        LOAD+SCAN:", tm.stop().duration_string());
+
+    tm.start();
+    {
+        zen::mapped_vector<int> mapped(path, zen::mapped_vector<int>::mode::read_only);
+        for (int x : mapped)
+            sink_add(x);
+    }
+    zen::log("PERF TIME FOR zen::mapped_vector OPEN+SCAN:", tm.stop().duration_string());
+
+    std::filesystem::remove(path);
+}
+
+#endif // ZEN_MMAP
+
+// Records whose scans read one field out of eight
+struct perf_record {
+    double price;
+    double other[7];
+};
+
+void test_perf_soa_vector()
+{
+    BEGIN_SUBTEST;
+
+    const int N = 200'000; // use 20M for Release/optimized mode
+
+    zen::vector<perf_record>                                                    aos(N);
+    zen::soa_vector<double, double, double, double, double, double, double, double> soa;
+    soa.reserve(N);
+    for (int i : zen::in(N)) {
+        aos[i].price = i;
+        soa.push_back(i, 0, 0, 0, 0, 0, 0, 0);
+    }
+
+    zen::timer tm;
+    double total = 0;
+    for (const auto& r : aos)
+        total += r.price;
+    sink_add(static_cast<int>(total));
+    zen::log("PERF TIME FOR zen::vector<struct> FIELD SCAN:", tm.stop().duration_string());
+
+    tm.start();
+    total = 0;
+    for (double p : soa.column<0>())
+        total += p;
+    sink_add(static_cast<int>(total));
+    zen::log("PERF TIME FOR zen::soa_vector     FIELD SCAN:", tm.stop().duration_string());
+}
+
+// Looks up every live entity by its id, then updates them all in one pass
+void test_perf_slot_map()
+{
+    BEGIN_SUBTEST;
+
+    const int N = 100'000; // use 10M for Release/optimized mode
+
+    zen::hash_map<int, int>                 by_id;
+    zen::slot_map<int>                      slots;
+    zen::vector<zen::slot_map<int>::handle> handles;
+    for (int i : zen::in(N)) {
+        by_id[i] = i;
+        handles.push_back(slots.insert(i));
+    }
+    for (int i = 0; i < N; i += 2) {
+        by_id.erase(i);
+        slots.erase(handles[i]);
+    }
+
+    zen::timer tm;
+    for (int i = 1; i < N; i += 2)
+        sink_add(by_id[i]);
+    for (auto& [id, x] : by_id)
+        ++x;
+    zen::log("PERF TIME FOR zen::hash_map  LOOKUP+UPDATE:", tm.stop().duration_string());
+
+    tm.start();
+    for (int i = 1; i < N; i += 2)
+        sink_add(slots[handles[i]]);
+    for (int& x : slots)
+        ++x;
+    zen::log("PERF TIME FOR zen::slot_map  LOOKUP+UPDATE:", tm.stop().duration_string());
+}
+
+// Counts the windows overlapping each of N ranges among 100K short ones
+void test_perf_interval_tree()
+{
+    BEGIN_SUBTEST;
+
+    const int N = 100; // use 10K for Release/optimized mode
+
+    zen::vector<std::pair<int, int>>                     windows;
+    zen::vector<zen::interval_tree<int, int>::interval>  items;
+    for (int i : zen::in(100'000)) {
+        const int lo = static_cast<int>(static_cast<unsigned>(scattered(i)) % 10'000'000);
+        windows.push_back({ lo, lo + 100 });
+        items.push_back({ lo, lo + 100, i });
+    }
+    const zen::interval_tree<int, int> tree(items.begin(), items.end());
+
+    auto query = [](int i) { return static_cast<int>(static_cast<unsigned>(scattered(i + 7)) % 10'000'000); };
+
+    zen::timer tm;
+    for (int i : zen::in(N)) {
+        const int lo = query(i);
+        for (const auto& [a, b] : windows)
+            sink_add(a <= lo + 1'000 && lo <= b);
+    }
+    zen::log("PERF TIME FOR zen::vector<pair>   OVERLAP QUERIES:", tm.stop().duration_string());
+
+    tm.start();
+    for (int i : zen::in(N)) {
+        const int lo = query(i);
+        sink_add(tree.count_overlapping(lo, lo + 1'000));
+    }
+    zen::log("PERF TIME FOR zen::interval_tree  OVERLAP QUERIES:", tm.stop().duration_string());
+}
+
+void test_perf_set_algebra()
+{
+    BEGIN_SUBTEST;
+
+    const int N = 10; // use 1K for Release/optimized mode
+
+    // Posting lists of the documents that contain a term, each one in about half of them
+    std::mt19937 rng(1);
+    zen::ints common, rare, frequent;
+    for (int i : zen::in(200'000)) {
+        if (rng() & 1)         common.push_back(i);
+        if (rng() & 1)         frequent.push_back(i);
+        if (rng() % 128 == 0)  rare.push_back(i);
+    }
+    zen::ints out(frequent.size());
+
+    zen::timer tm;
+    for ([[maybe_unused]] int i : zen::in(N)) {
+        sink_add(std::set_intersection(common.begin(), common.end(), frequent.begin(), frequent.end(), out.begin()) - out.begin());
+        sink_add(std::set_intersection(rare.begin(),   rare.end(),   frequent.begin(), frequent.end(), out.begin()) - out.begin());
+    }
+    zen::log("PERF TIME FOR std::set_intersection POSTING LISTS:", tm.stop().duration_string());
+
+    tm.start();
+    for ([[maybe_unused]] int i : zen::in(N)) {
+        sink_add(zen::intersect(common, frequent, out));
+        sink_add(zen::intersect(rare,   frequent, out));
+    }
+    zen::log("PERF TIME FOR zen::intersect        POSTING LISTS:", tm.stop().duration_string());
+}
+
 void main_test_performance()
 {
     BEGIN_TEST;
@@ -36,4 +635,24 @@ void main_test_performance()
     zen::log("PERF TIME FOR RAW for:", t2);
 
     silent_print(sink); // to ensure it's used
+
+    test_perf_hash_map_lookups();
+    test_perf_concurrent_counting();
+    test_perf_queue_handoff();
+    test_perf_heaps();
+    test_perf_deques();
+    test_perf_node_pool();
+    test_perf_bitsets();
+    test_perf_ordered_maps();
+    test_perf_multimap_values();
+    test_perf_bloom_filter();
+    test_perf_radix_trie();
+    test_perf_persistent();
+#ifdef ZEN_MMAP
+    test_perf_mapped_vector();
+#endif
+    test_perf_soa_vector();
+    test_perf_slot_map();
+    test_perf_interval_tree();
+    test_perf_set_algebra();
 }
\ No newline at end of file
@@ -0,0 +1,260 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <unordered_map>
+#include <stdexcept>
+#include <cstddef>
+#include <string>
+#include <random>
+#include <thread>
+#include <vector>
+#include <atomic>
+
+#include "kaizen.h" // test using generated header: jump with the parachute you folded
+
+void test_persistent_vector_versions()
+{
+    BEGIN_SUBTEST;
+
+    const zen::persistent_vector<int> v1 = { 1, 2, 3 };
+    const auto v2 = v1.push_back(4).set(0, 10);
+    const auto v3 = v2.pop_back();
+
+    ZEN_EXPECT(v1.size() == 3 && v1[0] == 1 && v1.back() == 3);
+    ZEN_EXPECT(v2.size() == 4 && v2[0] == 10 && v2.back() == 4);
+    ZEN_EXPECT(v3.size() == 3 && v3.front() == 10);
+    ZEN_EXPECT(v1 == zen::persistent_vector<int>({ 1, 2, 3 }));
+    ZEN_EXPECT(!(v1 == v3));
+
+    bool threw_at = false, threw_pop = false, threw_set = false;
+    try { (void)v1.at(3);                          } catch (const std::out_of_range&) { threw_at  = true; }
+    try { (void)zen::persistent_vector<int>().pop_back(); } catch (const std::out_of_range&) { threw_pop = true; }
+    try { (void)v1.set(7, 0);                      } catch (const std::out_of_range&) { threw_set = true; }
+    ZEN_EXPECT(threw_at && threw_pop && threw_set);
+
+    // Non-trivial elements are copied, moved and destroyed along with the nodes
+    zen::persistent_vector<std::string> s;
+    for (int i : zen::in(100))
+        s = s.push_back(std::to_string(i));
+    const auto t = s.set(50, "fifty");
+    ZEN_EXPECT(s[50] == "50" && t[50] == "fifty");
+    ZEN_EXPECT(s[99] == "99" && t[99] == "99");
+}
+
+void test_persistent_vector_growth()
+{
+    BEGIN_SUBTEST;
+
+    // Up past three levels of branches and back down to nothing, keeping every version
+    const int N = 40'000;
+    std::vector<zen::persistent_vector<int>> versions(1);
+    for (int i : zen::in(N))
+        versions.push_back(versions.back().push_back(i));
+
+    bool all_there = true;
+    for (int n : { 1, 31, 32, 33, 1024, 1056, 1057, 32'800, N })
+        for (int i : zen::in(n))
+            all_there = all_there && versions[n][i] == i && versions[n].size() == static_cast<std::size_t>(n);
+    ZEN_EXPECT(all_there);
+
+    int expected = 0;
+    bool iterated = true;
+    for (int x : versions[N])
+        iterated = iterated && x == expected++;
+    ZEN_EXPECT(iterated && expected == N);
+
+    auto v = versions[N].set(33'000, -1).set(5, -2);
+    ZEN_EXPECT(v[33'000] == -1 && v[5] == -2 && versions[N][33'000] == 33'000);
+
+    v = versions[N];
+    bool pops_match = true;
+    for (int n = N; n > 0; --n) {
+        v = v.pop_back();
+        pops_match = pops_match && v.size() == static_cast<std::size_t>(n - 1) && (n == 1 || v.back() == n - 2);
+    }
+    ZEN_EXPECT(pops_match && v.is_empty());
+    ZEN_EXPECT(versions[N].size() == static_cast<std::size_t>(N) && versions[N].back() == N - 1);
+}
+
+void test_persistent_vector_builder()
+{
+    BEGIN_SUBTEST;
+
+    const zen::persistent_vector<int> base = { 0, 1, 2 };
+
+    auto b = base.transient();
+    for (int i = 3; i < 5'000; ++i)
+        b.push_back(i);
+    b.set(0, 100);
+    b.pop_back();
+
+    const auto built = b.persistent();
+    b.set(1, 200); // after persistent(), the builder copies what it shares with the version
+
+    ZEN_EXPECT(base.size() == 3 && base[0] == 0);
+    ZEN_EXPECT(built.size() == 4'999 && built[0] == 100 && built[1] == 1 && built.back() == 4'998);
+    ZEN_EXPECT(b[1] == 200);
+}
+
+// Keys whose hashes all collide, to reach the nodes past the last bits of the hash
+struct bad_hash {
+    std::size_t operator()(int x) const { return static_cast<std::size_t>(x % 3); }
+};
+
+void test_persistent_map_versions()
+{
+    BEGIN_SUBTEST;
+
+    const zen::persistent_map<std::string, int> m1 = { {"a", 1} };
+    const auto m2 = m1.set("b", 2).erase("a");
+    const auto m3 = m2.set("b", 3);
+
+    ZEN_EXPECT(m1.size() == 1 && m1.at("a") == 1 && !m1.contains("b"));
+    ZEN_EXPECT(m2.size() == 1 && m2.find("a") == nullptr && *m2.find("b") == 2);
+    ZEN_EXPECT(m3.size() == 1 && m3.at("b") == 3);
+
+    bool threw = false;
+    try { (void)m1.at("z"); } catch (const std::out_of_range&) { threw = true; }
+    ZEN_EXPECT(threw);
+
+    const auto same = m1.erase("nothing");
+    ZEN_EXPECT(same.size() == 1 && same.at("a") == 1);
+    ZEN_EXPECT(m1.erase("a").is_empty());
+
+    // Colliding hashes
+    zen::persistent_map<int, int, bad_hash> c;
+    for (int i : zen::in(30))
+        c = c.set(i, i * i);
+    bool collided = c.size() == 30;
+    for (int i : zen::in(30))
+        collided = collided && c.at(i) == i * i;
+    ZEN_EXPECT(collided);
+    for (int i = 0; i < 30; i += 2)
+        c = c.erase(i);
+    ZEN_EXPECT(c.size() == 15 && !c.contains(4) && c.at(5) == 25);
+}
+
+void test_persistent_map_against_unordered_map()
+{
+    BEGIN_SUBTEST;
+
+    std::mt19937 rng(11);
+    zen::persistent_map<int, int>   m;
+    std::unordered_map<int, int>    u;
+    std::vector<zen::persistent_map<int, int>> snapshots;
+
+    for (int i : zen::in(30'000)) {
+        const int key = static_cast<int>(rng() % 5'000);
+        if (rng() % 4 == 0) {
+            m = m.erase(key);
+            u.erase(key);
+        } else {
+            m = m.set(key, i);
+            u[key] = i;
+        }
+        if (i == 10'000)
+            snapshots.push_back(m);
+    }
+
+    ZEN_EXPECT(m.size() == u.size());
+
+    bool same = true;
+    std::size_t iterated = 0;
+    for (const auto& [k, v] : m) {
+        same = same && u.count(k) && u.at(k) == v;
+        ++iterated;
+    }
+    ZEN_EXPECT(same && iterated == u.size());
+
+    // A builder makes the same changes in place
+    auto b = snapshots.front().transient();
+    for (int k : zen::in(5'000))
+        b.erase(k);
+    for (const auto& [k, v] : u)
+        b.set(k, v);
+    const auto rebuilt = b.persistent();
+    bool rebuilt_same = rebuilt.size() == u.size();
+    for (const auto& [k, v] : u)
+        rebuilt_same = rebuilt_same && rebuilt.at(k) == v;
+    ZEN_EXPECT(rebuilt_same);
+    ZEN_EXPECT(snapshots.front().size() > 0);
+}
+
+void test_atomic_version()
+{
+    BEGIN_SUBTEST;
+
+    // Readers always see a whole version: each one's keys add up to its "total"
+    zen::atomic_version<zen::persistent_map<int, int>> published;
+    std::atomic<bool> done = false;
+    std::atomic<int>  torn = 0;
+
+    std::thread reader([&] {
+        while (!done) {
+            const auto snapshot = published.load();
+            int sum = 0;
+            for (const auto& [k, v] : snapshot)
+                if (k != -1)
+                    sum += v;
+            if (snapshot.contains(-1) && snapshot.at(-1) != sum)
+                ++torn;
+        }
+    });
+
+    for (int i : zen::in(1, 500))
+        published.update([i](const auto& m) {
+            auto b = m.transient();
+            b.set(i % 50, i);
+            int sum = 0;
+            for (const auto& [k, v] : b.persistent())
+                if (k != -1)
+                    sum += v;
+            b.set(-1, sum);
+            return b.persistent();
+        });
+
+    done = true;
+    reader.join();
+
+    const auto last = published.load();
+    ZEN_EXPECT(torn == 0);
+    ZEN_EXPECT(last.size() == 51);
+
+    published.store({});
+    ZEN_EXPECT(published.load().is_empty());
+    ZEN_EXPECT(last.size() == 51);
+}
+
+void main_test_persistent()
+{
+    BEGIN_TEST;
+
+    test_persistent_vector_versions();
+    test_persistent_vector_growth();
+    test_persistent_vector_builder();
+    test_persistent_map_versions();
+    test_persistent_map_against_unordered_map();
+    test_atomic_version();
+}
@@ -0,0 +1,231 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <random>
+#include <vector>
+#include <map>
+
+#include "kaizen.h" // test using generated header: jump with the parachute you folded
+
+void test_radix_trie_basics()
+{
+    BEGIN_SUBTEST;
+
+    zen::radix_trie<int> t = { {"car", 1}, {"cart", 2}, {"dog", 3}, {"", 4} };
+
+    ZEN_EXPECT(t.size() == 4);
+    ZEN_EXPECT(t.contains("car"));
+    ZEN_EXPECT(t.contains("cart"));
+    ZEN_EXPECT(t.contains(""));
+    ZEN_EXPECT(!t.contains("ca"));
+    ZEN_EXPECT(!t.contains("carts"));
+    ZEN_EXPECT(t.at("dog") == 3);
+    ZEN_EXPECT(t.find("cart")->second == 2);
+    ZEN_EXPECT(t.find("do") == t.end());
+
+    bool threw = false;
+    try { (void)t.at("cat"); } catch (const std::out_of_range&) { threw = true; }
+    ZEN_EXPECT(threw);
+
+    const bool inserted_new = t.insert("cat", 5);
+    const bool inserted_old = t.insert("car", 9);
+    ZEN_EXPECT(inserted_new);
+    ZEN_EXPECT(!inserted_old);
+    ZEN_EXPECT(t.at("car") == 1);
+
+    t.insert_or_assign("car", 9);
+    ZEN_EXPECT(t.at("car") == 9);
+
+    t["cattle"] += 7;
+    ZEN_EXPECT(t.at("cattle") == 7);
+
+    // Iteration is in byte order, a key before the longer keys it's a prefix of
+    std::vector<std::string> keys;
+    for (const auto& [k, v] : t)
+        keys.push_back(k);
+    ZEN_EXPECT(keys == std::vector<std::string>({ "", "car", "cart", "cat", "cattle", "dog" }));
+
+    const std::size_t erased_once  = t.erase("car");
+    const std::size_t erased_twice = t.erase("car");
+    ZEN_EXPECT(erased_once == 1);
+    ZEN_EXPECT(erased_twice == 0);
+    ZEN_EXPECT(!t.contains("car"));
+    ZEN_EXPECT(t.contains("cart"));
+    ZEN_EXPECT(t.size() == 5);
+
+    zen::radix_trie<int> copy = t;
+    t.clear();
+    ZEN_EXPECT(t.is_empty());
+    ZEN_EXPECT(t.begin() == t.end());
+    ZEN_EXPECT(copy.size() == 5);
+    ZEN_EXPECT(copy.at("cattle") == 7);
+}
+
+void test_radix_trie_prefix()
+{
+    BEGIN_SUBTEST;
+
+    zen::radix_trie<int> t = { {"car", 1}, {"cart", 2}, {"carbon", 3}, {"cat", 4}, {"dog", 5} };
+
+    auto keys_of = [](const auto& range) {
+        std::vector<std::string> keys;
+        for (const auto& kv : range)
+            keys.push_back(kv.first);
+        return keys;
+    };
+
+    ZEN_EXPECT(keys_of(t.prefix("car")) == std::vector<std::string>({ "car", "carbon", "cart" }));
+    ZEN_EXPECT(keys_of(t.prefix("ca"))  == std::vector<std::string>({ "car", "carbon", "cart", "cat" }));
+    ZEN_EXPECT(keys_of(t.prefix("carb")) == std::vector<std::string>({ "carbon" }));
+    ZEN_EXPECT(keys_of(t.prefix("do"))  == std::vector<std::string>({ "dog" }));
+    ZEN_EXPECT(t.prefix("").size() == 5);
+    ZEN_EXPECT(t.prefix("cab").is_empty());
+    ZEN_EXPECT(t.prefix("carts").is_empty());
+    ZEN_EXPECT(t.prefix("x").is_empty());
+
+    // Values are writable through the range
+    for (auto& [k, v] : t.prefix("car"))
+        v *= 10;
+    ZEN_EXPECT(t.at("cart") == 20);
+    ZEN_EXPECT(t.at("cat")  == 4);
+
+    const zen::radix_trie<int>& ct = t;
+    ZEN_EXPECT(ct.prefix("ca").size() == 4);
+}
+
+void test_radix_trie_longest_prefix_match()
+{
+    BEGIN_SUBTEST;
+
+    // Routes as bit strings, the way a routing table matches addresses
+    zen::radix_trie<std::string> routes = {
+        {"",         "default"},
+        {"10",       "net-2"},
+        {"1011",     "net-11"},
+        {"10110010", "host-178"},
+    };
+
+    ZEN_EXPECT(routes.longest_prefix_match("10110010")->second == "host-178");
+    ZEN_EXPECT(routes.longest_prefix_match("10110011")->second == "net-11");
+    ZEN_EXPECT(routes.longest_prefix_match("1001")->second     == "net-2");
+    ZEN_EXPECT(routes.longest_prefix_match("0")->second        == "default");
+    ZEN_EXPECT(routes.longest_prefix_match("")->second         == "default");
+
+    routes.erase("");
+    ZEN_EXPECT(routes.longest_prefix_match("0") == routes.end());
+
+    // The iterator of the match continues in order
+    auto it = routes.longest_prefix_match("1011");
+    ++it;
+    ZEN_EXPECT(it->first == "10110010");
+}
+
+void test_radix_trie_node_growth()
+{
+    BEGIN_SUBTEST;
+
+    // One node going through every layout, up to all 256 bytes, and back down
+    zen::radix_trie<int> t;
+    for (int b = 255; b >= 0; --b)
+        t.insert(std::string("k") + static_cast<char>(b), b);
+    t.insert("k", -1);
+
+    ZEN_EXPECT(t.size() == 257);
+    int expected = -1;
+    bool ordered = true;
+    for (const auto& [k, v] : t)
+        ordered = ordered && v == expected++;
+    ZEN_EXPECT(ordered);
+
+    for (int b = 0; b < 256; b += 2)
+        t.erase(std::string("k") + static_cast<char>(b));
+    ZEN_EXPECT(t.size() == 129);
+
+    int found = 0;
+    for (int b = 0; b < 256; ++b)
+        found += t.contains(std::string("k") + static_cast<char>(b));
+    ZEN_EXPECT(found == 128);
+    ZEN_EXPECT(t.prefix("k").size() == 129);
+
+    for (int b = 1; b < 256; b += 2)
+        t.erase(std::string("k") + static_cast<char>(b));
+    ZEN_EXPECT(t.size() == 1);
+    ZEN_EXPECT(t.at("k") == -1);
+}
+
+void test_radix_trie_against_map()
+{
+    BEGIN_SUBTEST;
+
+    // Random keys over a small alphabet share plenty of prefixes
+    std::mt19937 rng(7);
+    auto random_key = [&] {
+        std::string key(rng() % 8, ' ');
+        for (char& c : key)
+            c = "abc\xff"[rng() % 4];
+        return key;
+    };
+
+    zen::radix_trie<int> t;
+    std::map<std::string, int> m;
+    for (int i = 0; i < 20'000; ++i) {
+        const std::string key = random_key();
+        if (rng() % 3 == 0) {
+            t.erase(key);
+            m.erase(key);
+        } else {
+            t.insert_or_assign(key, i);
+            m.insert_or_assign(key, i);
+        }
+    }
+
+    ZEN_EXPECT(t.size() == m.size());
+
+    // std::string compares as unsigned bytes, like the trie
+    bool same = std::equal(t.begin(), t.end(), m.begin(), m.end());
+    ZEN_EXPECT(same);
+
+    bool same_prefixes = true;
+    for (const std::string p : { "a", "ab", "c\xff", "bca", "\xff\xff" }) {
+        std::size_t expected = 0;
+        for (auto it = m.lower_bound(p); it != m.end() && it->first.starts_with(p); ++it)
+            ++expected;
+        same_prefixes = same_prefixes && t.prefix(p).size() == expected;
+    }
+    ZEN_EXPECT(same_prefixes);
+}
+
+void main_test_radix_trie()
+{
+    BEGIN_TEST;
+
+    test_radix_trie_basics();
+    test_radix_trie_prefix();
+    test_radix_trie_longest_prefix_match();
+    test_radix_trie_node_growth();
+    test_radix_trie_against_map();
+}
@@ -0,0 +1,113 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <numeric>
+#include <string>
+
+#include "kaizen.h" // test using generated header: jump with the parachute you folded
+
+void test_ring_deque_both_ends()
+{
+    BEGIN_SUBTEST;
+    zen::ring_deque<std::string> d;
+
+    d.push_back("b");
+    d.push_front("a");
+    d.emplace_back(2, 'c');
+    ZEN_EXPECT(d.size() == 3 && d.capacity() == 8);
+    ZEN_EXPECT(d.front() == "a" && d.back() == "cc" && d[1] == "b");
+    ZEN_EXPECT(d.contains("b") && !d.contains("x"));
+    ZEN_EXPECT(d.contains([](const std::string& s) { return s.size() == 2; }));
+    ZEN_EXPECT_THROW(d.at(3), std::out_of_range);
+
+    // Growing while the elements wrap around the end of the buffer
+    for (int i : zen::in(10))
+        d.push_front(std::to_string(i));
+    ZEN_EXPECT(d.size() == 13 && d.capacity() == 16);
+    ZEN_EXPECT(d.front() == "9" && d[9] == "0" && d[10] == "a" && d.back() == "cc");
+
+    d.pop_front();
+    d.pop_back();
+    ZEN_EXPECT(d.front() == "8" && d.back() == "b");
+
+    auto copy = d;
+    d.clear();
+    ZEN_EXPECT(d.is_empty() && copy.size() == 11 && copy[10] == "b");
+
+    copy.shrink_to_fit();
+    ZEN_EXPECT(copy.capacity() == 16 && copy.front() == "8");
+}
+
+void test_ring_deque_segments()
+{
+    BEGIN_SUBTEST;
+    zen::ring_deque<int> d;
+    d.reserve(8);
+
+    for (int i : zen::in(1, 7)) // 1..6
+        d.push_back(i);
+    for (int i : zen::in(4))
+        d.pop_front(), (void) i;
+    for (int i : zen::in(7, 11)) // 7..10, wrapping around
+        d.push_back(i);
+
+    const auto [head, tail] = d.segments();
+    ZEN_EXPECT(head.size() == 4 && tail.size() == 2);
+    ZEN_EXPECT(head[0] == 5 && tail[1] == 10);
+
+    const int sum = std::accumulate(head.begin(), head.end(), 0) + std::accumulate(tail.begin(), tail.end(), 0);
+    ZEN_EXPECT(sum == 5 + 6 + 7 + 8 + 9 + 10);
+
+    // Iterators go straight across the seam
+    ZEN_EXPECT(std::is_sorted(d.begin(), d.end()) && d.end() - d.begin() == 6);
+    ZEN_EXPECT(*(d.begin() + 5) == 10 && *d.rbegin() == 10);
+    ZEN_EXPECT(*std::lower_bound(d.begin(), d.end(), 8) == 8);
+}
+
+void test_ring_deque_as_queue_and_stack()
+{
+    BEGIN_SUBTEST;
+    zen::ring_queue<int> q;
+    zen::ring_stack<int> s;
+    for (int i : zen::in(100)) {
+        q.push(i);
+        s.push(i);
+    }
+    ZEN_EXPECT(q.front() == 0 && q.back() == 99 && s.top() == 99);
+
+    q.pop();
+    s.pop();
+    ZEN_EXPECT(q.front() == 1 && s.top() == 98 && q.size() == 99 && !s.is_empty());
+
+    ZEN_STATIC_ASSERT((std::is_same_v<zen::ring_queue<int>, zen::queue<int, zen::ring_deque<int>>>), "zen::ring_queue MUST BE A zen::queue");
+}
+
+void main_test_ring_deque()
+{
+    BEGIN_TEST;
+    test_ring_deque_both_ends();
+    test_ring_deque_segments();
+    test_ring_deque_as_queue_and_stack();
+}
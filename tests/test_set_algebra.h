@@ -0,0 +1,196 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <iterator>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <span>
+
+#include "kaizen.h" // test using generated header: jump with the parachute you folded
+
+// n distinct sorted values drawn from [0, universe)
+template<class T>
+std::vector<T> set_algebra_sample(std::mt19937& rng, std::size_t n, std::size_t universe)
+{
+    std::vector<T> v;
+    std::uniform_int_distribution<std::size_t> d(0, universe - 1);
+    for (std::size_t i = 0; i != n; ++i)
+        v.push_back(static_cast<T>(d(rng)));
+    std::sort(v.begin(), v.end());
+    v.erase(std::unique(v.begin(), v.end()), v.end());
+    return v;
+}
+
+// Checks all three operations and their counts against the std algorithms
+template<class T>
+bool set_algebra_matches_std(const std::vector<T>& a, const std::vector<T>& b)
+{
+    std::vector<T> expected, out;
+
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+    out.assign(std::min(a.size(), b.size()), T(0));
+    out.resize(zen::intersect(a, b, out));
+    bool ok = out == expected && zen::intersect_count(a, b) == expected.size();
+
+    expected.clear();
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+    out.assign(a.size() + b.size(), T(0));
+    out.resize(zen::unite(a, b, out));
+    ok = ok && out == expected && zen::unite_count(a, b) == expected.size();
+
+    expected.clear();
+    std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+    out.assign(a.size(), T(0));
+    out.resize(zen::difference(a, b, out));
+    ok = ok && out == expected && zen::difference_count(a, b) == expected.size();
+
+    return ok;
+}
+
+template<class T>
+bool set_algebra_matches_std_on_random(std::mt19937& rng)
+{
+    // Balanced sizes go through the merges (and SSE2 blocks),
+    // skewed ones through galloping, both ways round
+    const std::size_t sizes[][2] = { {0, 0}, {0, 9}, {1, 1}, {3, 5}, {17, 19}, {100, 120},
+                                     {1000, 900}, {2, 1000}, {1000, 3}, {40, 5000} };
+    bool ok = true;
+    for (const auto& [na, nb] : sizes) {
+        for (const std::size_t universe : { std::size_t(10), (na + nb) * 2 + 1, std::size_t(100'000) }) {
+            const auto a = set_algebra_sample<T>(rng, na, universe);
+            const auto b = set_algebra_sample<T>(rng, nb, universe);
+            ok = ok && set_algebra_matches_std(a, b) && set_algebra_matches_std(b, a) && set_algebra_matches_std(a, a);
+        }
+    }
+    return ok;
+}
+
+void test_set_algebra_basic()
+{
+    BEGIN_SUBTEST;
+
+    const zen::ints a = { 1, 3, 5, 7, 9, 11, 13, 15 };
+    const zen::ints b = { 3, 4, 5, 6, 7, 15, 16 };
+
+    zen::ints out(7);
+    out.resize(zen::intersect(a, b, out));
+    ZEN_EXPECT(out == zen::ints({ 3, 5, 7, 15 }));
+
+    out.assign(15, 0);
+    out.resize(zen::unite(a, b, out));
+    ZEN_EXPECT(out == zen::ints({ 1, 3, 4, 5, 6, 7, 9, 11, 13, 15, 16 }));
+
+    out.assign(8, 0);
+    out.resize(zen::difference(a, b, out));
+    ZEN_EXPECT(out == zen::ints({ 1, 9, 11, 13 }));
+
+    ZEN_EXPECT(zen::intersect_count(a, b)  == 4);
+    ZEN_EXPECT(zen::unite_count(a, b)      == 11);
+    ZEN_EXPECT(zen::difference_count(a, b) == 4);
+    ZEN_EXPECT(zen::difference_count(b, a) == 3);
+
+    // Any contiguous output will do, and the values past the result are left alone
+    int raw[10] = {};
+    std::fill(std::begin(raw), std::end(raw), -1);
+    const std::size_t n = zen::intersect(std::span<const int>(a), b, std::span<int>(raw));
+    ZEN_EXPECT(n == 4 && raw[0] == 3 && raw[3] == 15 && raw[7] == -1);
+
+    // The output has to have room for the largest possible result
+    zen::ints small(6);
+    ZEN_EXPECT_THROW(zen::intersect(a, b, small),  std::invalid_argument);
+    ZEN_EXPECT_THROW(zen::unite(a, b, small),      std::invalid_argument);
+    ZEN_EXPECT_THROW(zen::difference(a, b, small), std::invalid_argument);
+}
+
+void test_set_algebra_against_std()
+{
+    BEGIN_SUBTEST;
+
+    std::mt19937 rng(5);
+    ZEN_EXPECT(set_algebra_matches_std_on_random<int>(rng));
+    ZEN_EXPECT(set_algebra_matches_std_on_random<unsigned>(rng));
+    ZEN_EXPECT(set_algebra_matches_std_on_random<std::int64_t>(rng));
+    ZEN_EXPECT(set_algebra_matches_std_on_random<std::uint16_t>(rng));
+
+    // Signed values, including the extremes, compare as signed in the SSE2 blocks
+    const std::vector<int> a = { INT32_MIN, -7, -5, -3, -1, 0, 2, 4, 6, INT32_MAX };
+    const std::vector<int> b = { INT32_MIN, -6, -5, -1, 1, 2, 3, 5, 6, 7, 8, INT32_MAX };
+    ZEN_EXPECT(set_algebra_matches_std(a, b));
+    ZEN_EXPECT(set_algebra_matches_std(b, a));
+}
+
+void test_set_algebra_sets()
+{
+    BEGIN_SUBTEST;
+
+    const zen::flat_set<int> a = { 9, 1, 5, 3, 7 };
+    const zen::flat_set<int> b = { 4, 3, 5 };
+
+    ZEN_EXPECT(zen::intersect(a, b)  == zen::flat_set<int>({ 3, 5 }));
+    ZEN_EXPECT(zen::unite(a, b)      == zen::flat_set<int>({ 1, 3, 4, 5, 7, 9 }));
+    ZEN_EXPECT(zen::difference(a, b) == zen::flat_set<int>({ 1, 7, 9 }));
+    ZEN_EXPECT(zen::intersect_count(a, b) == 2);
+
+    const zen::set<int> c = { 9, 1, 5, 3, 7 };
+    const zen::set<int> d = { 4, 3, 5 };
+
+    ZEN_EXPECT(zen::intersect(c, d)  == zen::set<int>({ 3, 5 }));
+    ZEN_EXPECT(zen::unite(c, d)      == zen::set<int>({ 1, 3, 4, 5, 7, 9 }));
+    ZEN_EXPECT(zen::difference(c, d) == zen::set<int>({ 1, 7, 9 }));
+    ZEN_EXPECT(zen::intersect_count(c, d)  == 2);
+    ZEN_EXPECT(zen::unite_count(c, d)      == 6);
+    ZEN_EXPECT(zen::difference_count(c, d) == 3);
+
+    // Skewed sizes take the lookup paths
+    zen::set<int> big;
+    for (int i = 0; i != 1000; ++i)
+        big.insert(i * 2);
+    const zen::set<int> few = { -1, 4, 5, 1998, 3000 };
+    ZEN_EXPECT(zen::intersect(few, big)  == zen::set<int>({ 4, 1998 }));
+    ZEN_EXPECT(zen::intersect_count(big, few) == 2);
+    ZEN_EXPECT(zen::unite(big, few).size() == 1003);
+    ZEN_EXPECT(zen::difference(few, big) == zen::set<int>({ -1, 5, 3000 }));
+    ZEN_EXPECT(zen::difference(big, few).size() == 998);
+
+    // Results can be built from a sorted sequence without sorting it again
+    std::vector<int> sorted = { 1, 2, 3 }, unsorted = { 1, 3, 2 }, repeated = { 1, 2, 2 };
+    const zen::flat_set<int> adopted(zen::presorted{}, std::move(sorted));
+    ZEN_EXPECT(adopted == zen::flat_set<int>({ 1, 2, 3 }));
+    ZEN_EXPECT_THROW(zen::flat_set<int>(zen::presorted{}, std::move(unsorted)), std::invalid_argument);
+    ZEN_EXPECT_THROW(zen::flat_set<int>(zen::presorted{}, std::move(repeated)), std::invalid_argument);
+}
+
+void main_test_set_algebra()
+{
+    BEGIN_TEST;
+
+    test_set_algebra_basic();
+    test_set_algebra_against_std();
+    test_set_algebra_sets();
+}
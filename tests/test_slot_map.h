@@ -0,0 +1,146 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <unordered_map>
+#include <stdexcept>
+#include <numeric>
+#include <string>
+#include <random>
+#include <vector>
+
+#include "kaizen.h" // test using generated header: jump with the parachute you folded
+
+void test_slot_map_handles()
+{
+    BEGIN_SUBTEST;
+
+    zen::slot_map<std::string> names;
+    ZEN_EXPECT(names.is_empty());
+
+    const auto ada   = names.insert("Ada");
+    const auto alan  = names.insert("Alan");
+    const auto grace = names.emplace(5, 'G');
+    ZEN_EXPECT(names.size() == 3);
+    ZEN_EXPECT(names[grace] == "GGGGG");
+
+    names[ada] += " Lovelace";
+    ZEN_EXPECT(names.at(ada) == "Ada Lovelace");
+
+    // Erasing one element leaves the others' handles valid
+    const bool erased_once  = names.erase(alan);
+    const bool erased_twice = names.erase(alan);
+    ZEN_EXPECT(erased_once && !erased_twice);
+    ZEN_EXPECT(!names.contains(alan) && names.find(alan) == nullptr);
+    ZEN_EXPECT(names.at(ada) == "Ada Lovelace" && names.at(grace) == "GGGGG");
+
+    // The freed slot is reused, but the stale handle doesn't name the new element
+    const auto edsger = names.insert("Edsger");
+    ZEN_EXPECT(edsger != alan);
+    ZEN_EXPECT(!names.contains(alan) && names.contains(edsger));
+
+    bool threw = false;
+    try { (void)names.at(alan); } catch (const std::out_of_range&) { threw = true; }
+    ZEN_EXPECT(threw);
+    ZEN_EXPECT(!names.contains(zen::slot_map<std::string>::handle()));
+
+    // Iteration is over the dense elements, and each knows its handle
+    std::size_t length = 0;
+    for (const auto& s : names)
+        length += s.size();
+    ZEN_EXPECT(length == 12 + 5 + 6);
+    ZEN_EXPECT(names.handle_of(names.begin()) == ada);
+    ZEN_EXPECT(names.handle_at(names.size() - 1) == edsger);
+
+    names.clear();
+    ZEN_EXPECT(names.is_empty() && !names.contains(ada) && !names.contains(edsger));
+}
+
+void test_slot_map_erase_if()
+{
+    BEGIN_SUBTEST;
+
+    zen::slot_map<int> m;
+    std::vector<zen::slot_map<int>::handle> handles;
+    for (int i = 0; i < 100; ++i)
+        handles.push_back(m.insert(i));
+
+    const auto erased = m.erase_if([](int x) { return x % 3 == 0; });
+    ZEN_EXPECT(erased == 34 && m.size() == 66);
+
+    bool consistent = true;
+    for (int i = 0; i < 100; ++i)
+        consistent = consistent && (m.contains(handles[i]) == (i % 3 != 0)) && (i % 3 == 0 || m[handles[i]] == i);
+    ZEN_EXPECT(consistent);
+
+    const int sum   = std::accumulate(m.values().begin(), m.values().end(), 0);
+    const int first = *m.begin();
+    auto it = m.erase(m.begin());
+    ZEN_EXPECT(m.size() == 65 && it == m.begin());
+    ZEN_EXPECT(sum == 99 * 100 / 2 - 3 * (33 * 34 / 2));
+    ZEN_EXPECT(std::accumulate(m.values().begin(), m.values().end(), 0) == sum - first);
+}
+
+void test_slot_map_against_unordered_map()
+{
+    BEGIN_SUBTEST;
+
+    using handle = zen::slot_map<int>::handle;
+
+    std::mt19937 rng(3);
+    zen::slot_map<int> m;
+    std::vector<std::pair<handle, int>> live;   // handles and the values they should find
+    std::vector<handle>                 stale;
+
+    for (int i = 0; i < 20'000; ++i) {
+        if (!live.empty() && rng() % 3 == 0) {
+            const std::size_t k = rng() % live.size();
+            m.erase(live[k].first);
+            stale.push_back(live[k].first);
+            live[k] = live.back();
+            live.pop_back();
+        } else {
+            live.push_back({ m.insert(i), i });
+        }
+    }
+
+    bool live_ok = m.size() == live.size();
+    for (const auto& [h, v] : live)
+        live_ok = live_ok && m.contains(h) && m[h] == v;
+    ZEN_EXPECT(live_ok);
+
+    bool stale_ok = true;
+    for (const auto& h : stale)
+        stale_ok = stale_ok && !m.contains(h);
+    ZEN_EXPECT(stale_ok);
+}
+
+void main_test_slot_map()
+{
+    BEGIN_TEST;
+
+    test_slot_map_handles();
+    test_slot_map_erase_if();
+    test_slot_map_against_unordered_map();
+}
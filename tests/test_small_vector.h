@@ -0,0 +1,161 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <string>
+#include <memory>
+
+#include "kaizen.h" // test using generated header: jump with the parachute you folded
+
+// Counts the heap allocations made through it
+template<class T>
+struct counting_allocator : std::allocator<T> {
+    using value_type = T;
+    template<class U> struct rebind { using other = counting_allocator<U>; };
+
+    inline static int allocations = 0;
+
+    counting_allocator() = default;
+    template<class U> counting_allocator(const counting_allocator<U>&) {}
+
+    T* allocate(size_t n) { ++allocations; return std::allocator<T>().allocate(n); }
+    void deallocate(T* p, size_t n) { std::allocator<T>().deallocate(p, n); }
+
+    friend bool operator==(const counting_allocator&, const counting_allocator&) { return true; }
+};
+
+// Allocators with different ids don't free each other's memory and aren't propagated on moves
+template<class T>
+struct stateful_allocator : std::allocator<T> {
+    using propagate_on_container_move_assignment = std::false_type;
+    using is_always_equal                        = std::false_type;
+    template<class U> struct rebind { using other = stateful_allocator<U>; };
+
+    int id = 0;
+
+    stateful_allocator(int id = 0) : id(id) {}
+    template<class U> stateful_allocator(const stateful_allocator<U>& o) : id(o.id) {}
+
+    friend bool operator==(const stateful_allocator& a, const stateful_allocator& b) { return a.id == b.id; }
+};
+
+void test_small_vector_inline_and_spilled()
+{
+    BEGIN_SUBTEST;
+    using allocator = counting_allocator<int>;
+    allocator::allocations = 0;
+
+    zen::small_vector<int, 4, allocator> v = { 1, 2, 3 };
+    v.push_back(4);
+    ZEN_EXPECT(v.is_inline() && v.capacity() == 4);
+    ZEN_EXPECT(allocator::allocations == 0);
+
+    v.push_back(5); // spills to the heap
+    ZEN_EXPECT(!v.is_inline() && v.capacity() >= 5);
+    ZEN_EXPECT(allocator::allocations == 1);
+    ZEN_EXPECT((v == zen::small_vector<int, 4, allocator>{ 1, 2, 3, 4, 5 }));
+
+    v.erase(v.begin(), v.begin() + 2);
+    v.shrink_to_fit(); // back inline
+    ZEN_EXPECT(v.is_inline() && v.size() == 3 && v.front() == 3 && v.back() == 5);
+
+    ZEN_EXPECT(v.contains(4) && !v.contains(1));
+    ZEN_EXPECT(v.contains([](int x) { return x > 4; }));
+    ZEN_EXPECT_THROW(v.at(3), std::out_of_range);
+}
+
+void test_small_vector_modifiers()
+{
+    BEGIN_SUBTEST;
+    zen::small_vector<std::string, 2> v;
+
+    v.emplace_back(3, 'a');
+    v.insert(v.begin(), "b");
+    v.insert(v.begin() + 1, 2, "c"); // spills
+    ZEN_EXPECT((v == zen::small_vector<std::string, 2>{ "b", "c", "c", "aaa" }));
+
+    const std::string more[] = { "x", "y" };
+    v.insert(v.end(), std::begin(more), std::end(more));
+    v.erase(v.begin() + 1);
+    ZEN_EXPECT((v == zen::small_vector<std::string, 2>{ "b", "c", "aaa", "x", "y" }));
+
+    v.push_back(v[0]); // an element of the vector itself, maybe while growing
+    ZEN_EXPECT(v.back() == "b" && v.size() == 6);
+
+    v.resize(2);
+    v.resize(4, "z");
+    ZEN_EXPECT((v == zen::small_vector<std::string, 2>{ "b", "c", "z", "z" }));
+
+    v.pop_back();
+    ZEN_EXPECT(v.size() == 3 && !v.is_empty());
+    v.clear();
+    ZEN_EXPECT(v.is_empty());
+}
+
+void test_small_vector_moves()
+{
+    BEGIN_SUBTEST;
+
+    // Inline elements are moved one by one
+    zen::small_vector<std::unique_ptr<int>, 2> a;
+    a.push_back(std::make_unique<int>(1));
+    auto b = std::move(a);
+    ZEN_EXPECT(a.is_empty() && b.size() == 1 && *b[0] == 1);
+
+    // Spilled elements are not moved at all, the buffer changes hands
+    b.push_back(std::make_unique<int>(2));
+    b.push_back(std::make_unique<int>(3));
+    const int* second = b[1].get();
+    const auto* buffer = b.data();
+    zen::small_vector<std::unique_ptr<int>, 2> c;
+    c = std::move(b);
+    ZEN_EXPECT(c.data() == buffer && c[1].get() == second);
+    ZEN_EXPECT(b.is_empty() && b.is_inline());
+
+    // With allocators that stay put and may differ, a move may allocate, so it may throw
+    using stateful = zen::small_vector<int, 2, stateful_allocator<int>>;
+    ZEN_STATIC_ASSERT(!std::is_nothrow_move_assignable_v<stateful>, "zen::small_vector MOVE MAY ALLOCATE");
+    ZEN_STATIC_ASSERT((std::is_nothrow_move_assignable_v<zen::small_vector<int, 2>>), "zen::small_vector MOVE MUST BE NOEXCEPT");
+    stateful d({ 1, 2, 3 }, stateful_allocator<int>(1));
+    stateful e(stateful_allocator<int>(2));
+    e = std::move(d);
+    ZEN_EXPECT(e.size() == 3 && e[2] == 3 && e.get_allocator().id == 2 && d.is_empty());
+
+    // Copies of inline and spilled vectors
+    zen::small_vector<std::string, 1> s = { "a", "b" };
+    zen::small_vector<std::string, 1> t = { "c" };
+    auto s2 = s;
+    auto t2 = t;
+    s2.swap(t2);
+    ZEN_EXPECT(s2 == t && t2 == s && s2.is_inline());
+    ZEN_EXPECT(s < t && !(t < s));
+}
+
+void main_test_small_vector()
+{
+    BEGIN_TEST;
+    test_small_vector_inline_and_spilled();
+    test_small_vector_modifiers();
+    test_small_vector_moves();
+}
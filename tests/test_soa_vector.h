@@ -0,0 +1,186 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <stdexcept>
+#include <numeric>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <tuple>
+
+#include "kaizen.h" // test using generated header: jump with the parachute you folded
+
+void test_soa_vector_rows()
+{
+    BEGIN_SUBTEST;
+
+    zen::soa_vector<int, double, std::string> v;
+    ZEN_EXPECT(v.is_empty());
+
+    v.push_back(7, 2.5, "seven");
+    v.emplace_back(3, 1.5, "three");
+    v.push_back(std::tuple<int, double, std::string>(5, 9.0, "five"));
+    ZEN_EXPECT(v.size() == 3);
+
+    // Rows bind like structs and write through to the columns
+    auto [id, price, name] = v[1];
+    ZEN_EXPECT(id == 3 && price == 1.5 && name == "three");
+    price = 4.0;
+    ZEN_EXPECT(v.column<1>()[1] == 4.0);
+
+    for (auto [i, p, n] : v)
+        p *= 2;
+    ZEN_EXPECT(v.column<1>()[0] == 5.0 && v.column<1>()[2] == 18.0);
+
+    v[2] = std::make_tuple(6, 0.5, std::string("six"));
+    ZEN_EXPECT(std::get<2>(v.back()) == "six");
+    ZEN_EXPECT(std::get<0>(v.front()) == 7);
+
+    bool threw = false;
+    try { (void)v.at(3); } catch (const std::out_of_range&) { threw = true; }
+    ZEN_EXPECT(threw);
+
+    // Copies are deep, and rows of one go into another
+    const auto copy = v;
+    v.pop_back();
+    ZEN_EXPECT(copy.size() == 3 && v.size() == 2);
+    v.push_back(copy[2]);
+    ZEN_EXPECT(v == copy);
+}
+
+void test_soa_vector_columns()
+{
+    BEGIN_SUBTEST;
+
+    zen::soa_vector<std::int64_t, float> v;
+    for (int i = 0; i < 1'000; ++i)
+        v.push_back(i, i * 0.5f);
+
+    // Each column is a span aligned to a cache line
+    const auto ids    = v.column<0>();
+    const auto values = v.column<1>();
+    ZEN_EXPECT(ids.size() == 1'000 && values.size() == 1'000);
+    ZEN_EXPECT(reinterpret_cast<std::uintptr_t>(ids.data())    % 64 == 0);
+    ZEN_EXPECT(reinterpret_cast<std::uintptr_t>(values.data()) % 64 == 0);
+    ZEN_EXPECT(std::accumulate(ids.begin(), ids.end(), std::int64_t{ 0 }) == 999 * 1'000 / 2);
+
+    v.reserve(5'000);
+    ZEN_EXPECT(v.capacity() >= 5'000 && v.column<0>()[999] == 999);
+    v.shrink_to_fit();
+    ZEN_EXPECT(v.capacity() == 1'000);
+
+    const auto& cv = v;
+    ZEN_EXPECT(cv.column<1>()[10] == 5.0f);
+}
+
+void test_soa_vector_erase_and_sort()
+{
+    BEGIN_SUBTEST;
+
+    zen::soa_vector<int, std::string> v = { {4, "d"}, {1, "a"}, {3, "c"}, {2, "b"}, {5, "e"} };
+
+    v.sort_by<0>();
+    std::string names;
+    for (auto [i, s] : v)
+        names += s;
+    ZEN_EXPECT(names == "abcde");
+
+    v.sort_by<1>(std::greater<>());
+    ZEN_EXPECT(std::get<0>(v[0]) == 5 && std::get<1>(v[4]) == "a");
+
+    v.sort([](const auto& a, const auto& b) { return std::get<0>(a) % 2 < std::get<0>(b) % 2 || (std::get<0>(a) % 2 == std::get<0>(b) % 2 && std::get<0>(a) < std::get<0>(b)); });
+    ZEN_EXPECT(v.column<0>()[0] == 2 && v.column<0>()[1] == 4 && v.column<0>()[2] == 1);
+
+    // Erasing moves every column down together
+    auto it = v.erase(v.begin() + 1);
+    ZEN_EXPECT(std::get<1>(*it) == "a");
+    v.erase(v.begin(), v.begin() + 2);
+    ZEN_EXPECT(v.size() == 2);
+    ZEN_EXPECT(std::get<1>(v[0]) == "c" && std::get<1>(v[1]) == "e");
+    ZEN_EXPECT(v.end() - v.begin() == 2);
+
+    v.clear();
+    ZEN_EXPECT(v.is_empty() && v.begin() == v.end());
+}
+
+// Counts its live instances and throws on the copy that exhausts the budget
+struct soa_fragile {
+    static inline int live   = 0;
+    static inline int budget = -1; // unlimited
+    int x = 0;
+
+    soa_fragile(int x = 0) : x(x) { ++live; }
+    soa_fragile(const soa_fragile& o) : x(o.x)
+    {
+        if (budget == 0)
+            throw std::runtime_error("soa_fragile BUDGET EXHAUSTED");
+        --budget;
+        ++live;
+    }
+    soa_fragile(soa_fragile&& o) : soa_fragile(static_cast<const soa_fragile&>(o)) {} // may throw, so reallocation copies
+    soa_fragile& operator=(const soa_fragile&) = default;
+    ~soa_fragile() { --live; }
+};
+
+void test_soa_vector_exceptions()
+{
+    BEGIN_SUBTEST;
+
+    {
+        zen::soa_vector<soa_fragile, std::string, soa_fragile> v;
+        for (int i : zen::in(20))
+            v.emplace_back(i, std::to_string(i), -i);
+
+        // Copying throws in the third column, after the first two are built
+        soa_fragile::budget = 30;
+        ZEN_EXPECT_THROW(auto copy = v, std::runtime_error);
+        soa_fragile::budget = -1;
+        ZEN_EXPECT(soa_fragile::live == 40);
+
+        // Growing throws halfway through, and the old columns stay as they were
+        soa_fragile::budget = 25;
+        ZEN_EXPECT_THROW(v.reserve(100), std::runtime_error);
+        soa_fragile::budget = -1;
+        ZEN_EXPECT(soa_fragile::live == 40 && v.size() == 20 && v.capacity() < 100);
+        ZEN_EXPECT(std::get<2>(v[19]).x == -19 && std::get<1>(v[19]) == "19");
+
+        // Sorting throws in the last column
+        soa_fragile::budget = 30;
+        ZEN_EXPECT_THROW(v.sort_by<1>(), std::runtime_error);
+        soa_fragile::budget = -1;
+        ZEN_EXPECT(soa_fragile::live == 40 && v.size() == 20);
+    }
+    ZEN_EXPECT(soa_fragile::live == 0);
+}
+
+void main_test_soa_vector()
+{
+    BEGIN_TEST;
+
+    test_soa_vector_rows();
+    test_soa_vector_columns();
+    test_soa_vector_erase_and_sort();
+    test_soa_vector_exceptions();
+}
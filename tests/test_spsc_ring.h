@@ -0,0 +1,207 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <memory>
+#include <thread>
+#include <vector>
+#include <array>
+
+#include "kaizen.h" // test using generated header: jump with the parachute you folded
+
+void test_spsc_ring_single_thread()
+{
+    BEGIN_SUBTEST;
+    zen::spsc_ring<std::string, 4> r;
+
+    ZEN_EXPECT(r.capacity() == 4 && r.is_empty());
+
+    const bool pushed = r.try_push("a") && r.try_push("b") && r.try_push("c") && r.try_push("d");
+    const bool full   = !r.try_push("e");
+    ZEN_EXPECT(pushed && full && r.size() == 4);
+
+    std::string s1, s2;
+    const bool popped = r.try_pop(s1) && r.try_pop(s2);
+    ZEN_EXPECT(popped && s1 == "a" && s2 == "b");
+
+    // Wrapping around the end of the ring
+    const bool wrapped = r.try_push("e") && r.try_push("f");
+    ZEN_EXPECT(wrapped && r.size() == 4);
+
+    std::string out[4];
+    const auto n = r.try_pop_bulk(out);
+    ZEN_EXPECT(n == 4 && out[0] == "c" && out[3] == "f");
+
+    const bool empty = !r.try_pop(s1);
+    ZEN_EXPECT(empty && r.is_empty());
+}
+
+void test_spsc_ring_bulk()
+{
+    BEGIN_SUBTEST;
+    zen::spsc_ring<int, 8> r;
+
+    const std::vector<int> v = { 1, 2, 3, 4, 5, 6 };
+    const auto pushed1 = r.try_push_bulk(v);
+    ZEN_EXPECT(pushed1 == 6);
+
+    int out[4] = {};
+    const auto popped1 = r.try_pop_bulk(out);
+    ZEN_EXPECT(popped1 == 4 && out[0] == 1 && out[3] == 4);
+
+    // 2 of the 8 slots are used, and the free ones wrap around the end
+    const auto pushed2 = r.try_push_bulk(v);
+    ZEN_EXPECT(pushed2 == 6 && r.size() == 8);
+
+    std::vector<int> rest(10);
+    const auto popped2 = r.try_pop_bulk(rest);
+    ZEN_EXPECT(popped2 == 8);
+    ZEN_EXPECT(std::vector<int>(rest.begin(), rest.begin() + 8) == std::vector<int>({ 5, 6, 1, 2, 3, 4, 5, 6 }));
+}
+
+void test_spsc_ring_in_place()
+{
+    BEGIN_SUBTEST;
+    zen::spsc_ring<int, 8> r;
+
+    // Writing straight into the ring
+    auto slots = r.reserve(5);
+    ZEN_EXPECT(slots.size() == 5 && r.is_empty()); // nothing is visible before commit()
+    for (size_t i = 0; i < slots.size(); ++i)
+        slots[i] = static_cast<int>(i * 10);
+    r.commit(3);
+    ZEN_EXPECT(r.size() == 3);
+    ZEN_EXPECT_THROW(r.commit(3), std::out_of_range); // only 2 reserved slots left
+
+    // Reading straight from the ring
+    auto elements = r.peek();
+    ZEN_EXPECT(elements.size() == 3 && elements[2] == 20);
+    r.consume(2);
+    ZEN_EXPECT(r.size() == 1 && r.peek()[0] == 20);
+    ZEN_EXPECT_THROW(r.consume(2), std::out_of_range);
+
+    // Contiguous regions stop at the end of the ring
+    r.commit(0);
+    auto tail = r.reserve();
+    ZEN_EXPECT(tail.size() == 5); // slots 3..7
+    r.commit(5);
+    auto head = r.reserve();
+    ZEN_EXPECT(head.size() == 2); // slots 0..1, since slot 2 still holds an element
+}
+
+void test_spsc_ring_lifetimes()
+{
+    BEGIN_SUBTEST;
+
+    // The slots are on the heap, so a 16 MB ring is fine on the stack
+    zen::spsc_ring<std::array<char, 256>, 1 << 16> big;
+    const bool pushed_big = big.try_push(std::array<char, 256>{ 'x' });
+    ZEN_EXPECT(pushed_big && big.size() == 1);
+
+    // Elements are released as soon as they leave the ring
+    const auto token = std::make_shared<int>(7);
+    zen::spsc_ring<std::shared_ptr<int>, 4> r;
+    const bool pushed = r.try_push(token) && r.try_push(token) && r.try_push(token);
+    ZEN_EXPECT(pushed && token.use_count() == 4);
+
+    std::shared_ptr<int> p;
+    const bool popped = r.try_pop(p);
+    p.reset();
+    ZEN_EXPECT(popped && token.use_count() == 3);
+
+    r.consume(r.peek(1).size());
+    ZEN_EXPECT(token.use_count() == 2);
+
+    // Reserved slots that are never committed are dropped by the next push
+    auto slots = r.reserve(1);
+    slots[0] = token;
+    ZEN_EXPECT(slots.size() == 1 && token.use_count() == 3);
+    const bool pushed_again = r.try_push(nullptr);
+    ZEN_EXPECT(pushed_again && token.use_count() == 2 && r.size() == 2);
+
+    // Elements don't have to be default constructible unless slots are reserved
+    struct no_default {
+        explicit no_default(int x) : x(x) {}
+        int x;
+    };
+    zen::spsc_ring<no_default, 2> nd;
+    no_default out(0);
+    const bool moved = nd.try_push(no_default(5)) && nd.try_pop(out);
+    ZEN_EXPECT(moved && out.x == 5);
+}
+
+void test_spsc_ring_two_threads()
+{
+    BEGIN_SUBTEST;
+    zen::spsc_ring<int, 64> r;
+    const int N = 100'000;
+
+    std::thread producer([&r] {
+        std::vector<int> batch;
+        for (int i = 1; i <= N; ) {
+            if (i % 3 == 0) { // single pushes, batches and in-place writes take turns
+                while (!r.try_push(i)) std::this_thread::yield();
+                ++i;
+            } else if (i % 3 == 1) {
+                batch.clear();
+                for (int j = i; j < i + 10 && j <= N; ++j) batch.push_back(j);
+                const auto n = r.try_push_bulk(batch);
+                if (n == 0) std::this_thread::yield();
+                i += static_cast<int>(n);
+            } else {
+                auto slots = r.reserve(1);
+                if (slots.empty()) { std::this_thread::yield(); continue; }
+                slots[0] = i++;
+                r.commit(1);
+            }
+        }
+    });
+
+    long long sum = 0;
+    int  expected = 1;
+    bool ordered  = true;
+    std::vector<int> batch(7);
+    while (expected <= N) {
+        const auto n = r.try_pop_bulk(batch);
+        if (n == 0) std::this_thread::yield();
+        for (size_t i = 0; i < n; ++i) {
+            ordered = ordered && batch[i] == expected++;
+            sum += batch[i];
+        }
+    }
+    producer.join();
+
+    ZEN_EXPECT(ordered);
+    ZEN_EXPECT(sum == N * (N + 1LL) / 2);
+}
+
+void main_test_spsc_ring()
+{
+    BEGIN_TEST;
+    test_spsc_ring_single_thread();
+    test_spsc_ring_bulk();
+    test_spsc_ring_in_place();
+    test_spsc_ring_lifetimes();
+    test_spsc_ring_two_threads();
+}
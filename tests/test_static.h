@@ -0,0 +1,144 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <string>
+#include <memory>
+
+#include "kaizen.h" // test using generated header: jump with the parachute you folded
+
+// Everything with trivial elements works at compile time
+constexpr int static_containers_at_compile_time()
+{
+    zen::static_vector<int, 4> v = { 3, 1, 2 };
+    v.insert(v.begin(), 0);
+    v.erase(v.begin() + 1);
+
+    zen::static_deque<int, 3> d;
+    d.push_back(2);
+    d.push_front(1);
+    d.pop_back();
+    d.push_back(5);
+    d.push_back(7);
+
+    zen::static_string<8> s = "ab";
+    s += "cd";
+
+    return v[0] + v[1] + v[2] + d.front() + d.back() + static_cast<int>(s.size()); // 0+1+2 + 1+7 + 4
+}
+
+void test_static_vector()
+{
+    BEGIN_SUBTEST;
+    ZEN_STATIC_ASSERT(static_containers_at_compile_time() == 15, "STATIC CONTAINERS MUST BE USABLE IN constexpr");
+
+    zen::static_vector<std::string, 3> v = { "a", "b" };
+    v.emplace_back(2, 'c');
+    ZEN_EXPECT(v.is_full() && v.back() == "cc");
+    ZEN_EXPECT(v.contains("b") && v.contains([](const std::string& s) { return s.size() == 2; }));
+    ZEN_EXPECT_THROW(v.push_back("d"), std::length_error);
+    ZEN_EXPECT_THROW(v.at(3), std::out_of_range);
+
+    const bool pushed = v.try_push_back("d");
+    ZEN_EXPECT(!pushed && v.size() == 3);
+
+    v.erase(v.begin());
+    v.insert(v.begin() + 1, "x");
+    ZEN_EXPECT((v == zen::static_vector<std::string, 3>{ "b", "x", "cc" }));
+
+    auto copy = v;
+    v.clear();
+    ZEN_EXPECT(v.is_empty() && copy.size() == 3);
+
+    // Unchecked overflow leaves it to the caller, and checking is still possible
+    zen::static_vector<int, 2, zen::unchecked> u(2, 7);
+    const bool fits = !u.is_full() || !u.try_push_back(8);
+    ZEN_EXPECT(fits && u.size() == 2 && u[1] == 7);
+
+    // Only live elements are destroyed
+    auto p = std::make_shared<int>(0);
+    {
+        zen::static_vector<std::shared_ptr<int>, 8> ps(3, p);
+        ps.pop_back();
+        ZEN_EXPECT(p.use_count() == 3);
+    }
+    ZEN_EXPECT(p.use_count() == 1);
+}
+
+void test_static_string()
+{
+    BEGIN_SUBTEST;
+    zen::static_string<8> s = "id-";
+    s += "42";
+    s.push_back('!');
+
+    ZEN_EXPECT(s == "id-42!" && s.size() == 6 && s.c_str()[6] == '\0');
+    ZEN_EXPECT(s.starts_with("id") && s.ends_with("!") && s.contains("-4") && !s.contains('x'));
+    ZEN_EXPECT(s.substr(3, 2) == "42" && s.find("42") == 3);
+    ZEN_EXPECT(s.str() == std::string("id-42!") && s < "id-5");
+    ZEN_EXPECT_THROW(s += "too long", std::length_error);
+    ZEN_EXPECT(s == "id-42!"); // unchanged by the failed append
+
+    s.resize(2);
+    ZEN_EXPECT(s == "id" && !s.is_empty());
+    s.clear();
+    ZEN_EXPECT(s.is_empty() && s == "");
+}
+
+void test_static_deque()
+{
+    BEGIN_SUBTEST;
+    zen::static_deque<std::string, 4> d;
+
+    d.push_back("b");
+    d.push_front("a");
+    d.push_back("c");
+    d.push_front("z");
+    ZEN_EXPECT(d.is_full());
+    ZEN_EXPECT((d == zen::static_deque<std::string, 4>{ "z", "a", "b", "c" }));
+    ZEN_EXPECT_THROW(d.push_back("d"), std::length_error);
+
+    // Going around the ring a few times
+    for (int i : zen::in(10)) {
+        d.pop_front();
+        d.push_back(std::to_string(i));
+    }
+    ZEN_EXPECT(d.front() == "6" && d.back() == "9" && d[1] == "7");
+    ZEN_EXPECT(std::is_sorted(d.begin(), d.end()) && d.end() - d.begin() == 4);
+    ZEN_EXPECT(std::string(d.rbegin()->c_str()) == "9");
+    ZEN_EXPECT(d.contains("8") && !d.contains("5"));
+    ZEN_EXPECT_THROW(d.at(4), std::out_of_range);
+
+    d.pop_back();
+    d.clear();
+    ZEN_EXPECT(d.is_empty());
+}
+
+void main_test_static()
+{
+    BEGIN_TEST;
+    test_static_vector();
+    test_static_string();
+    test_static_deque();
+}
@@ -2,6 +2,121 @@
 
 #include "kaizen.h" // test using generated header: jump with the parachute you folded
 
+void test_version_parsing()
+{
+    BEGIN_SUBTEST;
+
+    constexpr zen::version vc("10.20.30.40"); // parsed at compile time
+    ZEN_STATIC_ASSERT(vc.minor() == 20, "zen::version MUST BE PARSABLE AT COMPILE TIME");
+    ZEN_EXPECT(vc == zen::version(10, 20, 30, 40));
+
+    ZEN_EXPECT(zen::version("0.0.0.0") == zen::version(0, 0, 0, 0));
+    ZEN_EXPECT(zen::version(std::string("2147483647.1.2.3")).major() == 2147483647);
+
+    ZEN_EXPECT_THROW(zen::version(""),                 std::invalid_argument);
+    ZEN_EXPECT_THROW(zen::version("1.2.3"),            std::invalid_argument);
+    ZEN_EXPECT_THROW(zen::version("1.2.3.4."),         std::invalid_argument);
+    ZEN_EXPECT_THROW(zen::version("1.2..4"),           std::invalid_argument);
+    ZEN_EXPECT_THROW(zen::version("1.2.3.4x"),         std::invalid_argument);
+    ZEN_EXPECT_THROW(zen::version("-1.2.3.4"),         std::invalid_argument);
+    ZEN_EXPECT_THROW(zen::version("2147483648.1.2.3"), std::out_of_range);
+}
+
+void test_version_key()
+{
+    BEGIN_SUBTEST;
+
+    constexpr zen::version v(1, 2, 3, 4);
+    ZEN_STATIC_ASSERT(v.key() == 0x0001'0002'0003'0004, "zen::version KEY MUST BE COMPUTABLE AT COMPILE TIME");
+    ZEN_EXPECT(zen::version::from_key(v.key()) == v);
+    ZEN_EXPECT(zen::version(1, 2, 3, 65535).key() < zen::version(1, 2, 4, 0).key());
+    ZEN_EXPECT(zen::version(9, 0, 0, 0).key()     < zen::version(10, 0, 0, 0).key());
+    ZEN_EXPECT_THROW(zen::version(1, 2, 3, 65536).key(), std::out_of_range);
+    ZEN_EXPECT_THROW(zen::version(1, 2, -3, 4).key(),    std::out_of_range);
+
+    std::vector<zen::version> vs = {
+        {1, 10, 0, 0}, {1, 2, 0, 0}, {0, 9, 9, 9}, {1, 2, 0, 300}, {1, 2, 0, 1}, {1, 2, 0, 0}
+    };
+    std::vector<zen::version> sorted = vs;
+    std::sort(sorted.begin(), sorted.end());
+    zen::sort_versions(vs);
+    ZEN_EXPECT(vs == sorted);
+
+    std::vector<zen::version> none;
+    zen::sort_versions(none);
+    ZEN_EXPECT(none.empty());
+
+    // Components that don't fit into a key are sorted all the same
+    std::vector<zen::version> wide = { {1, 70000, 0, 0}, {1, 2, 0, 0}, {-1, 0, 0, 0}, {1, 65535, 0, 0} };
+    sorted = wide;
+    std::sort(sorted.begin(), sorted.end());
+    zen::sort_versions(wide);
+    ZEN_EXPECT(wide == sorted);
+}
+
+void test_version_range()
+{
+    BEGIN_SUBTEST;
+
+    constexpr zen::version_range r(">=1.2 <2.0");
+    ZEN_STATIC_ASSERT(r.contains(zen::version(1, 9, 9, 9)), "zen::version_range MUST BE USABLE AT COMPILE TIME");
+    ZEN_EXPECT( r.contains(zen::version(1, 2, 0, 0)));
+    ZEN_EXPECT( r.contains(zen::version(1, 99, 0, 0)));
+    ZEN_EXPECT(!r.contains(zen::version(1, 1, 9, 9)));
+    ZEN_EXPECT(!r.contains(zen::version(2, 0, 0, 0)));
+
+    ZEN_EXPECT( zen::version_range("> 1.2.3.4").contains(zen::version(1, 2, 3, 5)));
+    ZEN_EXPECT(!zen::version_range("> 1.2.3.4").contains(zen::version(1, 2, 3, 4)));
+    ZEN_EXPECT( zen::version_range("<=3").contains(zen::version(3, 0, 0, 0)));
+    ZEN_EXPECT( zen::version_range("=1.5").contains(zen::version(1, 5, 0, 0)));
+    ZEN_EXPECT( zen::version_range("1.5").contains(zen::version(1, 5, 0, 0)));
+    ZEN_EXPECT(!zen::version_range("==1.5").contains(zen::version(1, 5, 0, 1)));
+    ZEN_EXPECT( zen::version_range("*").contains(zen::version(0, 0, 0, 0)));
+    ZEN_EXPECT( zen::version_range("").contains(zen::version(65535, 65535, 65535, 65535)));
+    ZEN_EXPECT( zen::version_range(">2 <1").is_empty());
+    ZEN_EXPECT( zen::version_range("<0").is_empty());
+
+    ZEN_EXPECT_THROW(zen::version_range("=>1"),     std::invalid_argument);
+    ZEN_EXPECT_THROW(zen::version_range(">="),      std::invalid_argument);
+    ZEN_EXPECT_THROW(zen::version_range(">=70000"), std::out_of_range);
+
+    // Versions checked against a range are limited to 16-bit components too
+    ZEN_EXPECT(!zen::version(1, 70000, 0, 0).fits_key());
+    ZEN_EXPECT_THROW(r.contains(zen::version(1, 70000, 0, 0)), std::out_of_range);
+}
+
+void test_version_index()
+{
+    BEGIN_SUBTEST;
+
+    zen::version_index idx = { {2, 0, 0, 0}, {1, 0, 0, 0}, {1, 5, 0, 0}, {1, 2, 0, 0}, {1, 5, 0, 0} };
+    ZEN_EXPECT(idx.size() == 4); // duplicates are merged
+    ZEN_EXPECT(idx.contains(zen::version(1, 2, 0, 0)));
+    ZEN_EXPECT(!idx.contains(zen::version(1, 3, 0, 0)));
+    ZEN_EXPECT(std::is_sorted(idx.keys().begin(), idx.keys().end()));
+
+    const zen::version_range r(">=1.2 <2.0");
+    ZEN_EXPECT(idx.max_satisfying(r) == zen::version(1, 5, 0, 0));
+    ZEN_EXPECT(idx.min_satisfying(r) == zen::version(1, 2, 0, 0));
+    ZEN_EXPECT(idx.count_satisfying(r) == 2);
+    ZEN_EXPECT(idx.all_satisfying(r) == std::vector<zen::version>({ {1, 2, 0, 0}, {1, 5, 0, 0} }));
+    ZEN_EXPECT(!idx.max_satisfying(zen::version_range(">3")).has_value());
+    ZEN_EXPECT(idx.all_satisfying(zen::version_range(">2 <1")).empty());
+
+    const bool inserted1 = idx.insert(zen::version(1, 7, 0, 0));
+    const bool inserted2 = idx.insert(zen::version(1, 7, 0, 0));
+    ZEN_EXPECT(inserted1 && !inserted2);
+    ZEN_EXPECT(idx.max_satisfying(r) == zen::version(1, 7, 0, 0));
+    const bool erased1 = idx.erase(zen::version(1, 7, 0, 0));
+    const bool erased2 = idx.erase(zen::version(1, 7, 0, 0));
+    ZEN_EXPECT(erased1 && !erased2);
+
+    const std::vector<zen::version> more = { {3, 0, 0, 0}, {0, 1, 0, 0}, {2, 0, 0, 0} };
+    idx.insert(more.begin(), more.end());
+    ZEN_EXPECT(idx.size() == 6 && std::is_sorted(idx.keys().begin(), idx.keys().end()));
+    ZEN_EXPECT(zen::is_empty(idx) == idx.is_empty());
+}
+
 void main_test_version()
 {
     BEGIN_TEST;
@@ -33,4 +148,12 @@ void main_test_version()
 
     ZEN_EXPECT(os.str() == "1.2.3.4");
     ZEN_EXPECT_THROW(zen::version vi("invalid.version"), std::invalid_argument);
+
+    constexpr auto vl = "7.6.5.4321"_version; // a malformed literal wouldn't compile
+    ZEN_EXPECT(vl == v7);
+
+    test_version_parsing();
+    test_version_key();
+    test_version_range();
+    test_version_index();
 }
@@ -30,13 +30,38 @@ namespace zen {
 // pretty much all C++ projects that use the types on the right.
 // The name 'composites' is chosen by analogy with composite materials.
 
+// Engines that zen::hash_set and zen::hash_map can be built on:
+struct node_based      {}; // zen::unordered_set/map: references to elements stay valid on rehashing
+struct open_addressing {}; // zen::flat_hash_set/map: faster lookups and less memory, see flat_hash.h
+
+namespace internal {
+    template<class P, class T, class H, class E, class A> struct hash_set_engine;
+    template<class P, class K, class V, class H, class E, class A> struct hash_map_engine;
+
+    template<class T, class H, class E, class A>
+    struct hash_set_engine<node_based, T, H, E, A>      { using type = zen::unordered_set<T, H, E, A>; };
+    template<class T, class H, class E, class A>
+    struct hash_set_engine<open_addressing, T, H, E, A> { using type = zen::flat_hash_set<T, H, E, A>; };
+
+    template<class K, class V, class H, class E, class A>
+    struct hash_map_engine<node_based, K, V, H, E, A>      { using type = zen::unordered_map<K, V, H, E, A>; };
+    template<class K, class V, class H, class E, class A>
+    struct hash_map_engine<open_addressing, K, V, H, E, A> {
+        // Flat maps store std::pair<K, V>, so a default allocator of std::pair<const K, V> is rebound
+        using type = zen::flat_hash_map<K, V, H, E, typename std::allocator_traits<A>::template rebind_alloc<std::pair<K, V>>>;
+    };
+} // namespace internal
+
+// Example: zen::hash_set<int> s; // node-based, the same as zen::unordered_set<int>
+// Example: zen::hash_set<int, std::hash<int>, std::equal_to<int>, std::allocator<int>, zen::open_addressing> s;
 template<
     class T,
     class H = std::hash<T>,
     class E = std::equal_to<T>,
-    class A = std::allocator<T>
+    class A = std::allocator<T>,
+    class P = node_based
 >
-using hash_set = zen::unordered_set<T, H, E, A>;
+using hash_set = typename internal::hash_set_engine<P, T, H, E, A>::type;
 
 template<
     class T,
@@ -51,9 +76,10 @@ template<
     class V,
     class H = std::hash<K>,
     class E = std::equal_to<K>,
-    class A = std::allocator<std::pair<const K, V>>
+    class A = std::allocator<std::pair<const K, V>>,
+    class P = node_based
 >
-using hash_map = zen::unordered_map<K, V, H, E, A>;
+using hash_map = typename internal::hash_map_engine<P, K, V, H, E, A>::type;
 
 template<
     class K,
@@ -64,6 +90,25 @@ template<
 >
 using hash_multimap = zen::unordered_multimap<K, V, H, E, A>;
 
+// Queues and stacks on a single circular buffer rather than the blocks of std::deque
+template<class T, class A = std::allocator<T>> using ring_queue = zen::queue<T, zen::ring_deque<T, A>>;
+template<class T, class A = std::allocator<T>> using ring_stack = zen::stack<T, zen::ring_deque<T, A>>;
+
+// A hash map that many threads can update at once, sharded into maps of policy P
+// that are locked independently, see zen::internal::sharded_hash_map
+// Example: zen::concurrent_hash_map<zen::string, int> counts;
+//          // on each of several threads:
+//          counts.upsert(word, [](int& n) { ++n; }, 1); // insert 1 or increment
+template<
+    class K,
+    class V,
+    class H = std::hash<K>,
+    class E = std::equal_to<K>,
+    class A = std::allocator<std::pair<const K, V>>,
+    class P = open_addressing
+>
+using concurrent_hash_map = internal::sharded_hash_map<zen::hash_map<K, V, H, E, A, P>>;
+
 // Composite names
 using stringlist = zen::list<  zen::string>;
 using stringvec  = zen::vector<zen::string>;
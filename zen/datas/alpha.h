@@ -22,8 +22,19 @@
 
 #pragma once
 
+#include <type_traits>
+#include <algorithm>
+#include <iterator>
+#include <utility>
 #include <queue>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+// SSE2 is there on all of x86-64 and on 32-bit x86 when enabled. Code that uses it
+// checks ZEN_SSE2 and falls back to portable code without it.
+#define ZEN_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace zen {
 
 // At the moment kaizen.h is generated by dumping the contents of the constituent header files
@@ -122,6 +133,111 @@ std::ostream& operator<<(std::ostream& os, const std::tuple<Ts...>& tup) {
     return os;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////// KEY EXTRACTORS
+
+// Shared by the containers that implement sets and maps with the same code
+namespace internal {
+    struct key_of_value { template<class T> const T&    operator()(const T& x) const { return x;       } };
+    struct key_of_pair  { template<class P> const auto& operator()(const P& p) const { return p.first; } };
+} // namespace internal
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::presorted
+
+// Tags the constructors of sorted containers whose input is already sorted by key,
+// which they then take in O(n) rather than sorting it again
+struct presorted {};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::values_view
+
+// The mapped values of a range of key-value pairs, such as the equal_range() of a key in
+// a multimap, seen in place: nothing is copied or allocated unless to() asks for a container.
+// It's as fast to walk and to size() as the underlying range, so size() is O(1) over the
+// contiguous storage of zen::flat_multimap and O(n) over the nodes of zen::multimap.
+// Example: for (const auto& v : mm.values("key")) { ... }
+//          auto copy = mm.values("key").to<zen::vector<zen::string>>();
+template<class It>
+class values_view
+{
+public:
+    using value_type = std::remove_cvref_t<decltype(std::declval<It>()->second)>;
+    using reference  = decltype((std::declval<It>()->second)); // V& or const V&
+    using size_type  = std::size_t;
+
+    class iterator {
+    public:
+        using iterator_category = typename std::iterator_traits<It>::iterator_category;
+        using value_type        = typename values_view::value_type;
+        using difference_type   = typename std::iterator_traits<It>::difference_type;
+        using reference         = typename values_view::reference;
+        using pointer           = std::add_pointer_t<reference>;
+
+        iterator() = default;
+        explicit iterator(It it) : it_(it) {}
+
+        reference operator*()  const { return it_->second;  }
+        pointer   operator->() const { return &it_->second; }
+
+        iterator& operator++()    { ++it_; return *this; }
+        iterator  operator++(int) { auto i = *this; ++it_; return i; }
+        iterator& operator--()    requires std::bidirectional_iterator<It> { --it_; return *this; }
+        iterator  operator--(int) requires std::bidirectional_iterator<It> { auto i = *this; --it_; return i; }
+
+        iterator& operator+=(difference_type n) requires std::random_access_iterator<It> { it_ += n; return *this; }
+        iterator& operator-=(difference_type n) requires std::random_access_iterator<It> { it_ -= n; return *this; }
+        reference operator[](difference_type n) const requires std::random_access_iterator<It> { return it_[n].second; }
+
+        friend iterator operator+(iterator i, difference_type n) requires std::random_access_iterator<It> { return i += n; }
+        friend iterator operator+(difference_type n, iterator i) requires std::random_access_iterator<It> { return i += n; }
+        friend iterator operator-(iterator i, difference_type n) requires std::random_access_iterator<It> { return i -= n; }
+        friend difference_type operator-(const iterator& a, const iterator& b) requires std::random_access_iterator<It> { return a.it_ - b.it_; }
+        friend auto operator<=>(const iterator& a, const iterator& b) requires std::random_access_iterator<It> { return a.it_ <=> b.it_; }
+
+        friend bool operator==(const iterator& a, const iterator& b) { return a.it_ == b.it_; }
+
+        // The iterator to the key-value pair
+        It base() const { return it_; }
+
+    private:
+        It it_{};
+    };
+
+    values_view(It first, It last) : first_(first), last_(last) {}
+    explicit values_view(const std::pair<It, It>& range) : first_(range.first), last_(range.second) {}
+
+    iterator begin() const { return iterator(first_); }
+    iterator end()   const { return iterator(last_);  }
+
+    size_type size()     const { return static_cast<size_type>(std::distance(first_, last_)); }
+    bool      empty()    const { return first_ == last_; }
+    bool      is_empty() const { return first_ == last_; }
+
+    reference front() const { return first_->second; }
+    reference operator[](size_type i) const requires std::random_access_iterator<It> { return first_[i].second; }
+
+    bool contains(const value_type& x) const { return std::find(begin(), end(), x) != end(); }
+
+    // Copies the values into a container, the one place where anything is allocated
+    template<class Container>
+    Container to() const { return Container(begin(), end()); }
+
+private:
+    It first_;
+    It last_;
+};
+
+template<class It>
+values_view(const std::pair<It, It>&) -> values_view<It>;
+
+///////////////////////////////////////////////////////////////////////////////////////////// CONCURRENCY
+
+namespace internal {
+    // The size of a cache line on x86-64 and most ARM cores. Data written by different threads
+    // is aligned to it, so that each thread's writes don't invalidate the others' cache lines.
+    // It isn't std::hardware_destructive_interference_size, since that one varies with compiler
+    // flags (which GCC warns about) and isn't available in every standard library yet.
+    inline constexpr std::size_t cache_line_size = 64;
+} // namespace internal
+
 ///////////////////////////////////////////////////////////////////////////////////////////// zen::stackonly
 
 struct stackonly
@@ -0,0 +1,471 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <initializer_list>
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <new>
+#include <span>
+#include <bit>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
+
+namespace zen {
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::bitset
+
+// A dynamically sized set of bits stored in 64-bit words, allocated in whole cache lines
+// aligned to them. The bits past size() are always kept zero, so the bulk operations
+// run over whole cache lines of words without any tail handling, in loops that the
+// compiler vectorizes, and go as fast as memory can feed them. Bit i is bit i % 64 of
+// word i / 64; find_first() and find_next() skip over zero words and locate bits
+// with std::countr_zero. See zen::rank_select for rank and select queries.
+// Example: zen::bitset visited(n);
+//          visited.set(7);
+//          for (std::size_t i : (a & b).ones()) { ... } // the positions of the set bits
+class bitset : private zen::stackonly
+{
+public:
+    using word_type = std::uint64_t;
+    using size_type = std::size_t;
+
+    static constexpr size_type npos       = static_cast<size_type>(-1);
+    static constexpr size_type word_bits  = 64;
+    static constexpr size_type line_words = internal::cache_line_size / sizeof(word_type);
+
+    // Forward iteration over the positions of the set bits
+    class ones_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = size_type;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const size_type*;
+        using reference         = size_type;
+
+        ones_iterator() = default;
+
+        size_type      operator*()  const { return pos_; }
+        ones_iterator& operator++()       { pos_ = bits_->find_next(pos_); return *this; }
+        ones_iterator  operator++(int)    { auto it = *this; ++*this; return it; }
+
+        friend bool operator==(const ones_iterator& a, const ones_iterator& b) { return a.pos_ == b.pos_; }
+
+    private:
+        friend class bitset;
+
+        ones_iterator(const bitset* bits, size_type pos) : bits_(bits), pos_(pos) {}
+
+        const bitset* bits_ = nullptr;
+        size_type     pos_  = npos;
+    };
+
+    class ones_range {
+    public:
+        ones_iterator begin() const { return ones_iterator(bits_, bits_->find_first()); }
+        ones_iterator end()   const { return ones_iterator(bits_, npos); }
+
+    private:
+        friend class bitset;
+
+        explicit ones_range(const bitset* bits) : bits_(bits) {}
+
+        const bitset* bits_;
+    };
+
+    bitset() = default;
+
+    explicit bitset(size_type n, bool value = false) { resize(n, value); }
+
+    bitset(std::initializer_list<bool> bits)
+    {
+        reserve(bits.size());
+        for (bool b : bits)
+            push_back(b);
+    }
+
+    bitset(const bitset& other) : size_(other.size_)
+    {
+        if (size_ != 0) {
+            capacity_ = other.padded_words();
+            words_    = allocate(capacity_);
+            std::memcpy(words_, other.words_, capacity_ * sizeof(word_type));
+        }
+    }
+
+    bitset(bitset&& other) noexcept
+        : words_(std::exchange(other.words_, nullptr))
+        , capacity_(std::exchange(other.capacity_, 0))
+        , size_(std::exchange(other.size_, 0))
+    {}
+
+    bitset& operator=(bitset other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+
+    ~bitset() { deallocate(words_); }
+
+    void swap(bitset& other) noexcept
+    {
+        std::swap(words_,    other.words_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(size_,     other.size_);
+    }
+
+    friend void swap(bitset& a, bitset& b) noexcept { a.swap(b); }
+
+    size_type size()     const noexcept { return size_; }
+    bool      empty()    const noexcept { return size_ == 0; }
+    bool      is_empty() const noexcept { return size_ == 0; }
+    size_type capacity() const noexcept { return capacity_ * word_bits; }
+
+    // The words holding the bits, the bits past size() being zero
+    std::span<const word_type> words() const noexcept { return { words_, used_words() }; }
+
+    void reserve(size_type n)
+    {
+        const size_type needed = words_for(n);
+        if (needed <= capacity_)
+            return;
+
+        word_type* words = allocate(needed);
+        if (size_ != 0)
+            std::memcpy(words, words_, padded_words() * sizeof(word_type));
+        deallocate(words_);
+        words_    = words;
+        capacity_ = needed;
+    }
+
+    void resize(size_type n, bool value = false)
+    {
+        if (n > size_) {
+            reserve(n);
+            const size_type old = size_;
+            size_ = n;
+            if (value)
+                fill(old, n);
+        }
+        else {
+            const size_type old_words = used_words();
+            size_ = n;
+            clear_tail();
+            std::fill(words_ + used_words(), words_ + old_words, word_type(0));
+        }
+    }
+
+    void push_back(bool value)
+    {
+        if (size_ == capacity())
+            reserve(std::max(2 * capacity(), line_words * word_bits));
+        set(size_++, value);
+    }
+
+    void clear() noexcept { resize(0); }
+
+    bool test(size_type i) const noexcept { return (words_[i / word_bits] >> (i % word_bits)) & 1; }
+
+    bool operator[](size_type i) const noexcept { return test(i); }
+
+    bool at(size_type i) const
+    {
+        if (i >= size_)
+            throw std::out_of_range("zen::bitset INDEX OUT OF RANGE");
+        return test(i);
+    }
+
+    bitset& set(size_type i) noexcept   { words_[i / word_bits] |=  bit(i); return *this; }
+    bitset& reset(size_type i) noexcept { words_[i / word_bits] &= ~bit(i); return *this; }
+    bitset& flip(size_type i) noexcept  { words_[i / word_bits] ^=  bit(i); return *this; }
+
+    bitset& set(size_type i, bool value) noexcept { return value ? set(i) : reset(i); }
+
+    bitset& set() noexcept
+    {
+        std::fill(words_, words_ + used_words(), ~word_type(0));
+        clear_tail();
+        return *this;
+    }
+
+    bitset& reset() noexcept
+    {
+        std::fill(words_, words_ + used_words(), word_type(0));
+        return *this;
+    }
+
+    bitset& flip() noexcept
+    {
+        for (size_type i = 0; i < used_words(); ++i)
+            words_[i] = ~words_[i];
+        clear_tail();
+        return *this;
+    }
+
+    // Number of set bits
+    size_type count() const noexcept
+    {
+        const word_type* w = std::assume_aligned<internal::cache_line_size>(words_);
+        size_type total = 0;
+        for (size_type i = 0; i < padded_words(); i += line_words)
+            for (size_type j = 0; j < line_words; ++j)
+                total += std::popcount(w[i + j]);
+        return total;
+    }
+
+    bool any()  const noexcept { return find_first() != npos; }
+    bool none() const noexcept { return !any(); }
+    bool all()  const noexcept { return count() == size_; }
+
+    // Position of the first set bit, or npos if there is none
+    size_type find_first() const noexcept { return scan(0, size_ == 0 ? 0 : words_[0]); }
+
+    // Position of the first set bit after pos, or npos if there is none
+    size_type find_next(size_type pos) const noexcept
+    {
+        ++pos;
+        if (pos >= size_)
+            return npos;
+        const size_type i = pos / word_bits;
+        return scan(i, words_[i] & (~word_type(0) << (pos % word_bits)));
+    }
+
+    ones_range ones() const noexcept { return ones_range(this); }
+
+    bool contains(size_type i) const noexcept { return i < size_ && test(i); }
+
+    // The bulk operations take bitsets of the same size
+    bitset& operator&=(const bitset& other) { return combine(other, [](word_type a, word_type b) { return a &  b; }); }
+    bitset& operator|=(const bitset& other) { return combine(other, [](word_type a, word_type b) { return a |  b; }); }
+    bitset& operator^=(const bitset& other) { return combine(other, [](word_type a, word_type b) { return a ^  b; }); }
+    bitset& operator-=(const bitset& other) { return combine(other, [](word_type a, word_type b) { return a & ~b; }); } // and-not
+
+    friend bitset operator&(bitset a, const bitset& b) { return a &= b; }
+    friend bitset operator|(bitset a, const bitset& b) { return a |= b; }
+    friend bitset operator^(bitset a, const bitset& b) { return a ^= b; }
+    friend bitset operator-(bitset a, const bitset& b) { return a -= b; }
+
+    bitset operator~() const
+    {
+        bitset b = *this;
+        return b.flip();
+    }
+
+    // Whether the two bitsets have a set bit in common, without building their intersection
+    bool intersects(const bitset& other) const
+    {
+        check_size(other);
+        for (size_type i = 0; i < used_words(); ++i)
+            if (words_[i] & other.words_[i])
+                return true;
+        return false;
+    }
+
+    bool is_subset_of(const bitset& other) const
+    {
+        check_size(other);
+        for (size_type i = 0; i < used_words(); ++i)
+            if (words_[i] & ~other.words_[i])
+                return false;
+        return true;
+    }
+
+    friend bool operator==(const bitset& a, const bitset& b) noexcept
+    {
+        return a.size_ == b.size_ && std::equal(a.words_, a.words_ + a.used_words(), b.words_);
+    }
+
+private:
+    static constexpr size_type words_for(size_type n) noexcept
+    {
+        const size_type words = (n + word_bits - 1) / word_bits;
+        return (words + line_words - 1) / line_words * line_words;
+    }
+
+    static word_type bit(size_type i) noexcept { return word_type(1) << (i % word_bits); }
+
+    // Zero-filled, so that the bits past size() are zero from the start
+    static word_type* allocate(size_type words)
+    {
+        void* p = ::operator new(words * sizeof(word_type), std::align_val_t(internal::cache_line_size));
+        return static_cast<word_type*>(std::memset(p, 0, words * sizeof(word_type)));
+    }
+
+    static void deallocate(word_type* words) noexcept
+    {
+        if (words)
+            ::operator delete(words, std::align_val_t(internal::cache_line_size));
+    }
+
+    size_type used_words()   const noexcept { return (size_ + word_bits - 1) / word_bits; }
+    size_type padded_words() const noexcept { return words_for(size_); }
+
+    void clear_tail() noexcept
+    {
+        if (size_ % word_bits)
+            words_[size_ / word_bits] &= bit(size_) - 1;
+    }
+
+    // Sets the bits in [first, last)
+    void fill(size_type first, size_type last) noexcept
+    {
+        for (; first < last && first % word_bits; ++first)
+            set(first);
+        for (; first + word_bits <= last; first += word_bits)
+            words_[first / word_bits] = ~word_type(0);
+        for (; first < last; ++first)
+            set(first);
+    }
+
+    size_type scan(size_type i, word_type w) const noexcept
+    {
+        const size_type n = used_words();
+        while (w == 0) {
+            if (++i >= n)
+                return npos;
+            w = words_[i];
+        }
+        return i * word_bits + std::countr_zero(w);
+    }
+
+    void check_size(const bitset& other) const
+    {
+        if (size_ != other.size_)
+            throw std::invalid_argument("zen::bitset SIZES DIFFER");
+    }
+
+    // Whole cache lines at a time, which the padding of zero words makes possible
+    template<class Op>
+    bitset& combine(const bitset& other, Op op)
+    {
+        check_size(other);
+        word_type*       a = std::assume_aligned<internal::cache_line_size>(words_);
+        const word_type* b = std::assume_aligned<internal::cache_line_size>(other.words_);
+        for (size_type i = 0; i < padded_words(); i += line_words)
+            for (size_type j = 0; j < line_words; ++j)
+                a[i + j] = op(a[i + j], b[i + j]);
+        return *this;
+    }
+
+    word_type* words_    = nullptr;
+    size_type  capacity_ = 0; // in words, a multiple of line_words
+    size_type  size_     = 0; // in bits
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::rank_select
+
+// Answers rank (how many bits are set before a position) and select (where the k-th
+// set bit is) over a zen::bitset in O(1) and O(log n), keeping the number of set bits
+// before each cache line of words (an eighth of the bitset's memory). Rank then adds
+// the popcounts of at most 8 words, and select binary searches the lines before
+// scanning one. It refers to the bitset, which must outlive it and not be modified.
+// Example: zen::rank_select rs(bits);
+//          rs.rank(100);  // number of set bits in [0, 100)
+//          rs.select(0);  // same as bits.find_first()
+class rank_select : private zen::stackonly
+{
+public:
+    using size_type = std::size_t;
+
+    static constexpr size_type npos = bitset::npos;
+
+    explicit rank_select(const bitset& bits) : bits_(&bits)
+    {
+        const auto words = bits.words();
+        const size_type lines = (words.size() + bitset::line_words - 1) / bitset::line_words;
+        lines_.reserve(lines + 1);
+
+        size_type total = 0;
+        for (size_type i = 0; i < words.size(); ++i) {
+            if (i % bitset::line_words == 0)
+                lines_.push_back(total);
+            total += std::popcount(words[i]);
+        }
+        lines_.push_back(total);
+    }
+
+    size_type count() const noexcept { return lines_.back(); }
+
+    // Number of set bits in [0, pos), pos being at most the size of the bitset
+    size_type rank(size_type pos) const noexcept
+    {
+        const auto      words = bits_->words();
+        const size_type word  = pos / bitset::word_bits;
+        const size_type first = word / bitset::line_words * bitset::line_words;
+
+        size_type r = lines_[first / bitset::line_words];
+        for (size_type i = first; i < word; ++i)
+            r += std::popcount(words[i]);
+        if (pos % bitset::word_bits)
+            r += std::popcount(words[word] & ((bitset::word_type(1) << (pos % bitset::word_bits)) - 1));
+        return r;
+    }
+
+    // Position of the k-th set bit counting from 0, or npos if fewer bits are set
+    size_type select(size_type k) const noexcept
+    {
+        if (k >= count())
+            return npos;
+
+        // The last line with fewer than k + 1 set bits before it holds the bit
+        const auto      it   = std::upper_bound(lines_.begin(), lines_.end(), k) - 1;
+        const auto      line = static_cast<size_type>(it - lines_.begin());
+        const auto      words = bits_->words();
+        k -= *it;
+        for (size_type i = line * bitset::line_words;; ++i) {
+            const size_type c = std::popcount(words[i]);
+            if (k < c)
+                return i * bitset::word_bits + select_in_word(words[i], k);
+            k -= c;
+        }
+    }
+
+private:
+    // A byte at a time, then clearing the lowest set bits of the byte
+    static size_type select_in_word(bitset::word_type w, size_type k) noexcept
+    {
+        for (size_type shift = 0;; shift += 8) {
+            const size_type c = std::popcount((w >> shift) & 0xFF);
+            if (k < c) {
+                w >>= shift;
+                while (k--)
+                    w &= w - 1;
+                return shift + std::countr_zero(w);
+            }
+            k -= c;
+        }
+    }
+
+    const bitset*          bits_;
+    std::vector<size_type> lines_; // set bits before each line of words, then all of them
+};
+
+} // namespace zen
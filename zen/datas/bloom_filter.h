@@ -0,0 +1,373 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <initializer_list>
+#include <type_traits>
+#include <functional>
+#include <stdexcept>
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <cstdint>
+#include <limits>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <cmath>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
+
+namespace zen {
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::bloom_filter
+
+// A set that answers "definitely not there" or "maybe there" in the space of a few bits
+// per element. It is split into blocks of one cache line each, and an element's hash
+// picks one block and sets one bit in each of its eight 64-bit words, so inserting and
+// testing touch a single cache line and the eight bit tests are independent of each
+// other, which the compiler turns into a few vector instructions. The number of blocks
+// is computed from the expected number of elements and the wanted false positive rate.
+// Filters of the same size can be merged, and save() and load() read and write them.
+// Example: zen::bloom_filter<int> f(1'000'000, 0.01); // 1% false positives
+//          f.insert(42);
+//          if (f.may_contain(x)) { ... look x up for real ... }
+template<class T, class H = std::hash<T>>
+class bloom_filter : private zen::stackonly
+{
+    using word_type = std::uint64_t;
+
+    static constexpr std::size_t block_words = internal::cache_line_size / sizeof(word_type);
+    static constexpr std::size_t block_bits  = block_words * 64;
+
+    struct alignas(internal::cache_line_size) block {
+        word_type words[block_words] = {};
+    };
+
+public:
+    using value_type = T;
+    using hasher     = H;
+    using size_type  = std::size_t;
+
+    explicit bloom_filter(size_type expected, double fp_rate = 0.01, const H& hash = H())
+        : blocks_(blocks_for(expected, fp_rate)), hash_(hash) {}
+
+    bloom_filter(std::initializer_list<T> il, double fp_rate = 0.01, const H& hash = H())
+        : bloom_filter(il.size(), fp_rate, hash)
+    {
+        for (const T& x : il)
+            insert(x);
+    }
+
+    void insert(const T& x) { insert_hash(hash_(x)); }
+
+    template<class InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        for (; first != last; ++first)
+            insert(*first);
+    }
+
+    // False means that x was never inserted, true that it probably was
+    bool may_contain(const T& x) const { return may_contain_hash(hash_(x)); }
+
+    // For callers that already have the hash of an element
+    void insert_hash(std::size_t h)
+    {
+        const std::uint64_t mixed = mix(h);
+        block& b = blocks_[block_index(mixed)];
+        for (std::size_t j = 0; j < block_words; ++j)
+            b.words[j] |= bit(mixed, j);
+        ++inserted_;
+    }
+
+    // All eight words are tested without branching out early, which vectorizes
+    bool may_contain_hash(std::size_t h) const
+    {
+        const std::uint64_t mixed = mix(h);
+        const block& b = blocks_[block_index(mixed)];
+        word_type missing = 0;
+        for (std::size_t j = 0; j < block_words; ++j)
+            missing |= bit(mixed, j) & ~b.words[j];
+        return missing == 0;
+    }
+
+    // Afterwards the filter holds the elements of both, which must have the same size
+    bloom_filter& merge(const bloom_filter& other)
+    {
+        if (blocks_.size() != other.blocks_.size())
+            throw std::invalid_argument("zen::bloom_filter SIZES DIFFER");
+        for (std::size_t i = 0; i < blocks_.size(); ++i)
+            for (std::size_t j = 0; j < block_words; ++j)
+                blocks_[i].words[j] |= other.blocks_[i].words[j];
+        inserted_ += other.inserted_;
+        return *this;
+    }
+
+    bloom_filter& operator|=(const bloom_filter& other) { return merge(other); }
+
+    void clear()
+    {
+        std::fill(blocks_.begin(), blocks_.end(), block{});
+        inserted_ = 0;
+    }
+
+    size_type bit_count()      const { return blocks_.size() * block_bits; }
+    size_type block_count()    const { return blocks_.size(); }
+    size_type inserted_count() const { return inserted_; } // including repeats
+    bool      is_empty()       const { return inserted_ == 0; }
+
+    // The false positive rate expected at the number of insertions so far
+    double estimated_fp_rate() const { return fp_rate_at(static_cast<double>(inserted_) / static_cast<double>(blocks_.size())); }
+
+    // Writes the filter in a portable little-endian format
+    void save(std::ostream& os) const
+    {
+        os.write(magic, sizeof(magic));
+        put(os, blocks_.size());
+        put(os, inserted_);
+        for (const block& b : blocks_)
+            for (word_type w : b.words)
+                put(os, w);
+    }
+
+    // Reads a filter written by save(), which has to use the same hash function
+    static bloom_filter load(std::istream& is, const H& hash = H())
+    {
+        char header[sizeof(magic)] = {};
+        is.read(header, sizeof(header));
+        if (!is || !std::equal(header, header + sizeof(header), magic))
+            throw std::runtime_error("zen::bloom_filter DATA IS CORRUPT");
+
+        const std::uint64_t blocks = get(is);
+        bloom_filter f(hash, nullptr);
+        f.inserted_ = get(is);
+        if (!is || blocks == 0 || blocks > f.blocks_.max_size() || blocks > blocks_left(is))
+            throw std::runtime_error("zen::bloom_filter DATA IS CORRUPT");
+
+        // A stream that cannot tell its length is read a chunk at a time, so a
+        // corrupt count runs out of data long before it runs out of memory
+        constexpr std::size_t chunk = 4096;
+        const auto n = static_cast<std::size_t>(blocks);
+        while (f.blocks_.size() < n) {
+            const std::size_t from = f.blocks_.size();
+            f.blocks_.resize(from + std::min(chunk, n - from));
+            for (std::size_t i = from; i < f.blocks_.size(); ++i)
+                for (word_type& w : f.blocks_[i].words)
+                    w = get(is);
+            if (!is)
+                throw std::runtime_error("zen::bloom_filter DATA IS CORRUPT");
+        }
+        return f;
+    }
+
+    friend bool operator==(const bloom_filter& a, const bloom_filter& b)
+    {
+        return a.blocks_.size() == b.blocks_.size() && std::equal(a.blocks_.begin(), a.blocks_.end(), b.blocks_.begin(),
+            [](const block& x, const block& y) { return std::equal(x.words, x.words + block_words, y.words); });
+    }
+
+private:
+    static constexpr char magic[8] = { 'Z', 'E', 'N', 'B', 'L', 'O', 'O', 'M' };
+
+    bloom_filter(const H& hash, std::nullptr_t) : hash_(hash) {} // no blocks yet, for load()
+
+    // std::hash of integers is often the identity, so the bits are spread first
+    static std::uint64_t mix(std::uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ull;
+        return h ^ (h >> 33);
+    }
+
+    // The high half picks the block by multiplying instead of a modulo
+    std::size_t block_index(std::uint64_t mixed) const
+    {
+        return static_cast<std::size_t>(((mixed >> 32) * blocks_.size()) >> 32);
+    }
+
+    // The low half times a different odd constant per word, whose top 6 bits pick the bit
+    static word_type bit(std::uint64_t mixed, std::size_t j)
+    {
+        constexpr std::uint32_t salts[block_words] = {
+            0x47B6137Bu, 0x44974D91u, 0x8824AD5Bu, 0xA2B7289Du,
+            0x705495C7u, 0x2DF1424Bu, 0x9EFC4947u, 0x5C6BFB31u
+        };
+        const std::uint32_t low = static_cast<std::uint32_t>(mixed) * salts[j];
+        return word_type(1) << (low >> 26);
+    }
+
+    // The chance that all eight bits of a non-element are set in a block holding x elements is
+    // (1 - (1 - 1/64)^x)^8, and the elements per block follow a Poisson distribution whose
+    // mean is the load, so the rate is the sum of those chances weighted by their probabilities
+    static double fp_rate_at(double load)
+    {
+        if (load <= 0)
+            return 0;
+        const double spread = 12 * std::sqrt(load) + 12;
+        const auto   first  = static_cast<std::size_t>(std::max(0.0, load - spread));
+        const auto   last   = static_cast<std::size_t>(load + spread);
+        double rate = 0;
+        for (std::size_t x = first; x <= last; ++x) {
+            const double xs = static_cast<double>(x);
+            const double p  = std::exp(xs * std::log(load) - load - std::lgamma(xs + 1));
+            rate += p * std::pow(1 - std::pow(1 - 1.0 / 64, xs), static_cast<double>(block_words));
+        }
+        return rate;
+    }
+
+    // The largest load per block that keeps the rate within fp_rate, found by bisection
+    static std::size_t blocks_for(std::size_t expected, double fp_rate)
+    {
+        if (!(fp_rate > 0 && fp_rate < 1))
+            throw std::invalid_argument("zen::bloom_filter FALSE POSITIVE RATE MUST BE IN (0, 1)");
+
+        double lo = 0, hi = static_cast<double>(block_bits);
+        for (int i = 0; i < 50; ++i) {
+            const double mid = (lo + hi) / 2;
+            (fp_rate_at(mid) <= fp_rate ? lo : hi) = mid;
+        }
+        const double blocks = std::ceil(static_cast<double>(expected) / std::max(lo, 1e-3));
+        return std::max<std::size_t>(1, static_cast<std::size_t>(blocks));
+    }
+
+    static void put(std::ostream& os, std::uint64_t x)
+    {
+        char bytes[8];
+        for (int i = 0; i < 8; ++i)
+            bytes[i] = static_cast<char>((x >> (8 * i)) & 0xFF);
+        os.write(bytes, sizeof(bytes));
+    }
+
+    static std::uint64_t get(std::istream& is)
+    {
+        unsigned char bytes[8] = {};
+        is.read(reinterpret_cast<char*>(bytes), sizeof(bytes));
+        std::uint64_t x = 0;
+        for (int i = 0; i < 8; ++i)
+            x |= std::uint64_t(bytes[i]) << (8 * i);
+        return x;
+    }
+
+    // The number of whole blocks left in the stream, or no limit if it cannot be seeked
+    static std::uint64_t blocks_left(std::istream& is)
+    {
+        constexpr auto unknown = std::numeric_limits<std::uint64_t>::max();
+        const auto here = is.tellg();
+        if (here == std::istream::pos_type(-1))
+            return unknown;
+        is.seekg(0, std::ios::end);
+        const auto end = is.tellg();
+        if (!is || end == std::istream::pos_type(-1)) {
+            is.clear();
+            is.seekg(here);
+            return unknown;
+        }
+        is.seekg(here);
+        return static_cast<std::uint64_t>(end - here) / (block_words * sizeof(word_type));
+    }
+
+    std::vector<block> blocks_;
+    std::size_t        inserted_ = 0;
+    H                  hash_;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::filtered_set
+
+// A hash set behind a zen::bloom_filter that answers most lookups of elements that aren't
+// there from the filter's single cache line, without walking the set. Sized for an
+// expected number of elements, the filter is rebuilt twice as large whenever the set
+// outgrows it, and erased elements stay in it until then (or until rebuild()), which
+// only costs some extra lookups in the set.
+// Example: zen::filtered_set<zen::hash_set<int>> s(1'000'000);
+//          s.insert(42);
+//          s.contains(7); // most likely decided by the filter alone
+template<class Set, class H = typename Set::hasher>
+class filtered_set : private zen::stackonly
+{
+public:
+    using value_type = typename Set::value_type;
+    using size_type  = std::size_t;
+
+    explicit filtered_set(size_type expected = 1024, double fp_rate = 0.01)
+        : filter_(expected, fp_rate), capacity_(std::max<size_type>(expected, 1)), fp_rate_(fp_rate) {}
+
+    filtered_set(std::initializer_list<value_type> il, double fp_rate = 0.01) : filtered_set(il.size(), fp_rate)
+    {
+        for (const value_type& x : il)
+            insert(x);
+    }
+
+    // Returns whether x wasn't in the set yet
+    bool insert(const value_type& x)
+    {
+        if (!set_.insert(x).second)
+            return false;
+        if (set_.size() > capacity_) {
+            capacity_ *= 2;
+            rebuild();
+        }
+        else {
+            filter_.insert(x);
+        }
+        return true;
+    }
+
+    size_type erase(const value_type& x) { return filter_.may_contain(x) ? set_.erase(x) : 0; }
+
+    bool contains(const value_type& x) const { return filter_.may_contain(x) && set_.find(x) != set_.end(); }
+
+    // Starts the filter over from the elements in the set, dropping the erased ones
+    void rebuild()
+    {
+        filter_ = zen::bloom_filter<value_type, H>(capacity_, fp_rate_);
+        filter_.insert(set_.begin(), set_.end());
+    }
+
+    void clear()
+    {
+        set_.clear();
+        filter_.clear();
+    }
+
+    auto begin() const { return set_.begin(); }
+    auto end()   const { return set_.end();   }
+
+    size_type size()     const { return set_.size();  }
+    bool      empty()    const { return set_.empty(); }
+    bool      is_empty() const { return set_.empty(); }
+
+    const Set&                             set()    const { return set_;    }
+    const zen::bloom_filter<value_type, H>& filter() const { return filter_; }
+
+private:
+    Set                              set_;
+    zen::bloom_filter<value_type, H> filter_;
+    size_type                        capacity_;
+    double                           fp_rate_;
+};
+
+} // namespace zen
@@ -0,0 +1,914 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <initializer_list>
+#include <type_traits>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <iterator>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <memory>
+#include <vector>
+#include <tuple>
+#include <new>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
+
+namespace zen {
+
+///////////////////////////////////////////////////////////////////////////////////////////// B-TREES
+
+// Sorted associative containers on a B+ tree: each node holds as many elements (or keys)
+// as fit into four cache lines, instead of one element per node as in zen::map's
+// red-black tree, so a tree of a million ints is five levels deep instead of twenty
+// and is walked with a handful of cache misses, with no per-element pointers. The
+// elements are in the leaves, which are linked for ordered iteration, and the inner
+// nodes keep copies of the keys that separate their children. Sorted input is loaded
+// bottom-up in O(n) into full leaves, see zen::presorted. Unlike with zen::map, but as
+// with zen::flat_map, insertion and erasure invalidate iterators and references.
+
+namespace internal {
+    // The common implementation behind zen::btree_set, zen::btree_multiset, zen::btree_map and zen::btree_multimap
+    template<class K, class T, class KeyOf, class C, class A, bool Multi>
+    class btree : private zen::stackonly
+    {
+        static constexpr bool is_set = std::is_same_v<K, T>;
+
+        struct inner_node;
+
+        struct node_base {
+            explicit node_base(bool leaf) : is_leaf(leaf) {}
+
+            inner_node*   parent = nullptr;
+            std::uint16_t count  = 0; // elements in a leaf, keys in an inner node
+            bool          is_leaf;
+        };
+
+        static constexpr std::size_t node_bytes = 4 * internal::cache_line_size;
+
+    public:
+        // At least 4, so that splitting and merging always have room to work with
+        static constexpr std::size_t leaf_capacity  = std::max<std::size_t>(4, (node_bytes - sizeof(node_base) - 2 * sizeof(void*)) / sizeof(T));
+        static constexpr std::size_t inner_capacity = std::max<std::size_t>(4, (node_bytes - sizeof(node_base) - sizeof(void*)) / (sizeof(K) + sizeof(void*)));
+
+    private:
+        static constexpr std::size_t leaf_min  = leaf_capacity  / 2;
+        static constexpr std::size_t inner_min = inner_capacity / 2;
+
+        struct leaf_node : node_base {
+            leaf_node() : node_base(true) {}
+
+            T* values() { return std::launder(reinterpret_cast<T*>(storage)); }
+
+            leaf_node* prev = nullptr;
+            leaf_node* next = nullptr;
+            alignas(T) unsigned char storage[leaf_capacity * sizeof(T)];
+        };
+
+        struct inner_node : node_base {
+            inner_node() : node_base(false) {}
+
+            K* keys() { return std::launder(reinterpret_cast<K*>(storage)); }
+
+            node_base* children[inner_capacity + 1];
+            alignas(K) unsigned char storage[inner_capacity * sizeof(K)];
+        };
+
+        using leaf_allocator  = typename std::allocator_traits<A>::template rebind_alloc<leaf_node>;
+        using inner_allocator = typename std::allocator_traits<A>::template rebind_alloc<inner_node>;
+
+        template<bool Const>
+        class basic_iterator {
+        public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = std::conditional_t<Const, const T*, T*>;
+            using reference         = std::conditional_t<Const, const T&, T&>;
+
+            basic_iterator() = default;
+
+            template<bool C2, class = std::enable_if_t<Const && !C2>>
+            basic_iterator(const basic_iterator<C2>& it) : leaf_(it.leaf_), pos_(it.pos_) {}
+
+            reference operator*()  const { return leaf_->values()[pos_];  }
+            pointer   operator->() const { return &leaf_->values()[pos_]; }
+
+            basic_iterator& operator++()
+            {
+                if (++pos_ == leaf_->count && leaf_->next) {
+                    leaf_ = leaf_->next;
+                    pos_  = 0;
+                }
+                return *this;
+            }
+
+            basic_iterator& operator--()
+            {
+                if (pos_ == 0) {
+                    leaf_ = leaf_->prev;
+                    pos_  = leaf_->count;
+                }
+                --pos_;
+                return *this;
+            }
+
+            basic_iterator operator++(int) { auto it = *this; ++*this; return it; }
+            basic_iterator operator--(int) { auto it = *this; --*this; return it; }
+
+            friend bool operator==(const basic_iterator& a, const basic_iterator& b) { return a.leaf_ == b.leaf_ && a.pos_ == b.pos_; }
+
+        private:
+            template<bool> friend class basic_iterator;
+            friend class btree;
+
+            // Past the last element of a leaf is the first element of the next one,
+            // so that each position has a single iterator and end() compares right
+            basic_iterator(leaf_node* leaf, std::size_t pos) : leaf_(leaf), pos_(pos)
+            {
+                if (leaf_ && pos_ == leaf_->count && leaf_->next) {
+                    leaf_ = leaf_->next;
+                    pos_  = 0;
+                }
+            }
+
+            leaf_node*  leaf_ = nullptr;
+            std::size_t pos_  = 0;
+        };
+
+    public:
+        using key_type               = K;
+        using value_type             = T;
+        using key_compare            = C;
+        using allocator_type         = A;
+        using size_type              = std::size_t;
+        using difference_type        = std::ptrdiff_t;
+        using reference              = T&;
+        using const_reference        = const T&;
+        using const_iterator         = basic_iterator<true>;
+        using iterator               = std::conditional_t<is_set, const_iterator, basic_iterator<false>>; // keys must stay sorted
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+        using reverse_iterator       = std::reverse_iterator<iterator>;
+        using insert_return_type     = std::conditional_t<Multi, iterator, std::pair<iterator, bool>>;
+
+        btree() = default;
+        explicit btree(const C& comp, const A& alloc = A()) : comp_(comp), alloc_(alloc) {}
+
+        template<class InputIt>
+        btree(InputIt first, InputIt last, const C& comp = C(), const A& alloc = A()) : comp_(comp), alloc_(alloc) { insert(first, last); }
+
+        btree(std::initializer_list<T> il, const C& comp = C(), const A& alloc = A()) : btree(il.begin(), il.end(), comp, alloc) {}
+
+        // Bulk loading of input sorted by key, throws std::invalid_argument if it isn't.
+        // As with insert(), of equal keys in unique containers the first one wins.
+        template<class InputIt>
+        btree(presorted, InputIt first, InputIt last, const C& comp = C(), const A& alloc = A()) : comp_(comp), alloc_(alloc)
+        {
+            load_sorted(first, last);
+        }
+
+        btree(const btree& other)
+            : comp_(other.comp_)
+            , alloc_(std::allocator_traits<A>::select_on_container_copy_construction(other.alloc_))
+        {
+            load_sorted(other.begin(), other.end());
+        }
+
+        btree(btree&& other) noexcept
+            : root_( std::exchange(other.root_,  nullptr))
+            , first_(std::exchange(other.first_, nullptr))
+            , last_( std::exchange(other.last_,  nullptr))
+            , size_( std::exchange(other.size_,  0))
+            , comp_(other.comp_)
+            , alloc_(std::move(other.alloc_))
+        {}
+
+        btree& operator=(btree other) noexcept { swap(other); return *this; }
+
+        btree& operator=(std::initializer_list<T> il) { clear(); insert(il); return *this; }
+
+        ~btree() { clear(); }
+
+        iterator               begin()         { return iterator(first_, 0);                           }
+        iterator               end()           { return iterator(last_, last_ ? last_->count : 0);     }
+        const_iterator         begin()   const { return const_iterator(first_, 0);                     }
+        const_iterator         end()     const { return const_iterator(last_, last_ ? last_->count : 0); }
+        const_iterator         cbegin()  const { return begin();                                       }
+        const_iterator         cend()    const { return end();                                         }
+        reverse_iterator       rbegin()        { return reverse_iterator(end());                       }
+        reverse_iterator       rend()          { return reverse_iterator(begin());                     }
+        const_reverse_iterator rbegin()  const { return const_reverse_iterator(end());                 }
+        const_reverse_iterator rend()    const { return const_reverse_iterator(begin());               }
+
+        size_type size()     const { return size_;      }
+        bool      empty()    const { return size_ == 0; }
+        bool      is_empty() const { return size_ == 0; }
+
+        key_compare    key_comp()      const { return comp_;  }
+        allocator_type get_allocator() const { return alloc_; }
+
+        // The number of levels, 0 when empty
+        size_type height() const
+        {
+            size_type h = 0;
+            for (node_base* n = root_; n; n = n->is_leaf ? nullptr : static_cast<inner_node*>(n)->children[0])
+                ++h;
+            return h;
+        }
+
+        void clear() noexcept
+        {
+            if (root_)
+                destroy_subtree(root_);
+            root_ = first_ = last_ = nullptr;
+            size_ = 0;
+        }
+
+        // ------------------------------------------------------------------------------------------ lookup
+
+        iterator       find(const K& k)       { return find_impl(k); }
+        const_iterator find(const K& k) const { return const_cast<btree*>(this)->find_impl(k); }
+
+        bool      contains(const K& k) const { return find(k) != end(); }
+        size_type count(   const K& k) const { auto [lo, hi] = equal_range(k); return static_cast<size_type>(std::distance(lo, hi)); }
+
+        iterator       lower_bound(const K& k)       { auto [leaf, pos] = lower_position(k); return iterator(leaf, pos);       }
+        const_iterator lower_bound(const K& k) const { auto [leaf, pos] = lower_position(k); return const_iterator(leaf, pos); }
+        iterator       upper_bound(const K& k)       { auto [leaf, pos] = upper_position(k); return iterator(leaf, pos);       }
+        const_iterator upper_bound(const K& k) const { auto [leaf, pos] = upper_position(k); return const_iterator(leaf, pos); }
+
+        std::pair<iterator, iterator>             equal_range(const K& k)       { return { lower_bound(k), upper_bound(k) }; }
+        std::pair<const_iterator, const_iterator> equal_range(const K& k) const { return { lower_bound(k), upper_bound(k) }; }
+
+        // Heterogeneous lookup, enabled when the comparator is transparent like std::less<>
+        template<class Kx, class Cx = C, class = typename Cx::is_transparent>
+        iterator       find(const Kx& k)       { return find_impl(k); }
+        template<class Kx, class Cx = C, class = typename Cx::is_transparent>
+        const_iterator find(const Kx& k) const { return const_cast<btree*>(this)->find_impl(k); }
+
+        template<class Kx, class Cx = C, class = typename Cx::is_transparent>
+        bool      contains(const Kx& k) const { return find(k) != end(); }
+        template<class Kx, class Cx = C, class = typename Cx::is_transparent>
+        size_type count(   const Kx& k) const { auto [lo, hi] = equal_range(k); return static_cast<size_type>(std::distance(lo, hi)); }
+
+        template<class Kx, class Cx = C, class = typename Cx::is_transparent>
+        iterator       lower_bound(const Kx& k)       { auto [leaf, pos] = lower_position(k); return iterator(leaf, pos);       }
+        template<class Kx, class Cx = C, class = typename Cx::is_transparent>
+        const_iterator lower_bound(const Kx& k) const { auto [leaf, pos] = lower_position(k); return const_iterator(leaf, pos); }
+        template<class Kx, class Cx = C, class = typename Cx::is_transparent>
+        iterator       upper_bound(const Kx& k)       { auto [leaf, pos] = upper_position(k); return iterator(leaf, pos);       }
+        template<class Kx, class Cx = C, class = typename Cx::is_transparent>
+        const_iterator upper_bound(const Kx& k) const { auto [leaf, pos] = upper_position(k); return const_iterator(leaf, pos); }
+
+        template<class Kx, class Cx = C, class = typename Cx::is_transparent>
+        std::pair<iterator, iterator>             equal_range(const Kx& k)       { return { lower_bound(k), upper_bound(k) }; }
+        template<class Kx, class Cx = C, class = typename Cx::is_transparent>
+        std::pair<const_iterator, const_iterator> equal_range(const Kx& k) const { return { lower_bound(k), upper_bound(k) }; }
+
+        // ------------------------------------------------------------------------------------------ modifiers
+
+        insert_return_type insert(const T& x) { return emplace(x); }
+        insert_return_type insert(T&& x)      { return emplace(std::move(x)); }
+
+        template<class... Args>
+        insert_return_type emplace(Args&&... args)
+        {
+            T x(std::forward<Args>(args)...);
+            if constexpr (Multi) {
+                auto [leaf, pos] = upper_position(KeyOf{}(x));
+                return insert_at(leaf, pos, std::move(x));
+            } else {
+                return emplace_key(KeyOf{}(x), std::move(x));
+            }
+        }
+
+        template<class InputIt>
+        void insert(InputIt first, InputIt last)
+        {
+            for (; first != last; ++first)
+                emplace(*first);
+        }
+
+        void insert(std::initializer_list<T> il) { insert(il.begin(), il.end()); }
+
+        // Returns the iterator following the erased element
+        iterator erase(const_iterator pos)
+        {
+            leaf_node*  leaf = pos.leaf_;
+            std::size_t i    = pos.pos_;
+
+            erase_slot(leaf->values(), leaf->count--, i);
+            if (--size_ == 0) {
+                clear();
+                return end();
+            }
+            if (leaf != root_ && leaf->count < leaf_min)
+                rebalance_leaf(leaf, i);
+            return iterator(leaf, i);
+        }
+
+        iterator erase(const_iterator first, const_iterator last)
+        {
+            for (auto n = std::distance(first, last); n > 0; --n)
+                first = erase(first);
+            return iterator(first.leaf_, first.pos_);
+        }
+
+        size_type erase(const K& k)
+        {
+            size_type n = 0;
+            for (auto it = find(k); it != end() && !comp_(k, KeyOf{}(*it)); ++n)
+                it = erase(it);
+            return n;
+        }
+
+        void swap(btree& other) noexcept
+        {
+            using std::swap;
+            swap(root_,  other.root_);
+            swap(first_, other.first_);
+            swap(last_,  other.last_);
+            swap(size_,  other.size_);
+            swap(comp_,  other.comp_);
+            swap(alloc_, other.alloc_);
+        }
+
+        friend bool operator==(const btree& a, const btree& b) { return a.size_ == b.size_ && std::equal(a.begin(), a.end(), b.begin()); }
+        friend bool operator!=(const btree& a, const btree& b) { return !(a == b); }
+        friend bool operator< (const btree& a, const btree& b) { return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end()); }
+
+    protected:
+        // ------------------------------------------------------------------------------------------ searching
+
+        // The leaf and the position in it of the first element not less than k
+        template<class Kx>
+        std::pair<leaf_node*, std::size_t> lower_position(const Kx& k) const
+        {
+            return descend(k, [this](const K& a, const Kx& b) { return comp_(a, b); });
+        }
+
+        // The leaf and the position in it of the first element greater than k
+        template<class Kx>
+        std::pair<leaf_node*, std::size_t> upper_position(const Kx& k) const
+        {
+            return descend(k, [this](const K& a, const Kx& b) { return !comp_(b, a); });
+        }
+
+        // Each child of an inner node holds keys not greater than the separator after it and
+        // not less than the one before it, so the first key for which before(key, k) is false
+        // is in the child under the first separator for which it is false
+        template<class Kx, class Before>
+        std::pair<leaf_node*, std::size_t> descend(const Kx& k, Before before) const
+        {
+            if (!root_)
+                return { nullptr, 0 };
+
+            node_base* n = root_;
+            while (!n->is_leaf) {
+                auto* inner = static_cast<inner_node*>(n);
+                K*    keys  = inner->keys();
+                n = inner->children[count_before(keys, inner->count, [&](const K& s) { return before(s, k); })];
+            }
+
+            auto* leaf = static_cast<leaf_node*>(n);
+            return { leaf, count_before(leaf->values(), leaf->count, [&](const T& x) { return before(KeyOf{}(x), k); }) };
+        }
+
+        // The elements of a node for which before() is true come first. Arithmetic keys are
+        // counted without branches, which beats binary search's mispredictions at node sizes.
+        template<class U, class Before>
+        static std::size_t count_before(const U* a, std::size_t n, Before before)
+        {
+            if constexpr (std::is_arithmetic_v<K>) {
+                std::size_t count = 0;
+                for (std::size_t i = 0; i < n; ++i)
+                    count += before(a[i]);
+                return count;
+            } else {
+                return static_cast<std::size_t>(std::partition_point(a, a + n, before) - a);
+            }
+        }
+
+        template<class Kx>
+        iterator find_impl(const Kx& k)
+        {
+            auto [leaf, pos] = lower_position(k);
+            auto it = iterator(leaf, pos);
+            return it != end() && !comp_(k, KeyOf{}(*it)) ? it : end();
+        }
+
+        // ------------------------------------------------------------------------------------------ insertion
+
+        // Constructs an element from args only if the key k isn't there yet
+        template<class Kx, class... Args>
+        std::pair<iterator, bool> emplace_key(const Kx& k, Args&&... args)
+        {
+            auto [leaf, pos] = lower_position(k);
+            if (auto it = iterator(leaf, pos); it != end() && !comp_(k, KeyOf{}(*it)))
+                return { it, false };
+            return { insert_at(leaf, pos, std::forward<Args>(args)...), true };
+        }
+
+        // Inserts at a position found by descending for the element's key, splitting
+        // the leaf and then the inner nodes above it that are full
+        template<class... Args>
+        iterator insert_at(leaf_node* leaf, std::size_t pos, Args&&... args)
+        {
+            if (!root_)
+                root_ = first_ = last_ = leaf = new_leaf();
+
+            if (leaf->count < leaf_capacity) {
+                insert_slot(leaf->values(), leaf->count++, pos, std::forward<Args>(args)...);
+                ++size_;
+                return iterator(leaf, pos);
+            }
+
+            // Appending to a full leaf starts a new one, so that ascending keys fill leaves up
+            const std::size_t mid   = pos == leaf_capacity ? leaf_capacity : leaf_capacity / 2;
+            leaf_node*        right = new_leaf();
+            relocate(leaf->values() + mid, leaf_capacity - mid, right->values());
+            right->count = static_cast<std::uint16_t>(leaf_capacity - mid);
+            leaf->count  = static_cast<std::uint16_t>(mid);
+
+            right->prev = leaf;
+            right->next = leaf->next;
+            (leaf->next ? leaf->next->prev : last_) = right;
+            leaf->next = right;
+
+            leaf_node* target = pos >= mid ? right : leaf;
+            if (pos >= mid)
+                pos -= mid;
+            insert_slot(target->values(), target->count++, pos, std::forward<Args>(args)...);
+            ++size_;
+
+            insert_into_parent(leaf, K(KeyOf{}(right->values()[0])), right);
+            return iterator(target, pos);
+        }
+
+        // Puts right, split from left, next to it in the parent under the separator s
+        void insert_into_parent(node_base* left, K s, node_base* right)
+        {
+            while (true) {
+                inner_node* parent = left->parent;
+                if (!parent) {
+                    parent = new_inner();
+                    ::new (parent->keys()) K(std::move(s));
+                    parent->children[0] = left;
+                    parent->children[1] = right;
+                    parent->count = 1;
+                    left->parent = right->parent = parent;
+                    root_ = parent;
+                    return;
+                }
+
+                const std::size_t i = child_index(parent, left);
+                if (parent->count < inner_capacity) {
+                    insert_child(parent, i, std::move(s), right);
+                    return;
+                }
+
+                // The middle separator moves up, and appending starts a new node as with leaves
+                const std::size_t mid  = i == inner_capacity ? inner_capacity - 1 : inner_capacity / 2;
+                inner_node*       next = new_inner();
+                K                 up   = std::move(parent->keys()[mid]);
+                std::destroy_at(parent->keys() + mid);
+                relocate(parent->keys() + mid + 1, inner_capacity - mid - 1, next->keys());
+                for (std::size_t c = mid + 1; c <= inner_capacity; ++c) {
+                    next->children[c - mid - 1] = parent->children[c];
+                    parent->children[c]->parent = next;
+                }
+                next->count   = static_cast<std::uint16_t>(inner_capacity - mid - 1);
+                parent->count = static_cast<std::uint16_t>(mid);
+
+                if (i <= mid)
+                    insert_child(parent, i, std::move(s), right);
+                else
+                    insert_child(next, i - mid - 1, std::move(s), right);
+
+                left  = parent;
+                s     = std::move(up);
+                right = next;
+            }
+        }
+
+        // Inserts the separator s at i and the child after it
+        static void insert_child(inner_node* node, std::size_t i, K&& s, node_base* child)
+        {
+            insert_slot(node->keys(), node->count, i, std::move(s));
+            std::copy_backward(node->children + i + 1, node->children + node->count + 1, node->children + node->count + 2);
+            node->children[i + 1] = child;
+            child->parent = node;
+            ++node->count;
+        }
+
+        // ------------------------------------------------------------------------------------------ erasure
+
+        // Refills a leaf that fell under half full from a sibling or merges it into one,
+        // keeping track of where the element at (leaf, i) goes
+        void rebalance_leaf(leaf_node*& leaf, std::size_t& i)
+        {
+            inner_node*       parent = leaf->parent;
+            const std::size_t j      = child_index(parent, leaf);
+            auto* left  = j > 0             ? static_cast<leaf_node*>(parent->children[j - 1]) : nullptr;
+            auto* right = j < parent->count ? static_cast<leaf_node*>(parent->children[j + 1]) : nullptr;
+
+            if (left && left->count > leaf_min) {
+                T* last = left->values() + --left->count;
+                insert_slot(leaf->values(), leaf->count++, 0, std::move(*last));
+                std::destroy_at(last);
+                parent->keys()[j - 1] = KeyOf{}(leaf->values()[0]);
+                ++i;
+            }
+            else if (right && right->count > leaf_min) {
+                ::new (leaf->values() + leaf->count++) T(std::move(right->values()[0]));
+                erase_slot(right->values(), right->count--, 0);
+                parent->keys()[j] = KeyOf{}(right->values()[0]);
+            }
+            else {
+                if (left) {
+                    i += left->count;
+                    merge_leaves(left, leaf, j);
+                    leaf = left;
+                }
+                else {
+                    merge_leaves(leaf, right, j + 1);
+                }
+                rebalance_inner(parent);
+            }
+        }
+
+        // Moves the elements of the leaf at j in the parent to its left sibling and drops it
+        void merge_leaves(leaf_node* left, leaf_node* right, std::size_t j)
+        {
+            relocate(right->values(), right->count, left->values() + left->count);
+            left->count = static_cast<std::uint16_t>(left->count + right->count);
+            right->count = 0;
+
+            left->next = right->next;
+            (right->next ? right->next->prev : last_) = left;
+
+            remove_child(left->parent, j);
+            delete_node(right);
+        }
+
+        void rebalance_inner(inner_node* node)
+        {
+            while (true) {
+                if (node == root_) {
+                    if (node->count == 0) { // down to one child, which becomes the root
+                        root_ = node->children[0];
+                        root_->parent = nullptr;
+                        delete_node(node);
+                    }
+                    return;
+                }
+                if (node->count >= inner_min)
+                    return;
+
+                inner_node*       parent = node->parent;
+                const std::size_t j      = child_index(parent, node);
+                auto* left  = j > 0             ? static_cast<inner_node*>(parent->children[j - 1]) : nullptr;
+                auto* right = j < parent->count ? static_cast<inner_node*>(parent->children[j + 1]) : nullptr;
+
+                if (left && left->count > inner_min) { // rotates through the parent
+                    insert_slot(node->keys(), node->count, 0, std::move(parent->keys()[j - 1]));
+                    std::copy_backward(node->children, node->children + node->count + 1, node->children + node->count + 2);
+                    node->children[0] = left->children[left->count];
+                    node->children[0]->parent = node;
+                    ++node->count;
+
+                    K* last = left->keys() + --left->count;
+                    parent->keys()[j - 1] = std::move(*last);
+                    std::destroy_at(last);
+                    return;
+                }
+                if (right && right->count > inner_min) {
+                    ::new (node->keys() + node->count) K(std::move(parent->keys()[j]));
+                    node->children[++node->count] = right->children[0];
+                    right->children[0]->parent = node;
+
+                    parent->keys()[j] = std::move(right->keys()[0]);
+                    erase_slot(right->keys(), right->count, 0);
+                    std::copy(right->children + 1, right->children + right->count + 1, right->children);
+                    --right->count;
+                    return;
+                }
+
+                if (left)
+                    merge_inner(left, node, j);
+                else
+                    merge_inner(node, right, j + 1);
+                node = parent;
+            }
+        }
+
+        // Pulls the separator down between the two, moves the right's keys and children to the left and drops it
+        void merge_inner(inner_node* left, inner_node* right, std::size_t j)
+        {
+            inner_node* parent = left->parent;
+            ::new (left->keys() + left->count) K(std::move(parent->keys()[j - 1]));
+            relocate(right->keys(), right->count, left->keys() + left->count + 1);
+            for (std::size_t c = 0; c <= right->count; ++c) {
+                left->children[left->count + 1 + c] = right->children[c];
+                right->children[c]->parent = left;
+            }
+            left->count = static_cast<std::uint16_t>(left->count + 1 + right->count);
+            right->count = 0;
+
+            remove_child(parent, j);
+            delete_node(right);
+        }
+
+        // Removes the child at j > 0 and the separator before it
+        static void remove_child(inner_node* node, std::size_t j)
+        {
+            erase_slot(node->keys(), node->count, j - 1);
+            std::copy(node->children + j + 1, node->children + node->count + 1, node->children + j);
+            --node->count;
+        }
+
+        static std::size_t child_index(const inner_node* parent, const node_base* child)
+        {
+            return static_cast<std::size_t>(std::find(parent->children, parent->children + parent->count + 1, child) - parent->children);
+        }
+
+        // ------------------------------------------------------------------------------------------ bulk loading
+
+        // Fills leaves one after another, then builds each level of inner nodes over the
+        // one below it, spreading the children evenly, so the whole load is O(n)
+        template<class InputIt>
+        void load_sorted(InputIt first, InputIt last)
+        {
+            std::vector<node_base*> level;
+            try {
+                for (; first != last; ++first) {
+                    if (last_ && last_->count > 0) {
+                        const K& prev = KeyOf{}(last_->values()[last_->count - 1]);
+                        if (comp_(KeyOf{}(*first), prev))
+                            throw std::invalid_argument("zen::btree_* PRESORTED INPUT IS NOT SORTED");
+                        if (!Multi && !comp_(prev, KeyOf{}(*first)))
+                            continue;
+                    }
+                    if (!last_ || last_->count == leaf_capacity) {
+                        leaf_node* leaf = new_leaf();
+                        leaf->prev = last_;
+                        (last_ ? last_->next : first_) = leaf;
+                        last_ = leaf;
+                        level.push_back(leaf);
+                    }
+                    ::new (last_->values() + last_->count) T(*first);
+                    ++last_->count;
+                    ++size_;
+                }
+            }
+            catch (...) {
+                release_leaves();
+                throw;
+            }
+
+            // The last leaf borrows from the full one before it to be at least half full
+            if (level.size() > 1)
+                while (last_->count < leaf_min) {
+                    T* moved = last_->prev->values() + --last_->prev->count;
+                    insert_slot(last_->values(), last_->count++, 0, std::move(*moved));
+                    std::destroy_at(moved);
+                }
+
+            while (level.size() > 1) {
+                const std::size_t n      = level.size();
+                const std::size_t groups = (n + inner_capacity) / (inner_capacity + 1);
+                std::vector<node_base*> parents;
+                parents.reserve(groups);
+
+                for (std::size_t g = 0, next = 0; g < groups; ++g) {
+                    const std::size_t fanout = n / groups + (g < n % groups);
+                    inner_node* inner = new_inner();
+                    for (std::size_t c = 0; c < fanout; ++c) {
+                        node_base* child = level[next + c];
+                        if (c > 0)
+                            ::new (inner->keys() + c - 1) K(first_key(child));
+                        inner->children[c] = child;
+                        child->parent = inner;
+                    }
+                    inner->count = static_cast<std::uint16_t>(fanout - 1);
+                    next += fanout;
+                    parents.push_back(inner);
+                }
+                level.swap(parents);
+            }
+            root_ = level.empty() ? nullptr : level[0];
+        }
+
+        static const K& first_key(node_base* n)
+        {
+            while (!n->is_leaf)
+                n = static_cast<inner_node*>(n)->children[0];
+            return KeyOf{}(static_cast<leaf_node*>(n)->values()[0]);
+        }
+
+        // Frees the linked leaves that have no inner nodes above them yet
+        void release_leaves() noexcept
+        {
+            for (leaf_node* leaf = first_; leaf;) {
+                leaf_node* next = leaf->next;
+                delete_node(leaf);
+                leaf = next;
+            }
+            root_ = first_ = last_ = nullptr;
+            size_ = 0;
+        }
+
+        // ------------------------------------------------------------------------------------------ memory
+
+        // Shifts [i, n) right by one into raw memory at n and puts a new element at i
+        template<class U, class... Args>
+        static void insert_slot(U* a, std::size_t n, std::size_t i, Args&&... args)
+        {
+            if (i == n) {
+                ::new (a + n) U(std::forward<Args>(args)...);
+                return;
+            }
+            U x(std::forward<Args>(args)...);
+            ::new (a + n) U(std::move(a[n - 1]));
+            std::move_backward(a + i, a + n - 1, a + n);
+            a[i] = std::move(x);
+        }
+
+        // Shifts (i, n) left by one and destroys what is left at n - 1
+        template<class U>
+        static void erase_slot(U* a, std::size_t n, std::size_t i)
+        {
+            std::move(a + i + 1, a + n, a + i);
+            std::destroy_at(a + n - 1);
+        }
+
+        template<class U>
+        static void relocate(U* from, std::size_t n, U* to)
+        {
+            std::uninitialized_move(from, from + n, to);
+            std::destroy(from, from + n);
+        }
+
+        leaf_node* new_leaf()
+        {
+            leaf_allocator alloc(alloc_);
+            return ::new (std::allocator_traits<leaf_allocator>::allocate(alloc, 1)) leaf_node();
+        }
+
+        inner_node* new_inner()
+        {
+            inner_allocator alloc(alloc_);
+            return ::new (std::allocator_traits<inner_allocator>::allocate(alloc, 1)) inner_node();
+        }
+
+        void delete_node(node_base* n) noexcept
+        {
+            if (n->is_leaf) {
+                auto* leaf = static_cast<leaf_node*>(n);
+                std::destroy(leaf->values(), leaf->values() + leaf->count);
+                leaf_allocator alloc(alloc_);
+                std::allocator_traits<leaf_allocator>::deallocate(alloc, leaf, 1);
+            }
+            else {
+                auto* inner = static_cast<inner_node*>(n);
+                std::destroy(inner->keys(), inner->keys() + inner->count);
+                inner_allocator alloc(alloc_);
+                std::allocator_traits<inner_allocator>::deallocate(alloc, inner, 1);
+            }
+        }
+
+        void destroy_subtree(node_base* n) noexcept
+        {
+            if (!n->is_leaf) {
+                auto* inner = static_cast<inner_node*>(n);
+                for (std::size_t c = 0; c <= inner->count; ++c)
+                    destroy_subtree(inner->children[c]);
+            }
+            delete_node(n);
+        }
+
+        node_base*  root_  = nullptr;
+        leaf_node*  first_ = nullptr;
+        leaf_node*  last_  = nullptr;
+        std::size_t size_  = 0;
+        C           comp_;
+        A           alloc_;
+    };
+} // namespace internal
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::btree_set
+
+// Example: zen::btree_set<int> s = { 3, 1, 2 };
+//          zen::btree_set<int> t(zen::presorted{}, v.begin(), v.end()); // bulk load of a sorted zen::vector
+template<class K, class C = std::less<K>, class A = std::allocator<K>>
+class btree_set : public internal::btree<K, K, internal::key_of_value, C, A, false>
+{
+public:
+    using internal::btree<K, K, internal::key_of_value, C, A, false>::btree; // inherit constructors, has to be explicit
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::btree_multiset
+
+template<class K, class C = std::less<K>, class A = std::allocator<K>>
+class btree_multiset : public internal::btree<K, K, internal::key_of_value, C, A, true>
+{
+public:
+    using internal::btree<K, K, internal::key_of_value, C, A, true>::btree; // inherit constructors, has to be explicit
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::btree_map
+
+// As in zen::flat_map, the elements are std::pair<K, V> (without const K) so that
+// they can move between nodes; don't modify keys through iterators.
+// Example: zen::btree_map<int, zen::string> m = { {2, "b"}, {1, "a"} };
+//          for (auto it = m.lower_bound(1); it != m.upper_bound(5); ++it) { ... } // in key order
+template<class K, class V, class C = std::less<K>, class A = std::allocator<std::pair<K, V>>>
+class btree_map : public internal::btree<K, std::pair<K, V>, internal::key_of_pair, C, A, false>
+{
+    using base = internal::btree<K, std::pair<K, V>, internal::key_of_pair, C, A, false>;
+
+public:
+    using base::base; // inherit constructors, has to be explicit
+    using mapped_type = V;
+
+    V& operator[](const K& k) { return try_emplace(k).first->second; }
+    V& operator[](K&& k)      { return try_emplace(std::move(k)).first->second; }
+
+    V& at(const K& k)
+    {
+        auto it = base::find(k);
+        if (it == base::end())
+            throw std::out_of_range("zen::btree_map::at() KEY NOT FOUND");
+        return it->second;
+    }
+
+    const V& at(const K& k) const
+    {
+        auto it = base::find(k);
+        if (it == base::end())
+            throw std::out_of_range("zen::btree_map::at() KEY NOT FOUND");
+        return it->second;
+    }
+
+    // Unlike emplace(), doesn't construct the value if the key is already there
+    template<class Kx, class... Args>
+    std::pair<typename base::iterator, bool> try_emplace(Kx&& k, Args&&... args)
+    {
+        return base::emplace_key(k,
+            std::piecewise_construct,
+            std::forward_as_tuple(std::forward<Kx>(k)),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template<class Vx>
+    std::pair<typename base::iterator, bool> insert_or_assign(const K& k, Vx&& v)
+    {
+        auto result = try_emplace(k, std::forward<Vx>(v));
+        if (!result.second)
+            result.first->second = std::forward<Vx>(v);
+        return result;
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::btree_multimap
+
+// Values of equal keys are adjacent, in insertion order
+template<class K, class V, class C = std::less<K>, class A = std::allocator<std::pair<K, V>>>
+class btree_multimap : public internal::btree<K, std::pair<K, V>, internal::key_of_pair, C, A, true>
+{
+    using base = internal::btree<K, std::pair<K, V>, internal::key_of_pair, C, A, true>;
+
+public:
+    using base::base; // inherit constructors, has to be explicit
+    using mapped_type = V;
+
+    auto values(const K& k)       { return zen::values_view(base::equal_range(k)); }
+    auto values(const K& k) const { return zen::values_view(base::equal_range(k)); }
+};
+
+} // namespace zen
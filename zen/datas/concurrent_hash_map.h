@@ -0,0 +1,364 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <initializer_list>
+#include <shared_mutex>
+#include <type_traits>
+#include <functional>
+#include <stdexcept>
+#include <algorithm>
+#include <optional>
+#include <iterator>
+#include <numeric>
+#include <cstdint>
+#include <utility>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <bit>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
+
+namespace zen {
+
+namespace internal {
+    // The implementation behind zen::concurrent_hash_map (see collections.h), which
+    // picks the map type M of its shards. Keys are spread over a power-of-two number
+    // of shards, each an M guarded by its own reader-writer lock on its own cache
+    // line, so threads only contend when they touch the same shard. Reads take the
+    // lock in shared mode, so they never wait for each other, only for writers.
+    // 
+    // There are no iterators or references into the map, since they would outlive
+    // the lock; instead, callbacks passed to upsert(), visit() and friends run
+    // while the shard of their key is locked. Callbacks must not access the map.
+    template<class M>
+    class sharded_hash_map : private zen::stackonly
+    {
+        using K = typename M::key_type;
+        using V = typename M::mapped_type;
+
+    public:
+        using shard_map       = M;
+        using key_type        = typename M::key_type;
+        using mapped_type     = typename M::mapped_type;
+        using value_type      = std::pair<key_type, mapped_type>; // what snapshot() returns
+        using hasher          = typename M::hasher;
+        using key_equal       = typename M::key_equal;
+        using allocator_type  = typename M::allocator_type;
+        using size_type       = std::size_t;
+
+        // Enough shards for all hardware threads to rarely meet
+        static size_type default_shard_count()
+        {
+            return std::bit_ceil(std::max<size_type>(1, 4 * std::thread::hardware_concurrency()));
+        }
+
+        explicit sharded_hash_map(size_type shard_count = default_shard_count(),
+                                  const hasher& hash = hasher(), const key_equal& eq = key_equal(), const allocator_type& alloc = allocator_type())
+            : shard_count_(std::bit_ceil(shard_count)), hash_(hash)
+        {
+            if (shard_count == 0)
+                throw std::invalid_argument("zen::concurrent_hash_map NEEDS AT LEAST ONE SHARD");
+
+            shards_ = std::make_unique<shard[]>(shard_count_);
+            for (size_type i = 0; i < shard_count_; ++i)
+                shards_[i].map = shard_map(0, hash, eq, alloc);
+        }
+
+        sharded_hash_map(std::initializer_list<value_type> il, size_type shard_count = default_shard_count())
+            : sharded_hash_map(shard_count)
+        {
+            for (const auto& x : il)
+                insert(x.first, x.second);
+        }
+
+        // All of these are snapshots that may be out of date by the time they return
+        size_type size() const
+        {
+            size_type n = 0;
+            for (size_type i = 0; i < shard_count_; ++i) {
+                std::shared_lock lock(shards_[i].mutex);
+                n += shards_[i].map.size();
+            }
+            return n;
+        }
+
+        bool empty()    const { return size() == 0; }
+        bool is_empty() const { return empty();     }
+
+        size_type shard_count() const { return shard_count_; }
+
+        // Spreads room for n elements evenly over the shards
+        void reserve(size_type n)
+        {
+            for (size_type i = 0; i < shard_count_; ++i) {
+                std::unique_lock lock(shards_[i].mutex);
+                shards_[i].map.reserve(n / shard_count_ + 1);
+            }
+        }
+
+        void clear()
+        {
+            for (size_type i = 0; i < shard_count_; ++i) {
+                std::unique_lock lock(shards_[i].mutex);
+                shards_[i].map.clear();
+            }
+        }
+
+        // ------------------------------------------------------------------------------------------ lookup
+
+        bool contains(const K& k) const
+        {
+            const shard& s = shard_of(k);
+            std::shared_lock lock(s.mutex);
+            return s.map.contains(k);
+        }
+
+        // A copy, since a reference would escape the lock
+        std::optional<V> find(const K& k) const
+        {
+            const shard& s = shard_of(k);
+            std::shared_lock lock(s.mutex);
+            const auto it = s.map.find(k);
+            return it == s.map.end() ? std::nullopt : std::optional<V>(it->second);
+        }
+
+        // Calls f(V&) on the value of k under an exclusive lock; returns whether k was found
+        template<class F>
+        bool visit(const K& k, F&& f)
+        {
+            shard& s = shard_of(k);
+            std::unique_lock lock(s.mutex);
+            const auto it = s.map.find(k);
+            if (it == s.map.end())
+                return false;
+            f(it->second);
+            return true;
+        }
+
+        // Calls f(const V&) on the value of k under a shared lock, so readers don't block each other
+        template<class F>
+        bool cvisit(const K& k, F&& f) const
+        {
+            const shard& s = shard_of(k);
+            std::shared_lock lock(s.mutex);
+            const auto it = s.map.find(k);
+            if (it == s.map.end())
+                return false;
+            f(std::as_const(it->second));
+            return true;
+        }
+
+        // ------------------------------------------------------------------------------------------ modifiers
+
+        // Does nothing if k is already there; returns whether it was inserted
+        template<class... Args>
+        bool emplace(const K& k, Args&&... args)
+        {
+            shard& s = shard_of(k);
+            std::unique_lock lock(s.mutex);
+            return s.map.try_emplace(k, std::forward<Args>(args)...).second;
+        }
+
+        template<class Vx>
+        bool insert(const K& k, Vx&& v) { return emplace(k, std::forward<Vx>(v)); }
+
+        // Returns whether k was inserted rather than assigned
+        template<class Vx>
+        bool insert_or_assign(const K& k, Vx&& v)
+        {
+            shard& s = shard_of(k);
+            std::unique_lock lock(s.mutex);
+            return s.map.insert_or_assign(k, std::forward<Vx>(v)).second;
+        }
+
+        // Calls f(V&) if k is there, otherwise inserts V(args...), as one atomic step;
+        // returns whether k was inserted. This is what counters and aggregations need.
+        // Example: m.upsert(key, [&](Stats& s) { s.add(x); }, x); // Stats(x) if new
+        template<class F, class... Args>
+        bool upsert(const K& k, F&& f, Args&&... args)
+        {
+            shard& s = shard_of(k);
+            std::unique_lock lock(s.mutex);
+            const auto it = s.map.find(k);
+            if (it != s.map.end()) {
+                f(it->second);
+                return false;
+            }
+            s.map.try_emplace(k, std::forward<Args>(args)...);
+            return true;
+        }
+
+        // Returns a copy of the value of k, inserting make() first if k isn't there.
+        // make() runs at most once per key no matter how many threads race for it.
+        template<class F>
+        V compute_if_absent(const K& k, F&& make)
+        {
+            shard& s = shard_of(k);
+            {
+                std::shared_lock lock(s.mutex); // the common case of k being there only needs to read
+                const auto it = s.map.find(k);
+                if (it != s.map.end())
+                    return it->second;
+            }
+            std::unique_lock lock(s.mutex);
+            auto it = s.map.find(k); // another thread may have inserted it in between the locks
+            if (it == s.map.end())
+                it = s.map.try_emplace(k, make()).first;
+            return it->second;
+        }
+
+        // Returns whether k was erased
+        bool erase(const K& k)
+        {
+            shard& s = shard_of(k);
+            std::unique_lock lock(s.mutex);
+            return s.map.erase(k) != 0;
+        }
+
+        // Erases k only if pred(const V&) holds, as one atomic step
+        template<class Pred>
+        bool erase_if(const K& k, Pred&& pred)
+        {
+            shard& s = shard_of(k);
+            std::unique_lock lock(s.mutex);
+            const auto it = s.map.find(k);
+            if (it == s.map.end() || !pred(std::as_const(it->second)))
+                return false;
+            s.map.erase(it);
+            return true;
+        }
+
+        // ------------------------------------------------------------------------------------------ whole map
+
+        // Calls f(const K&, V&) on every element, locking one shard at a time, so
+        // other threads can keep working on the rest of the map in the meantime
+        template<class F>
+        void visit_all(F&& f)
+        {
+            for (size_type i = 0; i < shard_count_; ++i) {
+                std::unique_lock lock(shards_[i].mutex);
+                for (auto& [k, v] : shards_[i].map)
+                    f(std::as_const(k), v);
+            }
+        }
+
+        template<class F>
+        void cvisit_all(F&& f) const
+        {
+            for (size_type i = 0; i < shard_count_; ++i) {
+                std::shared_lock lock(shards_[i].mutex);
+                for (const auto& [k, v] : shards_[i].map)
+                    f(k, v);
+            }
+        }
+
+        // Same as cvisit_all(), but shards are split among thread_count threads,
+        // so f must be safe to call concurrently (on different elements)
+        template<class F>
+        void parallel_cvisit_all(F&& f, size_type thread_count = std::thread::hardware_concurrency()) const
+        {
+            for_each_shard_in_parallel(thread_count, [&](const shard& s) {
+                std::shared_lock lock(s.mutex);
+                for (const auto& [k, v] : s.map)
+                    f(k, v);
+            });
+        }
+
+        // A consistent point-in-time copy of all elements: every shard is locked (in
+        // shared mode, in a fixed order) before any is copied, and shards are copied
+        // on thread_count threads. Writers wait until the copying is done.
+        std::vector<value_type> snapshot(size_type thread_count = std::thread::hardware_concurrency()) const
+        {
+            std::vector<std::shared_lock<std::shared_mutex>> locks;
+            locks.reserve(shard_count_);
+            for (size_type i = 0; i < shard_count_; ++i)
+                locks.emplace_back(shards_[i].mutex);
+
+            std::vector<std::vector<value_type>> parts(shard_count_);
+            for_each_shard_in_parallel(thread_count, [&](const shard& s) {
+                auto& part = parts[static_cast<size_type>(&s - shards_.get())];
+                part.assign(s.map.begin(), s.map.end());
+            });
+            locks.clear();
+
+            std::vector<value_type> result;
+            result.reserve(std::accumulate(parts.begin(), parts.end(), size_type(0),
+                [](size_type n, const auto& part) { return n + part.size(); }));
+            for (auto& part : parts)
+                std::move(part.begin(), part.end(), std::back_inserter(result));
+            return result;
+        }
+
+    private:
+        // Padded to a cache line of its own, so that threads working on
+        // neighboring shards don't keep invalidating each other's caches
+        struct alignas(cache_line_size) shard {
+            mutable std::shared_mutex mutex;
+            shard_map                 map;
+        };
+
+        // The inner maps use the low bits of the hash, so the shard comes from the high
+        // bits of a differently mixed hash, keeping keys well spread inside each shard
+        template<class Kx>
+        size_type shard_index(const Kx& k) const
+        {
+            const auto h = static_cast<std::uint64_t>(hash_(k)) * 0xFF51AFD7ED558CCDull;
+            return shard_count_ == 1 ? 0 : static_cast<size_type>(h >> (64 - std::countr_zero(shard_count_)));
+        }
+
+        shard&       shard_of(const K& k)       { return shards_[shard_index(k)]; }
+        const shard& shard_of(const K& k) const { return shards_[shard_index(k)]; }
+
+        template<class F>
+        void for_each_shard_in_parallel(size_type thread_count, F&& f) const
+        {
+            thread_count = std::clamp<size_type>(thread_count, 1, shard_count_);
+            if (thread_count == 1) {
+                for (size_type i = 0; i < shard_count_; ++i)
+                    f(shards_[i]);
+                return;
+            }
+
+            std::vector<std::thread> threads;
+            threads.reserve(thread_count);
+            for (size_type t = 0; t < thread_count; ++t) {
+                threads.emplace_back([&, t] {
+                    for (size_type i = t; i < shard_count_; i += thread_count)
+                        f(shards_[i]);
+                });
+            }
+            for (auto& thread : threads)
+                thread.join();
+        }
+
+        size_type                shard_count_;
+        std::unique_ptr<shard[]> shards_;
+        hasher                   hash_;
+    };
+} // namespace internal
+
+} // namespace zen
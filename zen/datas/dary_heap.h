@@ -0,0 +1,402 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <initializer_list>
+#include <type_traits>
+#include <functional>
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+#include <utility>
+#include <memory>
+#include <vector>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
+
+namespace zen {
+
+///////////////////////////////////////////////////////////////////////////////////////////// D-ARY HEAPS
+
+// A d-ary heap is a binary heap with D children per node instead of 2. That makes
+// it shallower (log base D levels instead of log base 2), so pushing is cheaper,
+// and as the D children of a node sit next to each other in memory, picking
+// the largest of them on the way down reads a single cache line or two.
+// D = 4 measures best for elements from 4 to 32 bytes, draining up to 1.8x
+// faster than a binary heap, while 8 children already cost more to compare
+// than the shallower heap saves.
+
+namespace internal {
+    // The index of the largest of the children starting at index child
+    template<std::size_t D, class It, class L>
+    std::size_t dary_best_child(It first, std::size_t child, std::size_t n, L& less)
+    {
+        std::size_t best = child;
+        if (child + D <= n) { // all D children there, the usual case, with a loop the compiler can unroll
+            for (std::size_t c = 1; c < D; ++c)
+                if (less(first[best], first[child + c]))
+                    best = child + c;
+        } else {
+            for (std::size_t c = child + 1; c < n; ++c)
+                if (less(first[best], first[c]))
+                    best = c;
+        }
+        return best;
+    }
+
+    // The sift functions call moved(i) whenever an element lands at index i, which is
+    // how the addressable heap keeps track of where each of its elements is
+    template<std::size_t D, class It, class L, class F>
+    void dary_sift_up(It first, std::size_t i, L& less, F&& moved)
+    {
+        auto x = std::move(first[i]);
+        while (i > 0) {
+            const std::size_t parent = (i - 1) / D;
+            if (!less(first[parent], x))
+                break;
+            first[i] = std::move(first[parent]);
+            moved(i);
+            i = parent;
+        }
+        first[i] = std::move(x);
+        moved(i);
+    }
+
+    template<std::size_t D, class It, class L, class F>
+    void dary_sift_down(It first, std::size_t n, std::size_t i, L& less, F&& moved)
+    {
+        auto x = std::move(first[i]);
+        for (;;) {
+            const std::size_t child = D * i + 1;
+            if (child >= n)
+                break;
+
+            const std::size_t best = dary_best_child<D>(first, child, n, less);
+
+            if (!less(x, first[best]))
+                break;
+            first[i] = std::move(first[best]);
+            moved(i);
+            i = best;
+        }
+        first[i] = std::move(x);
+        moved(i);
+    }
+
+    // Sifting down an element that came from the bottom of the heap, as when popping:
+    // since it will most likely end up near the bottom again, the hole is moved all the
+    // way down without comparing the element to anything, and then the element sifts up
+    // from there, which saves about one comparison per level
+    template<std::size_t D, class It, class L, class F>
+    void dary_sift_down_from_bottom(It first, std::size_t n, std::size_t i, L& less, F&& moved)
+    {
+        auto x = std::move(first[i]);
+        const std::size_t top = i;
+        for (;;) {
+            const std::size_t child = D * i + 1;
+            if (child >= n)
+                break;
+
+            const std::size_t best = dary_best_child<D>(first, child, n, less);
+
+            first[i] = std::move(first[best]);
+            moved(i);
+            i = best;
+        }
+        while (i > top) {
+            const std::size_t parent = (i - 1) / D;
+            if (!less(first[parent], x))
+                break;
+            first[i] = std::move(first[parent]);
+            moved(i);
+            i = parent;
+        }
+        first[i] = std::move(x);
+        moved(i);
+    }
+
+    // Floyd's bottom-up construction in O(n): sifting down every parent, last first
+    template<std::size_t D, class It, class L, class F>
+    void dary_heapify(It first, std::size_t n, L& less, F&& moved)
+    {
+        for (std::size_t i = n > 1 ? (n - 2) / D + 1 : 0; i-- > 0; )
+            dary_sift_down<D>(first, n, i, less, moved);
+    }
+
+    struct dary_unmoved { void operator()(std::size_t) const {} };
+} // namespace internal
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::dary_heap
+
+// A priority queue with the largest element (by L) on top, like zen::priority_queue
+// Example: zen::dary_heap<int> h = { 3, 1, 4 }; // built in O(n)
+//          h.top(); // 4
+template<class T, std::size_t D = 4, class L = std::less<T>, class A = std::allocator<T>>
+class dary_heap : private zen::stackonly
+{
+    ZEN_STATIC_ASSERT(D >= 2, "zen::dary_heap NEEDS AT LEAST 2 CHILDREN PER NODE");
+
+public:
+    using value_type      = T;
+    using value_compare   = L;
+    using allocator_type  = A;
+    using size_type       = std::size_t;
+    using const_reference = const T&;
+    using const_iterator  = typename std::vector<T, A>::const_iterator;
+
+    static constexpr size_type arity() { return D; }
+
+    dary_heap() = default;
+
+    explicit dary_heap(const L& less) : less_(less) {}
+
+    template<class InputIt, class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    dary_heap(InputIt first, InputIt last, const L& less = L()) : c_(first, last), less_(less) { heapify(); }
+
+    dary_heap(std::initializer_list<T> il, const L& less = L()) : dary_heap(il.begin(), il.end(), less) {}
+
+    // Takes over the elements of a container and heapifies them in O(n)
+    explicit dary_heap(std::vector<T, A>&& c, const L& less = L()) : c_(std::move(c)), less_(less) { heapify(); }
+
+    const T& top() const { return c_.front(); }
+
+    size_type size()     const { return c_.size();  }
+    bool      empty()    const { return c_.empty(); }
+    bool      is_empty() const { return c_.empty(); }
+
+    void reserve(size_type n) { c_.reserve(n); }
+    void clear()              { c_.clear();    }
+
+    // The elements in heap order, for reading them all without popping
+    const_iterator begin() const { return c_.begin(); }
+    const_iterator end()   const { return c_.end();   }
+
+    template<class... Args>
+    void emplace(Args&&... args)
+    {
+        c_.emplace_back(std::forward<Args>(args)...);
+        internal::dary_sift_up<D>(c_.begin(), c_.size() - 1, less_, internal::dary_unmoved());
+    }
+
+    void push(const T& x) { emplace(x);            }
+    void push(T&& x)      { emplace(std::move(x)); }
+
+    // Adds many elements at once: when they are about as many as those already
+    // there, rebuilding the whole heap in O(n) beats pushing them one by one
+    template<class InputIt>
+    void push(InputIt first, InputIt last)
+    {
+        const auto n = c_.size();
+        c_.insert(c_.end(), first, last);
+        if (c_.size() - n >= n / 2) {
+            heapify();
+        } else {
+            for (auto i = n; i < c_.size(); ++i)
+                internal::dary_sift_up<D>(c_.begin(), i, less_, internal::dary_unmoved());
+        }
+    }
+
+    void pop()
+    {
+        if (c_.size() > 1) // or the last element would be moved onto itself
+            c_.front() = std::move(c_.back());
+        c_.pop_back();
+        if (!c_.empty())
+            internal::dary_sift_down_from_bottom<D>(c_.begin(), c_.size(), 0, less_, internal::dary_unmoved());
+    }
+
+    // Pops the top and returns it
+    T extract_top()
+    {
+        T x = std::move(c_.front());
+        pop();
+        return x;
+    }
+
+    // Pops the top and pushes x in a single pass down the heap
+    void replace_top(T x)
+    {
+        c_.front() = std::move(x);
+        internal::dary_sift_down<D>(c_.begin(), c_.size(), 0, less_, internal::dary_unmoved());
+    }
+
+private:
+    void heapify() { internal::dary_heapify<D>(c_.begin(), c_.size(), less_, internal::dary_unmoved()); }
+
+    std::vector<T, A> c_;
+    L                 less_;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::addressable_dary_heap
+
+// A zen::dary_heap whose elements can be found again through the handles that push()
+// returns, so their priorities can be updated (as in decrease-key) or they can be
+// erased in O(log n), rather than being left in the heap and skipped when popped.
+// A handle stays valid until its element leaves the heap; after that, it may be
+// given to a new element.
+// Example: zen::addressable_dary_heap<int, 4, std::greater<int>> h; // smallest on top
+//          auto a = h.push(10);
+//          h.update(a, 3); // a is now on top
+template<class T, std::size_t D = 4, class L = std::less<T>>
+class addressable_dary_heap : private zen::stackonly
+{
+    ZEN_STATIC_ASSERT(D >= 2, "zen::addressable_dary_heap NEEDS AT LEAST 2 CHILDREN PER NODE");
+
+    struct node {
+        T           value;
+        std::size_t id;
+    };
+
+    struct node_less {
+        L less;
+        bool operator()(const node& a, const node& b) const { return less(a.value, b.value); }
+    };
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+public:
+    using value_type    = T;
+    using value_compare = L;
+    using size_type     = std::size_t;
+
+    class handle {
+    public:
+        handle() = default;
+        friend bool operator==(handle a, handle b) { return a.id_ == b.id_; }
+        friend bool operator!=(handle a, handle b) { return a.id_ != b.id_; }
+
+    private:
+        friend class addressable_dary_heap;
+        explicit handle(std::size_t id) : id_(id) {}
+        std::size_t id_ = npos;
+    };
+
+    addressable_dary_heap() = default;
+
+    explicit addressable_dary_heap(const L& less) : less_{ less } {}
+
+    const T& top()        const { return nodes_.front().value;      }
+    handle   top_handle() const { return handle(nodes_.front().id); }
+
+    const T& operator[](handle h) const { return nodes_[position(h)].value; }
+
+    bool contains(handle h) const { return h.id_ < pos_.size() && pos_[h.id_] != npos; }
+
+    size_type size()     const { return nodes_.size();  }
+    bool      empty()    const { return nodes_.empty(); }
+    bool      is_empty() const { return nodes_.empty(); }
+
+    void reserve(size_type n)
+    {
+        nodes_.reserve(n);
+        pos_.reserve(n);
+    }
+
+    void clear()
+    {
+        nodes_.clear();
+        pos_.clear();
+        free_ids_.clear();
+    }
+
+    handle push(T x)
+    {
+        std::size_t id;
+        if (free_ids_.empty()) {
+            id = pos_.size();
+            pos_.push_back(npos);
+        } else {
+            id = free_ids_.back();
+            free_ids_.pop_back();
+        }
+
+        nodes_.push_back(node{ std::move(x), id });
+        sift_up(nodes_.size() - 1);
+        return handle(id);
+    }
+
+    void pop() { erase_at(0); }
+
+    // Pops the top and returns it
+    T extract_top()
+    {
+        T x = std::move(nodes_.front().value);
+        erase_at(0);
+        return x;
+    }
+
+    // Sets a new priority, moving the element up or down as needed
+    void update(handle h, T x)
+    {
+        const auto i = position(h);
+        const bool up = less_.less(nodes_[i].value, x);
+        nodes_[i].value = std::move(x);
+        if (up)
+            sift_up(i);
+        else
+            sift_down(i);
+    }
+
+    void erase(handle h) { erase_at(position(h)); }
+
+private:
+    std::size_t position(handle h) const
+    {
+        if (!contains(h))
+            throw std::out_of_range("zen::addressable_dary_heap HANDLE OF AN ELEMENT THAT ISN'T IN THE HEAP");
+        return pos_[h.id_];
+    }
+
+    // Puts the last element in place of the i-th and lets it find its level
+    void erase_at(std::size_t i)
+    {
+        pos_[nodes_[i].id] = npos;
+        free_ids_.push_back(nodes_[i].id);
+
+        const bool last = i + 1 == nodes_.size();
+        if (!last)
+            nodes_[i] = std::move(nodes_.back());
+        nodes_.pop_back();
+        if (!last) {
+            pos_[nodes_[i].id] = i;
+            if (i > 0 && less_(nodes_[(i - 1) / D], nodes_[i]))
+                sift_up(i);
+            else
+                sift_down(i);
+        }
+    }
+
+    void sift_up(std::size_t i)   { internal::dary_sift_up<D>(nodes_.begin(), i, less_, tracker());                }
+    void sift_down(std::size_t i) { internal::dary_sift_down<D>(nodes_.begin(), nodes_.size(), i, less_, tracker()); }
+
+    auto tracker() { return [this](std::size_t i) { pos_[nodes_[i].id] = i; }; }
+
+    std::vector<node>        nodes_;
+    std::vector<std::size_t> pos_;      // the index in nodes_ of each id, or npos
+    std::vector<std::size_t> free_ids_; // ids to reuse
+    node_less                less_;
+};
+
+} // namespace zen
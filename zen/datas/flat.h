@@ -0,0 +1,347 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <initializer_list>
+#include <type_traits>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
+
+namespace zen {
+
+///////////////////////////////////////////////////////////////////////////////////////////// FLAT CONTAINERS
+
+// Sorted associative containers that keep their elements in one contiguous
+// std::vector instead of a tree of separately allocated nodes. Lookups are
+// binary searches over adjacent memory, so they take far fewer cache misses
+// than with zen::set or zen::map, and there's no allocation per element.
+// The price is O(n) single-element insertion and erasure, which is why they
+// suit read-mostly data best, and bulk insertion is O(n log n) via sort+merge.
+// As with std::vector, insertion and erasure invalidate iterators.
+
+namespace internal {
+    // The common implementation behind zen::flat_set, zen::flat_multiset, zen::flat_map and zen::flat_multimap
+    template<class K, class T, class KeyOf, class C, class A, bool Multi>
+    class flat_tree : private zen::stackonly
+    {
+        static constexpr bool is_set = std::is_same_v<K, T>;
+
+    public:
+        using key_type               = K;
+        using value_type             = T;
+        using key_compare            = C;
+        using allocator_type         = A;
+        using container_type         = std::vector<T, A>;
+        using size_type              = typename container_type::size_type;
+        using difference_type        = typename container_type::difference_type;
+        using reference              = T&;
+        using const_reference        = const T&;
+        using const_iterator         = typename container_type::const_iterator;
+        using iterator               = std::conditional_t<is_set, const_iterator, typename container_type::iterator>; // keys must stay sorted
+        using const_reverse_iterator = typename container_type::const_reverse_iterator;
+        using reverse_iterator       = std::conditional_t<is_set, const_reverse_iterator, typename container_type::reverse_iterator>;
+        using insert_return_type     = std::conditional_t<Multi, iterator, std::pair<iterator, bool>>;
+
+        flat_tree() = default;
+        explicit flat_tree(const C& comp) : comp_(comp) {}
+
+        template<class InputIt>
+        flat_tree(InputIt first, InputIt last, const C& comp = C()) : comp_(comp) { insert(first, last); }
+
+        flat_tree(std::initializer_list<T> il, const C& comp = C()) : flat_tree(il.begin(), il.end(), comp) {}
+
+        // Adopts the contents of an unsorted container without copying them
+        explicit flat_tree(container_type&& c, const C& comp = C()) : c_(std::move(c)), comp_(comp) { sort_and_unique(0); }
+
+        // Adopts the contents of a container that's already sorted by key (and free of equal keys,
+        // unless Multi), checking that in O(n) instead of sorting it
+        flat_tree(zen::presorted, container_type&& c, const C& comp = C()) : c_(std::move(c)), comp_(comp)
+        {
+            const auto out_of_order = [this](const T& a, const T& b) {
+                return Multi ? comp_(KeyOf{}(b), KeyOf{}(a)) : !comp_(KeyOf{}(a), KeyOf{}(b));
+            };
+            if (std::adjacent_find(c_.begin(), c_.end(), out_of_order) != c_.end())
+                throw std::invalid_argument("zen::flat_* PRESORTED INPUT IS NOT SORTED");
+        }
+
+        flat_tree& operator=(std::initializer_list<T> il) { clear(); insert(il); return *this; }
+
+        iterator               begin()         { return c_.begin();   }
+        iterator               end()           { return c_.end();     }
+        const_iterator         begin()   const { return c_.begin();   }
+        const_iterator         end()     const { return c_.end();     }
+        const_iterator         cbegin()  const { return c_.cbegin();  }
+        const_iterator         cend()    const { return c_.cend();    }
+        reverse_iterator       rbegin()        { return c_.rbegin();  }
+        reverse_iterator       rend()          { return c_.rend();    }
+        const_reverse_iterator rbegin()  const { return c_.rbegin();  }
+        const_reverse_iterator rend()    const { return c_.rend();    }
+
+        size_type size()     const { return c_.size();     }
+        size_type max_size() const { return c_.max_size(); }
+        size_type capacity() const { return c_.capacity(); }
+        bool      empty()    const { return c_.empty();    }
+        bool      is_empty() const { return c_.empty();    }
+
+        void reserve(size_type n) { c_.reserve(n);     }
+        void shrink_to_fit()      { c_.shrink_to_fit(); }
+        void clear()              { c_.clear();         }
+
+        key_compare key_comp() const { return comp_; }
+
+        // Read-only access to the underlying sorted storage, e.g. for passing on as a span
+        const container_type& sequence() const { return c_; }
+
+        // Hands over the underlying storage and leaves the container empty
+        container_type extract() && { container_type c = std::move(c_); c_.clear(); return c; }
+
+        // ------------------------------------------------------------------------------------------ lookup
+
+        iterator       find(const K& k)       { auto it = lower_bound(k); return it != end() && !comp_(k, KeyOf{}(*it)) ? it : end(); }
+        const_iterator find(const K& k) const { auto it = lower_bound(k); return it != end() && !comp_(k, KeyOf{}(*it)) ? it : end(); }
+
+        bool      contains(const K& k) const { return find(k) != end(); }
+        size_type count(   const K& k) const { auto [lo, hi] = equal_range(k); return static_cast<size_type>(hi - lo); }
+
+        iterator       lower_bound(const K& k)       { return begin() + lower_index(k); }
+        const_iterator lower_bound(const K& k) const { return begin() + lower_index(k); }
+        iterator       upper_bound(const K& k)       { return begin() + upper_index(k); }
+        const_iterator upper_bound(const K& k) const { return begin() + upper_index(k); }
+
+        std::pair<iterator, iterator>             equal_range(const K& k)       { return { lower_bound(k), upper_bound(k) }; }
+        std::pair<const_iterator, const_iterator> equal_range(const K& k) const { return { lower_bound(k), upper_bound(k) }; }
+
+        // Heterogeneous lookup, enabled when the comparator is transparent like std::less<>,
+        // so that, for example, a flat_set<std::string> can be searched with a string_view
+        // without constructing a temporary std::string.
+        template<class Kx, class Cx = C, class = typename Cx::is_transparent>
+        iterator       find(const Kx& k)       { auto it = lower_bound(k); return it != end() && !comp_(k, KeyOf{}(*it)) ? it : end(); }
+        template<class Kx, class Cx = C, class = typename Cx::is_transparent>
+        const_iterator find(const Kx& k) const { auto it = lower_bound(k); return it != end() && !comp_(k, KeyOf{}(*it)) ? it : end(); }
+
+        template<class Kx, class Cx = C, class = typename Cx::is_transparent>
+        bool      contains(const Kx& k) const { return find(k) != end(); }
+        template<class Kx, class Cx = C, class = typename Cx::is_transparent>
+        size_type count(   const Kx& k) const { auto [lo, hi] = equal_range(k); return static_cast<size_type>(hi - lo); }
+
+        template<class Kx, class Cx = C, class = typename Cx::is_transparent>
+        iterator       lower_bound(const Kx& k)       { return begin() + lower_index(k); }
+        template<class Kx, class Cx = C, class = typename Cx::is_transparent>
+        const_iterator lower_bound(const Kx& k) const { return begin() + lower_index(k); }
+        template<class Kx, class Cx = C, class = typename Cx::is_transparent>
+        iterator       upper_bound(const Kx& k)       { return begin() + upper_index(k); }
+        template<class Kx, class Cx = C, class = typename Cx::is_transparent>
+        const_iterator upper_bound(const Kx& k) const { return begin() + upper_index(k); }
+
+        template<class Kx, class Cx = C, class = typename Cx::is_transparent>
+        std::pair<iterator, iterator>             equal_range(const Kx& k)       { return { lower_bound(k), upper_bound(k) }; }
+        template<class Kx, class Cx = C, class = typename Cx::is_transparent>
+        std::pair<const_iterator, const_iterator> equal_range(const Kx& k) const { return { lower_bound(k), upper_bound(k) }; }
+
+        // ------------------------------------------------------------------------------------------ modifiers
+
+        insert_return_type insert(const T& x) { return emplace(x); }
+        insert_return_type insert(T&& x)      { return emplace(std::move(x)); }
+
+        template<class... Args>
+        insert_return_type emplace(Args&&... args)
+        {
+            T x(std::forward<Args>(args)...);
+            const K& k = KeyOf{}(x);
+            if constexpr (Multi) {
+                return c_.insert(c_.begin() + upper_index(k), std::move(x));
+            } else {
+                const size_type i = lower_index(k);
+                if (i != c_.size() && !comp_(k, KeyOf{}(c_[i])))
+                    return { begin() + i, false };
+                return { c_.insert(c_.begin() + i, std::move(x)), true };
+            }
+        }
+
+        // Bulk insertion: appends everything, sorts only the new part and merges
+        // it in, which is O(n log n) instead of O(n^2) for inserting one by one.
+        // As with zen::map, of equal keys in unique containers the first one wins.
+        template<class InputIt>
+        void insert(InputIt first, InputIt last)
+        {
+            const size_type old_size = c_.size();
+            c_.insert(c_.end(), first, last);
+            sort_and_unique(old_size);
+        }
+
+        void insert(std::initializer_list<T> il) { insert(il.begin(), il.end()); }
+
+        iterator erase(const_iterator pos)                       { return c_.erase(pos); }
+        iterator erase(const_iterator first, const_iterator last) { return c_.erase(first, last); }
+
+        size_type erase(const K& k)
+        {
+            auto [lo, hi] = equal_range(k);
+            const auto n = static_cast<size_type>(hi - lo);
+            c_.erase(lo, hi);
+            return n;
+        }
+
+        void swap(flat_tree& other) noexcept { using std::swap; swap(c_, other.c_); swap(comp_, other.comp_); }
+
+        friend bool operator==(const flat_tree& a, const flat_tree& b) { return a.c_ == b.c_; }
+        friend bool operator!=(const flat_tree& a, const flat_tree& b) { return a.c_ != b.c_; }
+        friend bool operator< (const flat_tree& a, const flat_tree& b) { return a.c_ <  b.c_; }
+
+    protected:
+        template<class Kx>
+        size_type lower_index(const Kx& k) const
+        {
+            return static_cast<size_type>(std::partition_point(c_.begin(), c_.end(),
+                [&](const T& x) { return comp_(KeyOf{}(x), k); }) - c_.begin());
+        }
+
+        template<class Kx>
+        size_type upper_index(const Kx& k) const
+        {
+            return static_cast<size_type>(std::partition_point(c_.begin(), c_.end(),
+                [&](const T& x) { return !comp_(k, KeyOf{}(x)); }) - c_.begin());
+        }
+
+        // Sorts [from, end), merges it with the already sorted [begin, from) and,
+        // for unique containers, drops all but the first element of equal keys.
+        void sort_and_unique(size_type from)
+        {
+            const auto by_key = [this](const T& a, const T& b) { return comp_(KeyOf{}(a), KeyOf{}(b)); };
+            const auto middle = c_.begin() + static_cast<difference_type>(from);
+            std::stable_sort(middle, c_.end(), by_key);
+            std::inplace_merge(c_.begin(), middle, c_.end(), by_key);
+            if constexpr (!Multi) {
+                const auto equal_keys = [&](const T& a, const T& b) { return !by_key(a, b); }; // sorted, so a <= b
+                c_.erase(std::unique(c_.begin(), c_.end(), equal_keys), c_.end());
+            }
+        }
+
+        container_type c_;
+        C              comp_;
+    };
+} // namespace internal
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::flat_set
+
+// Example: zen::flat_set<int> s = { 3, 1, 2 }; // stored as [1, 2, 3]
+//          s.contains(2); // binary search over contiguous memory
+template<class K, class C = std::less<K>, class A = std::allocator<K>>
+class flat_set : public internal::flat_tree<K, K, internal::key_of_value, C, A, false>
+{
+public:
+    using internal::flat_tree<K, K, internal::key_of_value, C, A, false>::flat_tree; // inherit constructors, has to be explicit
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::flat_multiset
+
+template<class K, class C = std::less<K>, class A = std::allocator<K>>
+class flat_multiset : public internal::flat_tree<K, K, internal::key_of_value, C, A, true>
+{
+public:
+    using internal::flat_tree<K, K, internal::key_of_value, C, A, true>::flat_tree; // inherit constructors, has to be explicit
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::flat_map
+
+// Unlike zen::map, the elements are std::pair<K, V> (without const K) so that
+// they can be moved around within the storage; don't modify keys through iterators.
+// Example: zen::flat_map<zen::string, int> m = { {"b", 2}, {"a", 1} };
+//          m["c"] = 3;
+template<class K, class V, class C = std::less<K>, class A = std::allocator<std::pair<K, V>>>
+class flat_map : public internal::flat_tree<K, std::pair<K, V>, internal::key_of_pair, C, A, false>
+{
+    using base = internal::flat_tree<K, std::pair<K, V>, internal::key_of_pair, C, A, false>;
+
+public:
+    using base::base; // inherit constructors, has to be explicit
+    using mapped_type = V;
+
+    V& operator[](const K& k) { return try_emplace(k).first->second; }
+    V& operator[](K&& k)      { return try_emplace(std::move(k)).first->second; }
+
+    V& at(const K& k)
+    {
+        auto it = base::find(k);
+        if (it == base::end())
+            throw std::out_of_range("zen::flat_map::at() KEY NOT FOUND");
+        return it->second;
+    }
+
+    const V& at(const K& k) const
+    {
+        auto it = base::find(k);
+        if (it == base::end())
+            throw std::out_of_range("zen::flat_map::at() KEY NOT FOUND");
+        return it->second;
+    }
+
+    // Unlike emplace(), doesn't construct the value if the key is already there
+    template<class Kx, class... Args>
+    std::pair<typename base::iterator, bool> try_emplace(Kx&& k, Args&&... args)
+    {
+        const auto i = base::lower_index(k);
+        if (i != base::c_.size() && !base::comp_(k, base::c_[i].first))
+            return { base::begin() + i, false };
+        auto it = base::c_.emplace(base::c_.begin() + i,
+            std::piecewise_construct,
+            std::forward_as_tuple(std::forward<Kx>(k)),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+        return { it, true };
+    }
+
+    template<class Vx>
+    std::pair<typename base::iterator, bool> insert_or_assign(const K& k, Vx&& v)
+    {
+        auto result = try_emplace(k, std::forward<Vx>(v));
+        if (!result.second)
+            result.first->second = std::forward<Vx>(v);
+        return result;
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::flat_multimap
+
+// Values of equal keys are adjacent in memory, in insertion order, so values(key)
+// is a random-access view over one contiguous run that's sized in O(1)
+// Example: zen::flat_multimap<int, zen::string> index = { {1, "a"}, {1, "b"} };
+//          for (const auto& v : index.values(1)) { ... } // no allocation, no copies
+template<class K, class V, class C = std::less<K>, class A = std::allocator<std::pair<K, V>>>
+class flat_multimap : public internal::flat_tree<K, std::pair<K, V>, internal::key_of_pair, C, A, true>
+{
+    using base = internal::flat_tree<K, std::pair<K, V>, internal::key_of_pair, C, A, true>;
+
+public:
+    using base::base; // inherit constructors, has to be explicit
+    using mapped_type = V;
+
+    auto values(const K& k)       { return zen::values_view(base::equal_range(k)); }
+    auto values(const K& k) const { return zen::values_view(base::equal_range(k)); }
+};
+
+} // namespace zen
@@ -0,0 +1,550 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <initializer_list>
+#include <type_traits>
+#include <functional>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <memory>
+#include <bit>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
+
+namespace zen {
+
+///////////////////////////////////////////////////////////////////////////////////////////// OPEN ADDRESSING HASH TABLES
+
+// Swiss-table style hash containers. All elements live in one flat array of
+// slots, next to an array of one-byte control tags: for each slot, the tag
+// says whether it's empty, deleted, or full, in which case it also stores 7
+// bits of the element's hash. Slots are probed in groups of 16, and the tags
+// of a whole group are compared against the hash bits at once with SSE2 (or
+// with a portable loop elsewhere), so most lookups touch one control group and
+// a single slot, with no allocation per element and no pointer chasing.
+// Like with zen::flat_map, the elements of a map are std::pair<K, V> (without
+// const K) so they can be moved when the table grows; don't modify keys through
+// iterators. Insertion may invalidate all iterators; erasure only the erased one.
+
+namespace internal {
+    class swiss_group {
+    public:
+        static constexpr size_t      WIDTH   = 16;
+        static constexpr std::int8_t EMPTY   = -128; // 0b10000000
+        static constexpr std::int8_t DELETED =   -2; // 0b11111110
+        static constexpr std::int8_t END     =   -1; // 0b11111111, stops iteration past the last slot
+
+        explicit swiss_group(const std::int8_t* ctrl)
+#ifdef ZEN_SSE2
+            : ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+#else
+            : ctrl_(ctrl) {}
+#endif
+
+        // Bit i is set if the i-th tag of the group is h2
+        std::uint32_t match(std::int8_t h2) const
+        {
+#ifdef ZEN_SSE2
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_)));
+#else
+            std::uint32_t mask = 0;
+            for (size_t i = 0; i < WIDTH; ++i)
+                mask |= static_cast<std::uint32_t>(ctrl_[i] == h2) << i;
+            return mask;
+#endif
+        }
+
+        std::uint32_t match_empty() const { return match(EMPTY); }
+
+        // Empty and deleted tags are the only ones with the sign bit set inside a group
+        std::uint32_t match_free() const
+        {
+#ifdef ZEN_SSE2
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl_));
+#else
+            std::uint32_t mask = 0;
+            for (size_t i = 0; i < WIDTH; ++i)
+                mask |= static_cast<std::uint32_t>(ctrl_[i] < 0) << i;
+            return mask;
+#endif
+        }
+
+    private:
+#ifdef ZEN_SSE2
+        __m128i ctrl_;
+#else
+        const std::int8_t* ctrl_;
+#endif
+    };
+
+    // The common implementation behind zen::flat_hash_set and zen::flat_hash_map
+    template<class K, class T, class KeyOf, class H, class E, class A>
+    class swiss_table : private zen::stackonly
+    {
+        static constexpr bool is_set = std::is_same_v<K, T>;
+
+        using group       = swiss_group;
+        using slot_traits = std::allocator_traits<A>;
+        using ctrl_alloc  = typename slot_traits::template rebind_alloc<std::int8_t>;
+        using ctrl_traits = std::allocator_traits<ctrl_alloc>;
+
+    public:
+        using key_type        = K;
+        using value_type      = T;
+        using hasher          = H;
+        using key_equal       = E;
+        using allocator_type  = A;
+        using size_type       = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference       = T&;
+        using const_reference = const T&;
+
+        template<bool Const>
+        class basic_iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
+            using reference         = std::conditional_t<Const || is_set, const T&, T&>;
+            using pointer           = std::conditional_t<Const || is_set, const T*, T*>;
+
+            basic_iterator() = default;
+            basic_iterator(const std::int8_t* ctrl, T* slot) : ctrl_(ctrl), slot_(slot) { skip_free(); }
+
+            // Conversion from iterator to const_iterator
+            template<bool C, class = std::enable_if_t<Const && !C>>
+            basic_iterator(const basic_iterator<C>& it) : ctrl_(it.ctrl_), slot_(it.slot_) {}
+
+            reference operator*()  const { return *slot_; }
+            pointer   operator->() const { return  slot_; }
+
+            basic_iterator& operator++()    { ++ctrl_; ++slot_; skip_free(); return *this; }
+            basic_iterator  operator++(int) { auto t = *this; ++*this; return t; }
+
+            friend bool operator==(const basic_iterator& a, const basic_iterator& b) { return a.slot_ == b.slot_; }
+            friend bool operator!=(const basic_iterator& a, const basic_iterator& b) { return a.slot_ != b.slot_; }
+
+        private:
+            template<bool> friend class basic_iterator;
+            friend class swiss_table;
+
+            // The END tag after the last slot isn't free, so this always stops
+            void skip_free() { while (ctrl_ && *ctrl_ < group::END) { ++ctrl_; ++slot_; } }
+
+            const std::int8_t* ctrl_ = nullptr;
+            T*                 slot_ = nullptr;
+        };
+
+        using iterator       = basic_iterator<false>;
+        using const_iterator = basic_iterator<true>;
+
+        swiss_table() = default;
+
+        explicit swiss_table(size_type n, const H& hash = H(), const E& eq = E(), const A& alloc = A())
+            : hash_(hash), eq_(eq), alloc_(alloc) { reserve(n); }
+
+        template<class InputIt>
+        swiss_table(InputIt first, InputIt last, size_type n = 0, const H& hash = H(), const E& eq = E(), const A& alloc = A())
+            : swiss_table(n, hash, eq, alloc) { insert(first, last); }
+
+        swiss_table(std::initializer_list<T> il, size_type n = 0, const H& hash = H(), const E& eq = E(), const A& alloc = A())
+            : swiss_table(il.begin(), il.end(), n, hash, eq, alloc) {}
+
+        swiss_table(const swiss_table& other)
+            : hash_(other.hash_), eq_(other.eq_), alloc_(slot_traits::select_on_container_copy_construction(other.alloc_)),
+              max_load_(other.max_load_)
+        {
+            reserve(other.size_);
+            for (const auto& x : other)
+                insert_unique_unchecked(x);
+        }
+
+        swiss_table(swiss_table&& other) noexcept
+            : ctrl_(std::exchange(other.ctrl_, nullptr)), slots_(std::exchange(other.slots_, nullptr)),
+              capacity_(std::exchange(other.capacity_, 0)), size_(std::exchange(other.size_, 0)),
+              deleted_(std::exchange(other.deleted_, 0)), hash_(std::move(other.hash_)), eq_(std::move(other.eq_)),
+              alloc_(std::move(other.alloc_)), max_load_(other.max_load_) {}
+
+        swiss_table& operator=(swiss_table other) noexcept { swap(other); return *this; }
+
+        ~swiss_table() { destroy(); }
+
+        iterator       begin()        { return capacity_ ? iterator(ctrl_, slots_) : iterator(); }
+        iterator       end()          { return capacity_ ? iterator(ctrl_ + capacity_, slots_ + capacity_) : iterator(); }
+        const_iterator begin()  const { return const_cast<swiss_table*>(this)->begin(); }
+        const_iterator end()    const { return const_cast<swiss_table*>(this)->end();   }
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend()   const { return end();   }
+
+        size_type size()     const { return size_;      }
+        size_type capacity() const { return capacity_;  }
+        bool      empty()    const { return size_ == 0; }
+        bool      is_empty() const { return size_ == 0; }
+
+        float load_factor()     const { return capacity_ ? static_cast<float>(size_) / capacity_ : 0.0f; }
+        float max_load_factor() const { return max_load_; }
+
+        // Higher values save memory at the cost of longer probe sequences.
+        // The default of 7/8 is what Swiss tables are usually tuned to.
+        void max_load_factor(float f)
+        {
+            if (!(f > 0.0f && f < 1.0f))
+                throw std::invalid_argument("MAX LOAD FACTOR OF AN OPEN ADDRESSING HASH TABLE MUST BE IN (0, 1)");
+            max_load_ = f;
+            if (size_ + deleted_ > growth_limit(capacity_))
+                rehash(0);
+        }
+
+        // Makes room for n elements without rehashing
+        void reserve(size_type n) { if (n > growth_limit(capacity_)) rehash(n); }
+
+        // Rebuilds the table with room for at least n elements, which also purges deleted tags
+        void rehash(size_type n)
+        {
+            n = std::max(n, size_);
+            size_type cap = n ? group::WIDTH : 0;
+            while (cap && growth_limit(cap) < n)
+                cap *= 2;
+            resize(cap);
+        }
+
+        void clear()
+        {
+            for (size_type i = 0; i < capacity_; ++i) {
+                if (ctrl_[i] >= 0)
+                    slot_traits::destroy(alloc_, slots_ + i);
+                ctrl_[i] = group::EMPTY;
+            }
+            size_ = deleted_ = 0;
+        }
+
+        hasher    hash_function() const { return hash_; }
+        key_equal key_eq()        const { return eq_;   }
+
+        // ------------------------------------------------------------------------------------------ lookup
+
+        iterator       find(const K& k)       { return find_impl(k); }
+        const_iterator find(const K& k) const { return const_cast<swiss_table*>(this)->find_impl(k); }
+        bool       contains(const K& k) const { return find(k) != end(); }
+        size_type     count(const K& k) const { return contains(k) ? 1 : 0; }
+
+        // Heterogeneous lookup, enabled when both the hasher and key_equal are
+        // transparent, so that, for example, a table of std::string can be
+        // searched with a string_view without constructing a temporary string.
+        template<class Kx, class Hx = H, class Ex = E, class = typename Hx::is_transparent, class = typename Ex::is_transparent>
+        iterator       find(const Kx& k)       { return find_impl(k); }
+        template<class Kx, class Hx = H, class Ex = E, class = typename Hx::is_transparent, class = typename Ex::is_transparent>
+        const_iterator find(const Kx& k) const { return const_cast<swiss_table*>(this)->find_impl(k); }
+        template<class Kx, class Hx = H, class Ex = E, class = typename Hx::is_transparent, class = typename Ex::is_transparent>
+        bool       contains(const Kx& k) const { return find(k) != end(); }
+        template<class Kx, class Hx = H, class Ex = E, class = typename Hx::is_transparent, class = typename Ex::is_transparent>
+        size_type     count(const Kx& k) const { return contains(k) ? 1 : 0; }
+
+        // ------------------------------------------------------------------------------------------ modifiers
+
+        std::pair<iterator, bool> insert(const T& x) { return emplace(x); }
+        std::pair<iterator, bool> insert(T&& x)      { return emplace(std::move(x)); }
+
+        template<class InputIt>
+        void insert(InputIt first, InputIt last) { for (; first != last; ++first) emplace(*first); }
+
+        void insert(std::initializer_list<T> il) { insert(il.begin(), il.end()); }
+
+        template<class... Args>
+        std::pair<iterator, bool> emplace(Args&&... args)
+        {
+            if constexpr (sizeof...(Args) == 1 && (std::is_same_v<std::decay_t<Args>, T> && ...)) {
+                // Already a value_type, so its key can be looked up before anything is constructed
+                return emplace_key(KeyOf{}(args...), std::forward<Args>(args)...);
+            } else {
+                T x(std::forward<Args>(args)...);
+                const auto& k = KeyOf{}(x);
+                return emplace_key(k, std::move(x));
+            }
+        }
+
+        iterator erase(const_iterator pos)
+        {
+            iterator it(pos.ctrl_, const_cast<T*>(pos.slot_));
+            erase_at(static_cast<size_type>(it.slot_ - slots_));
+            return ++it;
+        }
+
+        size_type erase(const K& k)
+        {
+            const auto it = find(k);
+            if (it == end())
+                return 0;
+            erase_at(static_cast<size_type>(it.slot_ - slots_));
+            return 1;
+        }
+
+        void swap(swiss_table& other) noexcept
+        {
+            using std::swap;
+            swap(ctrl_,     other.ctrl_);
+            swap(slots_,    other.slots_);
+            swap(capacity_, other.capacity_);
+            swap(size_,     other.size_);
+            swap(deleted_,  other.deleted_);
+            swap(hash_,     other.hash_);
+            swap(eq_,       other.eq_);
+            swap(alloc_,    other.alloc_);
+            swap(max_load_, other.max_load_);
+        }
+
+        friend bool operator==(const swiss_table& a, const swiss_table& b)
+        {
+            if (a.size() != b.size())
+                return false;
+            for (const auto& x : a) {
+                const auto it = b.find(KeyOf{}(x));
+                if (it == b.end() || !(*it == x))
+                    return false;
+            }
+            return true;
+        }
+
+        friend bool operator!=(const swiss_table& a, const swiss_table& b) { return !(a == b); }
+
+    protected:
+        // std::hash of integers is usually the identity, whose low bits are too
+        // regular to be used directly, so the hash is mixed before being split
+        // into the group index (h1) and the 7 bits stored in the control tag (h2).
+        template<class Kx>
+        std::uint64_t mixed_hash(const Kx& k) const
+        {
+            std::uint64_t h = static_cast<std::uint64_t>(hash_(k)) * 0x9E3779B97F4A7C15ull;
+            return h ^ (h >> 32);
+        }
+
+        static std::int8_t h2(std::uint64_t h) { return static_cast<std::int8_t>(h & 0x7F); }
+
+        template<class Kx>
+        iterator find_impl(const Kx& k)
+        {
+            const size_type i = find_index(k);
+            return i == NOT_FOUND ? end() : iterator(ctrl_ + i, slots_ + i);
+        }
+
+        // Visits the groups in triangular order, which covers all of them when their number is a power of two.
+        // A group with an empty tag ends the search since the key would have been inserted there otherwise.
+        template<class Kx>
+        size_type find_index(const Kx& k) const
+        {
+            if (size_ == 0)
+                return NOT_FOUND;
+            const std::uint64_t h    = mixed_hash(k);
+            const size_type     mask = capacity_ / group::WIDTH - 1;
+            size_type g = static_cast<size_type>(h >> 7) & mask;
+            for (size_type step = 1; ; g = (g + step++) & mask) {
+                const group grp(ctrl_ + g * group::WIDTH);
+                for (auto m = grp.match(h2(h)); m; m &= m - 1) {
+                    const size_type i = g * group::WIDTH + std::countr_zero(m);
+                    if (eq_(KeyOf{}(slots_[i]), k))
+                        return i;
+                }
+                if (grp.match_empty() || step > mask)
+                    return NOT_FOUND;
+            }
+        }
+
+        template<class Kx, class... Args>
+        std::pair<iterator, bool> emplace_key(const Kx& k, Args&&... args)
+        {
+            if (const size_type i = find_index(k); i != NOT_FOUND)
+                return { iterator(ctrl_ + i, slots_ + i), false };
+
+            if (size_ + deleted_ + 1 > growth_limit(capacity_))
+                rehash(std::max(size_ + 1, size_ * 2)); // rehashing in place when there are a lot of deleted tags
+
+            const size_type i = insert_index(mixed_hash(k));
+            slot_traits::construct(alloc_, slots_ + i, std::forward<Args>(args)...);
+            return { iterator(ctrl_ + i, slots_ + i), true };
+        }
+
+        // Claims the first free slot along the probe sequence of hash h
+        size_type insert_index(std::uint64_t h)
+        {
+            const size_type mask = capacity_ / group::WIDTH - 1;
+            size_type g = static_cast<size_type>(h >> 7) & mask;
+            for (size_type step = 1; ; g = (g + step++) & mask) {
+                if (const auto m = group(ctrl_ + g * group::WIDTH).match_free()) {
+                    const size_type i = g * group::WIDTH + std::countr_zero(m);
+                    if (ctrl_[i] == group::DELETED)
+                        --deleted_;
+                    ctrl_[i] = h2(h);
+                    ++size_;
+                    return i;
+                }
+            }
+        }
+
+        void insert_unique_unchecked(const T& x)
+        {
+            const size_type i = insert_index(mixed_hash(KeyOf{}(x)));
+            slot_traits::construct(alloc_, slots_ + i, x);
+        }
+
+        // If the group still has an empty tag, no probe sequence ever went past it, so the
+        // slot can become empty again. Otherwise, it has to be marked as deleted (tombstone)
+        // so that the lookups of keys that did go past this group keep on going past it.
+        void erase_at(size_type i)
+        {
+            slot_traits::destroy(alloc_, slots_ + i);
+            const size_type g = i / group::WIDTH * group::WIDTH;
+            if (group(ctrl_ + g).match_empty()) {
+                ctrl_[i] = group::EMPTY;
+            } else {
+                ctrl_[i] = group::DELETED;
+                ++deleted_;
+            }
+            --size_;
+        }
+
+        size_type growth_limit(size_type cap) const { return static_cast<size_type>(cap * max_load_); }
+
+        void resize(size_type cap)
+        {
+            std::int8_t* old_ctrl  = ctrl_;
+            T*           old_slots = slots_;
+            size_type    old_cap   = capacity_;
+
+            ctrl_alloc ca(alloc_);
+            ctrl_     = cap ? ctrl_traits::allocate(ca, cap + 1) : nullptr;
+            slots_    = cap ? slot_traits::allocate(alloc_, cap) : nullptr;
+            capacity_ = cap;
+            size_     = 0;
+            deleted_  = 0;
+            if (cap) {
+                std::fill(ctrl_, ctrl_ + cap, group::EMPTY);
+                ctrl_[cap] = group::END;
+            }
+
+            for (size_type i = 0; i < old_cap; ++i) {
+                if (old_ctrl[i] >= 0) {
+                    const size_type j = insert_index(mixed_hash(KeyOf{}(old_slots[i])));
+                    slot_traits::construct(alloc_, slots_ + j, std::move(old_slots[i]));
+                    slot_traits::destroy(alloc_, old_slots + i);
+                }
+            }
+            if (old_cap) {
+                ctrl_traits::deallocate(ca, old_ctrl, old_cap + 1);
+                slot_traits::deallocate(alloc_, old_slots, old_cap);
+            }
+        }
+
+        void destroy()
+        {
+            if (!capacity_)
+                return;
+            clear();
+            ctrl_alloc ca(alloc_);
+            ctrl_traits::deallocate(ca, ctrl_, capacity_ + 1);
+            slot_traits::deallocate(alloc_, slots_, capacity_);
+            ctrl_     = nullptr;
+            slots_    = nullptr;
+            capacity_ = 0;
+        }
+
+        static constexpr size_type NOT_FOUND = static_cast<size_type>(-1);
+
+        std::int8_t* ctrl_     = nullptr;
+        T*           slots_    = nullptr;
+        size_type    capacity_ = 0; // always 0 or a power of two of at least a group width
+        size_type    size_     = 0;
+        size_type    deleted_  = 0;
+        H            hash_;
+        E            eq_;
+        A            alloc_;
+        float        max_load_ = 0.875f;
+    };
+} // namespace internal
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::flat_hash_set
+
+// Example: zen::flat_hash_set<int> s = { 1, 2, 3 };
+//          s.contains(2);
+template<class K, class H = std::hash<K>, class E = std::equal_to<K>, class A = std::allocator<K>>
+class flat_hash_set : public internal::swiss_table<K, K, internal::key_of_value, H, E, A>
+{
+public:
+    using internal::swiss_table<K, K, internal::key_of_value, H, E, A>::swiss_table; // inherit constructors, has to be explicit
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::flat_hash_map
+
+// Example: zen::flat_hash_map<zen::string, int> m = { {"a", 1} };
+//          m["b"] = 2;
+template<class K, class V, class H = std::hash<K>, class E = std::equal_to<K>, class A = std::allocator<std::pair<K, V>>>
+class flat_hash_map : public internal::swiss_table<K, std::pair<K, V>, internal::key_of_pair, H, E, A>
+{
+    using base = internal::swiss_table<K, std::pair<K, V>, internal::key_of_pair, H, E, A>;
+
+public:
+    using base::base; // inherit constructors, has to be explicit
+    using mapped_type = V;
+
+    V& operator[](const K& k) { return try_emplace(k).first->second; }
+    V& operator[](K&& k)      { return try_emplace(std::move(k)).first->second; }
+
+    V& at(const K& k)
+    {
+        auto it = base::find(k);
+        if (it == base::end())
+            throw std::out_of_range("zen::flat_hash_map::at() KEY NOT FOUND");
+        return it->second;
+    }
+
+    const V& at(const K& k) const
+    {
+        auto it = base::find(k);
+        if (it == base::end())
+            throw std::out_of_range("zen::flat_hash_map::at() KEY NOT FOUND");
+        return it->second;
+    }
+
+    // Unlike emplace(), doesn't construct anything if the key is already there
+    template<class Kx, class... Args>
+    std::pair<typename base::iterator, bool> try_emplace(Kx&& k, Args&&... args)
+    {
+        return base::emplace_key(k,
+            std::piecewise_construct,
+            std::forward_as_tuple(std::forward<Kx>(k)),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    template<class Vx>
+    std::pair<typename base::iterator, bool> insert_or_assign(const K& k, Vx&& v)
+    {
+        auto result = try_emplace(k, std::forward<Vx>(v));
+        if (!result.second)
+            result.first->second = std::forward<Vx>(v);
+        return result;
+    }
+};
+
+} // namespace zen
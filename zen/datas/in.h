@@ -22,43 +22,440 @@
 
 #pragma once
 
+#include <type_traits>
+#include <algorithm>
+#include <stdexcept>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+#include <array>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
+
 namespace zen {
 
+namespace internal {
+    // Start of the k-th of n contiguous parts of [0, size), the first size % n of which are one longer
+    constexpr size_t chunk_bound(size_t size, size_t k, size_t n)
+    {
+        if (n == 0 || k > n)
+            throw std::out_of_range("CHUNK INDEX OUT OF RANGE");
+        return size / n * k + std::min(k, size % n);
+    }
+} // namespace internal
+
 ///////////////////////////////////////////////////////////////////////////////////////////// zen::in
 
 // Declarative range-for loop. Note that apart from an intuitive
 // reading, "in" can also be thought of standing for "interval".
-// Example: for (int i : zen::in(5))         // from  0 to  5
-// Example: for (int i : zen::in(1, 10))     // from  1 to 10
-// Example: for (int i : zen::in(10, 1, -1)) // from 10 to  1, step -1
+// Example: for (int i : zen::in(5))            // from  0 to  5
+// Example: for (int i : zen::in(1, 10))        // from  1 to 10
+// Example: for (int i : zen::in(10, 1, -1))    // from 10 to  1, step -1
+// Example: for (auto x : zen::in(0.0, 1.0, .1)) // works with any arithmetic type
+//
+// The number of elements is computed once up front and the i-th element is
+// begin + i * step, so the loop has a known trip count (which helps compilers
+// vectorize it), never overflows near the limits of T, and is a random-access,
+// sized range that can be split up by parallel algorithms:
+// Example: auto r = zen::in(N);
+//          std::for_each(std::execution::par, r.begin(), r.end(), f);
+template<class T = int>
 class in {
+    ZEN_STATIC_ASSERT((std::is_arithmetic_v<T> && !std::is_same_v<T, bool>), "TEMPLATE PARAMETER EXPECTED TO BE ARITHMETIC, BUT IS NOT");
+
+    // Unsigned ranges can still be iterated backwards, so the step is signed
+    using step_type = typename std::conditional_t<std::is_integral_v<T>, std::make_signed<T>, std::type_identity<T>>::type;
+
+public:
+    using value_type      = T;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    constexpr in(T end)
+        : in(T(0), end, step_type(1)) {}
+
+    constexpr in(T begin, T end, step_type step = 1)
+        : begin_(begin), step_(step), size_(count(begin, end, step)) {}
+
+    // Like in std::vector<bool>, dereferencing yields a value rather than a
+    // reference, which is what lets the i-th element be computed on the fly
+    class iterator {
+    public:
+        using iterator_concept  = std::random_access_iterator_tag;
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using reference         = T;
+        using pointer           = void;
+
+        constexpr iterator() = default;
+        constexpr iterator(T begin, step_type step, difference_type i) : begin_(begin), step_(step), i_(i) {}
+
+        constexpr T operator*()                   const { return nth(begin_, step_, i_); }
+        constexpr T operator[](difference_type n) const { return nth(begin_, step_, i_ + n); }
+
+        constexpr iterator& operator++()    { ++i_; return *this; }
+        constexpr iterator& operator--()    { --i_; return *this; }
+        constexpr iterator  operator++(int) { auto t = *this; ++i_; return t; }
+        constexpr iterator  operator--(int) { auto t = *this; --i_; return t; }
+
+        constexpr iterator& operator+=(difference_type n) { i_ += n; return *this; }
+        constexpr iterator& operator-=(difference_type n) { i_ -= n; return *this; }
+
+        friend constexpr iterator operator+(iterator it, difference_type n) { return it += n; }
+        friend constexpr iterator operator+(difference_type n, iterator it) { return it += n; }
+        friend constexpr iterator operator-(iterator it, difference_type n) { return it -= n; }
+
+        friend constexpr difference_type operator-(const iterator& a, const iterator& b) { return a.i_ - b.i_; }
+
+        friend constexpr bool operator==(const iterator& a, const iterator& b) { return a.i_ == b.i_; }
+        friend constexpr bool operator!=(const iterator& a, const iterator& b) { return a.i_ != b.i_; }
+        friend constexpr bool operator< (const iterator& a, const iterator& b) { return a.i_ <  b.i_; }
+        friend constexpr bool operator> (const iterator& a, const iterator& b) { return a.i_ >  b.i_; }
+        friend constexpr bool operator<=(const iterator& a, const iterator& b) { return a.i_ <= b.i_; }
+        friend constexpr bool operator>=(const iterator& a, const iterator& b) { return a.i_ >= b.i_; }
+
+    private:
+        T               begin_ = 0;
+        step_type       step_  = 0;
+        difference_type i_     = 0;
+    };
+
+    using const_iterator = iterator;
+
+    constexpr iterator begin() const { return iterator(begin_, step_, 0); }
+    constexpr iterator end()   const { return iterator(begin_, step_, static_cast<difference_type>(size_)); }
+
+    constexpr T operator[](size_type i) const { return nth(begin_, step_, static_cast<difference_type>(i)); }
+
+    constexpr size_type size()     const { return size_; }
+    constexpr bool      empty()    const { return size_ == 0; }
+    constexpr bool      is_empty() const { return size_ == 0; }
+
+    // The k-th of n contiguous parts of roughly equal size, for splitting up work across threads
+    // Example: for (int i : zen::in(N).chunk(k, thread_count)) // run by thread k
+    constexpr in chunk(size_type k, size_type n) const
+    {
+        const size_type lo = internal::chunk_bound(size_, k,     n);
+        const size_type hi = internal::chunk_bound(size_, k + 1, n);
+        return in(nth(begin_, step_, static_cast<difference_type>(lo)), step_, hi - lo, sized{});
+    }
+
+private:
+    struct sized {}; // disambiguates from the public (begin, end, step) constructor
+
+    constexpr in(T begin, step_type step, size_type size, sized)
+        : begin_(begin), step_(step), size_(size) {}
+
+    // Integers are computed in the unsigned domain, where wraparound is well-defined
+    // and yields the right result whenever the true result is representable in T
+    static constexpr T nth(T begin, step_type step, difference_type i)
+    {
+        if constexpr (std::is_integral_v<T>) {
+            using U = std::make_unsigned_t<std::common_type_t<T, difference_type>>;
+            return static_cast<T>(static_cast<U>(begin) + static_cast<U>(i) * static_cast<U>(step));
+        } else {
+            return begin + static_cast<T>(i) * step;
+        }
+    }
+
+    static constexpr size_type count(T begin, T end, step_type step)
+    {
+        if (step == 0)
+            throw std::invalid_argument("zen::in STEP CANNOT BE ZERO");
+
+        if constexpr (std::is_integral_v<T>) {
+            using U = std::make_unsigned_t<T>;
+            // Both the distance and the magnitude of the step always fit into U, even for extremes like
+            // zen::in(INT_MIN, INT_MAX, INT_MAX), where their signed counterparts would overflow
+            if (step > 0 && begin < end) return static_cast<size_type>((U(U(end) - U(begin)) - 1) / U(step)         + 1);
+            if (step < 0 && begin > end) return static_cast<size_type>((U(U(begin) - U(end)) - 1) / U(U(0) - U(step)) + 1);
+            return 0;
+        } else {
+            const T n = (end - begin) / step;
+            if (!(n > 0)) // also catches NaN
+                return 0;
+            if (!(n < static_cast<T>(PTRDIFF_MAX)))
+                throw std::overflow_error("zen::in HAS TOO MANY ELEMENTS TO ITERATE");
+            const auto whole = static_cast<size_type>(n);
+            return static_cast<T>(whole) < n ? whole + 1 : whole; // constexpr ceil()
+        }
+    }
+
+    T         begin_;
+    step_type step_;
+    size_type size_;
+};
+
+// Deduces zen::in(0, 10.0) as zen::in<double> and zen::in(10u, 0u, -1) as zen::in<unsigned>
+// (an integral step doesn't affect the type since it's allowed to be negative for unsigned T)
+template<class B, class E>
+in(B, E) -> in<std::common_type_t<B, E>>;
+template<class B, class E, class S>
+in(B, E, S) -> in<std::common_type_t<B, E, std::conditional_t<std::is_floating_point_v<S>, S, B>>>;
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::in_nd
+
+// Multi-dimensional zen::in. Yields index tuples in row-major order (the
+// last index changes fastest), so a single loop replaces a nest of loops.
+// Example: for (auto [i, j] : zen::in_nd({H, W})) // same as two nested zen::in loops
+// Like zen::in, it's a sized random-access range that can be split into chunks.
+template<size_t N, class T = int>
+class in_nd {
+    ZEN_STATIC_ASSERT((std::is_integral_v<T> && !std::is_same_v<T, bool>), "TEMPLATE PARAMETER EXPECTED TO BE INTEGRAL, BUT IS NOT");
+    ZEN_STATIC_ASSERT(N > 0, "zen::in_nd NEEDS AT LEAST ONE DIMENSION");
+
+public:
+    using index_type      = std::array<T, N>;
+    using value_type      = index_type;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    constexpr in_nd(const T (&extents)[N])         : in_nd(to_array(extents)) {}
+    constexpr in_nd(const index_type& extents)     : extents_(extents), first_(0), last_(volume(extents)) {}
+
+    // Walks the indices like an odometer, so moving to the next index is
+    // an increment and a compare, while jumps are done with div and mod
+    class iterator {
+    public:
+        using iterator_concept  = std::random_access_iterator_tag;
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = index_type;
+        using difference_type   = std::ptrdiff_t;
+        using reference         = index_type;
+        using pointer           = void;
+
+        constexpr iterator() = default;
+        constexpr iterator(const index_type& extents, size_type i)
+            : extents_(extents), index_(unravel(extents, i)), i_(i) {}
+
+        constexpr index_type operator*()                   const { return index_; }
+        constexpr index_type operator[](difference_type n) const { return unravel(extents_, i_ + n); }
+
+        constexpr iterator& operator++()
+        {
+            ++i_;
+            for (size_t d = N; d-- > 0; ) {
+                if (++index_[d] < extents_[d] || d == 0)
+                    return *this;
+                index_[d] = 0;
+            }
+            return *this;
+        }
+
+        constexpr iterator& operator--()    { return *this -= 1; }
+        constexpr iterator  operator++(int) { auto t = *this; ++*this; return t; }
+        constexpr iterator  operator--(int) { auto t = *this; --*this; return t; }
+
+        constexpr iterator& operator+=(difference_type n) { i_ += n; index_ = unravel(extents_, i_); return *this; }
+        constexpr iterator& operator-=(difference_type n) { return *this += -n; }
+
+        friend constexpr iterator operator+(iterator it, difference_type n) { return it += n; }
+        friend constexpr iterator operator+(difference_type n, iterator it) { return it += n; }
+        friend constexpr iterator operator-(iterator it, difference_type n) { return it -= n; }
+
+        friend constexpr difference_type operator-(const iterator& a, const iterator& b) {
+            return static_cast<difference_type>(a.i_) - static_cast<difference_type>(b.i_);
+        }
+
+        friend constexpr bool operator==(const iterator& a, const iterator& b) { return a.i_ == b.i_; }
+        friend constexpr bool operator!=(const iterator& a, const iterator& b) { return a.i_ != b.i_; }
+        friend constexpr bool operator< (const iterator& a, const iterator& b) { return a.i_ <  b.i_; }
+        friend constexpr bool operator> (const iterator& a, const iterator& b) { return a.i_ >  b.i_; }
+        friend constexpr bool operator<=(const iterator& a, const iterator& b) { return a.i_ <= b.i_; }
+        friend constexpr bool operator>=(const iterator& a, const iterator& b) { return a.i_ >= b.i_; }
+
+    private:
+        index_type extents_{};
+        index_type index_{};
+        size_type  i_ = 0;
+    };
+
+    using const_iterator = iterator;
+
+    constexpr iterator begin() const { return iterator(extents_, first_); }
+    constexpr iterator end()   const { return iterator(extents_, last_);  }
+
+    constexpr index_type operator[](size_type i) const { return unravel(extents_, first_ + i); }
+
+    constexpr size_type size()     const { return last_ - first_; }
+    constexpr bool      empty()    const { return last_ == first_; }
+    constexpr bool      is_empty() const { return last_ == first_; }
+
+    constexpr const index_type& extents() const { return extents_; }
+
+    // The k-th of n contiguous parts of roughly equal size, for splitting up work across threads
+    constexpr in_nd chunk(size_type k, size_type n) const
+    {
+        in_nd part = *this;
+        part.first_ = first_ + internal::chunk_bound(size(), k,     n);
+        part.last_  = first_ + internal::chunk_bound(size(), k + 1, n);
+        return part;
+    }
+
+    // Negative extents are treated as zero, just like zen::in(-5) is empty
+    static constexpr size_type volume(const index_type& extents)
+    {
+        size_type v = 1;
+        for (const T e : extents)
+            v *= e > 0 ? static_cast<size_type>(e) : 0;
+        return v;
+    }
+
+    static constexpr index_type unravel(const index_type& extents, size_type i)
+    {
+        index_type index{};
+        for (size_t d = N; d-- > 1; ) {
+            const auto e = extents[d] > 0 ? static_cast<size_type>(extents[d]) : 0;
+            if (e == 0)
+                return index; // empty, so there's nothing to unravel
+            index[d] = static_cast<T>(i % e);
+            i /= e;
+        }
+        index[0] = static_cast<T>(i); // the first index is unbounded so that end() unravels too
+        return index;
+    }
+
+private:
+    static constexpr index_type to_array(const T (&a)[N])
+    {
+        index_type r{};
+        for (size_t d = 0; d < N; ++d)
+            r[d] = a[d];
+        return r;
+    }
+
+    index_type extents_;
+    size_type  first_;
+    size_type  last_;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::tiled
+
+// Visits all indices of a zen::in_nd block by block, where each block (tile) is
+// small enough to stay in cache, which is what transposes and stencils need.
+// Tiles are visited in row-major order, and so are the indices inside each tile.
+// Tiles at the far edges are cut short if the extents aren't multiples of the tile sizes.
+// Example: for (auto [i, j] : zen::tiled(zen::in_nd({H, W}), {32, 32}))
+//              b[j][i] = a[i][j]; // cache-blocked transpose
+// Splitting into chunks happens at tile boundaries, so each thread gets whole tiles.
+template<size_t N, class T = int>
+class tiled {
 public:
-    in(int end)
-        : begin_(0), end_(end), step_(1) {}
+    using index_type = std::array<T, N>;
+    using size_type  = std::size_t;
 
-    in(int begin, int end, int step = 1)
-        : begin_(begin), end_(end), step_(step) {}
+    constexpr tiled(const in_nd<N, T>& r, const std::type_identity_t<T> (&tile)[N])
+        : extents_(r.extents())
+    {
+        for (size_t d = 0; d < N; ++d) {
+            if (tile[d] <= 0)
+                throw std::invalid_argument("zen::tiled TILE SIZES MUST BE POSITIVE");
+            tile_[d]  = tile[d];
+            tiles_[d] = extents_[d] > 0 ? static_cast<T>((extents_[d] - 1) / tile[d] + 1) : T(0);
+        }
+        last_ = in_nd<N, T>::volume(tiles_);
+    }
 
     class iterator {
     public:
-        iterator(int n = 0, int step = 1) : n_(n), step_(step) {}
-        iterator& operator++() { n_ += step_; return *this; }
-        const int& operator*()             const { return n_; }
-        bool operator!=(const iterator& x) const {
-            return (step_ > 0) ? (n_ < x.n_) : (n_ > x.n_);
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = index_type;
+        using difference_type   = std::ptrdiff_t;
+        using reference         = index_type;
+        using pointer           = void;
+
+        constexpr iterator() = default;
+        constexpr iterator(const tiled* t, size_type tile) : t_(t), tile_(tile) { enter_tile(); }
+
+        constexpr index_type operator*() const
+        {
+            index_type index{};
+            for (size_t d = 0; d < N; ++d)
+                index[d] = static_cast<T>(origin_[d] + offset_[d]);
+            return index;
         }
+
+        constexpr iterator& operator++()
+        {
+            for (size_t d = N; d-- > 0; ) {
+                if (++offset_[d] < limit_[d])
+                    return *this;
+                offset_[d] = 0;
+            }
+            ++tile_;
+            enter_tile();
+            return *this;
+        }
+
+        constexpr iterator operator++(int) { auto t = *this; ++*this; return t; }
+
+        friend constexpr bool operator==(const iterator& a, const iterator& b) { return a.tile_ == b.tile_ && a.offset_ == b.offset_; }
+        friend constexpr bool operator!=(const iterator& a, const iterator& b) { return !(a == b); }
+
     private:
-        int n_;
-        int step_;
+        constexpr void enter_tile()
+        {
+            if (tile_ >= t_->last_)
+                return;
+            const index_type t = in_nd<N, T>::unravel(t_->tiles_, tile_);
+            for (size_t d = 0; d < N; ++d) {
+                origin_[d] = static_cast<T>(t[d] * t_->tile_[d]);
+                limit_[d]  = std::min<T>(t_->tile_[d], static_cast<T>(t_->extents_[d] - origin_[d]));
+            }
+        }
+
+        const tiled* t_ = nullptr;
+        size_type    tile_ = 0;
+        index_type   origin_{};
+        index_type   offset_{};
+        index_type   limit_{};
     };
 
-    iterator begin() const { return iterator(begin_, step_); }
-    iterator end()   const { return iterator(end_,   step_); }
+    using const_iterator = iterator;
+
+    constexpr iterator begin() const { return iterator(this, first_); }
+    constexpr iterator end()   const { return iterator(this, last_);  }
+
+    // Total number of indices in all the tiles of this range
+    constexpr size_type size() const
+    {
+        if (first_ == 0 && last_ == in_nd<N, T>::volume(tiles_))
+            return in_nd<N, T>::volume(extents_);
+        size_type n = 0;
+        for (size_type t = first_; t < last_; ++t) {
+            const index_type tt = in_nd<N, T>::unravel(tiles_, t);
+            size_type v = 1;
+            for (size_t d = 0; d < N; ++d)
+                v *= static_cast<size_type>(std::min<T>(tile_[d], static_cast<T>(extents_[d] - tt[d] * tile_[d])));
+            n += v;
+        }
+        return n;
+    }
+
+    constexpr bool empty()    const { return first_ == last_; }
+    constexpr bool is_empty() const { return first_ == last_; }
+
+    constexpr size_type tile_count() const { return last_ - first_; }
+
+    // The k-th of n contiguous runs of whole tiles, for splitting up work across threads
+    constexpr tiled chunk(size_type k, size_type n) const
+    {
+        tiled part = *this;
+        part.first_ = first_ + internal::chunk_bound(tile_count(), k,     n);
+        part.last_  = first_ + internal::chunk_bound(tile_count(), k + 1, n);
+        return part;
+    }
 
 private:
-    int begin_;
-    int end_;
-    int step_;
+    index_type extents_{};
+    index_type tile_{};
+    index_type tiles_{}; // number of tiles along each dimension
+    size_type  first_ = 0;
+    size_type  last_  = 0;
 };
 
+template<size_t N, class T>
+tiled(const in_nd<N, T>&, const T (&)[N]) -> tiled<N, T>;
+
 } // namespace zen
\ No newline at end of file
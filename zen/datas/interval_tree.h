@@ -0,0 +1,273 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <initializer_list>
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+#include <utility>
+#include <numeric>
+#include <vector>
+#include <array>
+#include <span>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
+
+namespace zen {
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::interval_tree
+
+// A collection of closed intervals [lo, hi] with values, answering which intervals contain
+// a point (stabbing) or overlap a range. A query visits O(min(n, k log n)) nodes for k
+// results in the worst case, and close to O(log n + k) when the intervals are of similar
+// lengths, since then few subtrees reach past a query without overlapping it. It's a static, flat
+// interval tree: the intervals are kept in one array sorted by lo, which is read as the
+// in-order layout of an implicit balanced binary tree whose nodes are also annotated with
+// the highest hi in their subtree, so a query skips every subtree that ends before it
+// starts. There are no nodes or pointers, and the search reads a separate compact array
+// of the bounds only. Like zen::flat_map, it's built for read-mostly data: construction
+// from a range is O(n log n), while a single insert() or erase_if() is O(n).
+// Results come in ascending order of lo. Batch queries answer many ranges in one call.
+// Example: zen::interval_tree<int, zen::string> windows = { {9, 17, "work"}, {12, 13, "lunch"} };
+//          windows.for_each_containing(12, [](const auto& w) { ... });   // work, lunch
+//          windows.any_overlapping(18, 20);                               // false
+template<class K, class V>
+class interval_tree : private zen::stackonly
+{
+public:
+    struct interval {
+        K lo;
+        K hi;
+        V value;
+    };
+
+    using key_type       = K;
+    using mapped_type    = V;
+    using value_type     = interval;
+    using size_type      = std::size_t;
+    using const_iterator = typename std::vector<interval>::const_iterator;
+    using iterator       = const_iterator;
+
+    interval_tree() = default;
+
+    interval_tree(std::initializer_list<interval> il) : items_(il) { build(); }
+
+    template<std::input_iterator It>
+    interval_tree(It first, It last) : items_(first, last) { build(); }
+
+    size_type size()     const { return items_.size();  }
+    bool      empty()    const { return items_.empty(); }
+    bool      is_empty() const { return items_.empty(); }
+
+    // The intervals in ascending order of lo
+    const_iterator begin() const { return items_.cbegin(); }
+    const_iterator end()   const { return items_.cend();   }
+
+    // ------------------------------------------------------------------------------------------ changes
+
+    void insert(K lo, K hi, V value)
+    {
+        const auto at = std::upper_bound(items_.begin(), items_.end(), lo, [](const K& k, const interval& x) { return k < x.lo; });
+        items_.insert(at, interval{ std::move(lo), std::move(hi), std::move(value) });
+        index();
+    }
+
+    template<class Pred>
+    size_type erase_if(Pred pred)
+    {
+        const size_type before = items_.size();
+        items_.erase(std::remove_if(items_.begin(), items_.end(), pred), items_.end());
+        if (items_.size() != before)
+            index();
+        return before - items_.size();
+    }
+
+    void clear()
+    {
+        items_.clear();
+        bounds_.clear();
+        levels_ = 0;
+    }
+
+    // ------------------------------------------------------------------------------------------ queries
+
+    // Calls f with each interval that shares at least one point with [lo, hi]
+    template<class F>
+    void for_each_overlapping(const K& lo, const K& hi, F f) const
+    {
+        search(lo, hi, [&](size_type i) { f(items_[i]); return true; });
+    }
+
+    // Calls f with each interval that contains p
+    template<class F>
+    void for_each_containing(const K& p, F f) const { for_each_overlapping(p, p, f); }
+
+    std::vector<const interval*> overlapping(const K& lo, const K& hi) const
+    {
+        std::vector<const interval*> found;
+        search(lo, hi, [&](size_type i) { found.push_back(&items_[i]); return true; });
+        return found;
+    }
+
+    std::vector<const interval*> containing(const K& p) const { return overlapping(p, p); }
+
+    size_type count_overlapping(const K& lo, const K& hi) const
+    {
+        size_type n = 0;
+        search(lo, hi, [&](size_type) { ++n; return true; });
+        return n;
+    }
+
+    bool any_overlapping(const K& lo, const K& hi) const
+    {
+        bool found = false;
+        search(lo, hi, [&](size_type) { found = true; return false; });
+        return found;
+    }
+
+    bool any_containing(const K& p) const { return any_overlapping(p, p); }
+
+    // Answers a batch of [lo, hi] queries, calling f(q, interval) with the index q of each
+    // query and every interval overlapping it. The queries run in ascending order of lo, so
+    // consecutive ones walk mostly the same parts of the tree, which are then still cached.
+    template<class F>
+    void for_each_overlapping(std::span<const std::pair<K, K>> queries, F f) const
+    {
+        for (size_type q : by_lo(queries))
+            search(queries[q].first, queries[q].second, [&](size_type i) { f(q, items_[i]); return true; });
+    }
+
+    // The number of intervals overlapping each query of a batch
+    std::vector<size_type> count_overlapping(std::span<const std::pair<K, K>> queries) const
+    {
+        std::vector<size_type> counts(queries.size());
+        for (size_type q : by_lo(queries))
+            counts[q] = count_overlapping(queries[q].first, queries[q].second);
+        return counts;
+    }
+
+private:
+    struct bounds {
+        K lo;
+        K hi;
+        K max; // the highest hi in the subtree of this node
+    };
+
+    void build()
+    {
+        std::stable_sort(items_.begin(), items_.end(), [](const interval& a, const interval& b) { return a.lo < b.lo; });
+        index();
+    }
+
+    // Annotates the implicit tree, in which leaves are at even indices and a node at level
+    // k (with k trailing 1 bits in its index i) has children at i - 2^(k-1) and i + 2^(k-1).
+    // A node's right subtree may run past the end of the array, and then it takes the max
+    // of the last node that does exist in it.
+    void index()
+    {
+        const size_type n = items_.size();
+        bounds_.clear();
+        bounds_.reserve(n);
+        for (const auto& x : items_)
+            bounds_.push_back({ x.lo, x.hi, x.hi });
+        levels_ = 0;
+        if (n == 0)
+            return;
+
+        size_type last_i = (n - 1) & ~size_type{ 1 }; // the last leaf
+        K last = bounds_[last_i].max;
+
+        int k = 1;
+        for (; (size_type{ 1 } << k) <= n; ++k) {
+            const size_type x    = size_type{ 1 } << (k - 1);
+            const size_type step = x << 2;
+            for (size_type i = (x << 1) - 1; i < n; i += step) {
+                const K& left  = bounds_[i - x].max;
+                const K& right = i + x < n ? bounds_[i + x].max : last;
+                bounds_[i].max = std::max({ bounds_[i].hi, left, right });
+            }
+            last_i = (last_i >> k & 1) ? last_i - x : last_i + x;
+            if (last_i < n && last < bounds_[last_i].max)
+                last = bounds_[last_i].max;
+        }
+        levels_ = k - 1;
+    }
+
+    // Calls visit(i) for each overlapping interval in order of lo, as long as it returns true
+    template<class Visit>
+    void search(const K& lo, const K& hi, Visit visit) const
+    {
+        const size_type n = bounds_.size();
+        if (n == 0)
+            return;
+
+        struct frame {
+            size_type x;     // the node
+            int       k;     // its level
+            bool      left;  // whether its left subtree is done
+        };
+
+        std::array<frame, 2 * (sizeof(size_type) * 8 + 1)> stack;
+        int top = 0;
+        stack[top++] = { (size_type{ 1 } << levels_) - 1, levels_, false };
+
+        while (top > 0) {
+            const frame z = stack[--top];
+            if (z.k <= 3) {
+                // Small subtrees are quicker to scan straight through
+                const size_type first = z.x >> z.k << z.k;
+                const size_type last  = std::min(n, first + (size_type{ 2 } << z.k) - 1);
+                for (size_type i = first; i < last && !(hi < bounds_[i].lo); ++i)
+                    if (!(bounds_[i].hi < lo) && !visit(i))
+                        return;
+            }
+            else if (!z.left) {
+                const size_type y = z.x - (size_type{ 1 } << (z.k - 1));
+                stack[top++] = { z.x, z.k, true };
+                if (y >= n || !(bounds_[y].max < lo))
+                    stack[top++] = { y, z.k - 1, false };
+            }
+            else if (z.x < n && !(hi < bounds_[z.x].lo)) {
+                if (!(bounds_[z.x].hi < lo) && !visit(z.x))
+                    return;
+                stack[top++] = { z.x + (size_type{ 1 } << (z.k - 1)), z.k - 1, false };
+            }
+        }
+    }
+
+    static std::vector<size_type> by_lo(std::span<const std::pair<K, K>> queries)
+    {
+        std::vector<size_type> order(queries.size());
+        std::iota(order.begin(), order.end(), size_type{ 0 });
+        std::sort(order.begin(), order.end(), [&](size_type a, size_type b) { return queries[a].first < queries[b].first; });
+        return order;
+    }
+
+    std::vector<interval> items_;      // sorted by lo
+    std::vector<bounds>   bounds_;     // the same intervals, with the subtree maxima, for searching
+    int                   levels_ = 0; // the level of the root
+};
+
+} // namespace zen
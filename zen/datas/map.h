@@ -65,14 +65,14 @@ public:
     // zen::map::operator[] returns an std::vector
     // composed of values corresponding to the parameter key.
     std::vector<V> operator[](const K& key) {
-        auto range = my::equal_range(key);
-        std::vector<V> values;
-        for (auto it = range.first; it != range.second; ++it) {
-            values.push_back(it->second);
-        }
-        return values;
+        return values(key).template to<std::vector<V>>();
     }
 
+    // The values corresponding to the key, in place and without the copies of operator[]
+    // Example: for (const auto& v : mm.values(key)) { ... }
+    auto values(const K& key)       { return zen::values_view(my::equal_range(key)); }
+    auto values(const K& key) const { return zen::values_view(my::equal_range(key)); }
+
     bool is_empty() const { return my::empty(); }
 
 private:
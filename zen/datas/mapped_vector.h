@@ -0,0 +1,325 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+#include <system_error>
+#include <type_traits>
+#include <filesystem>
+#include <algorithm>
+#include <stdexcept>
+#include <cstddef>
+#include <utility>
+#include <cerrno>
+#include <span>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
+
+namespace zen {
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ZEN_MMAP
+#endif
+
+#ifdef ZEN_MMAP
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::mapped_vector
+
+// A vector of trivially copyable elements whose memory is a file mapped with mmap, so a
+// dataset of any size opens instantly, pages in only as it's read, and is shared (not
+// copied) by every process that maps the same file. The file holds the elements and
+// nothing else, the way numeric columns are usually stored, and its length is the size
+// of the vector once it's closed. While open, the file grows ahead of the size the way
+// a vector's capacity does (with ftruncate, and mremap on Linux), and sync() writes the
+// changes through to disk. In read-only mode the mapping can't be changed at all, and
+// writing to an element through data() or a non-const operator[] crashes with SIGSEGV.
+// Available on POSIX systems, where ZEN_MMAP is defined.
+// Example: zen::mapped_vector<double> prices("prices.bin");   // created if it isn't there
+//          prices.push_back(9.99);
+//          prices.sync();
+//          zen::mapped_vector<double> view("prices.bin", zen::mapped_vector<double>::mode::read_only);
+template<class T>
+    requires std::is_trivially_copyable_v<T>
+class mapped_vector : private zen::stackonly
+{
+public:
+    using value_type      = T;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference       = T&;
+    using const_reference = const T&;
+    using iterator        = T*;
+    using const_iterator  = const T*;
+
+    enum class mode { read_write, read_only };
+
+    explicit mapped_vector(const std::filesystem::path& path, mode m = mode::read_write) : path_(path), mode_(m)
+    {
+        fd_ = ::open(path.c_str(), m == mode::read_only ? O_RDONLY : O_RDWR | O_CREAT, 0644);
+        if (fd_ < 0)
+            throw std::system_error(errno, std::generic_category(), "zen::mapped_vector CAN'T OPEN " + path.string());
+
+        struct stat st {};
+        if (::fstat(fd_, &st) != 0) {
+            const int error = errno;
+            ::close(fd_);
+            throw std::system_error(error, std::generic_category(), "zen::mapped_vector CAN'T READ THE SIZE OF " + path.string());
+        }
+        const auto bytes = static_cast<size_type>(st.st_size);
+        if (bytes % sizeof(T) != 0) {
+            ::close(fd_);
+            throw std::runtime_error("zen::mapped_vector FILE SIZE ISN'T A MULTIPLE OF THE ELEMENT SIZE: " + path.string());
+        }
+
+        size_ = capacity_ = bytes / sizeof(T);
+        if (capacity_ > 0) {
+            try {
+                map(capacity_);
+            } catch (...) {
+                ::close(fd_);
+                throw;
+            }
+        }
+    }
+
+    mapped_vector(const mapped_vector&)            = delete;
+    mapped_vector& operator=(const mapped_vector&) = delete;
+
+    mapped_vector(mapped_vector&& other) noexcept
+        : path_(std::move(other.path_)), mode_(other.mode_), fd_(std::exchange(other.fd_, -1))
+        , data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)), capacity_(std::exchange(other.capacity_, 0)) {}
+
+    mapped_vector& operator=(mapped_vector&& other) noexcept
+    {
+        if (this != &other) {
+            close();
+            path_     = std::move(other.path_);
+            mode_     = other.mode_;
+            fd_       = std::exchange(other.fd_, -1);
+            data_     = std::exchange(other.data_, nullptr);
+            size_     = std::exchange(other.size_, 0);
+            capacity_ = std::exchange(other.capacity_, 0);
+        }
+        return *this;
+    }
+
+    ~mapped_vector() { close(); }
+
+    // ------------------------------------------------------------------------------------------ access
+
+    size_type size()     const { return size_;      }
+    size_type capacity() const { return capacity_;  }
+    bool      empty()    const { return size_ == 0; }
+    bool      is_empty() const { return size_ == 0; }
+
+    bool is_read_only() const { return mode_ == mode::read_only; }
+
+    const std::filesystem::path& path() const { return path_; }
+
+    T*       data()       { return data_; }
+    const T* data() const { return data_; }
+
+    T&       operator[](size_type i)       { return data_[i]; }
+    const T& operator[](size_type i) const { return data_[i]; }
+
+    T& at(size_type i)
+    {
+        if (i >= size_)
+            throw std::out_of_range("zen::mapped_vector::at() INDEX OUT OF RANGE");
+        return data_[i];
+    }
+
+    const T& at(size_type i) const { return const_cast<mapped_vector*>(this)->at(i); }
+
+    T&       front()       { return data_[0];         }
+    const T& front() const { return data_[0];         }
+    T&       back()        { return data_[size_ - 1]; }
+    const T& back()  const { return data_[size_ - 1]; }
+
+    iterator       begin()       { return data_;         }
+    const_iterator begin() const { return data_;         }
+    iterator       end()         { return data_ + size_; }
+    const_iterator end()   const { return data_ + size_; }
+
+    template<class Pred>
+    typename std::enable_if<std::is_invocable_r<bool, Pred, const T&>::value, bool>::type
+        contains(Pred p) const
+    {
+        return std::find_if(begin(), end(), p) != end();
+    }
+
+    bool contains(const T& x) const { return std::find(begin(), end(), x) != end(); }
+
+    // ------------------------------------------------------------------------------------------ changes
+
+    void push_back(const T& x)
+    {
+        if (size_ == capacity_)
+            grow(size_ + 1);
+        data_[size_++] = x;
+    }
+
+    void append(std::span<const T> xs)
+    {
+        if (xs.empty())
+            return;
+        if (size_ + xs.size() > capacity_)
+            grow(size_ + xs.size());
+        std::copy(xs.begin(), xs.end(), data_ + size_);
+        size_ += xs.size();
+    }
+
+    void pop_back()
+    {
+        check_writable();
+        --size_;
+    }
+
+    void resize(size_type n, const T& x = T())
+    {
+        if (n > capacity_)
+            reserve(n);
+        else
+            check_writable();
+        if (n > size_)
+            std::fill(data_ + size_, data_ + n, x);
+        size_ = n;
+    }
+
+    void reserve(size_type n)
+    {
+        check_writable();
+        if (n > capacity_)
+            remap(n);
+    }
+
+    void clear()
+    {
+        check_writable();
+        size_ = 0;
+    }
+
+    // Gives the file's space beyond the size back to the file system
+    void shrink_to_fit()
+    {
+        check_writable();
+        if (size_ < capacity_)
+            remap(size_);
+    }
+
+    // Writes the changed pages through to the file and waits until they're on disk
+    void sync()
+    {
+        check_writable();
+        if (data_ && ::msync(data_, capacity_ * sizeof(T), MS_SYNC) != 0)
+            throw std::system_error(errno, std::generic_category(), "zen::mapped_vector CAN'T SYNC " + path_.string());
+    }
+
+private:
+    void check_writable() const
+    {
+        if (mode_ == mode::read_only)
+            throw std::logic_error("zen::mapped_vector IS READ-ONLY: " + path_.string());
+    }
+
+    // Doubles the capacity, as zen::vector would, but in whole pages of the file
+    void grow(size_type needed)
+    {
+        check_writable();
+        const size_type page = static_cast<size_type>(::sysconf(_SC_PAGESIZE));
+        const size_type least = (page + sizeof(T) - 1) / sizeof(T);
+        reserve(std::max({ needed, 2 * capacity_, least }));
+    }
+
+    void map(size_type n)
+    {
+        const int prot = mode_ == mode::read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+        void* p = ::mmap(nullptr, n * sizeof(T), prot, MAP_SHARED, fd_, 0);
+        if (p == MAP_FAILED)
+            throw std::system_error(errno, std::generic_category(), "zen::mapped_vector CAN'T MAP " + path_.string());
+        data_ = static_cast<T*>(p);
+    }
+
+    // Resizes the file to n elements and the mapping along with it
+    void remap(size_type n)
+    {
+        if (::ftruncate(fd_, static_cast<off_t>(n * sizeof(T))) != 0)
+            throw std::system_error(errno, std::generic_category(), "zen::mapped_vector CAN'T RESIZE " + path_.string());
+
+        if (n == 0) {
+            unmap();
+        }
+        else if (!data_) {
+            map(n);
+        }
+        else {
+#ifdef __linux__
+            void* p = ::mremap(data_, capacity_ * sizeof(T), n * sizeof(T), MREMAP_MAYMOVE);
+            if (p == MAP_FAILED)
+                throw std::system_error(errno, std::generic_category(), "zen::mapped_vector CAN'T REMAP " + path_.string());
+            data_ = static_cast<T*>(p);
+#else
+            unmap();
+            map(n);
+#endif
+        }
+        capacity_ = n;
+    }
+
+    void unmap()
+    {
+        if (data_)
+            ::munmap(data_, capacity_ * sizeof(T));
+        data_ = nullptr;
+    }
+
+    // Leaves the file exactly as long as the elements in it
+    void close()
+    {
+        if (fd_ < 0)
+            return;
+        unmap();
+        if (mode_ == mode::read_write && capacity_ != size_)
+            (void)::ftruncate(fd_, static_cast<off_t>(size_ * sizeof(T)));
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+    std::filesystem::path path_;
+    mode                  mode_;
+    int                   fd_       = -1;
+    T*                    data_     = nullptr;
+    size_type             size_     = 0;
+    size_type             capacity_ = 0;
+};
+
+#endif // ZEN_MMAP
+
+} // namespace zen
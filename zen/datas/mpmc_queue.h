@@ -0,0 +1,281 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <type_traits>
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+#include <utility>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <bit>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
+
+namespace zen {
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::mpmc_queue
+
+// A bounded lock-free queue for any number of producer and consumer threads,
+// after Dmitry Vyukov's design: a ring of slots, each with a sequence number
+// that tells whose turn it is to use the slot, so that threads only ever
+// contend on the two positions (padded to cache lines of their own) and
+// never on a lock. The capacity is rounded up to a power of two.
+// 
+// The try_ functions never block and report whether they succeeded. The
+// others claim a position right away and then wait for their slot, sleeping
+// in the kernel (std::atomic::wait, a futex on Linux) rather than spinning.
+// 
+// Example: zen::mpmc_queue<job> q(1024);
+//          q.push(job{...}); // on producer threads
+//          job j = q.pop();  // on consumer threads
+template<class T>
+class mpmc_queue : private zen::stackonly
+{
+    // Values are moved out of slots that have already been handed over, so there's no way back
+    ZEN_STATIC_ASSERT(std::is_nothrow_move_constructible_v<T>, "zen::mpmc_queue ELEMENTS MUST BE NOTHROW MOVE CONSTRUCTIBLE");
+    ZEN_STATIC_ASSERT(std::is_nothrow_destructible_v<T>,       "zen::mpmc_queue ELEMENTS MUST BE NOTHROW DESTRUCTIBLE");
+
+public:
+    using value_type = T;
+    using size_type  = std::size_t;
+
+    explicit mpmc_queue(size_type capacity)
+    {
+        if (capacity == 0)
+            throw std::invalid_argument("zen::mpmc_queue CAPACITY MUST BE POSITIVE");
+
+        mask_  = std::bit_ceil(std::max<size_type>(capacity, 2)) - 1;
+        slots_ = std::make_unique<slot[]>(mask_ + 1);
+        for (size_type i = 0; i <= mask_; ++i)
+            slots_[i].turn.store(i, std::memory_order_relaxed);
+    }
+
+    mpmc_queue(const mpmc_queue&)            = delete;
+    mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+    // No other thread may be using the queue by now
+    ~mpmc_queue()
+    {
+        const auto tail = enqueue_pos_.load(std::memory_order_acquire);
+        for (auto pos = dequeue_pos_.load(std::memory_order_acquire); pos < tail; ++pos)
+            slots_[pos & mask_].get()->~T();
+    }
+
+    size_type capacity() const { return mask_ + 1; }
+
+    // Only a hint while other threads are pushing or popping
+    size_type size() const
+    {
+        const auto tail = enqueue_pos_.load(std::memory_order_acquire);
+        const auto head = dequeue_pos_.load(std::memory_order_acquire);
+        return tail > head ? std::min(tail - head, capacity()) : 0;
+    }
+
+    bool empty()    const { return size() == 0; }
+    bool is_empty() const { return size() == 0; }
+
+    // ------------------------------------------------------------------------------------------ non-blocking
+
+    // Returns false right away if the queue is full
+    template<class... Args>
+    bool try_emplace(Args&&... args)
+    {
+        if constexpr (std::is_nothrow_constructible_v<T, Args...>) {
+            size_type pos;
+            if (!claim(enqueue_pos_, pos, 1, 0))
+                return false;
+            publish(pos, std::forward<Args>(args)...);
+            return true;
+        } else {
+            T x(std::forward<Args>(args)...); // if this throws, no slot has been claimed yet
+            return try_emplace(std::move(x));
+        }
+    }
+
+    bool try_push(const T& x) { return try_emplace(x);            }
+    bool try_push(T&& x)      { return try_emplace(std::move(x)); }
+
+    // Returns false right away if the queue is empty
+    bool try_pop(T& x)
+    {
+        size_type pos;
+        if (!claim(dequeue_pos_, pos, 1, 1))
+            return false;
+        x = consume(pos);
+        return true;
+    }
+
+    // Pushes as many elements from the front of [first, last) as there is room for,
+    // claiming all their slots at once; returns the number of elements pushed
+    template<class ForwardIt>
+    size_type try_push_bulk(ForwardIt first, ForwardIt last)
+    {
+        size_type pos;
+        const size_type n = claim(enqueue_pos_, pos, static_cast<size_type>(std::distance(first, last)), 0);
+        for (size_type i = 0; i < n; ++i, ++first)
+            publish(pos + i, *first);
+        return n;
+    }
+
+    // Pops up to n elements into out, claiming all their slots at once; returns the number popped
+    template<class OutputIt>
+    size_type try_pop_bulk(OutputIt out, size_type n)
+    {
+        size_type pos;
+        n = claim(dequeue_pos_, pos, n, 1);
+        for (size_type i = 0; i < n; ++i)
+            *out++ = consume(pos + i);
+        return n;
+    }
+
+    // ------------------------------------------------------------------------------------------ blocking
+
+    // Waits for room if the queue is full
+    template<class... Args>
+    void emplace(Args&&... args)
+    {
+        if constexpr (std::is_nothrow_constructible_v<T, Args...>) {
+            const auto pos = enqueue_pos_.fetch_add(1, std::memory_order_relaxed);
+            wait_for_turn(pos, 0);
+            publish(pos, std::forward<Args>(args)...);
+        } else {
+            T x(std::forward<Args>(args)...);
+            emplace(std::move(x));
+        }
+    }
+
+    void push(const T& x) { emplace(x);            }
+    void push(T&& x)      { emplace(std::move(x)); }
+
+    // Waits for an element if the queue is empty
+    T pop()
+    {
+        const auto pos = dequeue_pos_.fetch_add(1, std::memory_order_relaxed);
+        wait_for_turn(pos, 1);
+        return consume(pos);
+    }
+
+    // Pushes all of [first, last), waiting for room as needed
+    template<class ForwardIt>
+    void push_bulk(ForwardIt first, ForwardIt last)
+    {
+        const auto n   = static_cast<size_type>(std::distance(first, last));
+        const auto pos = enqueue_pos_.fetch_add(n, std::memory_order_relaxed);
+        for (size_type i = 0; i < n; ++i, ++first) {
+            wait_for_turn(pos + i, 0);
+            publish(pos + i, *first);
+        }
+    }
+
+    // Pops exactly n elements into out, waiting for them as needed
+    template<class OutputIt>
+    void pop_bulk(OutputIt out, size_type n)
+    {
+        const auto pos = dequeue_pos_.fetch_add(n, std::memory_order_relaxed);
+        for (size_type i = 0; i < n; ++i) {
+            wait_for_turn(pos + i, 1);
+            *out++ = consume(pos + i);
+        }
+    }
+
+private:
+    // The turn of the slot at position pos is pos when it's free for the producer
+    // of that lap and pos + 1 when it holds an element for the consumer of that lap.
+    // Consuming it makes it pos + capacity, the turn of the producer of the next lap.
+    struct slot {
+        std::atomic<size_type> turn;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* get() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    // Claims the (at most n) consecutive positions starting at the current value of
+    // pos_counter whose slots are ready (their turn is position + offset); returns
+    // how many were claimed, 0 if the first one isn't ready, with the first in pos.
+    // Slots that are ready stay so until claimed, so a successful exchange is enough.
+    size_type claim(std::atomic<size_type>& pos_counter, size_type& pos, size_type n, size_type offset)
+    {
+        pos = pos_counter.load(std::memory_order_relaxed);
+        for (;;) {
+            size_type ready = 0;
+            while (ready < n && ready <= mask_) {
+                const auto turn = slots_[(pos + ready) & mask_].turn.load(std::memory_order_acquire);
+                if (turn != pos + ready + offset)
+                    break;
+                ++ready;
+            }
+
+            if (ready == 0) {
+                // Either the queue is full (or empty), or another thread moved pos_counter on
+                const auto current = pos_counter.load(std::memory_order_relaxed);
+                if (current == pos)
+                    return 0;
+                pos = current;
+                continue;
+            }
+
+            if (pos_counter.compare_exchange_weak(pos, pos + ready, std::memory_order_relaxed))
+                return ready;
+        }
+    }
+
+    void wait_for_turn(size_type pos, size_type offset)
+    {
+        auto& turn = slots_[pos & mask_].turn;
+        for (auto t = turn.load(std::memory_order_acquire); t != pos + offset; t = turn.load(std::memory_order_acquire))
+            turn.wait(t, std::memory_order_acquire);
+    }
+
+    template<class... Args>
+    void publish(size_type pos, Args&&... args)
+    {
+        auto& s = slots_[pos & mask_];
+        ::new (static_cast<void*>(s.storage)) T(std::forward<Args>(args)...);
+        s.turn.store(pos + 1, std::memory_order_release);
+        s.turn.notify_all();
+    }
+
+    T consume(size_type pos)
+    {
+        auto& s = slots_[pos & mask_];
+        T x(std::move(*s.get()));
+        s.get()->~T();
+        s.turn.store(pos + mask_ + 1, std::memory_order_release);
+        s.turn.notify_all();
+        return x;
+    }
+
+    size_type               mask_ = 0;
+    std::unique_ptr<slot[]> slots_;
+
+    // Each on a cache line of its own, so producers and consumers don't slow each other down
+    alignas(internal::cache_line_size) std::atomic<size_type> enqueue_pos_ = 0;
+    alignas(internal::cache_line_size) std::atomic<size_type> dequeue_pos_ = 0;
+};
+
+} // namespace zen
@@ -0,0 +1,316 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <type_traits>
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <new>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
+
+namespace zen {
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::node_pool_allocator
+
+namespace internal {
+    // Blocks are multiples of this, so every block is suitably aligned for anything but over-aligned types
+    inline constexpr std::size_t node_pool_granularity = alignof(std::max_align_t);
+
+    // Bigger nodes (or over-aligned ones) aren't pooled
+    inline constexpr std::size_t node_pool_max_block = 1024;
+
+    inline constexpr std::size_t node_pool_slab_bytes = 64 * 1024;
+
+    constexpr std::size_t node_pool_block(std::size_t size)
+    {
+        return (size + node_pool_granularity - 1) / node_pool_granularity * node_pool_granularity;
+    }
+
+    struct free_node { free_node* next; };
+
+    // Links the count blocks of a slab into a free list and returns its head
+    inline free_node* carve(void* slab, std::size_t block, std::size_t count)
+    {
+        auto* bytes = static_cast<unsigned char*>(slab);
+        for (std::size_t i = 0; i + 1 < count; ++i)
+            ::new (bytes + i * block) free_node{ reinterpret_cast<free_node*>(bytes + (i + 1) * block) };
+        ::new (bytes + (count - 1) * block) free_node{ nullptr };
+        return reinterpret_cast<free_node*>(bytes);
+    }
+
+    // The pool of blocks of one size shared by the whole process. Each thread allocates from
+    // and frees to a free list of its own without any locking, and only takes the lock of the
+    // depot when it runs out, to take the blocks that exited threads have left there, or to
+    // carve a new slab. Slabs are kept for the lifetime of the process, like malloc does.
+    // Once a thread's free list is gone (containers with static or thread storage duration
+    // can outlive it), that thread allocates from and frees to the depot under its lock.
+    template<std::size_t Block>
+    class shared_node_pool
+    {
+    public:
+        static void* allocate()
+        {
+            if (cache_destroyed()) {
+                auto& d = global();
+                std::lock_guard lock(d.mutex);
+                if (!d.head)
+                    d.head = carve_slab();
+                return std::exchange(d.head, d.head->next);
+            }
+
+            auto& c = cache();
+            if (!c.head)
+                c.refill();
+            return std::exchange(c.head, c.head->next);
+        }
+
+        static void deallocate(void* p) noexcept
+        {
+            if (cache_destroyed()) {
+                auto& d = global();
+                std::lock_guard lock(d.mutex);
+                d.head = ::new (p) free_node{ d.head };
+                return;
+            }
+
+            auto& c = cache();
+            c.head = ::new (p) free_node{ c.head };
+        }
+
+    private:
+        struct depot {
+            std::mutex mutex;
+            free_node* head = nullptr;
+        };
+
+        // Never destroyed, so that threads exiting after static destruction still find it
+        static depot& global()
+        {
+            static depot* d = new depot;
+            return *d;
+        }
+
+        struct local_cache {
+            free_node* head = nullptr;
+
+            void refill()
+            {
+                auto& d = global();
+                {
+                    std::lock_guard lock(d.mutex);
+                    if (d.head) {
+                        head = std::exchange(d.head, nullptr);
+                        return;
+                    }
+                }
+                head = carve_slab();
+            }
+
+            // Hands the blocks freed on this thread over to the threads that remain
+            ~local_cache()
+            {
+                cache_destroyed() = true;
+                if (!head)
+                    return;
+                free_node* tail = head;
+                while (tail->next)
+                    tail = tail->next;
+
+                auto& d = global();
+                std::lock_guard lock(d.mutex);
+                tail->next = std::exchange(d.head, head);
+                head = nullptr; // the depot owns them now
+            }
+        };
+
+        static local_cache& cache()
+        {
+            thread_local local_cache c;
+            return c;
+        }
+
+        // Trivially destructible, so it can still be read after the thread's cache is destroyed
+        static bool& cache_destroyed()
+        {
+            thread_local bool destroyed = false;
+            return destroyed;
+        }
+
+        static free_node* carve_slab()
+        {
+            return carve(::operator new(node_pool_slab_bytes), Block, node_pool_slab_bytes / Block);
+        }
+    };
+
+    // A pool of its own for a single container (and its copies of the allocator), with no
+    // locking. All of its slabs are freed at once when the last of them is destroyed. Slabs
+    // start small, so that small containers don't pay for much memory, and grow geometrically.
+    class node_arena
+    {
+    public:
+        node_arena() = default;
+        node_arena(const node_arena&)            = delete;
+        node_arena& operator=(const node_arena&) = delete;
+
+        ~node_arena()
+        {
+            for (void* slab : slabs_)
+                ::operator delete(slab);
+        }
+
+        void* allocate(std::size_t block)
+        {
+            auto& head = free_list(block);
+            if (!head) {
+                const std::size_t bytes = std::max(next_slab_bytes_, block);
+                next_slab_bytes_ = std::min(2 * next_slab_bytes_, node_pool_slab_bytes);
+                slabs_.push_back(::operator new(bytes));
+                head = carve(slabs_.back(), block, bytes / block);
+            }
+            return std::exchange(head, head->next);
+        }
+
+        void deallocate(void* p, std::size_t block) noexcept
+        {
+            auto& head = free_list(block);
+            head = ::new (p) free_node{ head };
+        }
+
+    private:
+        // Containers allocate one or two sizes of nodes, so a linear search is the fastest
+        free_node*& free_list(std::size_t block)
+        {
+            for (auto& [size, head] : free_lists_)
+                if (size == block)
+                    return head;
+            free_lists_.emplace_back(block, nullptr);
+            return free_lists_.back().second;
+        }
+
+        std::vector<std::pair<std::size_t, free_node*>> free_lists_;
+        std::vector<void*>                              slabs_;
+        std::size_t                                     next_slab_bytes_ = 1024;
+    };
+
+    struct no_arena {};
+} // namespace internal
+
+// An allocator for node-based containers, which allocate their elements one node at a time.
+// Nodes come from slabs of equal-sized blocks, so allocating and freeing one is a matter of
+// popping and pushing a free list, and nodes allocated together sit together in memory.
+// 
+// By default, blocks come from a free list of the current thread, shared by all containers.
+// With BulkRelease, each container gets a pool of its own, whose slabs are all freed at
+// once when the container is destroyed, instead of returning its nodes one by one to the
+// heap, which makes tearing down large structures much faster. Such a container must not
+// be used from several threads at once, as with any zen container anyway. Its pool stays
+// with it: assigning or swapping containers moves their elements rather than their pools,
+// and one that is moved from gets a new pool the next time it allocates.
+// 
+// Example: zen::map<int, zen::string, std::less<int>, zen::node_pool_allocator<std::pair<const int, zen::string>>> m;
+//          zen::list<int, zen::node_pool_allocator<int, true>> l; // with its own pool
+template<class T, bool BulkRelease = false>
+class node_pool_allocator
+{
+    static constexpr std::size_t block  = internal::node_pool_block(sizeof(T));
+    static constexpr bool        pooled = block <= internal::node_pool_max_block && alignof(T) <= internal::node_pool_granularity;
+
+public:
+    using value_type      = T;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    // An own pool never ends up shared by two containers, which would then race inside it
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::false_type;
+    using propagate_on_container_swap            = std::false_type;
+    using is_always_equal                        = std::bool_constant<!BulkRelease>;
+
+    template<class U>
+    struct rebind { using other = node_pool_allocator<U, BulkRelease>; };
+
+    node_pool_allocator()
+    {
+        if constexpr (BulkRelease)
+            arena_ = std::make_shared<internal::node_arena>();
+    }
+
+    node_pool_allocator(const node_pool_allocator&)            = default;
+    node_pool_allocator& operator=(const node_pool_allocator&) = default;
+
+    // The pool goes along with the nodes of a moved container, and the moved-from one
+    // creates a new pool of its own if it allocates again, rather than share this one
+    node_pool_allocator(node_pool_allocator&& other) noexcept : arena_(std::move(other.arena_)) {}
+
+    template<class U>
+    node_pool_allocator(const node_pool_allocator<U, BulkRelease>& other) noexcept : arena_(other.arena_) {}
+
+    // A copy of a container gets a pool of its own too
+    node_pool_allocator select_on_container_copy_construction() const { return node_pool_allocator(); }
+
+    T* allocate(std::size_t n)
+    {
+        if (n != 1 || !pooled)
+            return std::allocator<T>().allocate(n); // arrays, like the buckets of hash tables, and big nodes
+
+        if constexpr (BulkRelease) {
+            if (!arena_)
+                arena_ = std::make_shared<internal::node_arena>();
+            return static_cast<T*>(arena_->allocate(block));
+        }
+        else
+            return static_cast<T*>(internal::shared_node_pool<block>::allocate());
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        if (n != 1 || !pooled)
+            return std::allocator<T>().deallocate(p, n);
+
+        if constexpr (BulkRelease)
+            arena_->deallocate(p, block);
+        else
+            internal::shared_node_pool<block>::deallocate(p);
+    }
+
+    friend bool operator==(const node_pool_allocator& a, const node_pool_allocator& b)
+    {
+        if constexpr (BulkRelease)
+            return a.arena_ == b.arena_;
+        else
+            return true;
+    }
+
+private:
+    template<class, bool> friend class node_pool_allocator;
+
+    std::conditional_t<BulkRelease, std::shared_ptr<internal::node_arena>, internal::no_arena> arena_;
+};
+
+} // namespace zen
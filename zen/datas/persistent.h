@@ -0,0 +1,868 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <initializer_list>
+#include <functional>
+#include <stdexcept>
+#include <iterator>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <new>
+#include <bit>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
+
+namespace zen {
+
+namespace internal {
+    // The reference count of a node shared between versions of a persistent container.
+    // Versions on other threads may hold the same node, so the count is atomic; a node
+    // whose count is 1 belongs to a single version, which may change it in place instead
+    // of copying it, and that's what makes transient builders cheap.
+    struct shared_node {
+        std::atomic<std::uint32_t> refs{ 1 };
+
+        bool is_unique() const { return refs.load(std::memory_order_acquire) == 1;            }
+        void retain()          { refs.fetch_add(1, std::memory_order_relaxed);                }
+        bool release()         { return refs.fetch_sub(1, std::memory_order_acq_rel) == 1;   }
+    };
+} // namespace internal
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::persistent_vector
+
+// An immutable vector whose updates return new versions that share all but O(log32 n)
+// of their memory with the old one, so taking a snapshot is a copy of one pointer and a
+// version stays valid and unchanged however many newer ones exist. The elements live in
+// leaves of 32 under a tree of 32-way branches (the radix balanced tree of RRB vectors)
+// plus a separate tail leaf, which makes push_back() and pop_back() amortized O(1) and
+// indexing a walk of at most a few levels. For many changes in a row, transient() gives
+// a builder that changes the nodes it already owns in place rather than copying them.
+// Example: zen::persistent_vector<int> v1 = { 1, 2, 3 };
+//          auto v2 = v1.push_back(4).set(0, 10);   // v1 is still { 1, 2, 3 }
+//          auto b  = v2.transient();
+//          for (int i : zen::in(1000)) b.push_back(i);
+//          auto v3 = b.persistent();
+template<class T>
+class persistent_vector : private zen::stackonly
+{
+    static constexpr std::size_t bits  = 5;
+    static constexpr std::size_t width = std::size_t{ 1 } << bits;
+    static constexpr std::size_t mask  = width - 1;
+
+    struct node : internal::shared_node {
+        explicit node(bool leaf) : is_leaf(leaf) {}
+        const bool is_leaf;
+    };
+
+    struct leaf : node {
+        leaf() : node(true) {}
+        ~leaf() { std::destroy_n(data(), count); }
+
+        T*       data()       { return std::launder(reinterpret_cast<T*>(storage));       }
+        const T* data() const { return std::launder(reinterpret_cast<const T*>(storage)); }
+
+        std::uint32_t count = 0;
+        alignas(T) unsigned char storage[width * sizeof(T)];
+    };
+
+    struct branch : node {
+        branch() : node(false) {}
+        node* children[width] = {};
+    };
+
+public:
+    using value_type      = T;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference       = const T&;
+    using const_reference = const T&;
+
+    // Reads the elements of a leaf straight through, walking the tree once per 32 elements
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const T*;
+        using reference         = const T&;
+
+        const_iterator() = default;
+
+        reference operator*()  const { return chunk_[i_ & mask];  }
+        pointer   operator->() const { return &chunk_[i_ & mask]; }
+
+        const_iterator& operator++()
+        {
+            if ((++i_ & mask) == 0 && i_ < v_->size_)
+                chunk_ = v_->leaf_for(i_)->data();
+            return *this;
+        }
+
+        const_iterator operator++(int) { auto it = *this; ++*this; return it; }
+
+        friend bool operator==(const const_iterator& a, const const_iterator& b) { return a.i_ == b.i_; }
+
+    private:
+        friend class persistent_vector;
+
+        const_iterator(const persistent_vector* v, size_type i)
+            : v_(v), i_(i), chunk_(i < v->size_ ? v->leaf_for(i)->data() : nullptr) {}
+
+        const persistent_vector* v_     = nullptr;
+        size_type                i_     = 0;
+        const T*                 chunk_ = nullptr;
+    };
+
+    using iterator = const_iterator;
+
+    // Changes a version in place, copying only the nodes it shares with other versions
+    class builder : private zen::stackonly {
+    public:
+        void push_back(T x)          { v_.push(std::move(x)); }
+        void set(size_type i, T x)   { v_.check(i); v_.assign(i, std::move(x)); }
+        void pop_back()              { v_.check_not_empty(); v_.pop(); }
+
+        const T& operator[](size_type i) const { return v_[i]; }
+
+        size_type size()     const { return v_.size();     }
+        bool      is_empty() const { return v_.is_empty(); }
+
+        // The version built so far; the builder can go on, copying what it shares with it
+        persistent_vector persistent() const { return v_; }
+
+    private:
+        friend class persistent_vector;
+        explicit builder(const persistent_vector& v) : v_(v) {}
+        persistent_vector v_;
+    };
+
+    persistent_vector() = default;
+
+    persistent_vector(std::initializer_list<T> il) : persistent_vector(il.begin(), il.end()) {}
+
+    template<std::input_iterator It>
+    persistent_vector(It first, It last)
+    {
+        for (; first != last; ++first)
+            push(*first);
+    }
+
+    persistent_vector(const persistent_vector& other)
+        : root_(other.root_), tail_(other.tail_), size_(other.size_), shift_(other.shift_)
+    {
+        if (root_) root_->retain();
+        if (tail_) tail_->retain();
+    }
+
+    persistent_vector(persistent_vector&& other) noexcept
+        : root_(std::exchange(other.root_, nullptr)), tail_(std::exchange(other.tail_, nullptr))
+        , size_(std::exchange(other.size_, 0)), shift_(std::exchange(other.shift_, bits)) {}
+
+    persistent_vector& operator=(persistent_vector other) noexcept
+    {
+        std::swap(root_,  other.root_);
+        std::swap(tail_,  other.tail_);
+        std::swap(size_,  other.size_);
+        std::swap(shift_, other.shift_);
+        return *this;
+    }
+
+    ~persistent_vector()
+    {
+        release(root_);
+        release(tail_);
+    }
+
+    size_type size()     const { return size_;      }
+    bool      empty()    const { return size_ == 0; }
+    bool      is_empty() const { return size_ == 0; }
+
+    const T& operator[](size_type i) const { return leaf_for(i)->data()[i & mask]; }
+
+    const T& at(size_type i) const
+    {
+        check(i);
+        return (*this)[i];
+    }
+
+    const T& front() const { return (*this)[0];         }
+    const T& back()  const { return (*this)[size_ - 1]; }
+
+    const_iterator begin() const { return const_iterator(this, 0);     }
+    const_iterator end()   const { return const_iterator(this, size_); }
+
+    // ------------------------------------------------------------------------------------------ new versions
+
+    [[nodiscard]] persistent_vector push_back(T x) const
+    {
+        persistent_vector v = *this;
+        v.push(std::move(x));
+        return v;
+    }
+
+    [[nodiscard]] persistent_vector set(size_type i, T x) const
+    {
+        check(i);
+        persistent_vector v = *this;
+        v.assign(i, std::move(x));
+        return v;
+    }
+
+    [[nodiscard]] persistent_vector pop_back() const
+    {
+        check_not_empty();
+        persistent_vector v = *this;
+        v.pop();
+        return v;
+    }
+
+    builder transient() const { return builder(*this); }
+
+    friend bool operator==(const persistent_vector& a, const persistent_vector& b)
+    {
+        return a.size_ == b.size_ && ((a.tail_ == b.tail_ && a.root_ == b.root_) || std::equal(a.begin(), a.end(), b.begin()));
+    }
+
+private:
+    void check(size_type i) const
+    {
+        if (i >= size_)
+            throw std::out_of_range("zen::persistent_vector INDEX OUT OF RANGE");
+    }
+
+    void check_not_empty() const
+    {
+        if (size_ == 0)
+            throw std::out_of_range("zen::persistent_vector::pop_back() ON AN EMPTY VECTOR");
+    }
+
+    // The first index held by the tail rather than the tree
+    size_type tail_offset() const { return size_ < width ? 0 : ((size_ - 1) >> bits) << bits; }
+
+    const leaf* leaf_for(size_type i) const
+    {
+        if (i >= tail_offset())
+            return tail_;
+        const node* n = root_;
+        for (std::size_t level = shift_; level > 0; level -= bits)
+            n = static_cast<const branch*>(n)->children[(i >> level) & mask];
+        return static_cast<const leaf*>(n);
+    }
+
+    // ------------------------------------------------------------------------------------------ in place changes
+
+    void push(T x)
+    {
+        if (!tail_ || tail_->count < width) {
+            tail_ = tail_ ? writable(tail_) : new leaf;
+            ::new (tail_->data() + tail_->count) T(std::move(x));
+            ++tail_->count;
+            ++size_;
+            return;
+        }
+
+        // The full tail goes into the tree and a new one starts
+        auto* fresh = new leaf;
+        try {
+            ::new (fresh->data()) T(std::move(x));
+        } catch (...) {
+            delete fresh;
+            throw;
+        }
+        fresh->count = 1;
+
+        if (!root_)
+            root_ = new branch;
+        if ((size_ >> bits) > (std::size_t{ 1 } << shift_)) {
+            auto* top = new branch;
+            top->children[0] = root_;
+            top->children[1] = new_path(shift_, tail_);
+            root_   = top;
+            shift_ += bits;
+        }
+        else
+            root_ = push_tail(shift_, root_, tail_);
+
+        tail_ = fresh;
+        ++size_;
+    }
+
+    void assign(size_type i, T&& x)
+    {
+        if (i >= tail_offset()) {
+            tail_ = writable(tail_);
+            tail_->data()[i & mask] = std::move(x);
+        }
+        else
+            root_ = static_cast<branch*>(assign_in(shift_, root_, i, std::move(x)));
+    }
+
+    void pop()
+    {
+        if (size_ - tail_offset() > 1) {
+            tail_ = writable(tail_);
+            std::destroy_at(tail_->data() + --tail_->count);
+            --size_;
+            return;
+        }
+
+        // The tail empties, and the last leaf of the tree becomes the tail
+        leaf* last = nullptr;
+        if (size_ > 1) {
+            last = const_cast<leaf*>(leaf_for(size_ - 2));
+            last->retain();
+            root_ = pop_tail(shift_, root_);
+            if (root_ && shift_ > bits && !root_->children[1]) {
+                auto* only = static_cast<branch*>(root_->children[0]);
+                only->retain();
+                release(root_);
+                root_   = only;
+                shift_ -= bits;
+            }
+            if (!root_)
+                shift_ = bits;
+        }
+        release(tail_);
+        tail_ = last;
+        --size_;
+    }
+
+    // A chain of branches down to n, for a leaf that starts a new subtree
+    static node* new_path(std::size_t level, node* n)
+    {
+        if (level == 0)
+            return n;
+        auto* b = new branch;
+        b->children[0] = new_path(level - bits, n);
+        return b;
+    }
+
+    branch* push_tail(std::size_t level, branch* parent, leaf* full) const
+    {
+        auto* b = writable(parent);
+        node*& slot = b->children[((size_ - 1) >> level) & mask];
+        if (level == bits)
+            slot = full;
+        else
+            slot = slot ? push_tail(level - bits, static_cast<branch*>(slot), full) : new_path(level - bits, full);
+        return b;
+    }
+
+    // Removes the last leaf of the tree, returning null for subtrees that end up empty
+    branch* pop_tail(std::size_t level, branch* parent) const
+    {
+        const std::size_t i = ((size_ - 2) >> level) & mask;
+        auto* b = writable(parent);
+        if (level > bits)
+            b->children[i] = pop_tail(level - bits, static_cast<branch*>(b->children[i]));
+        else {
+            release(b->children[i]);
+            b->children[i] = nullptr;
+        }
+        if (i == 0 && !b->children[0]) {
+            release(b);
+            return nullptr;
+        }
+        return b;
+    }
+
+    static node* assign_in(std::size_t level, node* n, size_type i, T&& x)
+    {
+        if (level == 0) {
+            auto* l = writable(static_cast<leaf*>(n));
+            l->data()[i & mask] = std::move(x);
+            return l;
+        }
+        auto* b = writable(static_cast<branch*>(n));
+        node*& slot = b->children[(i >> level) & mask];
+        slot = assign_in(level - bits, slot, i, std::move(x));
+        return b;
+    }
+
+    // ------------------------------------------------------------------------------------------ sharing
+
+    // The node itself if no other version holds it, or else a copy of it in its place
+    template<class N>
+    static N* writable(N* n)
+    {
+        if (n->is_unique())
+            return n;
+        N* copy = clone(n);
+        release(n);
+        return copy;
+    }
+
+    static leaf* clone(const leaf* l)
+    {
+        auto* copy = new leaf;
+        try {
+            for (; copy->count < l->count; ++copy->count)
+                ::new (copy->data() + copy->count) T(l->data()[copy->count]);
+        } catch (...) {
+            delete copy;
+            throw;
+        }
+        return copy;
+    }
+
+    static branch* clone(const branch* b)
+    {
+        auto* copy = new branch;
+        for (std::size_t i = 0; i < width; ++i)
+            if ((copy->children[i] = b->children[i]))
+                copy->children[i]->retain();
+        return copy;
+    }
+
+    static void release(node* n)
+    {
+        if (!n || !n->release())
+            return;
+        if (n->is_leaf) {
+            delete static_cast<leaf*>(n);
+            return;
+        }
+        auto* b = static_cast<branch*>(n);
+        for (node* child : b->children)
+            release(child);
+        delete b;
+    }
+
+    branch*     root_  = nullptr; // the elements before the tail, if there are 32 or more
+    leaf*       tail_  = nullptr; // the last 1 to 32 elements
+    size_type   size_  = 0;
+    std::size_t shift_ = bits;    // the bits of an index below the root's children
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::persistent_map
+
+// An immutable hash map whose updates return new versions sharing all but O(log32 n) of
+// their memory with the old one, a hash array mapped trie (HAMT) in which each node branches
+// on the next 5 bits of the hash. The nodes follow the CHAMP layout: a bitmap of the slots
+// holding an entry inline and another of those holding a subnode, each packed in hash order,
+// so a node is no larger than what it holds and iteration reads entries before descending.
+// As with zen::persistent_vector, transient() gives a builder for batches of changes.
+// Example: zen::persistent_map<std::string, int> m1 = { {"a", 1} };
+//          auto m2 = m1.set("b", 2).erase("a");   // m1 is still { {"a", 1} }
+//          const int* b = m2.find("b");           // nullptr if it isn't there
+template<class K, class V, class H = std::hash<K>, class E = std::equal_to<K>>
+class persistent_map : private zen::stackonly
+{
+    static constexpr unsigned bits      = 5;
+    static constexpr unsigned hash_bits = sizeof(std::size_t) * 8;
+
+public:
+    using key_type    = K;
+    using mapped_type = V;
+    using value_type  = std::pair<K, V>;
+    using size_type   = std::size_t;
+    using hasher      = H;
+    using key_equal   = E;
+
+private:
+    // Past the last bits of the hash, a node is a plain list of the keys that collide
+    struct node : internal::shared_node {
+        std::uint32_t           datamap = 0;
+        std::uint32_t           nodemap = 0;
+        std::vector<value_type> entries;
+        std::vector<node*>      children;
+    };
+
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = typename persistent_map::value_type;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const value_type*;
+        using reference         = const value_type&;
+
+        const_iterator() = default;
+
+        reference operator*()  const { return *current_; }
+        pointer   operator->() const { return current_;  }
+
+        const_iterator& operator++()    { advance(); return *this; }
+        const_iterator  operator++(int) { auto it = *this; advance(); return it; }
+
+        friend bool operator==(const const_iterator& a, const const_iterator& b) { return a.current_ == b.current_; }
+
+    private:
+        friend class persistent_map;
+
+        // The entries of a node, then those of its subnodes
+        struct frame {
+            const node* n;
+            std::size_t i;
+        };
+
+        explicit const_iterator(const node* root)
+        {
+            if (root) {
+                path_.push_back({ root, 0 });
+                advance();
+            }
+        }
+
+        void advance()
+        {
+            while (!path_.empty()) {
+                frame& f = path_.back();
+                if (f.i < f.n->entries.size()) {
+                    current_ = &f.n->entries[f.i++];
+                    return;
+                }
+                const std::size_t c = f.i++ - f.n->entries.size();
+                if (c < f.n->children.size())
+                    path_.push_back({ f.n->children[c], 0 });
+                else
+                    path_.pop_back();
+            }
+            current_ = nullptr;
+        }
+
+        std::vector<frame> path_;
+        const value_type*  current_ = nullptr;
+    };
+
+    using iterator = const_iterator;
+
+    // Changes a version in place, copying only the nodes it shares with other versions
+    class builder : private zen::stackonly {
+    public:
+        void set(K key, V value) { m_.assoc(std::move(key), std::move(value)); }
+        void erase(const K& key) { m_.dissoc(key); }
+
+        const V* find(const K& key)     const { return m_.find(key);     }
+        bool     contains(const K& key) const { return m_.contains(key); }
+
+        size_type size()     const { return m_.size();     }
+        bool      is_empty() const { return m_.is_empty(); }
+
+        // The version built so far; the builder can go on, copying what it shares with it
+        persistent_map persistent() const { return m_; }
+
+    private:
+        friend class persistent_map;
+        explicit builder(const persistent_map& m) : m_(m) {}
+        persistent_map m_;
+    };
+
+    persistent_map() = default;
+
+    persistent_map(std::initializer_list<value_type> il)
+    {
+        for (const auto& [k, v] : il)
+            assoc(K(k), V(v));
+    }
+
+    persistent_map(const persistent_map& other) : root_(other.root_), size_(other.size_), hash_(other.hash_), eq_(other.eq_)
+    {
+        if (root_)
+            root_->retain();
+    }
+
+    persistent_map(persistent_map&& other) noexcept
+        : root_(std::exchange(other.root_, nullptr)), size_(std::exchange(other.size_, 0)), hash_(other.hash_), eq_(other.eq_) {}
+
+    persistent_map& operator=(persistent_map other) noexcept
+    {
+        std::swap(root_, other.root_);
+        std::swap(size_, other.size_);
+        std::swap(hash_, other.hash_);
+        std::swap(eq_,   other.eq_);
+        return *this;
+    }
+
+    ~persistent_map() { release(root_); }
+
+    size_type size()     const { return size_;      }
+    bool      empty()    const { return size_ == 0; }
+    bool      is_empty() const { return size_ == 0; }
+
+    // The value of a key, or nullptr if the key isn't there
+    const V* find(const K& key) const
+    {
+        const value_type* e = lookup(key, hash_(key));
+        return e ? &e->second : nullptr;
+    }
+
+    bool contains(const K& key) const { return find(key) != nullptr; }
+
+    const V& at(const K& key) const
+    {
+        const V* v = find(key);
+        if (!v)
+            throw std::out_of_range("zen::persistent_map::at() KEY NOT FOUND");
+        return *v;
+    }
+
+    const_iterator begin() const { return const_iterator(root_); }
+    const_iterator end()   const { return const_iterator();      }
+
+    // ------------------------------------------------------------------------------------------ new versions
+
+    [[nodiscard]] persistent_map set(K key, V value) const
+    {
+        persistent_map m = *this;
+        m.assoc(std::move(key), std::move(value));
+        return m;
+    }
+
+    [[nodiscard]] persistent_map erase(const K& key) const
+    {
+        persistent_map m = *this;
+        m.dissoc(key);
+        return m;
+    }
+
+    builder transient() const { return builder(*this); }
+
+private:
+    static std::uint32_t bit_of(std::size_t hash, unsigned shift) { return std::uint32_t{ 1 } << ((hash >> shift) & 31); }
+    static std::size_t   index_of(std::uint32_t map, std::uint32_t bit) { return static_cast<std::size_t>(std::popcount(map & (bit - 1))); }
+
+    const value_type* lookup(const K& key, std::size_t hash) const
+    {
+        const node* n = root_;
+        for (unsigned shift = 0; n; shift += bits) {
+            if (shift >= hash_bits) {
+                for (const auto& e : n->entries)
+                    if (eq_(e.first, key))
+                        return &e;
+                return nullptr;
+            }
+            const std::uint32_t bit = bit_of(hash, shift);
+            if (n->datamap & bit) {
+                const auto& e = n->entries[index_of(n->datamap, bit)];
+                return eq_(e.first, key) ? &e : nullptr;
+            }
+            if (!(n->nodemap & bit))
+                return nullptr;
+            n = n->children[index_of(n->nodemap, bit)];
+        }
+        return nullptr;
+    }
+
+    // ------------------------------------------------------------------------------------------ in place changes
+
+    void assoc(K&& key, V&& value)
+    {
+        const std::size_t hash = hash_(key);
+        if (!root_)
+            root_ = new node;
+        size_ += assoc_in(root_, 0, hash, std::move(key), std::move(value));
+    }
+
+    void dissoc(const K& key)
+    {
+        const std::size_t hash = hash_(key);
+        if (!lookup(key, hash))
+            return; // nothing to copy
+        dissoc_in(root_, 0, hash, key);
+        if (--size_ == 0) {
+            release(root_);
+            root_ = nullptr;
+        }
+    }
+
+    // Returns whether the key is new
+    bool assoc_in(node*& ref, unsigned shift, std::size_t hash, K&& key, V&& value)
+    {
+        node* n = ref = writable(ref);
+
+        if (shift >= hash_bits) {
+            for (auto& e : n->entries)
+                if (eq_(e.first, key)) {
+                    e.second = std::move(value);
+                    return false;
+                }
+            n->entries.emplace_back(std::move(key), std::move(value));
+            return true;
+        }
+
+        const std::uint32_t bit = bit_of(hash, shift);
+        if (n->datamap & bit) {
+            const std::size_t i = index_of(n->datamap, bit);
+            value_type& e = n->entries[i];
+            if (eq_(e.first, key)) {
+                e.second = std::move(value);
+                return false;
+            }
+
+            // Two keys in one slot go down into a subnode together
+            const std::size_t other_hash = hash_(e.first);
+            node* sub = merge(shift + bits, std::move(e), other_hash, value_type(std::move(key), std::move(value)), hash);
+            n->entries.erase(n->entries.begin() + static_cast<std::ptrdiff_t>(i));
+            n->datamap ^= bit;
+            n->children.insert(n->children.begin() + static_cast<std::ptrdiff_t>(index_of(n->nodemap, bit)), sub);
+            n->nodemap |= bit;
+            return true;
+        }
+
+        if (n->nodemap & bit)
+            return assoc_in(n->children[index_of(n->nodemap, bit)], shift + bits, hash, std::move(key), std::move(value));
+
+        n->entries.emplace(n->entries.begin() + static_cast<std::ptrdiff_t>(index_of(n->datamap, bit)), std::move(key), std::move(value));
+        n->datamap |= bit;
+        return true;
+    }
+
+    static node* merge(unsigned shift, value_type&& a, std::size_t a_hash, value_type&& b, std::size_t b_hash)
+    {
+        auto* n = new node;
+        if (shift >= hash_bits) {
+            n->entries.push_back(std::move(a));
+            n->entries.push_back(std::move(b));
+            return n;
+        }
+        const std::uint32_t a_bit = bit_of(a_hash, shift);
+        const std::uint32_t b_bit = bit_of(b_hash, shift);
+        if (a_bit == b_bit) {
+            n->nodemap = a_bit;
+            n->children.push_back(merge(shift + bits, std::move(a), a_hash, std::move(b), b_hash));
+        }
+        else {
+            n->datamap = a_bit | b_bit;
+            if (a_bit > b_bit)
+                std::swap(a, b);
+            n->entries.push_back(std::move(a));
+            n->entries.push_back(std::move(b));
+        }
+        return n;
+    }
+
+    // Removes a key that's known to be there
+    void dissoc_in(node*& ref, unsigned shift, std::size_t hash, const K& key)
+    {
+        node* n = ref = writable(ref);
+
+        if (shift >= hash_bits) {
+            for (auto it = n->entries.begin(); it != n->entries.end(); ++it)
+                if (eq_(it->first, key)) {
+                    n->entries.erase(it);
+                    return;
+                }
+            return;
+        }
+
+        const std::uint32_t bit = bit_of(hash, shift);
+        if (n->datamap & bit) {
+            n->entries.erase(n->entries.begin() + static_cast<std::ptrdiff_t>(index_of(n->datamap, bit)));
+            n->datamap ^= bit;
+            return;
+        }
+
+        const std::size_t c = index_of(n->nodemap, bit);
+        dissoc_in(n->children[c], shift + bits, hash, key);
+
+        // A subnode left with a single entry gives it back to this node
+        node* child = n->children[c];
+        if (child->children.empty() && child->entries.size() == 1) {
+            n->entries.insert(n->entries.begin() + static_cast<std::ptrdiff_t>(index_of(n->datamap, bit)), std::move(child->entries.front()));
+            n->datamap |= bit;
+            n->nodemap ^= bit;
+            n->children.erase(n->children.begin() + static_cast<std::ptrdiff_t>(c));
+            release(child);
+        }
+    }
+
+    // ------------------------------------------------------------------------------------------ sharing
+
+    // The node itself if no other version holds it, or else a copy of it in its place
+    static node* writable(node* n)
+    {
+        if (n->is_unique())
+            return n;
+        auto* copy = new node;
+        copy->datamap  = n->datamap;
+        copy->nodemap  = n->nodemap;
+        copy->entries  = n->entries;
+        copy->children = n->children;
+        for (node* child : copy->children)
+            child->retain();
+        release(n);
+        return copy;
+    }
+
+    static void release(node* n)
+    {
+        if (!n || !n->release())
+            return;
+        for (node* child : n->children)
+            release(child);
+        delete n;
+    }
+
+    node*     root_ = nullptr;
+    size_type size_ = 0;
+    H         hash_;
+    E         eq_;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::atomic_version
+
+// Publishes versions of a persistent container (or of any copyable value) to reader threads.
+// Writers store() a new version or update() the latest one, and readers load() a version
+// they can go on reading for as long as they like, unaffected by the versions that follow.
+// With persistent containers both a load() and a store() copy one pointer, not the contents.
+// Example: zen::atomic_version<zen::persistent_map<std::string, int>> config;
+//          config.update([](const auto& m) { return m.set("timeout", 30); }); // a writer
+//          auto snapshot = config.load();                                     // a reader
+template<class P>
+class atomic_version : private zen::stackonly
+{
+public:
+    atomic_version() : current_(std::make_shared<const P>()) {}
+    explicit atomic_version(P initial) : current_(std::make_shared<const P>(std::move(initial))) {}
+
+    atomic_version(const atomic_version&)            = delete;
+    atomic_version& operator=(const atomic_version&) = delete;
+
+    P load() const { return *current_.load(std::memory_order_acquire); }
+
+    void store(P next) { current_.store(std::make_shared<const P>(std::move(next)), std::memory_order_release); }
+
+    // Makes f(latest) the latest version, calling f again if another writer got there first
+    template<class F>
+    P update(F f)
+    {
+        std::shared_ptr<const P> latest = current_.load(std::memory_order_acquire);
+        for (;;) {
+            auto next = std::make_shared<const P>(f(*latest));
+            if (current_.compare_exchange_weak(latest, next, std::memory_order_acq_rel, std::memory_order_acquire))
+                return *next;
+        }
+    }
+
+private:
+    std::atomic<std::shared_ptr<const P>> current_;
+};
+
+} // namespace zen
@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include <algorithm>
+#include <iterator>
 #include <queue>
 
 #include "alpha.h" // internal; will not be included in kaizen.h
@@ -74,8 +76,9 @@ public:
         // TODO: CI started to fail with this line, so commented out. Uncomment later & fix.
         // ZEN_STATIC_ASSERT(zen::is_iterable_v<Iterable>, "TEMPLATE PARAMETER EXPECTED TO BE Iterable, BUT IS NOT");
 
-        for (const auto& x : c)
-            my::push(x);
+        // Heapifying everything at once is O(n), unlike O(n log n) for pushing one by one
+        my::c.insert(my::c.end(), std::begin(c), std::end(c));
+        std::make_heap(my::c.begin(), my::c.end(), my::comp);
     }
 
     bool is_empty() const { return my::empty(); }
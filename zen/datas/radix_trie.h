@@ -0,0 +1,854 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <initializer_list>
+#include <type_traits>
+#include <string_view>
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <string>
+#include <vector>
+#include <tuple>
+#include <bit>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
+
+namespace zen {
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::radix_trie
+
+// A map from string keys to values of type V as an adaptive radix tree (ART): every inner
+// node branches on one byte of the key, and grows through four layouts as it fills up,
+// from 4 and 16 sorted bytes (the 16 searched at once with SSE2) to a 256-byte index of
+// 48 children and finally a direct array of 256, so sparse nodes stay small and dense
+// ones are a single array lookup. Runs of bytes without branches are collapsed into one
+// node's prefix, and a key is stored whole in its leaf. Lookups take time proportional to
+// the key's length, not to the number of keys, and keys sharing a prefix are one subtree,
+// so prefix(p) is a range of exactly the keys starting with p, and longest_prefix_match()
+// (as in routing tables) is a single descent. Iteration is in the byte order of the keys,
+// the same as in zen::map<zen::string, V>.
+// Example: zen::radix_trie<int> t = { {"car", 1}, {"cart", 2}, {"dog", 3} };
+//          for (auto& [key, value] : t.prefix("car")) { ... }   // "car", "cart"
+//          t.longest_prefix_match("cartwheel")->first;           // "cart"
+template<class V>
+class radix_trie : private zen::stackonly
+{
+public:
+    using key_type    = std::string;
+    using mapped_type = V;
+    using value_type  = std::pair<const std::string, V>;
+    using size_type   = std::size_t;
+
+private:
+    enum class kind : std::uint8_t { leaf, node4, node16, node48, node256 };
+
+    struct node {
+        explicit node(kind k) : type(k) {}
+        kind type;
+    };
+
+    struct leaf : node {
+        template<class... Args>
+        explicit leaf(std::string_view key, Args&&... args)
+            : node(kind::leaf), kv(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...)) {}
+
+        value_type kv;
+    };
+
+    struct inner : node {
+        explicit inner(kind k) : node(k) {}
+
+        std::uint16_t count    = 0;       // children
+        std::string   prefix;             // the bytes every key below shares after the parent's branch byte
+        leaf*         terminal = nullptr; // the key that ends right after the prefix
+    };
+
+    // Children in the order of their sorted bytes
+    struct node4 : inner {
+        node4() : inner(kind::node4) {}
+        unsigned char keys[4]     = {};
+        node*         children[4] = {};
+    };
+
+    struct node16 : inner {
+        node16() : inner(kind::node16) {}
+        unsigned char keys[16]     = {};
+        node*         children[16] = {};
+    };
+
+    // A byte's slot among the children plus one, or 0 if it has no child
+    struct node48 : inner {
+        node48() : inner(kind::node48) {}
+        unsigned char index[256]    = {};
+        node*         children[48]  = {};
+    };
+
+    struct node256 : inner {
+        node256() : inner(kind::node256) {}
+        node* children[256] = {};
+    };
+
+    // A position of an iterator within an inner node: -1 before its terminal, then
+    // the index of a child in node4/node16 and the byte of one in node48/node256
+    struct frame {
+        const inner* n;
+        int          pos;
+    };
+
+public:
+    // Walks the leaves of a subtree depth-first, keeping the path down to the current one
+    template<bool Const>
+    class basic_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = typename radix_trie::value_type;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = std::conditional_t<Const, const value_type*, value_type*>;
+        using reference         = std::conditional_t<Const, const value_type&, value_type&>;
+
+        basic_iterator() = default;
+
+        template<bool C> requires (Const && !C)
+        basic_iterator(const basic_iterator<C>& other) : path_(other.path_), current_(other.current_) {}
+
+        reference operator*()  const { return current_->kv;  }
+        pointer   operator->() const { return &current_->kv; }
+
+        basic_iterator& operator++()    { advance(); return *this; }
+        basic_iterator  operator++(int) { auto it = *this; advance(); return it; }
+
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) { return a.current_ == b.current_; }
+
+    private:
+        friend class radix_trie;
+        friend class basic_iterator<!Const>;
+
+        // Everything under n, which may be null
+        explicit basic_iterator(const node* n)
+        {
+            if (!n)
+                return;
+            if (n->type == kind::leaf) {
+                current_ = static_cast<leaf*>(const_cast<node*>(n));
+                return;
+            }
+            path_.push_back({ static_cast<const inner*>(n), -1 });
+            advance();
+        }
+
+        basic_iterator(std::vector<frame>&& path, leaf* current) : path_(std::move(path)), current_(current) {}
+
+        void advance()
+        {
+            while (!path_.empty()) {
+                frame& f = path_.back();
+                if (f.pos == -1) {
+                    f.pos = 0;
+                    if (f.n->terminal) {
+                        current_ = f.n->terminal;
+                        return;
+                    }
+                }
+                const node* next = next_child(f.n, f.pos);
+                if (!next) {
+                    path_.pop_back();
+                    continue;
+                }
+                if (next->type == kind::leaf) {
+                    current_ = static_cast<leaf*>(const_cast<node*>(next));
+                    return;
+                }
+                path_.push_back({ static_cast<const inner*>(next), -1 });
+            }
+            current_ = nullptr;
+        }
+
+        std::vector<frame> path_;
+        leaf*              current_ = nullptr;
+    };
+
+    using iterator       = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    // The keys that start with a prefix, in order
+    template<bool Const>
+    class basic_prefix_range {
+    public:
+        basic_iterator<Const> begin() const { return first_; }
+        basic_iterator<Const> end()   const { return {};     }
+
+        bool      is_empty() const { return first_ == basic_iterator<Const>(); }
+        size_type size()     const { return static_cast<size_type>(std::distance(begin(), end())); }
+
+    private:
+        friend class radix_trie;
+        explicit basic_prefix_range(basic_iterator<Const> first) : first_(std::move(first)) {}
+        basic_iterator<Const> first_;
+    };
+
+    using prefix_range       = basic_prefix_range<false>;
+    using const_prefix_range = basic_prefix_range<true>;
+
+    radix_trie() = default;
+
+    radix_trie(std::initializer_list<std::pair<std::string_view, V>> il)
+    {
+        for (const auto& [k, v] : il)
+            insert_or_assign(k, v);
+    }
+
+    radix_trie(const radix_trie& other) : root_(clone(other.root_)), size_(other.size_) {}
+
+    radix_trie(radix_trie&& other) noexcept
+        : root_(std::exchange(other.root_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+    radix_trie& operator=(radix_trie other) noexcept
+    {
+        std::swap(root_, other.root_);
+        std::swap(size_, other.size_);
+        return *this;
+    }
+
+    ~radix_trie() { destroy(root_); }
+
+    iterator       begin()       { return iterator(root_);       }
+    const_iterator begin() const { return const_iterator(root_); }
+    iterator       end()         { return {};                    }
+    const_iterator end()   const { return {};                    }
+
+    size_type size()     const { return size_;      }
+    bool      empty()    const { return size_ == 0; }
+    bool      is_empty() const { return size_ == 0; }
+
+    void clear()
+    {
+        destroy(root_);
+        root_ = nullptr;
+        size_ = 0;
+    }
+
+    // ------------------------------------------------------------------------------------------ lookup
+
+    iterator       find(std::string_view key)       { return find_path(key); }
+    const_iterator find(std::string_view key) const { return find_path(key); }
+
+    bool contains(std::string_view key) const { return find_leaf(key) != nullptr; }
+
+    V& at(std::string_view key)
+    {
+        leaf* l = find_leaf(key);
+        if (!l)
+            throw std::out_of_range("zen::radix_trie::at() KEY NOT FOUND");
+        return l->kv.second;
+    }
+
+    const V& at(std::string_view key) const { return const_cast<radix_trie*>(this)->at(key); }
+
+    // All the keys that start with p, including p itself, in order
+    prefix_range       prefix(std::string_view p)       { return prefix_range(prefix_first(p));       }
+    const_prefix_range prefix(std::string_view p) const { return const_prefix_range(prefix_first(p)); }
+
+    // The longest key that is a prefix of key (or key itself), or end() if there's none
+    iterator       longest_prefix_match(std::string_view key)       { return longest_match(key); }
+    const_iterator longest_prefix_match(std::string_view key) const { return longest_match(key); }
+
+    // ------------------------------------------------------------------------------------------ modifiers
+
+    // Returns whether the key was new; an existing value is left as it is
+    template<class... Args>
+    bool emplace(std::string_view key, Args&&... args)
+    {
+        auto [l, inserted] = insert_leaf(root_, key, 0, std::forward<Args>(args)...);
+        size_ += inserted;
+        return inserted;
+    }
+
+    bool insert(std::string_view key, const V& value) { return emplace(key, value); }
+    bool insert(std::string_view key, V&& value)      { return emplace(key, std::move(value)); }
+
+    template<class Vx>
+    bool insert_or_assign(std::string_view key, Vx&& value)
+    {
+        auto [l, inserted] = insert_leaf(root_, key, 0, std::forward<Vx>(value));
+        if (!inserted)
+            l->kv.second = std::forward<Vx>(value);
+        size_ += inserted;
+        return inserted;
+    }
+
+    V& operator[](std::string_view key)
+    {
+        auto [l, inserted] = insert_leaf(root_, key, 0);
+        size_ += inserted;
+        return l->kv.second;
+    }
+
+    size_type erase(std::string_view key)
+    {
+        const bool erased = erase_leaf(root_, key, 0);
+        size_ -= erased;
+        return erased;
+    }
+
+private:
+    // ------------------------------------------------------------------------------------------ nodes
+
+    static int child_position(const inner* in, unsigned char c)
+    {
+        switch (in->type) {
+        case kind::node4: {
+            auto* n = static_cast<const node4*>(in);
+            for (int i = 0; i < n->count; ++i)
+                if (n->keys[i] == c)
+                    return i;
+            return -1;
+        }
+        case kind::node16: {
+            auto* n = static_cast<const node16*>(in);
+#ifdef ZEN_SSE2
+            const __m128i match = _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(c)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(n->keys)));
+            const unsigned bits = static_cast<unsigned>(_mm_movemask_epi8(match)) & ((1u << n->count) - 1);
+            return bits ? std::countr_zero(bits) : -1;
+#else
+            for (int i = 0; i < n->count; ++i)
+                if (n->keys[i] == c)
+                    return i;
+            return -1;
+#endif
+        }
+        case kind::node48:
+            return static_cast<const node48*>(in)->index[c] ? c : -1;
+        default:
+            return static_cast<const node256*>(in)->children[c] ? c : -1;
+        }
+    }
+
+    // The child at a position returned by child_position()
+    static node*& child_at(const inner* in, int pos)
+    {
+        auto* mut = const_cast<inner*>(in);
+        switch (in->type) {
+        case kind::node4:  return static_cast<node4*>(mut)->children[pos];
+        case kind::node16: return static_cast<node16*>(mut)->children[pos];
+        case kind::node48: { auto* n = static_cast<node48*>(mut); return n->children[n->index[pos] - 1]; }
+        default:           return static_cast<node256*>(mut)->children[pos];
+        }
+    }
+
+    // The first child at or after pos, moving pos past it
+    static const node* next_child(const inner* in, int& pos)
+    {
+        switch (in->type) {
+        case kind::node4:  return pos < in->count ? static_cast<const node4*>(in)->children[pos++]  : nullptr;
+        case kind::node16: return pos < in->count ? static_cast<const node16*>(in)->children[pos++] : nullptr;
+        case kind::node48: {
+            auto* n = static_cast<const node48*>(in);
+            for (; pos < 256; ++pos)
+                if (n->index[pos])
+                    return n->children[n->index[pos++] - 1];
+            return nullptr;
+        }
+        default: {
+            auto* n = static_cast<const node256*>(in);
+            for (; pos < 256; ++pos)
+                if (n->children[pos])
+                    return n->children[pos++];
+            return nullptr;
+        }
+        }
+    }
+
+    // Adds a child for a byte that has none, growing the node into the next layout when full
+    static void add_child(node*& ref, unsigned char c, node* child)
+    {
+        auto* in = static_cast<inner*>(ref);
+        switch (in->type) {
+        case kind::node4:
+            if (in->count == 4) {
+                ref = grow<node4, node16>(static_cast<node4*>(in));
+                return add_child(ref, c, child);
+            }
+            return add_sorted(static_cast<node4*>(in), c, child);
+        case kind::node16:
+            if (in->count == 16) {
+                auto* n   = static_cast<node16*>(in);
+                auto* big = new node48();
+                move_header(n, big);
+                for (int i = 0; i < n->count; ++i) {
+                    big->children[i]     = n->children[i];
+                    big->index[n->keys[i]] = static_cast<unsigned char>(i + 1);
+                }
+                delete n;
+                ref = big;
+                return add_child(ref, c, child);
+            }
+            return add_sorted(static_cast<node16*>(in), c, child);
+        case kind::node48: {
+            auto* n = static_cast<node48*>(in);
+            if (n->count == 48) {
+                auto* big = new node256();
+                move_header(n, big);
+                for (int b = 0; b < 256; ++b)
+                    if (n->index[b])
+                        big->children[b] = n->children[n->index[b] - 1];
+                delete n;
+                ref = big;
+                return add_child(ref, c, child);
+            }
+            int slot = 0;
+            while (n->children[slot])
+                ++slot;
+            n->children[slot] = child;
+            n->index[c] = static_cast<unsigned char>(slot + 1);
+            ++n->count;
+            return;
+        }
+        default:
+            static_cast<node256*>(in)->children[c] = child;
+            ++in->count;
+        }
+    }
+
+    template<class N>
+    static void add_sorted(N* n, unsigned char c, node* child)
+    {
+        int i = n->count;
+        for (; i > 0 && n->keys[i - 1] > c; --i) {
+            n->keys[i]     = n->keys[i - 1];
+            n->children[i] = n->children[i - 1];
+        }
+        n->keys[i]     = c;
+        n->children[i] = child;
+        ++n->count;
+    }
+
+    template<class Small, class Big>
+    static Big* grow(Small* n)
+    {
+        auto* big = new Big();
+        move_header(n, big);
+        std::copy(n->keys, n->keys + n->count, big->keys);
+        std::copy(n->children, n->children + n->count, big->children);
+        delete n;
+        return big;
+    }
+
+    static void move_header(inner* from, inner* to)
+    {
+        to->count    = from->count;
+        to->prefix   = std::move(from->prefix);
+        to->terminal = from->terminal;
+    }
+
+    // Removes the child of a byte, shrinking the node into the previous layout well below
+    // its capacity (so that alternating inserts and erases don't keep converting it), and
+    // collapsing it into its parent's only remaining entry
+    static void remove_child(node*& ref, unsigned char c)
+    {
+        auto* in = static_cast<inner*>(ref);
+        switch (in->type) {
+        case kind::node4:
+        case kind::node16: {
+            const int pos = child_position(in, c);
+            if (in->type == kind::node4)
+                remove_sorted(static_cast<node4*>(in), pos);
+            else
+                remove_sorted(static_cast<node16*>(in), pos);
+            if (in->type == kind::node16 && in->count <= 3) {
+                auto* n     = static_cast<node16*>(in);
+                auto* small = new node4();
+                move_header(n, small);
+                std::copy(n->keys, n->keys + n->count, small->keys);
+                std::copy(n->children, n->children + n->count, small->children);
+                delete n;
+                ref = small;
+            }
+            break;
+        }
+        case kind::node48: {
+            auto* n = static_cast<node48*>(in);
+            n->children[n->index[c] - 1] = nullptr;
+            n->index[c] = 0;
+            if (--n->count <= 12) {
+                auto* small = new node16();
+                move_header(n, small);
+                for (int b = 0, i = 0; b < 256; ++b)
+                    if (n->index[b]) {
+                        small->keys[i]     = static_cast<unsigned char>(b);
+                        small->children[i] = n->children[n->index[b] - 1];
+                        ++i;
+                    }
+                delete n;
+                ref = small;
+            }
+            break;
+        }
+        default: {
+            auto* n = static_cast<node256*>(in);
+            n->children[c] = nullptr;
+            if (--n->count <= 37) {
+                auto* small = new node48();
+                move_header(n, small);
+                for (int b = 0, i = 0; b < 256; ++b)
+                    if (n->children[b]) {
+                        small->children[i] = n->children[b];
+                        small->index[b]    = static_cast<unsigned char>(++i);
+                    }
+                delete n;
+                ref = small;
+            }
+        }
+        }
+        collapse(ref);
+    }
+
+    template<class N>
+    static void remove_sorted(N* n, int pos)
+    {
+        std::copy(n->keys + pos + 1, n->keys + n->count, n->keys + pos);
+        std::copy(n->children + pos + 1, n->children + n->count, n->children + pos);
+        --n->count;
+    }
+
+    // A node left with a single entry is replaced by it, its prefix moving down into the child
+    static void collapse(node*& ref)
+    {
+        auto* in = static_cast<inner*>(ref);
+        if (in->count == 0) {
+            ref = in->terminal;
+            delete_inner(in);
+        }
+        else if (in->count == 1 && !in->terminal) {
+            int pos = 0;
+            node* child = const_cast<node*>(next_child(in, pos));
+            if (child->type != kind::leaf) {
+                auto* c = static_cast<inner*>(child);
+                const unsigned char byte = in->type == kind::node4 ? static_cast<node4*>(in)->keys[0] : static_cast<unsigned char>(pos - 1);
+                c->prefix = in->prefix + static_cast<char>(byte) + c->prefix;
+            }
+            ref = child;
+            delete_inner(in);
+        }
+    }
+
+    // ------------------------------------------------------------------------------------------ insertion and erasure
+
+    // Finds or creates the leaf of the key in the subtree at ref, whose keys share key[0, depth)
+    template<class... Args>
+    static std::pair<leaf*, bool> insert_leaf(node*& ref, std::string_view key, std::size_t depth, Args&&... args)
+    {
+        if (!ref) {
+            auto* l = new leaf(key, std::forward<Args>(args)...);
+            ref = l;
+            return { l, true };
+        }
+
+        if (ref->type == kind::leaf) {
+            auto* existing = static_cast<leaf*>(ref);
+            const std::string_view other = existing->kv.first;
+            if (other == key)
+                return { existing, false };
+
+            // Both go under a new node holding the bytes they share
+            const std::size_t shared = static_cast<std::size_t>(std::mismatch(
+                key.begin() + depth, key.end(), other.begin() + depth, other.end()).first - key.begin()) - depth;
+            auto* l = new leaf(key, std::forward<Args>(args)...);
+            auto* n = new node4();
+            n->prefix = std::string(key.substr(depth, shared));
+            node* branch = n;
+            place(branch, existing, depth + shared);
+            place(branch, l,        depth + shared);
+            ref = branch;
+            return { l, true };
+        }
+
+        auto* in = static_cast<inner*>(ref);
+        const std::string_view prefix = in->prefix;
+        const std::size_t shared = static_cast<std::size_t>(std::mismatch(
+            prefix.begin(), prefix.end(), key.begin() + depth, key.end()).first - prefix.begin());
+
+        if (shared < prefix.size()) {
+            // The key leaves the prefix midway, so a new node takes the shared part
+            auto* l = new leaf(key, std::forward<Args>(args)...);
+            auto* n = new node4();
+            n->prefix = std::string(prefix.substr(0, shared));
+            const unsigned char byte = static_cast<unsigned char>(prefix[shared]);
+            in->prefix.erase(0, shared + 1);
+            node* branch = n;
+            add_child(branch, byte, in);
+            place(branch, l, depth + shared);
+            ref = branch;
+            return { l, true };
+        }
+
+        depth += prefix.size();
+        if (depth == key.size()) {
+            if (in->terminal)
+                return { in->terminal, false };
+            in->terminal = new leaf(key, std::forward<Args>(args)...);
+            return { in->terminal, true };
+        }
+
+        const unsigned char byte = static_cast<unsigned char>(key[depth]);
+        if (const int pos = child_position(in, byte); pos >= 0)
+            return insert_leaf(child_at(in, pos), key, depth + 1, std::forward<Args>(args)...);
+
+        auto* l = new leaf(key, std::forward<Args>(args)...);
+        add_child(ref, byte, l);
+        return { l, true };
+    }
+
+    // Puts a leaf whose key has depth bytes in common with the node's keys into it
+    static void place(node*& ref, leaf* l, std::size_t depth)
+    {
+        const std::string& key = l->kv.first;
+        if (key.size() == depth)
+            static_cast<inner*>(ref)->terminal = l;
+        else
+            add_child(ref, static_cast<unsigned char>(key[depth]), l);
+    }
+
+    static bool erase_leaf(node*& ref, std::string_view key, std::size_t depth)
+    {
+        if (!ref)
+            return false;
+
+        if (ref->type == kind::leaf) {
+            if (static_cast<leaf*>(ref)->kv.first != key)
+                return false;
+            delete static_cast<leaf*>(ref);
+            ref = nullptr;
+            return true;
+        }
+
+        auto* in = static_cast<inner*>(ref);
+        if (key.substr(depth, in->prefix.size()) != in->prefix)
+            return false;
+        depth += in->prefix.size();
+
+        if (depth == key.size()) {
+            if (!in->terminal)
+                return false;
+            delete in->terminal;
+            in->terminal = nullptr;
+            collapse(ref);
+            return true;
+        }
+
+        const unsigned char byte = static_cast<unsigned char>(key[depth]);
+        const int pos = child_position(in, byte);
+        if (pos < 0)
+            return false;
+
+        node*& child = child_at(in, pos);
+        if (child->type == kind::leaf) {
+            if (static_cast<leaf*>(child)->kv.first != key)
+                return false;
+            delete static_cast<leaf*>(child);
+            remove_child(ref, byte);
+            return true;
+        }
+        return erase_leaf(child, key, depth + 1);
+    }
+
+    // ------------------------------------------------------------------------------------------ lookup
+
+    // The iterator of a key, recording the nodes passed on the way down
+    iterator find_path(std::string_view key) const
+    {
+        std::vector<frame> path;
+        const node* n = root_;
+        std::size_t depth = 0;
+        while (n) {
+            if (n->type == kind::leaf) {
+                auto* l = static_cast<leaf*>(const_cast<node*>(n));
+                return l->kv.first == key ? iterator(std::move(path), l) : iterator();
+            }
+            auto* in = static_cast<const inner*>(n);
+            if (key.substr(depth, in->prefix.size()) != in->prefix)
+                return iterator();
+            depth += in->prefix.size();
+            if (depth == key.size()) {
+                if (!in->terminal)
+                    return iterator();
+                path.push_back({ in, 0 });
+                return iterator(std::move(path), in->terminal);
+            }
+            const int pos = child_position(in, static_cast<unsigned char>(key[depth]));
+            if (pos < 0)
+                return iterator();
+            path.push_back({ in, pos + 1 });
+            n = child_at(in, pos);
+            ++depth;
+        }
+        return iterator();
+    }
+
+    // The first key that starts with p, iterating up to the end of its subtree
+    iterator prefix_first(std::string_view p) const
+    {
+        const node* n = root_;
+        std::size_t depth = 0;
+        while (n) {
+            if (n->type == kind::leaf)
+                return static_cast<const leaf*>(n)->kv.first.starts_with(p) ? iterator(n) : iterator();
+
+            auto* in = static_cast<const inner*>(n);
+            const std::size_t m = std::min(in->prefix.size(), p.size() - depth);
+            if (p.compare(depth, m, in->prefix, 0, m) != 0)
+                return iterator();
+            if (depth + in->prefix.size() >= p.size())
+                return iterator(n);
+
+            depth += in->prefix.size();
+            const int pos = child_position(in, static_cast<unsigned char>(p[depth]));
+            if (pos < 0)
+                return iterator();
+            n = child_at(in, pos);
+            ++depth;
+        }
+        return iterator();
+    }
+
+    iterator longest_match(std::string_view key) const
+    {
+        const leaf* best = nullptr;
+        const node* n = root_;
+        std::size_t depth = 0;
+        while (n) {
+            if (n->type == kind::leaf) {
+                auto* l = static_cast<const leaf*>(n);
+                if (key.starts_with(l->kv.first))
+                    best = l;
+                break;
+            }
+            auto* in = static_cast<const inner*>(n);
+            if (key.substr(depth, in->prefix.size()) != in->prefix)
+                break;
+            depth += in->prefix.size();
+            if (in->terminal)
+                best = in->terminal;
+            if (depth == key.size())
+                break;
+            const int pos = child_position(in, static_cast<unsigned char>(key[depth]));
+            if (pos < 0)
+                break;
+            n = child_at(in, pos);
+            ++depth;
+        }
+        return best ? find_path(best->kv.first) : iterator();
+    }
+
+    leaf* find_leaf(std::string_view key) const
+    {
+        const node* n = root_;
+        std::size_t depth = 0;
+        while (n) {
+            if (n->type == kind::leaf) {
+                auto* l = static_cast<leaf*>(const_cast<node*>(n));
+                return l->kv.first == key ? l : nullptr;
+            }
+            auto* in = static_cast<const inner*>(n);
+            if (key.substr(depth, in->prefix.size()) != in->prefix)
+                return nullptr;
+            depth += in->prefix.size();
+            if (depth == key.size())
+                return in->terminal;
+            const int pos = child_position(in, static_cast<unsigned char>(key[depth]));
+            if (pos < 0)
+                return nullptr;
+            n = child_at(in, pos);
+            ++depth;
+        }
+        return nullptr;
+    }
+
+    // ------------------------------------------------------------------------------------------ memory
+
+    static void delete_inner(inner* in)
+    {
+        switch (in->type) {
+        case kind::node4:  delete static_cast<node4*>(in);   break;
+        case kind::node16: delete static_cast<node16*>(in);  break;
+        case kind::node48: delete static_cast<node48*>(in);  break;
+        default:           delete static_cast<node256*>(in); break;
+        }
+    }
+
+    static void destroy(node* n)
+    {
+        if (!n)
+            return;
+        if (n->type == kind::leaf) {
+            delete static_cast<leaf*>(n);
+            return;
+        }
+        auto* in = static_cast<inner*>(n);
+        int pos = 0;
+        while (const node* child = next_child(in, pos))
+            destroy(const_cast<node*>(child));
+        delete in->terminal;
+        delete_inner(in);
+    }
+
+    static node* clone(const node* n)
+    {
+        if (!n)
+            return nullptr;
+        if (n->type == kind::leaf) {
+            auto* l = static_cast<const leaf*>(n);
+            return new leaf(l->kv.first, l->kv.second);
+        }
+
+        auto* in = static_cast<const inner*>(n);
+        inner* copy = nullptr;
+        switch (in->type) {
+        case kind::node4:  copy = new node4(*static_cast<const node4*>(in));     break;
+        case kind::node16: copy = new node16(*static_cast<const node16*>(in));   break;
+        case kind::node48: copy = new node48(*static_cast<const node48*>(in));   break;
+        default:           copy = new node256(*static_cast<const node256*>(in)); break;
+        }
+        copy->terminal = in->terminal ? static_cast<leaf*>(clone(in->terminal)) : nullptr;
+
+        // The copied child pointers still point into the original, and are replaced in place
+        for (int pos = 0, slot = 0; slot < 256; ++slot) {
+            const int before = pos;
+            const node* child = next_child(in, pos);
+            if (!child)
+                break;
+            child_at(copy, in->type == kind::node4 || in->type == kind::node16 ? before : pos - 1) = clone(child);
+        }
+        return copy;
+    }
+
+    node*     root_ = nullptr;
+    size_type size_ = 0;
+};
+
+} // namespace zen
@@ -0,0 +1,362 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <initializer_list>
+#include <type_traits>
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
+#include <cstring>
+#include <cstddef>
+#include <utility>
+#include <memory>
+#include <span>
+#include <bit>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
+
+namespace zen {
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::ring_deque
+
+// A deque in one contiguous circular buffer whose capacity is a power of two, so that
+// the i-th element is at (first + i) & (capacity - 1), and growing at either end is
+// O(1) amortized, like std::vector's push_back. Unlike std::deque, which splits its
+// elements into small blocks, iterating goes through a single buffer, and segments()
+// exposes the elements as (at most) two contiguous spans for bulk processing.
+// References are invalidated by growing, as with std::vector.
+// Example: zen::ring_deque<int> d = { 1, 2, 3 };
+//          d.push_front(0);
+//          zen::queue<int, zen::ring_deque<int>> q; // see also zen::ring_queue
+template<class T, class A = std::allocator<T>>
+class ring_deque : private zen::stackonly
+{
+    using traits = std::allocator_traits<A>;
+
+    // Elements that can be moved to a new place in memory bit by bit
+    static constexpr bool relocatable = std::is_trivially_copyable_v<T>;
+
+    template<bool Const>
+    class basic_iterator {
+    public:
+        using iterator_concept  = std::random_access_iterator_tag;
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = std::conditional_t<Const, const T*, T*>;
+        using reference         = std::conditional_t<Const, const T&, T&>;
+
+        basic_iterator() = default;
+
+        template<bool C, class = std::enable_if_t<Const && !C>>
+        basic_iterator(const basic_iterator<C>& it) : buffer_(it.buffer_), mask_(it.mask_), pos_(it.pos_) {}
+
+        reference operator*()                   const { return buffer_[pos_ & mask_];       }
+        pointer   operator->()                  const { return &buffer_[pos_ & mask_];      }
+        reference operator[](difference_type n) const { return buffer_[(pos_ + n) & mask_]; }
+
+        basic_iterator& operator++()    { ++pos_; return *this; }
+        basic_iterator& operator--()    { --pos_; return *this; }
+        basic_iterator  operator++(int) { auto it = *this; ++pos_; return it; }
+        basic_iterator  operator--(int) { auto it = *this; --pos_; return it; }
+
+        basic_iterator& operator+=(difference_type n) { pos_ += n; return *this; }
+        basic_iterator& operator-=(difference_type n) { pos_ -= n; return *this; }
+
+        friend basic_iterator  operator+(basic_iterator it, difference_type n) { return it += n; }
+        friend basic_iterator  operator+(difference_type n, basic_iterator it) { return it += n; }
+        friend basic_iterator  operator-(basic_iterator it, difference_type n) { return it -= n; }
+        friend difference_type operator-(const basic_iterator& a, const basic_iterator& b) { return static_cast<difference_type>(a.pos_ - b.pos_); }
+
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) { return a.pos_ == b.pos_; }
+        friend auto operator<=>(const basic_iterator& a, const basic_iterator& b) { return static_cast<difference_type>(a.pos_ - b.pos_) <=> 0; }
+
+    private:
+        template<bool> friend class basic_iterator;
+        friend class ring_deque;
+
+        basic_iterator(pointer buffer, std::size_t mask, std::size_t pos) : buffer_(buffer), mask_(mask), pos_(pos) {}
+
+        // The position is not masked, so that end() differs from begin() in a full ring
+        pointer     buffer_ = nullptr;
+        std::size_t mask_   = 0;
+        std::size_t pos_    = 0;
+    };
+
+public:
+    using value_type             = T;
+    using allocator_type         = A;
+    using size_type              = std::size_t;
+    using difference_type        = std::ptrdiff_t;
+    using reference              = T&;
+    using const_reference        = const T&;
+    using iterator               = basic_iterator<false>;
+    using const_iterator         = basic_iterator<true>;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    ring_deque() = default;
+
+    explicit ring_deque(const A& alloc) : alloc_(alloc) {}
+
+    explicit ring_deque(size_type n, const A& alloc = A()) : alloc_(alloc)
+    {
+        reserve(n);
+        while (size_ < n)
+            emplace_back();
+    }
+
+    ring_deque(size_type n, const T& x, const A& alloc = A()) : alloc_(alloc)
+    {
+        reserve(n);
+        while (size_ < n)
+            push_back(x);
+    }
+
+    template<class InputIt, class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    ring_deque(InputIt first, InputIt last, const A& alloc = A()) : alloc_(alloc)
+    {
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<InputIt>::iterator_category>)
+            reserve(static_cast<size_type>(std::distance(first, last)));
+        for (; first != last; ++first)
+            emplace_back(*first);
+    }
+
+    ring_deque(std::initializer_list<T> il, const A& alloc = A()) : ring_deque(il.begin(), il.end(), alloc) {}
+
+    ring_deque(const ring_deque& other)
+        : ring_deque(other.begin(), other.end(), traits::select_on_container_copy_construction(other.alloc_)) {}
+
+    ring_deque(ring_deque&& other) noexcept
+        : buffer_(std::exchange(other.buffer_, nullptr)), capacity_(std::exchange(other.capacity_, 0)),
+          first_(std::exchange(other.first_, 0)), size_(std::exchange(other.size_, 0)), alloc_(std::move(other.alloc_)) {}
+
+    // Copy-and-swap, assuming allocators that compare equal, like std::allocator
+    ring_deque& operator=(ring_deque other) noexcept { swap(other); return *this; }
+
+    ~ring_deque()
+    {
+        clear();
+        if (buffer_)
+            traits::deallocate(alloc_, buffer_, capacity_);
+    }
+
+    allocator_type get_allocator() const { return alloc_; }
+
+    // ------------------------------------------------------------------------------------------ access
+
+    iterator               begin()         { return iterator(buffer_, mask(), first_);                }
+    iterator               end()           { return iterator(buffer_, mask(), first_ + size_);        }
+    const_iterator         begin()   const { return const_iterator(buffer_, mask(), first_);          }
+    const_iterator         end()     const { return const_iterator(buffer_, mask(), first_ + size_);  }
+    const_iterator         cbegin()  const { return begin();                         }
+    const_iterator         cend()    const { return end();                           }
+    reverse_iterator       rbegin()        { return reverse_iterator(end());         }
+    reverse_iterator       rend()          { return reverse_iterator(begin());       }
+    const_reverse_iterator rbegin()  const { return const_reverse_iterator(end());   }
+    const_reverse_iterator rend()    const { return const_reverse_iterator(begin()); }
+
+    T&       operator[](size_type i)       { return buffer_[(first_ + i) & mask()]; }
+    const T& operator[](size_type i) const { return buffer_[(first_ + i) & mask()]; }
+
+    T&       at(size_type i)       { check(i); return (*this)[i]; }
+    const T& at(size_type i) const { check(i); return (*this)[i]; }
+
+    T&       front()       { return buffer_[first_];                        }
+    const T& front() const { return buffer_[first_];                        }
+    T&       back()        { return buffer_[(first_ + size_ - 1) & mask()]; }
+    const T& back()  const { return buffer_[(first_ + size_ - 1) & mask()]; }
+
+    // The elements in order as two contiguous runs, the second of which is
+    // empty unless the elements wrap around the end of the buffer
+    std::pair<std::span<T>, std::span<T>> segments()
+    {
+        const size_type head = std::min(size_, capacity_ - first_);
+        return { std::span<T>(buffer_ + first_, head), std::span<T>(buffer_, size_ - head) };
+    }
+
+    std::pair<std::span<const T>, std::span<const T>> segments() const
+    {
+        const size_type head = std::min(size_, capacity_ - first_);
+        return { std::span<const T>(buffer_ + first_, head), std::span<const T>(buffer_, size_ - head) };
+    }
+
+    size_type size()     const { return size_;      }
+    size_type capacity() const { return capacity_;  }
+    bool      empty()    const { return size_ == 0; }
+    bool      is_empty() const { return size_ == 0; }
+
+    size_type max_size() const { return traits::max_size(alloc_); }
+
+    template<class Pred>
+    typename std::enable_if<std::is_invocable_r<bool, Pred, const T&>::value, bool>::type
+        contains(Pred p) const
+    {
+        return std::find_if(begin(), end(), p) != end();
+    }
+
+    bool contains(const T& x) const { return std::find(begin(), end(), x) != end(); }
+
+    // ------------------------------------------------------------------------------------------ modifiers
+
+    // Rounds up to a power of two
+    void reserve(size_type n)
+    {
+        if (n > capacity_)
+            reallocate(std::bit_ceil(n));
+    }
+
+    void shrink_to_fit()
+    {
+        const size_type n = size_ ? std::bit_ceil(size_) : 0;
+        if (n < capacity_)
+            reallocate(n);
+    }
+
+    void clear() noexcept
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            for (size_type i = 0; i < size_; ++i)
+                traits::destroy(alloc_, &(*this)[i]);
+        first_ = size_ = 0;
+    }
+
+    template<class... Args>
+    T& emplace_back(Args&&... args)
+    {
+        if (size_ == capacity_) {
+            // The arguments may refer to an element, so the new one is built before the old ones move
+            T x(std::forward<Args>(args)...);
+            grow();
+            traits::construct(alloc_, buffer_ + ((first_ + size_) & mask()), std::move(x));
+        } else {
+            traits::construct(alloc_, buffer_ + ((first_ + size_) & mask()), std::forward<Args>(args)...);
+        }
+        ++size_;
+        return back();
+    }
+
+    template<class... Args>
+    T& emplace_front(Args&&... args)
+    {
+        if (size_ == capacity_) {
+            T x(std::forward<Args>(args)...);
+            grow();
+            traits::construct(alloc_, buffer_ + ((first_ - 1) & mask()), std::move(x));
+        } else {
+            traits::construct(alloc_, buffer_ + ((first_ - 1) & mask()), std::forward<Args>(args)...);
+        }
+        first_ = (first_ - 1) & mask();
+        ++size_;
+        return front();
+    }
+
+    void push_back(const T& x)  { emplace_back(x);             }
+    void push_back(T&& x)       { emplace_back(std::move(x));  }
+    void push_front(const T& x) { emplace_front(x);            }
+    void push_front(T&& x)      { emplace_front(std::move(x)); }
+
+    void pop_back()
+    {
+        traits::destroy(alloc_, &back());
+        --size_;
+    }
+
+    void pop_front()
+    {
+        traits::destroy(alloc_, &front());
+        first_ = (first_ + 1) & mask();
+        --size_;
+    }
+
+    void swap(ring_deque& other) noexcept
+    {
+        using std::swap;
+        swap(buffer_,   other.buffer_);
+        swap(capacity_, other.capacity_);
+        swap(first_,    other.first_);
+        swap(size_,     other.size_);
+        swap(alloc_,    other.alloc_);
+    }
+
+    friend void swap(ring_deque& a, ring_deque& b) noexcept { a.swap(b); }
+
+    friend bool operator==(const ring_deque& a, const ring_deque& b) { return std::equal(a.begin(), a.end(), b.begin(), b.end()); }
+    friend bool operator!=(const ring_deque& a, const ring_deque& b) { return !(a == b); }
+    friend bool operator< (const ring_deque& a, const ring_deque& b) { return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end()); }
+
+private:
+    size_type mask() const { return capacity_ - 1; } // all ones for an empty ring, which is harmless
+
+    void check(size_type i) const
+    {
+        if (i >= size_)
+            throw std::out_of_range("zen::ring_deque::at() INDEX OUT OF RANGE");
+    }
+
+    void grow()
+    {
+        if (capacity_ > max_size() / 2)
+            throw std::length_error("zen::ring_deque WOULD EXCEED ITS MAXIMUM SIZE");
+        reallocate(capacity_ ? 2 * capacity_ : 8);
+    }
+
+    // Moves the elements to the start of a new buffer of n (a power of two, at least size()) slots
+    void reallocate(size_type n)
+    {
+        T* buffer = n ? traits::allocate(alloc_, n) : nullptr;
+        const auto [head, tail] = segments();
+        if constexpr (relocatable) {
+            if (!head.empty()) std::memcpy(static_cast<void*>(buffer),               head.data(), head.size_bytes());
+            if (!tail.empty()) std::memcpy(static_cast<void*>(buffer + head.size()), tail.data(), tail.size_bytes());
+        } else {
+            size_type i = 0;
+            try {
+                for (; i < size_; ++i)
+                    traits::construct(alloc_, buffer + i, std::move_if_noexcept((*this)[i]));
+            } catch (...) {
+                std::destroy_n(buffer, i);
+                traits::deallocate(alloc_, buffer, n);
+                throw;
+            }
+            for (i = 0; i < size_; ++i)
+                traits::destroy(alloc_, &(*this)[i]);
+        }
+
+        if (buffer_)
+            traits::deallocate(alloc_, buffer_, capacity_);
+        buffer_   = buffer;
+        capacity_ = n;
+        first_    = 0;
+    }
+
+    T*        buffer_   = nullptr;
+    size_type capacity_ = 0;
+    size_type first_    = 0;
+    size_type size_     = 0;
+    A         alloc_;
+};
+
+} // namespace zen
@@ -0,0 +1,232 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <limits>
+#include <vector>
+#include <span>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
+
+namespace zen {
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::slot_map
+
+// A container that keeps its elements contiguous, like a vector, but gives each one a
+// handle that stays valid while other elements come and go, unlike a vector's index.
+// A handle names a slot and the generation the slot was in when the element went into
+// it; erasing the element moves the slot on to a new generation, so the old handle is
+// known to be stale instead of silently naming the next element to reuse the slot.
+// Insertion, erasure and lookup are O(1) with no hashing, and iteration runs over the
+// dense array of elements, whose order changes as erasures fill holes from the end.
+// Example: zen::slot_map<zen::string> names;
+//          auto h = names.insert("Ada");
+//          names[h] += " Lovelace";
+//          names.erase(h);
+//          names.contains(h); // false, and no later insert() makes it true again
+template<class T>
+class slot_map : private zen::stackonly
+{
+    // A slot's generation is odd while it holds an element and even while it's free
+    struct slot {
+        std::uint32_t index;      // of the element in the dense array, or of the next free slot
+        std::uint32_t generation;
+    };
+
+    static constexpr std::uint32_t npos = std::numeric_limits<std::uint32_t>::max();
+
+public:
+    using value_type     = T;
+    using size_type      = std::size_t;
+    using iterator       = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    class handle {
+    public:
+        handle() = default;
+        friend bool operator==(handle a, handle b) { return a.slot_ == b.slot_ && a.generation_ == b.generation_; }
+        friend bool operator!=(handle a, handle b) { return !(a == b); }
+
+    private:
+        friend class slot_map;
+        handle(std::uint32_t s, std::uint32_t generation) : slot_(s), generation_(generation) {}
+        std::uint32_t slot_       = npos;
+        std::uint32_t generation_ = 0; // never that of an occupied slot
+    };
+
+    slot_map() = default;
+
+    size_type size()     const { return values_.size();  }
+    bool      empty()    const { return values_.empty(); }
+    bool      is_empty() const { return values_.empty(); }
+
+    void reserve(size_type n)
+    {
+        values_.reserve(n);
+        owners_.reserve(n);
+        slots_.reserve(n);
+    }
+
+    // ------------------------------------------------------------------------------------------ handles
+
+    bool contains(handle h) const
+    {
+        return h.slot_ < slots_.size() && slots_[h.slot_].generation == h.generation_;
+    }
+
+    // The element of a handle, or nullptr if it's stale
+    T*       find(handle h)       { return contains(h) ? &values_[slots_[h.slot_].index] : nullptr; }
+    const T* find(handle h) const { return contains(h) ? &values_[slots_[h.slot_].index] : nullptr; }
+
+    T&       operator[](handle h)       { return values_[slots_[h.slot_].index]; }
+    const T& operator[](handle h) const { return values_[slots_[h.slot_].index]; }
+
+    T& at(handle h)
+    {
+        if (!contains(h))
+            throw std::out_of_range("zen::slot_map::at() STALE HANDLE");
+        return (*this)[h];
+    }
+
+    const T& at(handle h) const { return const_cast<slot_map*>(this)->at(h); }
+
+    // The handle of an element found by iterating or through values()
+    handle handle_of(const_iterator it) const { return handle_at(static_cast<size_type>(it - values_.cbegin())); }
+    handle handle_at(size_type i)        const { return handle(owners_[i], slots_[owners_[i]].generation); }
+
+    // ------------------------------------------------------------------------------------------ changes
+
+    handle insert(const T& x) { return emplace(x);            }
+    handle insert(T&& x)      { return emplace(std::move(x)); }
+
+    template<class... Args>
+    handle emplace(Args&&... args)
+    {
+        if (values_.size() >= npos)
+            throw std::length_error("zen::slot_map HAS NO MORE ROOM FOR HANDLES");
+
+        const auto i = static_cast<std::uint32_t>(values_.size());
+        values_.emplace_back(std::forward<Args>(args)...);
+
+        std::uint32_t s = free_;
+        try {
+            if (s == npos) {
+                s = static_cast<std::uint32_t>(slots_.size());
+                slots_.push_back({ i, 0 });
+            }
+            owners_.push_back(s);
+        } catch (...) {
+            values_.pop_back();
+            throw;
+        }
+
+        slot& sl = slots_[s];
+        if (s == free_)
+            free_ = sl.index;
+        sl.index = i;
+        ++sl.generation; // to odd
+        return handle(s, sl.generation);
+    }
+
+    // Moves the last element into the place of the erased one; returns whether h was valid
+    bool erase(handle h)
+    {
+        if (!contains(h))
+            return false;
+        erase_slot(h.slot_);
+        return true;
+    }
+
+    iterator erase(const_iterator it)
+    {
+        const auto i = static_cast<size_type>(it - values_.cbegin());
+        erase_slot(owners_[i]);
+        return values_.begin() + static_cast<std::ptrdiff_t>(i);
+    }
+
+    // Erases every element for which pred is true, making all their handles stale
+    template<class Pred>
+    size_type erase_if(Pred pred)
+    {
+        const size_type before = values_.size();
+        for (size_type i = 0; i < values_.size();) {
+            if (pred(std::as_const(values_[i])))
+                erase_slot(owners_[i]);
+            else
+                ++i;
+        }
+        return before - values_.size();
+    }
+
+    // Empties the map; every handle it gave out becomes stale
+    void clear()
+    {
+        while (!values_.empty())
+            erase_slot(owners_.back());
+    }
+
+    // ------------------------------------------------------------------------------------------ dense access
+
+    iterator       begin()       { return values_.begin();  }
+    const_iterator begin() const { return values_.cbegin(); }
+    iterator       end()         { return values_.end();    }
+    const_iterator end()   const { return values_.cend();   }
+
+    std::span<T>       values()       { return values_; }
+    std::span<const T> values() const { return values_; }
+
+private:
+    void erase_slot(std::uint32_t s)
+    {
+        slot& sl = slots_[s];
+        const std::uint32_t i    = sl.index;
+        const std::uint32_t last = static_cast<std::uint32_t>(values_.size() - 1);
+
+        if (i != last) {
+            values_[i] = std::move(values_[last]);
+            owners_[i] = owners_[last];
+            slots_[owners_[i]].index = i;
+        }
+        values_.pop_back();
+        owners_.pop_back();
+
+        // A slot whose generation would wrap around is retired rather than reused,
+        // since a handle from its first generation would otherwise come back to life
+        if (++sl.generation == std::numeric_limits<std::uint32_t>::max() - 1)
+            return;
+        sl.index = free_;
+        free_    = s;
+    }
+
+    std::vector<T>             values_; // dense
+    std::vector<std::uint32_t> owners_; // the slot of each element
+    std::vector<slot>          slots_;
+    std::uint32_t              free_ = npos; // first of the free slots, linked through their index
+};
+
+} // namespace zen
@@ -0,0 +1,405 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <initializer_list>
+#include <type_traits>
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
+#include <cstring>
+#include <cstddef>
+#include <utility>
+#include <memory>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
+
+namespace zen {
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::small_vector
+
+// A vector that keeps up to N elements inside the object itself, so that a zen::small_vector
+// (being stack-only, like all zen containers) doesn't touch the heap at all until it grows
+// beyond N elements, at which point it moves them to a heap buffer the way std::vector does.
+// Trivially copyable elements are moved around with memcpy. Unlike with std::vector, moving
+// a small_vector whose elements are inline moves the elements one by one and doesn't keep
+// iterators valid; moving one whose elements are on the heap just takes over the buffer.
+// Example: zen::small_vector<int, 8> v = { 1, 2, 3 }; // no allocation
+//          v.is_inline(); // true until more than 8 elements are there
+template<class T, std::size_t N, class A = std::allocator<T>>
+class small_vector : private zen::stackonly
+{
+    ZEN_STATIC_ASSERT(N > 0, "zen::small_vector NEEDS ROOM FOR AT LEAST ONE INLINE ELEMENT");
+
+    using traits = std::allocator_traits<A>;
+
+    // Elements that can be moved to a new place in memory bit by bit
+    static constexpr bool relocatable = std::is_trivially_copyable_v<T>;
+
+public:
+    using value_type             = T;
+    using allocator_type         = A;
+    using size_type              = std::size_t;
+    using difference_type        = std::ptrdiff_t;
+    using reference              = T&;
+    using const_reference        = const T&;
+    using pointer                = T*;
+    using const_pointer          = const T*;
+    using iterator               = T*;
+    using const_iterator         = const T*;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    static constexpr size_type inline_capacity() { return N; }
+
+    small_vector() = default;
+
+    explicit small_vector(const A& alloc) : alloc_(alloc) {}
+
+    explicit small_vector(size_type n, const A& alloc = A()) : alloc_(alloc) { resize(n); }
+
+    small_vector(size_type n, const T& x, const A& alloc = A()) : alloc_(alloc) { assign(n, x); }
+
+    template<class InputIt, class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    small_vector(InputIt first, InputIt last, const A& alloc = A()) : alloc_(alloc) { assign(first, last); }
+
+    small_vector(std::initializer_list<T> il, const A& alloc = A()) : alloc_(alloc) { assign(il.begin(), il.end()); }
+
+    small_vector(const small_vector& other)
+        : alloc_(traits::select_on_container_copy_construction(other.alloc_)) { assign(other.begin(), other.end()); }
+
+    small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : alloc_(std::move(other.alloc_)) { take(other); }
+
+    small_vector& operator=(const small_vector& other)
+    {
+        if (this != &other)
+            assign(other.begin(), other.end());
+        return *this;
+    }
+
+    // Without a propagating (or always equal) allocator, the heap elements of other may have to
+    // be moved one by one into memory of this one's allocator, which can throw like std::vector's
+    small_vector& operator=(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T> &&
+        (traits::propagate_on_container_move_assignment::value || traits::is_always_equal::value))
+    {
+        if (this != &other) {
+            clear();
+            release();
+            if constexpr (traits::propagate_on_container_move_assignment::value)
+                alloc_ = std::move(other.alloc_);
+            take(other);
+        }
+        return *this;
+    }
+
+    small_vector& operator=(std::initializer_list<T> il) { assign(il.begin(), il.end()); return *this; }
+
+    ~small_vector() { clear(); release(); }
+
+    allocator_type get_allocator() const { return alloc_; }
+
+    // ------------------------------------------------------------------------------------------ access
+
+    iterator               begin()         { return data_;          }
+    iterator               end()           { return data_ + size_;  }
+    const_iterator         begin()   const { return data_;          }
+    const_iterator         end()     const { return data_ + size_;  }
+    const_iterator         cbegin()  const { return begin();        }
+    const_iterator         cend()    const { return end();          }
+    reverse_iterator       rbegin()        { return reverse_iterator(end());         }
+    reverse_iterator       rend()          { return reverse_iterator(begin());       }
+    const_reverse_iterator rbegin()  const { return const_reverse_iterator(end());   }
+    const_reverse_iterator rend()    const { return const_reverse_iterator(begin()); }
+
+    T*       data()       { return data_; }
+    const T* data() const { return data_; }
+
+    T&       operator[](size_type i)       { return data_[i]; }
+    const T& operator[](size_type i) const { return data_[i]; }
+
+    T&       at(size_type i)       { check(i); return data_[i]; }
+    const T& at(size_type i) const { check(i); return data_[i]; }
+
+    T&       front()       { return data_[0];         }
+    const T& front() const { return data_[0];         }
+    T&       back()        { return data_[size_ - 1]; }
+    const T& back()  const { return data_[size_ - 1]; }
+
+    size_type size()     const { return size_;      }
+    size_type capacity() const { return capacity_;  }
+    bool      empty()    const { return size_ == 0; }
+    bool      is_empty() const { return size_ == 0; }
+
+    size_type max_size() const { return traits::max_size(alloc_); }
+
+    // Whether the elements are still stored inside the object rather than on the heap
+    bool is_inline() const { return data_ == inline_data(); }
+
+    template<class Pred>
+    typename std::enable_if<std::is_invocable_r<bool, Pred, const T&>::value, bool>::type
+        contains(Pred p) const
+    {
+        return std::find_if(begin(), end(), p) != end();
+    }
+
+    bool contains(const T& x) const { return std::find(begin(), end(), x) != end(); }
+
+    // ------------------------------------------------------------------------------------------ capacity
+
+    void reserve(size_type n) { if (n > capacity_) reallocate(n); }
+
+    // Moves the elements back inline if they fit, or into a heap buffer of the exact size
+    void shrink_to_fit()
+    {
+        if (!is_inline() && size_ < capacity_)
+            reallocate(size_);
+    }
+
+    // ------------------------------------------------------------------------------------------ modifiers
+
+    void clear() noexcept
+    {
+        std::destroy(begin(), end());
+        size_ = 0;
+    }
+
+    void assign(size_type n, const T& x)
+    {
+        clear();
+        reserve(n);
+        std::uninitialized_fill_n(data_, n, x);
+        size_ = n;
+    }
+
+    template<class InputIt, class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    void assign(InputIt first, InputIt last)
+    {
+        clear();
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<InputIt>::iterator_category>)
+            reserve(static_cast<size_type>(std::distance(first, last)));
+        for (; first != last; ++first)
+            emplace_back(*first);
+    }
+
+    void assign(std::initializer_list<T> il) { assign(il.begin(), il.end()); }
+
+    template<class... Args>
+    T& emplace_back(Args&&... args)
+    {
+        if (size_ == capacity_) {
+            // The arguments may refer to an element, so the new one is built before the old ones move
+            T x(std::forward<Args>(args)...);
+            reallocate(grown_capacity(size_ + 1));
+            traits::construct(alloc_, data_ + size_, std::move(x));
+        } else {
+            traits::construct(alloc_, data_ + size_, std::forward<Args>(args)...);
+        }
+        return data_[size_++];
+    }
+
+    void push_back(const T& x) { emplace_back(x);            }
+    void push_back(T&& x)      { emplace_back(std::move(x)); }
+
+    void pop_back() { traits::destroy(alloc_, data_ + --size_); }
+
+    // Appends at the end and rotates into place, so any iterator category works
+    template<class... Args>
+    iterator emplace(const_iterator pos, Args&&... args)
+    {
+        const auto i = pos - begin();
+        emplace_back(std::forward<Args>(args)...);
+        std::rotate(begin() + i, end() - 1, end());
+        return begin() + i;
+    }
+
+    iterator insert(const_iterator pos, const T& x) { return emplace(pos, x);            }
+    iterator insert(const_iterator pos, T&& x)      { return emplace(pos, std::move(x)); }
+
+    iterator insert(const_iterator pos, size_type n, const T& x)
+    {
+        const auto i = pos - begin();
+        const auto old_size = size_;
+        if (size_ + n > capacity_) {
+            T copy(x); // x may be an element
+            reserve(grown_capacity(size_ + n));
+            std::uninitialized_fill_n(end(), n, copy);
+        } else {
+            std::uninitialized_fill_n(end(), n, x);
+        }
+        size_ += n;
+        std::rotate(begin() + i, begin() + old_size, end());
+        return begin() + i;
+    }
+
+    template<class InputIt, class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    iterator insert(const_iterator pos, InputIt first, InputIt last)
+    {
+        const auto i = pos - begin();
+        const auto old_size = size_;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<InputIt>::iterator_category>) {
+            const auto n = static_cast<size_type>(std::distance(first, last));
+            if (size_ + n > capacity_)
+                reserve(grown_capacity(size_ + n));
+        }
+        for (; first != last; ++first)
+            emplace_back(*first);
+        std::rotate(begin() + i, begin() + old_size, end());
+        return begin() + i;
+    }
+
+    iterator insert(const_iterator pos, std::initializer_list<T> il) { return insert(pos, il.begin(), il.end()); }
+
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        const auto f = begin() + (first - begin());
+        const auto l = begin() + (last  - begin());
+        if (f != l) {
+            const auto new_end = std::move(l, end(), f);
+            std::destroy(new_end, end());
+            size_ -= static_cast<size_type>(l - f);
+        }
+        return f;
+    }
+
+    void resize(size_type n)
+    {
+        if (n < size_) {
+            erase(begin() + n, end());
+        } else {
+            reserve(n);
+            for (; size_ < n; ++size_)
+                traits::construct(alloc_, data_ + size_);
+        }
+    }
+
+    void resize(size_type n, const T& x)
+    {
+        if (n < size_)
+            erase(begin() + n, end());
+        else
+            insert(end(), n - size_, x);
+    }
+
+    void swap(small_vector& other)
+    {
+        small_vector tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    friend void swap(small_vector& a, small_vector& b) { a.swap(b); }
+
+    friend bool operator==(const small_vector& a, const small_vector& b) { return std::equal(a.begin(), a.end(), b.begin(), b.end()); }
+    friend bool operator!=(const small_vector& a, const small_vector& b) { return !(a == b); }
+    friend bool operator< (const small_vector& a, const small_vector& b) { return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end()); }
+
+private:
+    T*       inline_data()       { return reinterpret_cast<T*>(inline_);       }
+    const T* inline_data() const { return reinterpret_cast<const T*>(inline_); }
+
+    void check(size_type i) const
+    {
+        if (i >= size_)
+            throw std::out_of_range("zen::small_vector::at() INDEX OUT OF RANGE");
+    }
+
+    size_type grown_capacity(size_type needed) const
+    {
+        if (needed > max_size())
+            throw std::length_error("zen::small_vector WOULD EXCEED ITS MAXIMUM SIZE");
+        return std::max(needed, capacity_ + capacity_ / 2);
+    }
+
+    // Moves n elements from src to the uninitialized dst and destroys the originals
+    void relocate(T* src, size_type n, T* dst)
+    {
+        if constexpr (relocatable) {
+            if (n)
+                std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), n * sizeof(T));
+        } else {
+            size_type i = 0;
+            try {
+                for (; i < n; ++i)
+                    traits::construct(alloc_, dst + i, std::move_if_noexcept(src[i]));
+            } catch (...) {
+                std::destroy_n(dst, i);
+                throw;
+            }
+            std::destroy_n(src, n);
+        }
+    }
+
+    // Moves the elements to a buffer of capacity n (at least size()), inline if they fit
+    void reallocate(size_type n)
+    {
+        T* buffer = n <= N ? inline_data() : traits::allocate(alloc_, n);
+        if (buffer == data_)
+            return;
+        try {
+            relocate(data_, size_, buffer);
+        } catch (...) {
+            if (buffer != inline_data())
+                traits::deallocate(alloc_, buffer, n);
+            throw;
+        }
+        release();
+        data_     = buffer;
+        capacity_ = n <= N ? N : n;
+    }
+
+    // Frees the heap buffer (if any) of the already destroyed elements
+    void release()
+    {
+        if (!is_inline())
+            traits::deallocate(alloc_, data_, capacity_);
+        data_     = inline_data();
+        capacity_ = N;
+    }
+
+    // Takes over the elements of other while this holds none, leaving other empty
+    void take(small_vector& other)
+    {
+        if (!other.is_inline() && alloc_ == other.alloc_) {
+            data_     = std::exchange(other.data_, other.inline_data());
+            size_     = std::exchange(other.size_, 0);
+            capacity_ = std::exchange(other.capacity_, N);
+        } else {
+            reserve(other.size_);
+            relocate(other.data_, other.size_, data_);
+            size_ = std::exchange(other.size_, 0);
+            other.release();
+        }
+    }
+
+    T*        data_     = inline_data();
+    size_type size_     = 0;
+    size_type capacity_ = N;
+    A         alloc_;
+    alignas(T) unsigned char inline_[N * sizeof(T)];
+};
+
+} // namespace zen
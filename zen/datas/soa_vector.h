@@ -0,0 +1,436 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <initializer_list>
+#include <type_traits>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <iterator>
+#include <cstddef>
+#include <utility>
+#include <numeric>
+#include <memory>
+#include <vector>
+#include <tuple>
+#include <span>
+#include <new>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
+
+namespace zen {
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::soa_vector
+
+// A vector of records stored as a struct of arrays: each field lives in its own array,
+// aligned to a cache line, so a scan of one field reads nothing but that field and runs
+// at the speed of memory (and vectorizes) however many other fields the records have.
+// A row is a tuple of references into the arrays, so structured bindings work on it as
+// they would on a struct, and column<I>() is the whole I-th field as a std::span for
+// kernels. push_back(), erase() and sort() move every field of a row together.
+// Example: zen::soa_vector<int, double, zen::string> v;
+//          v.push_back(7, 2.5, "seven");
+//          for (auto [id, price, name] : v) { ... }
+//          double total = std::reduce(v.column<1>().begin(), v.column<1>().end());
+//          v.sort_by<1>();   // by price, with the ids and names following along
+template<class... Ts>
+class soa_vector : private zen::stackonly
+{
+    ZEN_STATIC_ASSERT(sizeof...(Ts) > 0, "zen::soa_vector NEEDS AT LEAST ONE FIELD");
+
+    static constexpr std::size_t alignment = internal::cache_line_size;
+
+    using indices = std::index_sequence_for<Ts...>;
+
+public:
+    template<std::size_t I>
+    using field_type = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+    using value_type      = std::tuple<Ts...>;
+    using reference       = std::tuple<Ts&...>;
+    using const_reference = std::tuple<const Ts&...>;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    // Points at a row; dereferencing it gives a tuple of references, not a reference
+    template<bool Const>
+    class basic_iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = typename soa_vector::value_type;
+        using difference_type   = std::ptrdiff_t;
+        using reference         = std::conditional_t<Const, const_reference, typename soa_vector::reference>;
+        using container         = std::conditional_t<Const, const soa_vector, soa_vector>;
+
+        basic_iterator() = default;
+
+        template<bool C> requires (Const && !C)
+        basic_iterator(const basic_iterator<C>& other) : v_(other.v_), i_(other.i_) {}
+
+        reference operator*()                   const { return (*v_)[i_];     }
+        reference operator[](difference_type n) const { return (*v_)[i_ + n]; }
+
+        basic_iterator& operator++() { ++i_; return *this; }
+        basic_iterator& operator--() { --i_; return *this; }
+        basic_iterator  operator++(int) { auto it = *this; ++i_; return it; }
+        basic_iterator  operator--(int) { auto it = *this; --i_; return it; }
+
+        basic_iterator& operator+=(difference_type n) { i_ += n; return *this; }
+        basic_iterator& operator-=(difference_type n) { i_ -= n; return *this; }
+
+        friend basic_iterator  operator+(basic_iterator it, difference_type n) { return it += n; }
+        friend basic_iterator  operator+(difference_type n, basic_iterator it) { return it += n; }
+        friend basic_iterator  operator-(basic_iterator it, difference_type n) { return it -= n; }
+        friend difference_type operator-(const basic_iterator& a, const basic_iterator& b)
+        {
+            return static_cast<difference_type>(a.i_) - static_cast<difference_type>(b.i_);
+        }
+
+        friend bool operator== (const basic_iterator& a, const basic_iterator& b) { return a.i_ ==  b.i_; }
+        friend auto operator<=>(const basic_iterator& a, const basic_iterator& b) { return a.i_ <=> b.i_; }
+
+    private:
+        friend class soa_vector;
+        friend class basic_iterator<!Const>;
+
+        basic_iterator(container* v, size_type i) : v_(v), i_(i) {}
+
+        container* v_ = nullptr;
+        size_type  i_ = 0;
+    };
+
+    using iterator       = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    soa_vector() = default;
+
+    soa_vector(std::initializer_list<value_type> il)
+    {
+        reserve(il.size());
+        for (const auto& row : il)
+            push_back(row);
+    }
+
+    soa_vector(const soa_vector& other)
+    {
+        reserve(other.size_);
+        try {
+            build_columns(columns_, other.size_, [&](auto I, auto* to) {
+                std::uninitialized_copy_n(std::get<I>(other.columns_), other.size_, to);
+            }, indices{});
+        } catch (...) {
+            free_columns(columns_, capacity_, indices{}); // no destructor for a half-built object
+            throw;
+        }
+        size_ = other.size_;
+    }
+
+    soa_vector(soa_vector&& other) noexcept
+        : columns_(std::exchange(other.columns_, {})), size_(std::exchange(other.size_, 0)), capacity_(std::exchange(other.capacity_, 0)) {}
+
+    soa_vector& operator=(soa_vector other) noexcept
+    {
+        std::swap(columns_,  other.columns_);
+        std::swap(size_,     other.size_);
+        std::swap(capacity_, other.capacity_);
+        return *this;
+    }
+
+    ~soa_vector()
+    {
+        clear();
+        free_columns(columns_, capacity_, indices{});
+    }
+
+    // ------------------------------------------------------------------------------------------ access
+
+    size_type size()     const { return size_;      }
+    size_type capacity() const { return capacity_;  }
+    bool      empty()    const { return size_ == 0; }
+    bool      is_empty() const { return size_ == 0; }
+
+    reference       operator[](size_type i)       { return row(i, indices{}); }
+    const_reference operator[](size_type i) const { return row(i, indices{}); }
+
+    reference at(size_type i)
+    {
+        if (i >= size_)
+            throw std::out_of_range("zen::soa_vector::at() INDEX OUT OF RANGE");
+        return (*this)[i];
+    }
+
+    const_reference at(size_type i) const
+    {
+        if (i >= size_)
+            throw std::out_of_range("zen::soa_vector::at() INDEX OUT OF RANGE");
+        return (*this)[i];
+    }
+
+    reference       front()       { return (*this)[0];         }
+    const_reference front() const { return (*this)[0];         }
+    reference       back()        { return (*this)[size_ - 1]; }
+    const_reference back()  const { return (*this)[size_ - 1]; }
+
+    // The I-th field of every row, contiguous and aligned to a cache line
+    template<std::size_t I>
+    std::span<field_type<I>> column()
+    {
+        return { std::assume_aligned<alignment>(std::get<I>(columns_)), size_ };
+    }
+
+    template<std::size_t I>
+    std::span<const field_type<I>> column() const
+    {
+        return { std::assume_aligned<alignment>(std::get<I>(columns_)), size_ };
+    }
+
+    iterator       begin()       { return iterator(this, 0);           }
+    const_iterator begin() const { return const_iterator(this, 0);     }
+    iterator       end()         { return iterator(this, size_);       }
+    const_iterator end()   const { return const_iterator(this, size_); }
+
+    // ------------------------------------------------------------------------------------------ changes
+
+    void reserve(size_type n)
+    {
+        if (n > capacity_)
+            reallocate(n);
+    }
+
+    void shrink_to_fit()
+    {
+        if (size_ < capacity_)
+            reallocate(size_);
+    }
+
+    template<class... Us>
+        requires (sizeof...(Us) == sizeof...(Ts))
+    void emplace_back(Us&&... fields)
+    {
+        if (size_ == capacity_)
+            reallocate(std::max<size_type>(2 * capacity_, 8));
+        construct_row(size_, indices{}, std::forward<Us>(fields)...);
+        ++size_;
+    }
+
+    void push_back(const value_type& row) { std::apply([this](const auto&... f) { emplace_back(f...); }, row); }
+    void push_back(value_type&& row)      { std::apply([this](auto&... f) { emplace_back(std::move(f)...); }, row); }
+
+    template<class... Us>
+        requires (sizeof...(Us) == sizeof...(Ts) && sizeof...(Ts) > 1)
+    void push_back(Us&&... fields) { emplace_back(std::forward<Us>(fields)...); }
+
+    void pop_back()
+    {
+        --size_;
+        destroy_rows(size_, size_ + 1, indices{});
+    }
+
+    void clear()
+    {
+        destroy_rows(0, size_, indices{});
+        size_ = 0;
+    }
+
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        const size_type from = first.i_;
+        const size_type to   = last.i_;
+        if (from != to) {
+            shift_down(from, to, indices{});
+            destroy_rows(size_ - (to - from), size_, indices{});
+            size_ -= to - from;
+        }
+        return iterator(this, from);
+    }
+
+    // Sorts the rows by a comparison of two rows (as const tuples of references)
+    template<class Compare>
+    void sort(Compare comp)
+    {
+        std::vector<size_type> order(size_);
+        std::iota(order.begin(), order.end(), size_type{ 0 });
+        const soa_vector& self = *this;
+        std::sort(order.begin(), order.end(), [&](size_type a, size_type b) { return comp(self[a], self[b]); });
+        permute(order);
+    }
+
+    // Sorts the rows by their I-th field, reading only that column to decide the order
+    template<std::size_t I, class Compare = std::less<>>
+    void sort_by(Compare comp = Compare())
+    {
+        const auto* keys = std::get<I>(columns_);
+        std::vector<size_type> order(size_);
+        std::iota(order.begin(), order.end(), size_type{ 0 });
+        std::sort(order.begin(), order.end(), [&](size_type a, size_type b) { return comp(keys[a], keys[b]); });
+        permute(order);
+    }
+
+    friend bool operator==(const soa_vector& a, const soa_vector& b)
+    {
+        return a.size_ == b.size_ && std::equal(a.begin(), a.end(), b.begin());
+    }
+
+private:
+    template<std::size_t... Is>
+    reference row(size_type i, std::index_sequence<Is...>) { return reference(std::get<Is>(columns_)[i]...); }
+
+    template<std::size_t... Is>
+    const_reference row(size_type i, std::index_sequence<Is...>) const { return const_reference(std::get<Is>(columns_)[i]...); }
+
+    template<std::size_t... Is, class... Us>
+    void construct_row(size_type i, std::index_sequence<Is...>, Us&&... fields)
+    {
+        // Fields are built one by one, and if one throws the ones already built are destroyed
+        std::size_t built = 0;
+        try {
+            ((::new (static_cast<void*>(std::get<Is>(columns_) + i)) field_type<Is>(std::forward<Us>(fields)), ++built), ...);
+        } catch (...) {
+            ((Is < built ? std::destroy_at(std::get<Is>(columns_) + i) : void()), ...);
+            throw;
+        }
+    }
+
+    template<std::size_t... Is>
+    void destroy_rows(size_type from, size_type to, std::index_sequence<Is...>)
+    {
+        (std::destroy(std::get<Is>(columns_) + from, std::get<Is>(columns_) + to), ...);
+    }
+
+    template<std::size_t... Is>
+    void shift_down(size_type from, size_type to, std::index_sequence<Is...>)
+    {
+        (std::move(std::get<Is>(columns_) + to, std::get<Is>(columns_) + size_, std::get<Is>(columns_) + from), ...);
+    }
+
+    // Fills the columns of to one by one, fill(I, column) constructing the first n elements of
+    // the I-th one (or none, if it throws), and if one throws the ones already filled are destroyed
+    template<class Fill, std::size_t... Is>
+    static void build_columns(std::tuple<Ts*...>& to, size_type n, Fill fill, std::index_sequence<Is...>)
+    {
+        std::size_t built = 0;
+        try {
+            ((fill(std::integral_constant<std::size_t, Is>{}, std::get<Is>(to)), ++built), ...);
+        } catch (...) {
+            ((Is < built ? (void)std::destroy_n(std::get<Is>(to), n) : void()), ...);
+            throw;
+        }
+    }
+
+    // ------------------------------------------------------------------------------------------ memory
+
+    template<class T>
+    static T* allocate(size_type n)
+    {
+        if (n == 0)
+            return nullptr;
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{ std::max(alignment, alignof(T)) }));
+    }
+
+    template<class T>
+    static void deallocate(T* p, size_type n)
+    {
+        if (p)
+            ::operator delete(p, n * sizeof(T), std::align_val_t{ std::max(alignment, alignof(T)) });
+    }
+
+    template<std::size_t... Is>
+    static void free_columns(std::tuple<Ts*...>& columns, size_type n, std::index_sequence<Is...>)
+    {
+        (deallocate(std::get<Is>(columns), n), ...);
+    }
+
+    template<std::size_t... Is>
+    static std::tuple<Ts*...> allocate_columns(size_type n, std::index_sequence<Is...>)
+    {
+        std::tuple<Ts*...> columns{};
+        try {
+            ((std::get<Is>(columns) = allocate<field_type<Is>>(n)), ...);
+        } catch (...) {
+            free_columns(columns, n, indices{});
+            throw;
+        }
+        return columns;
+    }
+
+    // Builds a fresh set of n-element columns with fill and swaps it in for the current one;
+    // if fill throws, nothing leaks and the current columns stay in place
+    template<class Fill>
+    void replace_columns(size_type n, Fill fill)
+    {
+        std::tuple<Ts*...> fresh = allocate_columns(n, indices{});
+        try {
+            build_columns(fresh, size_, fill, indices{});
+        } catch (...) {
+            free_columns(fresh, n, indices{});
+            throw;
+        }
+        destroy_rows(0, size_, indices{});
+        free_columns(columns_, capacity_, indices{});
+        columns_  = fresh;
+        capacity_ = n;
+    }
+
+    // Fields are moved over, or copied (if they can be) when moving any of them might throw,
+    // so that a throw in one column doesn't leave the others moved from
+    void reallocate(size_type n)
+    {
+        replace_columns(n, [this](auto I, auto* to) {
+            using F = field_type<decltype(I)::value>;
+            if constexpr ((std::is_nothrow_move_constructible_v<Ts> && ...) || !std::is_copy_constructible_v<F>)
+                std::uninitialized_move_n(std::get<I>(columns_), size_, to);
+            else
+                std::uninitialized_copy_n(std::get<I>(columns_), size_, to);
+        });
+    }
+
+    // Rearranges every column so that row i becomes the row that was at order[i]
+    void permute(const std::vector<size_type>& order)
+    {
+        replace_columns(capacity_, [&](auto I, auto* to) { gather_column<I>(to, order); });
+    }
+
+    template<std::size_t I>
+    void gather_column(field_type<I>* to, const std::vector<size_type>& order)
+    {
+        field_type<I>* from = std::get<I>(columns_);
+        size_type k = 0;
+        try {
+            for (; k < size_; ++k)
+                ::new (static_cast<void*>(to + k)) field_type<I>(std::move(from[order[k]]));
+        } catch (...) {
+            std::destroy_n(to, k);
+            throw;
+        }
+    }
+
+    std::tuple<Ts*...> columns_{};
+    size_type          size_     = 0;
+    size_type          capacity_ = 0;
+};
+
+} // namespace zen
@@ -0,0 +1,248 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <type_traits>
+#include <stdexcept>
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <memory>
+#include <atomic>
+#include <span>
+#include <bit>
+#include <new>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
+
+namespace zen {
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::spsc_ring
+
+// A wait-free ring buffer of N elements (a power of two) between exactly one
+// producer thread and one consumer thread. Each side keeps a private copy of
+// the other side's position and only rereads the shared one when its copy
+// says the ring is full (or empty), so in the steady state the two threads
+// don't touch each other's cache lines at all.
+// 
+// The slots are on the heap, so a ring of any size can live anywhere. Elements are
+// constructed in their slots as they are pushed and destroyed as they are popped or
+// consumed, so whatever they hold is released right away rather than when the
+// producer comes around to the slot again. The producer can also write into the
+// ring in place with reserve()/commit(), and the consumer read from it with peek()/consume().
+// 
+// Example: zen::spsc_ring<sample, 4096> r;
+//          r.try_push(s);            // on the producer thread
+//          if (r.try_pop(s)) ...     // on the consumer thread
+template<class T, std::size_t N>
+class spsc_ring : private zen::stackonly
+{
+    ZEN_STATIC_ASSERT((N > 0 && std::has_single_bit(N)), "zen::spsc_ring CAPACITY MUST BE A POWER OF TWO");
+    ZEN_STATIC_ASSERT(std::is_nothrow_destructible_v<T>, "zen::spsc_ring ELEMENTS MUST BE NOTHROW DESTRUCTIBLE");
+
+public:
+    using value_type = T;
+    using size_type  = std::size_t;
+
+    spsc_ring() : buffer_(static_cast<T*>(::operator new(N * sizeof(T), std::align_val_t(alignment)))) {}
+
+    spsc_ring(const spsc_ring&)            = delete;
+    spsc_ring& operator=(const spsc_ring&) = delete;
+
+    // Neither thread may be using the ring by now
+    ~spsc_ring()
+    {
+        const auto end = tail_.load(std::memory_order_acquire) + reserved_;
+        for (auto i = head_.load(std::memory_order_acquire); i != end; ++i)
+            slot(i)->~T();
+    }
+
+    static constexpr size_type capacity() { return N; }
+
+    // Exact when called from either of the two threads while the other one is idle
+    size_type size() const { return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire); }
+    bool     empty() const { return size() == 0; }
+    bool  is_empty() const { return size() == 0; }
+
+    // ------------------------------------------------------------------------------------------ producer
+
+    bool try_push(const T& x) { return try_push_impl(x);            }
+    bool try_push(T&& x)      { return try_push_impl(std::move(x)); }
+
+    // Copies as many elements from the front of xs as there is room for; returns their number
+    size_type try_push_bulk(std::span<const T> xs)
+    {
+        drop_reserved();
+
+        size_type pushed = 0;
+        for (int part = 0; part < 2 && pushed < xs.size(); ++part) { // the ring may wrap around once
+            const auto tail = tail_.load(std::memory_order_relaxed);
+            const auto n    = free_run(tail, xs.size() - pushed);
+            if (n == 0)
+                break;
+            std::uninitialized_copy_n(xs.begin() + pushed, n, slot(tail));
+            tail_.store(tail + n, std::memory_order_release);
+            pushed += n;
+        }
+        return pushed;
+    }
+
+    // Up to n free slots, contiguous in memory and default constructed, for the producer
+    // to write to in place. None of them are visible to the consumer until they are
+    // committed, and a try_push() in the meantime drops the ones left uncommitted.
+    // Fewer than n are returned if the ring is (nearly) full or wraps around.
+    std::span<T> reserve(size_type n = N) requires std::is_default_constructible_v<T>
+    {
+        const auto tail = tail_.load(std::memory_order_relaxed);
+        n = free_run(tail, n);
+        for (; reserved_ > n; --reserved_)
+            slot(tail + reserved_ - 1)->~T();
+        for (; reserved_ < n; ++reserved_)
+            ::new (static_cast<void*>(slot(tail + reserved_))) T();
+        return std::span<T>(slot(tail), n);
+    }
+
+    // Hands the first n slots of the last reserve() over to the consumer
+    void commit(size_type n)
+    {
+        if (n > reserved_)
+            throw std::out_of_range("zen::spsc_ring::commit() MORE SLOTS THAN RESERVED");
+        reserved_ -= n;
+        tail_.store(tail_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    // ------------------------------------------------------------------------------------------ consumer
+
+    bool try_pop(T& x)
+    {
+        const auto head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_)
+                return false;
+        }
+
+        T* p = slot(head);
+        x = std::move(*p);
+        p->~T();
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Moves as many elements as are there, up to the size of xs, into xs; returns their number
+    size_type try_pop_bulk(std::span<T> xs)
+    {
+        size_type popped = 0;
+        for (int part = 0; part < 2 && popped < xs.size(); ++part) { // the ring may wrap around once
+            const auto elements = peek_mutable(xs.size() - popped);
+            if (elements.empty())
+                break;
+            std::move(elements.begin(), elements.end(), xs.begin() + popped);
+            consume(elements.size());
+            popped += elements.size();
+        }
+        return popped;
+    }
+
+    // Up to n of the oldest elements, contiguous in memory, for the consumer to read in
+    // place. They stay in the ring until consumed. Fewer than n are returned if the ring
+    // holds fewer elements or wraps around.
+    std::span<const T> peek(size_type n = N) { return peek_mutable(n); }
+
+    // Removes (and destroys) the first n elements of the last peek()
+    void consume(size_type n)
+    {
+        const auto head = head_.load(std::memory_order_relaxed);
+        if (n > cached_tail_ - head)
+            throw std::out_of_range("zen::spsc_ring::consume() MORE ELEMENTS THAN PEEKED");
+        std::destroy_n(slot(head), n);
+        head_.store(head + n, std::memory_order_release);
+    }
+
+private:
+    static constexpr std::size_t alignment = std::max(alignof(T), internal::cache_line_size);
+
+    struct storage_deleter {
+        void operator()(T* p) const { ::operator delete(p, std::align_val_t(alignment)); }
+    };
+
+    // Slots at any position i, which wrap around the end of the buffer
+    T* slot(size_type i) const { return buffer_.get() + (i & (N - 1)); }
+
+    template<class Tx>
+    bool try_push_impl(Tx&& x)
+    {
+        drop_reserved();
+
+        const auto tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ == N) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ == N)
+                return false;
+        }
+
+        ::new (static_cast<void*>(slot(tail))) T(std::forward<Tx>(x));
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // The number of free slots, up to n, that are contiguous from position tail on
+    size_type free_run(size_type tail, size_type n)
+    {
+        if (n > N - (tail - cached_head_))
+            cached_head_ = head_.load(std::memory_order_acquire);
+        return std::min({ n, N - (tail - cached_head_), N - (tail & (N - 1)) });
+    }
+
+    // Destroys the slots that were reserved but never committed
+    void drop_reserved()
+    {
+        std::destroy_n(slot(tail_.load(std::memory_order_relaxed)), reserved_);
+        reserved_ = 0;
+    }
+
+    std::span<T> peek_mutable(size_type n)
+    {
+        const auto head = head_.load(std::memory_order_relaxed);
+        if (n > cached_tail_ - head)
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+
+        n = std::min({ n, cached_tail_ - head, N - (head & (N - 1)) });
+        return std::span<T>(slot(head), n);
+    }
+
+    // Written by the producer; the consumer only reads tail_, and only when its copy runs out
+    alignas(internal::cache_line_size) std::atomic<size_type> tail_ = 0;
+    size_type cached_head_ = 0;
+    size_type reserved_    = 0; // default constructed slots from tail_ on
+
+    // Written by the consumer; the producer only reads head_, and only when its copy runs out
+    alignas(internal::cache_line_size) std::atomic<size_type> head_ = 0;
+    size_type cached_tail_ = 0;
+
+    // The slots, on a cache line of their own; the pointer never changes
+    alignas(internal::cache_line_size) const std::unique_ptr<T, storage_deleter> buffer_;
+};
+
+} // namespace zen
@@ -0,0 +1,607 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <initializer_list>
+#include <type_traits>
+#include <string_view>
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+#include <ostream>
+#include <utility>
+#include <memory>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
+
+namespace zen {
+
+///////////////////////////////////////////////////////////////////////////////////////////// STATIC CONTAINERS
+
+// Containers with a capacity fixed at compile time, whose elements live inside the
+// object itself, so they never allocate and take the same time for the same work,
+// which real-time code needs. For trivial element types they are usable in constexpr.
+
+// What to do when an element doesn't fit:
+struct checked   {}; // throw std::length_error
+struct unchecked {}; // nothing, not fitting is the caller's bug (like indexing past the end)
+
+namespace internal {
+    // Trivial elements are stored as a plain array, which constexpr code can use,
+    // others as raw memory, where elements are constructed only when they come in
+    template<class T, std::size_t N, bool = std::is_trivial_v<T>>
+    struct inplace_storage {
+        static constexpr bool trivial = true;
+
+        constexpr T*       ptr()       { return elems; }
+        constexpr const T* ptr() const { return elems; }
+
+        T elems[N] = {};
+    };
+
+    template<class T, std::size_t N>
+    struct inplace_storage<T, N, false> {
+        static constexpr bool trivial = false;
+
+        T*       ptr()       { return reinterpret_cast<T*>(bytes);       }
+        const T* ptr() const { return reinterpret_cast<const T*>(bytes); }
+
+        alignas(T) unsigned char bytes[N * sizeof(T)];
+    };
+
+    template<class S, class T, class... Args>
+    constexpr void construct_in(S& storage, std::size_t i, Args&&... args)
+    {
+        if constexpr (S::trivial)
+            storage.ptr()[i] = T(std::forward<Args>(args)...);
+        else
+            std::construct_at(storage.ptr() + i, std::forward<Args>(args)...);
+    }
+
+    template<class S>
+    constexpr void destroy_in(S& storage, std::size_t i)
+    {
+        if constexpr (!S::trivial)
+            std::destroy_at(storage.ptr() + i);
+    }
+
+    template<class P>
+    constexpr void check_capacity(bool fits, const char* message)
+    {
+        ZEN_STATIC_ASSERT((std::is_same_v<P, checked> || std::is_same_v<P, unchecked>), "OVERFLOW POLICY MUST BE zen::checked OR zen::unchecked");
+        if constexpr (std::is_same_v<P, checked>) {
+            if (!fits)
+                throw std::length_error(message);
+        }
+    }
+} // namespace internal
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::static_vector
+
+// Example: zen::static_vector<int, 16> v = { 1, 2, 3 };
+//          v.push_back(4); // throws std::length_error if 16 elements are already there
+template<class T, std::size_t N, class P = checked>
+class static_vector : private zen::stackonly
+{
+    ZEN_STATIC_ASSERT(N > 0, "zen::static_vector CAPACITY MUST BE POSITIVE");
+
+    using storage = internal::inplace_storage<T, N>;
+
+public:
+    using value_type             = T;
+    using size_type              = std::size_t;
+    using difference_type        = std::ptrdiff_t;
+    using reference              = T&;
+    using const_reference        = const T&;
+    using iterator               = T*;
+    using const_iterator         = const T*;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    constexpr static_vector() = default;
+
+    constexpr explicit static_vector(size_type n) { resize(n); }
+
+    constexpr static_vector(size_type n, const T& x) { resize(n, x); }
+
+    template<class InputIt, class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    constexpr static_vector(InputIt first, InputIt last) { for (; first != last; ++first) emplace_back(*first); }
+
+    constexpr static_vector(std::initializer_list<T> il) : static_vector(il.begin(), il.end()) {}
+
+    constexpr static_vector(const static_vector&) requires storage::trivial = default;
+    constexpr static_vector(static_vector&&)      requires storage::trivial = default;
+
+    static_vector(const static_vector& other) { for (const auto& x : other) emplace_back(x);            }
+    static_vector(static_vector&& other)      { for (auto& x : other)       emplace_back(std::move(x)); }
+
+    constexpr static_vector& operator=(const static_vector&) requires storage::trivial = default;
+    constexpr static_vector& operator=(static_vector&&)      requires storage::trivial = default;
+
+    static_vector& operator=(const static_vector& other)
+    {
+        if (this != &other) {
+            clear();
+            for (const auto& x : other)
+                emplace_back(x);
+        }
+        return *this;
+    }
+
+    static_vector& operator=(static_vector&& other)
+    {
+        if (this != &other) {
+            clear();
+            for (auto& x : other)
+                emplace_back(std::move(x));
+        }
+        return *this;
+    }
+
+    constexpr ~static_vector() requires storage::trivial = default;
+    ~static_vector() { clear(); }
+
+    constexpr iterator               begin()         { return s_.ptr();          }
+    constexpr iterator               end()           { return s_.ptr() + size_;  }
+    constexpr const_iterator         begin()   const { return s_.ptr();          }
+    constexpr const_iterator         end()     const { return s_.ptr() + size_;  }
+    constexpr const_iterator         cbegin()  const { return begin();           }
+    constexpr const_iterator         cend()    const { return end();             }
+    constexpr reverse_iterator       rbegin()        { return reverse_iterator(end());         }
+    constexpr reverse_iterator       rend()          { return reverse_iterator(begin());       }
+    constexpr const_reverse_iterator rbegin()  const { return const_reverse_iterator(end());   }
+    constexpr const_reverse_iterator rend()    const { return const_reverse_iterator(begin()); }
+
+    constexpr T*       data()       { return s_.ptr(); }
+    constexpr const T* data() const { return s_.ptr(); }
+
+    constexpr T&       operator[](size_type i)       { return s_.ptr()[i]; }
+    constexpr const T& operator[](size_type i) const { return s_.ptr()[i]; }
+
+    constexpr T&       at(size_type i)       { check(i); return s_.ptr()[i]; }
+    constexpr const T& at(size_type i) const { check(i); return s_.ptr()[i]; }
+
+    constexpr T&       front()       { return s_.ptr()[0];         }
+    constexpr const T& front() const { return s_.ptr()[0];         }
+    constexpr T&       back()        { return s_.ptr()[size_ - 1]; }
+    constexpr const T& back()  const { return s_.ptr()[size_ - 1]; }
+
+    static constexpr size_type capacity() { return N; }
+    static constexpr size_type max_size() { return N; }
+
+    constexpr size_type size()     const { return size_;      }
+    constexpr bool      empty()    const { return size_ == 0; }
+    constexpr bool      is_empty() const { return size_ == 0; }
+    constexpr bool      is_full()  const { return size_ == N; }
+
+    template<class Pred>
+    constexpr typename std::enable_if<std::is_invocable_r<bool, Pred, const T&>::value, bool>::type
+        contains(Pred p) const
+    {
+        return std::find_if(begin(), end(), p) != end();
+    }
+
+    constexpr bool contains(const T& x) const { return std::find(begin(), end(), x) != end(); }
+
+    template<class... Args>
+    constexpr T& emplace_back(Args&&... args)
+    {
+        internal::check_capacity<P>(size_ < N, "zen::static_vector CAPACITY EXCEEDED");
+        internal::construct_in<storage, T>(s_, size_, std::forward<Args>(args)...);
+        return s_.ptr()[size_++];
+    }
+
+    constexpr void push_back(const T& x) { emplace_back(x);            }
+    constexpr void push_back(T&& x)      { emplace_back(std::move(x)); }
+
+    // Whatever the overflow policy, returns false instead of pushing if there's no room
+    template<class Tx>
+    constexpr bool try_push_back(Tx&& x)
+    {
+        if (size_ == N)
+            return false;
+        internal::construct_in<storage, T>(s_, size_++, std::forward<Tx>(x));
+        return true;
+    }
+
+    constexpr void pop_back() { internal::destroy_in(s_, --size_); }
+
+    template<class... Args>
+    constexpr iterator emplace(const_iterator pos, Args&&... args)
+    {
+        const auto i = pos - begin();
+        emplace_back(std::forward<Args>(args)...);
+        std::rotate(begin() + i, end() - 1, end());
+        return begin() + i;
+    }
+
+    constexpr iterator insert(const_iterator pos, const T& x) { return emplace(pos, x);            }
+    constexpr iterator insert(const_iterator pos, T&& x)      { return emplace(pos, std::move(x)); }
+
+    constexpr iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+    constexpr iterator erase(const_iterator first, const_iterator last)
+    {
+        const auto f = begin() + (first - begin());
+        const auto l = begin() + (last  - begin());
+        const auto new_end = std::move(l, end(), f);
+        while (end() != new_end)
+            pop_back();
+        return f;
+    }
+
+    constexpr void clear() { while (size_) pop_back(); }
+
+    constexpr void resize(size_type n)
+    {
+        internal::check_capacity<P>(n <= N, "zen::static_vector CAPACITY EXCEEDED");
+        while (size_ > n) pop_back();
+        while (size_ < n) emplace_back();
+    }
+
+    constexpr void resize(size_type n, const T& x)
+    {
+        internal::check_capacity<P>(n <= N, "zen::static_vector CAPACITY EXCEEDED");
+        while (size_ > n) pop_back();
+        while (size_ < n) emplace_back(x);
+    }
+
+    friend constexpr bool operator==(const static_vector& a, const static_vector& b) { return std::equal(a.begin(), a.end(), b.begin(), b.end()); }
+    friend constexpr bool operator!=(const static_vector& a, const static_vector& b) { return !(a == b); }
+    friend constexpr bool operator< (const static_vector& a, const static_vector& b) { return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end()); }
+
+private:
+    constexpr void check(size_type i) const
+    {
+        if (i >= size_)
+            throw std::out_of_range("zen::static_vector::at() INDEX OUT OF RANGE");
+    }
+
+    storage   s_;
+    size_type size_ = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::static_string
+
+// A string of at most N characters, always followed by a terminating zero
+// Example: zen::static_string<15> s = "id-";
+//          s += "42"; // throws std::length_error if the result has more than 15 characters
+template<std::size_t N, class P = checked>
+class static_string : private zen::stackonly
+{
+public:
+    using value_type      = char;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator        = char*;
+    using const_iterator  = const char*;
+
+    static constexpr size_type npos = std::string_view::npos;
+
+    constexpr static_string() = default;
+
+    constexpr static_string(std::string_view s) { append(s); }
+    constexpr static_string(const char* s) : static_string(std::string_view(s)) {}
+
+    constexpr static_string(size_type n, char c) { append(n, c); }
+
+    constexpr static_string& operator=(std::string_view s) { clear(); return append(s); }
+    constexpr static_string& operator=(const char* s)      { return *this = std::string_view(s); }
+
+    constexpr operator std::string_view() const { return std::string_view(chars_, size_); }
+    constexpr std::string_view view()     const { return *this; }
+    std::string                str()      const { return std::string(chars_, size_); }
+
+    constexpr iterator       begin()        { return chars_;         }
+    constexpr iterator       end()          { return chars_ + size_; }
+    constexpr const_iterator begin()  const { return chars_;         }
+    constexpr const_iterator end()    const { return chars_ + size_; }
+    constexpr const_iterator cbegin() const { return begin();        }
+    constexpr const_iterator cend()   const { return end();          }
+
+    constexpr char*       data()        { return chars_; }
+    constexpr const char* data()  const { return chars_; }
+    constexpr const char* c_str() const { return chars_; }
+
+    constexpr char&       operator[](size_type i)       { return chars_[i]; }
+    constexpr const char& operator[](size_type i) const { return chars_[i]; }
+
+    constexpr char& front()       { return chars_[0];         }
+    constexpr char  front() const { return chars_[0];         }
+    constexpr char& back()        { return chars_[size_ - 1]; }
+    constexpr char  back()  const { return chars_[size_ - 1]; }
+
+    static constexpr size_type capacity() { return N; }
+    static constexpr size_type max_size() { return N; }
+
+    constexpr size_type size()     const { return size_;      }
+    constexpr size_type length()   const { return size_;      }
+    constexpr bool      empty()    const { return size_ == 0; }
+    constexpr bool      is_empty() const { return size_ == 0; }
+    constexpr bool      is_full()  const { return size_ == N; }
+
+    constexpr bool contains(std::string_view s) const { return view().find(s) != npos; }
+    constexpr bool contains(char c)             const { return view().find(c) != npos; }
+
+    constexpr bool starts_with(std::string_view s) const { return view().starts_with(s); }
+    constexpr bool ends_with(  std::string_view s) const { return view().ends_with(s);   }
+
+    constexpr size_type find(std::string_view s, size_type pos = 0) const { return view().find(s, pos); }
+
+    constexpr std::string_view substr(size_type pos, size_type n = npos) const { return view().substr(pos, n); }
+
+    constexpr static_string& append(std::string_view s)
+    {
+        internal::check_capacity<P>(s.size() <= N - size_, "zen::static_string CAPACITY EXCEEDED");
+        std::copy(s.begin(), s.end(), chars_ + size_);
+        size_ += s.size();
+        chars_[size_] = '\0';
+        return *this;
+    }
+
+    constexpr static_string& append(size_type n, char c)
+    {
+        internal::check_capacity<P>(n <= N - size_, "zen::static_string CAPACITY EXCEEDED");
+        std::fill_n(chars_ + size_, n, c);
+        size_ += n;
+        chars_[size_] = '\0';
+        return *this;
+    }
+
+    constexpr static_string& operator+=(std::string_view s) { return append(s);    }
+    constexpr static_string& operator+=(char c)             { return append(1, c); }
+
+    constexpr void push_back(char c) { append(1, c); }
+    constexpr void pop_back()        { chars_[--size_] = '\0'; }
+
+    constexpr void clear() { size_ = 0; chars_[0] = '\0'; }
+
+    constexpr void resize(size_type n, char c = '\0')
+    {
+        if (n < size_) {
+            size_ = n;
+            chars_[size_] = '\0';
+        } else {
+            append(n - size_, c);
+        }
+    }
+
+    friend constexpr bool operator==(const static_string& a, std::string_view b) { return a.view() == b; }
+    friend constexpr auto operator<=>(const static_string& a, std::string_view b) { return a.view() <=> b; }
+
+    friend std::ostream& operator<<(std::ostream& os, const static_string& s) { return os << s.view(); }
+
+private:
+    char      chars_[N + 1] = {};
+    size_type size_ = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::static_deque
+
+// A ring of N elements that can grow and shrink at both ends
+// Example: zen::static_deque<int, 64> d;
+//          d.push_back(1);
+//          d.push_front(0);
+template<class T, std::size_t N, class P = checked>
+class static_deque : private zen::stackonly
+{
+    ZEN_STATIC_ASSERT(N > 0, "zen::static_deque CAPACITY MUST BE POSITIVE");
+
+    using storage = internal::inplace_storage<T, N>;
+
+    template<bool Const>
+    class basic_iterator {
+        using deque = std::conditional_t<Const, const static_deque, static_deque>;
+
+    public:
+        using iterator_concept  = std::random_access_iterator_tag;
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = std::conditional_t<Const, const T*, T*>;
+        using reference         = std::conditional_t<Const, const T&, T&>;
+
+        constexpr basic_iterator() = default;
+        constexpr basic_iterator(deque* d, std::size_t i) : d_(d), i_(i) {}
+
+        template<bool C, class = std::enable_if_t<Const && !C>>
+        constexpr basic_iterator(const basic_iterator<C>& it) : d_(it.d_), i_(it.i_) {}
+
+        constexpr reference operator*()                    const { return (*d_)[i_];     }
+        constexpr pointer   operator->()                   const { return &(*d_)[i_];    }
+        constexpr reference operator[](difference_type n)  const { return (*d_)[i_ + n]; }
+
+        constexpr basic_iterator& operator++()    { ++i_; return *this; }
+        constexpr basic_iterator& operator--()    { --i_; return *this; }
+        constexpr basic_iterator  operator++(int) { auto it = *this; ++i_; return it; }
+        constexpr basic_iterator  operator--(int) { auto it = *this; --i_; return it; }
+
+        constexpr basic_iterator& operator+=(difference_type n) { i_ += n; return *this; }
+        constexpr basic_iterator& operator-=(difference_type n) { i_ -= n; return *this; }
+
+        friend constexpr basic_iterator  operator+(basic_iterator it, difference_type n) { return it += n; }
+        friend constexpr basic_iterator  operator+(difference_type n, basic_iterator it) { return it += n; }
+        friend constexpr basic_iterator  operator-(basic_iterator it, difference_type n) { return it -= n; }
+        friend constexpr difference_type operator-(const basic_iterator& a, const basic_iterator& b) { return static_cast<difference_type>(a.i_) - static_cast<difference_type>(b.i_); }
+
+        friend constexpr bool operator==(const basic_iterator& a, const basic_iterator& b) { return a.i_ == b.i_; }
+        friend constexpr auto operator<=>(const basic_iterator& a, const basic_iterator& b) { return a.i_ <=> b.i_; }
+
+    private:
+        template<bool> friend class basic_iterator;
+
+        deque*      d_ = nullptr;
+        std::size_t i_ = 0;
+    };
+
+public:
+    using value_type             = T;
+    using size_type              = std::size_t;
+    using difference_type        = std::ptrdiff_t;
+    using reference              = T&;
+    using const_reference        = const T&;
+    using iterator               = basic_iterator<false>;
+    using const_iterator         = basic_iterator<true>;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    constexpr static_deque() = default;
+
+    template<class InputIt, class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    constexpr static_deque(InputIt first, InputIt last) { for (; first != last; ++first) emplace_back(*first); }
+
+    constexpr static_deque(std::initializer_list<T> il) : static_deque(il.begin(), il.end()) {}
+
+    constexpr static_deque(const static_deque&) requires storage::trivial = default;
+    constexpr static_deque(static_deque&&)      requires storage::trivial = default;
+
+    static_deque(const static_deque& other) { for (const auto& x : other) emplace_back(x);            }
+    static_deque(static_deque&& other)      { for (auto& x : other)       emplace_back(std::move(x)); }
+
+    constexpr static_deque& operator=(const static_deque&) requires storage::trivial = default;
+    constexpr static_deque& operator=(static_deque&&)      requires storage::trivial = default;
+
+    static_deque& operator=(const static_deque& other)
+    {
+        if (this != &other) {
+            clear();
+            for (const auto& x : other)
+                emplace_back(x);
+        }
+        return *this;
+    }
+
+    static_deque& operator=(static_deque&& other)
+    {
+        if (this != &other) {
+            clear();
+            for (auto& x : other)
+                emplace_back(std::move(x));
+        }
+        return *this;
+    }
+
+    constexpr ~static_deque() requires storage::trivial = default;
+    ~static_deque() { clear(); }
+
+    constexpr iterator               begin()         { return iterator(this, 0);           }
+    constexpr iterator               end()           { return iterator(this, size_);       }
+    constexpr const_iterator         begin()   const { return const_iterator(this, 0);     }
+    constexpr const_iterator         end()     const { return const_iterator(this, size_); }
+    constexpr const_iterator         cbegin()  const { return begin();                     }
+    constexpr const_iterator         cend()    const { return end();                       }
+    constexpr reverse_iterator       rbegin()        { return reverse_iterator(end());         }
+    constexpr reverse_iterator       rend()          { return reverse_iterator(begin());       }
+    constexpr const_reverse_iterator rbegin()  const { return const_reverse_iterator(end());   }
+    constexpr const_reverse_iterator rend()    const { return const_reverse_iterator(begin()); }
+
+    constexpr T&       operator[](size_type i)       { return s_.ptr()[slot(i)]; }
+    constexpr const T& operator[](size_type i) const { return s_.ptr()[slot(i)]; }
+
+    constexpr T&       at(size_type i)       { check(i); return (*this)[i]; }
+    constexpr const T& at(size_type i) const { check(i); return (*this)[i]; }
+
+    constexpr T&       front()       { return (*this)[0];         }
+    constexpr const T& front() const { return (*this)[0];         }
+    constexpr T&       back()        { return (*this)[size_ - 1]; }
+    constexpr const T& back()  const { return (*this)[size_ - 1]; }
+
+    static constexpr size_type capacity() { return N; }
+    static constexpr size_type max_size() { return N; }
+
+    constexpr size_type size()     const { return size_;      }
+    constexpr bool      empty()    const { return size_ == 0; }
+    constexpr bool      is_empty() const { return size_ == 0; }
+    constexpr bool      is_full()  const { return size_ == N; }
+
+    template<class Pred>
+    constexpr typename std::enable_if<std::is_invocable_r<bool, Pred, const T&>::value, bool>::type
+        contains(Pred p) const
+    {
+        return std::find_if(begin(), end(), p) != end();
+    }
+
+    constexpr bool contains(const T& x) const { return std::find(begin(), end(), x) != end(); }
+
+    template<class... Args>
+    constexpr T& emplace_back(Args&&... args)
+    {
+        internal::check_capacity<P>(size_ < N, "zen::static_deque CAPACITY EXCEEDED");
+        internal::construct_in<storage, T>(s_, slot(size_), std::forward<Args>(args)...);
+        ++size_;
+        return back();
+    }
+
+    template<class... Args>
+    constexpr T& emplace_front(Args&&... args)
+    {
+        internal::check_capacity<P>(size_ < N, "zen::static_deque CAPACITY EXCEEDED");
+        const auto first = head_ == 0 ? N - 1 : head_ - 1;
+        internal::construct_in<storage, T>(s_, first, std::forward<Args>(args)...);
+        head_ = first;
+        ++size_;
+        return front();
+    }
+
+    constexpr void push_back(const T& x)  { emplace_back(x);             }
+    constexpr void push_back(T&& x)       { emplace_back(std::move(x));  }
+    constexpr void push_front(const T& x) { emplace_front(x);            }
+    constexpr void push_front(T&& x)      { emplace_front(std::move(x)); }
+
+    constexpr void pop_back() { internal::destroy_in(s_, slot(--size_)); }
+
+    constexpr void pop_front()
+    {
+        internal::destroy_in(s_, head_);
+        head_ = slot(1);
+        --size_;
+    }
+
+    constexpr void clear()
+    {
+        while (size_)
+            pop_back();
+        head_ = 0;
+    }
+
+    friend constexpr bool operator==(const static_deque& a, const static_deque& b) { return std::equal(a.begin(), a.end(), b.begin(), b.end()); }
+    friend constexpr bool operator!=(const static_deque& a, const static_deque& b) { return !(a == b); }
+
+private:
+    // Physical index of the i-th element; a comparison is cheaper than % for any N
+    constexpr size_type slot(size_type i) const { return head_ + i < N ? head_ + i : head_ + i - N; }
+
+    constexpr void check(size_type i) const
+    {
+        if (i >= size_)
+            throw std::out_of_range("zen::static_deque::at() INDEX OUT OF RANGE");
+    }
+
+    storage   s_;
+    size_type head_ = 0;
+    size_type size_ = 0;
+};
+
+} // namespace zen
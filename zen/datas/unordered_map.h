@@ -76,6 +76,10 @@ public:
     unordered_multimap(const std::unordered_multimap<Kx, Vx, Hx, Ex, Ax>& u)
         : std::unordered_multimap<K, V, H, E, A>(u.begin(), u.end()) {}
 
+    // The values corresponding to the key, in place and without copying them
+    auto values(const K& key)       { return zen::values_view(my::equal_range(key)); }
+    auto values(const K& key) const { return zen::values_view(my::equal_range(key)); }
+
     bool is_empty() const { return my::empty(); }
 
 private:
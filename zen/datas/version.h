@@ -22,9 +22,19 @@
 
 #pragma once
 
+#include <initializer_list>
+#include <string_view>
+#include <algorithm>
 #include <stdexcept>
+#include <iterator>
+#include <optional>
 #include <ostream>
-#include <regex>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <array>
+
+#include "alpha.h" // internal; will not be included in kaizen.h
 
 namespace zen {
 
@@ -46,30 +56,75 @@ namespace zen {
 // v1.build() == 4567;
 class version : public std::array<int, 4> { 
 public:
-    version(int major, int minor, int patch, int build)
+    constexpr version(int major, int minor, int patch, int build)
         : std::array<int, 4>{major, minor, patch, build}
     {}
 
-    explicit version(const std::string& text)
-    {
-        static const std::regex rx_version{R"((\d+)\.(\d+)\.(\d+)\.(\d+))"};
-        if (std::smatch sm; std::regex_match(text, sm, rx_version)) {
-            at(0) = std::stoi(sm[1]);
-            at(1) = std::stoi(sm[2]);
-            at(2) = std::stoi(sm[3]);
-            at(3) = std::stoi(sm[4]);
-        } else {
-            throw std::invalid_argument{
-                // Any cost of typeid is likely to be dwarfed by the cost of the exception anyway
-                std::string(typeid(*this).name()) + " CONSTRUCTOR ARGUMENT STRING DOESN'T MATCH THE EXPECTED M.M.P.B PATTERN."
-            };
+    // Hand-written instead of std::regex so that it's constexpr and cheap
+    // enough to parse hundreds of thousands of versions in a row.
+    // Example: constexpr zen::version v("1.2.3.4"); // parsed at compile time
+    constexpr explicit version(std::string_view text)
+        : std::array<int, 4>{}
+    {
+        size_t pos = 0;
+        for (size_t i = 0; i < size(); ++i) {
+            if (i > 0) {
+                if (pos == text.size() || text[pos] != '.')
+                    throw std::invalid_argument{"zen::version CONSTRUCTOR ARGUMENT STRING DOESN'T MATCH THE EXPECTED M.M.P.B PATTERN."};
+                ++pos;
+            }
+            const size_t first = pos;
+            long long    n     = 0;
+            for (; pos < text.size() && text[pos] >= '0' && text[pos] <= '9'; ++pos) {
+                n = n * 10 + (text[pos] - '0');
+                if (n > std::numeric_limits<int>::max())
+                    throw std::out_of_range{"zen::version COMPONENT DOESN'T FIT INTO AN int."};
+            }
+            if (pos == first)
+                throw std::invalid_argument{"zen::version CONSTRUCTOR ARGUMENT STRING DOESN'T MATCH THE EXPECTED M.M.P.B PATTERN."};
+            (*this)[i] = static_cast<int>(n);
         }
+        if (pos != text.size())
+            throw std::invalid_argument{"zen::version CONSTRUCTOR ARGUMENT STRING DOESN'T MATCH THE EXPECTED M.M.P.B PATTERN."};
     }
 
     constexpr auto major() const { return at(0); }
     constexpr auto minor() const { return at(1); }
     constexpr auto patch() const { return at(2); }
     constexpr auto build() const { return at(3); }
+
+    // Packs the version into a single integer, 16 bits per component, such that
+    // comparing keys is the same as comparing versions, but in one instruction.
+    // Useful for sorting, hashing and indexing large numbers of versions.
+    // Throws std::out_of_range for a version with a component outside [0, 65535].
+    // Example: zen::version(1, 2, 3, 4).key() == 0x0001'0002'0003'0004;
+    constexpr std::uint64_t key() const
+    {
+        if (!fits_key())
+            throw std::out_of_range{"zen::version COMPONENT DOESN'T FIT INTO 16 BITS OF A PACKED KEY."};
+
+        std::uint64_t k = 0;
+        for (const int c : *this)
+            k = (k << 16) | static_cast<std::uint64_t>(c);
+        return k;
+    }
+
+    // Whether every component is in [0, 65535], so that the version has a key()
+    constexpr bool fits_key() const
+    {
+        return std::all_of(begin(), end(), [](int c) { return c >= 0 && c <= 0xFFFF; });
+    }
+
+    // The inverse of key()
+    static constexpr version from_key(std::uint64_t k)
+    {
+        return version(
+            static_cast<int>((k >> 48) & 0xFFFF),
+            static_cast<int>((k >> 32) & 0xFFFF),
+            static_cast<int>((k >> 16) & 0xFFFF),
+            static_cast<int>( k        & 0xFFFF)
+        );
+    }
 };
 
 std::ostream& operator<<(std::ostream& os, const version& v)
@@ -77,12 +132,264 @@ std::ostream& operator<<(std::ostream& os, const version& v)
     return os << v.major() << '.' << v.minor() << '.' << v.patch() << '.' << v.build();
 }
 
+// Sorts versions by an LSD radix sort over the packed keys: linear in the number
+// of versions, one pass per key byte, skipping the passes in which all bytes are
+// equal (which is common since most version components are small numbers).
+// Versions with a component that doesn't fit into a key are sorted by std::sort.
+// Example: std::vector<zen::version> vs = ...;
+//          zen::sort_versions(vs);
+template<class RandomAccessContainer>
+void sort_versions(RandomAccessContainer& versions)
+{
+    if (!std::all_of(std::begin(versions), std::end(versions), [](const version& v) { return v.fits_key(); })) {
+        std::sort(std::begin(versions), std::end(versions));
+        return;
+    }
+
+    std::vector<std::uint64_t> keys, temp(std::size(versions));
+    keys.reserve(std::size(versions));
+    for (const version& v : versions)
+        keys.push_back(v.key());
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        std::array<size_t, 257> offsets{};
+        for (const auto k : keys)
+            ++offsets[((k >> shift) & 0xFF) + 1];
+
+        if (std::find(offsets.begin(), offsets.end(), keys.size()) != offsets.end())
+            continue; // all keys have the same byte here, so this pass would be a no-op
+
+        for (size_t i = 1; i < offsets.size(); ++i)
+            offsets[i] += offsets[i - 1];
+        for (const auto k : keys)
+            temp[offsets[(k >> shift) & 0xFF]++] = k;
+        keys.swap(temp);
+    }
+
+    auto it = std::begin(versions);
+    for (const auto k : keys)
+        *it++ = version::from_key(k);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::version_range
+
+// A conjunction of space-separated comparisons against versions. Missing
+// trailing components of a version in the constraint are taken to be zeros.
+// Internally, the range is a closed interval of packed version keys, so
+// checking a version against it is just two integer comparisons.
+// Example: zen::version_range r(">=1.2 <2.0");
+//          r.contains(zen::version(1, 9, 0, 0)) == true;
+//          r.contains(zen::version(2, 0, 0, 0)) == false;
+// Supported operators: >=, >, <=, <, = (or ==, or none at all) and * (any version).
+// Like the keys, both the constraints and the versions checked against them are limited
+// to components in [0, 65535]; anything outside throws std::out_of_range.
+class version_range {
+public:
+    constexpr version_range() = default; // any version
+
+    constexpr version_range(const version& lo, const version& hi)
+        : lo_(lo.key()), hi_(hi.key()) {}
+
+    constexpr explicit version_range(std::string_view text)
+    {
+        size_t pos = 0;
+        for (;;) {
+            skip_spaces(text, pos);
+            if (pos == text.size())
+                break;
+
+            if (text[pos] == '*') {
+                ++pos;
+                continue;
+            }
+
+            std::string_view op = parse_operator(text, pos);
+            skip_spaces(text, pos);
+            const std::uint64_t k = parse_partial_version(text, pos);
+
+            if      (op == ">=") lo_ = std::max(lo_, k);
+            else if (op == "<=") hi_ = std::min(hi_, k);
+            else if (op == ">" ) { if (k == MAX) make_empty(); else lo_ = std::max(lo_, k + 1); }
+            else if (op == "<" ) { if (k == 0)   make_empty(); else hi_ = std::min(hi_, k - 1); }
+            else                 { lo_ = std::max(lo_, k); hi_ = std::min(hi_, k); } // "=", "==" or none
+        }
+    }
+
+    constexpr bool contains(const version& v) const { return contains_key(v.key()); }
+    constexpr bool contains_key(std::uint64_t k) const { return lo_ <= k && k <= hi_; }
+
+    constexpr bool is_empty() const { return lo_ > hi_; } // a contradictory range like ">2 <1"
+
+    constexpr std::uint64_t lo_key() const { return lo_; } // smallest key in range, inclusive
+    constexpr std::uint64_t hi_key() const { return hi_; } // largest  key in range, inclusive
+
+private:
+    static constexpr std::uint64_t MAX = std::numeric_limits<std::uint64_t>::max();
+
+    constexpr void make_empty() { lo_ = MAX; hi_ = 0; }
+
+    static constexpr void skip_spaces(std::string_view text, size_t& pos)
+    {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == ','))
+            ++pos;
+    }
+
+    static constexpr std::string_view parse_operator(std::string_view text, size_t& pos)
+    {
+        const size_t first = pos;
+        while (pos < text.size() && (text[pos] == '<' || text[pos] == '>' || text[pos] == '='))
+            ++pos;
+        const std::string_view op = text.substr(first, pos - first);
+        if (!op.empty() && op != ">=" && op != "<=" && op != ">" && op != "<" && op != "=" && op != "==")
+            throw std::invalid_argument{"zen::version_range UNKNOWN COMPARISON OPERATOR."};
+        return op;
+    }
+
+    // Parses "M", "M.M", "M.M.P" or "M.M.P.B" into a packed key
+    static constexpr std::uint64_t parse_partial_version(std::string_view text, size_t& pos)
+    {
+        std::uint64_t k = 0;
+        int components = 0;
+        while (components < 4) {
+            const size_t  first = pos;
+            std::uint64_t c     = 0;
+            for (; pos < text.size() && text[pos] >= '0' && text[pos] <= '9'; ++pos) {
+                c = c * 10 + (text[pos] - '0');
+                if (c > 0xFFFF)
+                    throw std::out_of_range{"zen::version_range COMPONENT DOESN'T FIT INTO 16 BITS OF A PACKED KEY."};
+            }
+            if (pos == first)
+                throw std::invalid_argument{"zen::version_range EXPECTED A VERSION AFTER A COMPARISON OPERATOR."};
+            k = (k << 16) | c;
+            ++components;
+            if (pos == text.size() || text[pos] != '.')
+                break;
+            ++pos; // skip the '.'
+        }
+        return k << (16 * (4 - components));
+    }
+
+    std::uint64_t lo_ = 0;
+    std::uint64_t hi_ = MAX;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::version_index
+
+// A sorted set of versions kept as a contiguous array of packed keys, which
+// answers range queries by binary search instead of linear filtering.
+// Example: zen::version_index idx = { {1, 0, 0, 0}, {1, 5, 0, 0}, {2, 0, 0, 0} };
+//          idx.max_satisfying(zen::version_range(">=1.2 <2.0")); // 1.5.0.0
+//          idx.all_satisfying(zen::version_range(">=1.0"));      // all three
+class version_index : private zen::stackonly {
+public:
+    version_index() = default;
+
+    version_index(std::initializer_list<version> versions) : version_index(versions.begin(), versions.end()) {}
+
+    template<class InputIt>
+    version_index(InputIt first, InputIt last) { insert(first, last); }
+
+    // Appends unsorted and then merges, so that bulk loading is O(n log n) instead of O(n^2)
+    template<class InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        const auto mid = static_cast<std::ptrdiff_t>(keys_.size());
+        for (; first != last; ++first)
+            keys_.push_back(version(*first).key());
+        std::sort(keys_.begin() + mid, keys_.end());
+        std::inplace_merge(keys_.begin(), keys_.begin() + mid, keys_.end());
+        keys_.erase(std::unique(keys_.begin(), keys_.end()), keys_.end());
+    }
+
+    bool insert(const version& v)
+    {
+        const auto k  = v.key();
+        const auto it = std::lower_bound(keys_.begin(), keys_.end(), k);
+        if (it != keys_.end() && *it == k)
+            return false;
+        keys_.insert(it, k);
+        return true;
+    }
+
+    bool erase(const version& v)
+    {
+        const auto k  = v.key();
+        const auto it = std::lower_bound(keys_.begin(), keys_.end(), k);
+        if (it == keys_.end() || *it != k)
+            return false;
+        keys_.erase(it);
+        return true;
+    }
+
+    bool contains(const version& v) const { return std::binary_search(keys_.begin(), keys_.end(), v.key()); }
+
+    std::optional<version> min_satisfying(const version_range& r) const
+    {
+        const auto [first, last] = bounds(r);
+        if (first == last)
+            return std::nullopt;
+        return version::from_key(*first);
+    }
+
+    std::optional<version> max_satisfying(const version_range& r) const
+    {
+        const auto [first, last] = bounds(r);
+        if (first == last)
+            return std::nullopt;
+        return version::from_key(*std::prev(last));
+    }
+
+    // In ascending order
+    std::vector<version> all_satisfying(const version_range& r) const
+    {
+        const auto [first, last] = bounds(r);
+        std::vector<version> result;
+        result.reserve(static_cast<size_t>(last - first));
+        for (auto it = first; it != last; ++it)
+            result.push_back(version::from_key(*it));
+        return result;
+    }
+
+    size_t count_satisfying(const version_range& r) const
+    {
+        const auto [first, last] = bounds(r);
+        return static_cast<size_t>(last - first);
+    }
+
+    // Sorted packed keys of all the versions in the index
+    const std::vector<std::uint64_t>& keys() const { return keys_; }
+
+    size_t size()     const { return keys_.size(); }
+    bool   empty()    const { return keys_.empty(); }
+    bool   is_empty() const { return keys_.empty(); }
+
+private:
+    using const_iterator = std::vector<std::uint64_t>::const_iterator;
+
+    std::pair<const_iterator, const_iterator> bounds(const version_range& r) const
+    {
+        if (r.is_empty())
+            return { keys_.end(), keys_.end() };
+        return {
+            std::lower_bound(keys_.begin(), keys_.end(), r.lo_key()),
+            std::upper_bound(keys_.begin(), keys_.end(), r.hi_key())
+        };
+    }
+
+    std::vector<std::uint64_t> keys_;
+};
+
 namespace literals::version {
 
 // Example: auto v7 = "7.6.5.4321"_version;
-zen::version operator""_version(const char* text, size_t)
+// A malformed literal like "7.6"_version is a compile-time error.
+#if __cpp_consteval >= 201811L
+consteval zen::version operator""_version(const char* text, size_t n)
+#else
+constexpr zen::version operator""_version(const char* text, size_t n)
+#endif
 {
-    return zen::version{text};
+    return zen::version{std::string_view(text, n)};
 }
 
 } // namespace literals::version
@@ -0,0 +1,406 @@
+// MIT License
+// 
+// Copyright (c) 2023 Leo Heinsaar
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <concepts>
+#include <iterator>
+#include <cstddef>
+#include <ranges>
+#include <vector>
+#include <bit>
+
+#include "../datas/alpha.h" // internal; will not be included in kaizen.h
+#include "../datas/flat.h"  // internal; will not be included in kaizen.h
+#include "../datas/set.h"   // internal; will not be included in kaizen.h
+
+namespace zen {
+
+///////////////////////////////////////////////////////////////////////////////////////////// SET ALGEBRA
+
+// Intersection, union and difference of sorted integer ranges free of duplicates, such as
+// posting lists in a zen::ints, a zen::flat_set or a std::span over either. They do the
+// same as std::set_intersection, std::set_union and std::set_difference, but the merges
+// are branchless, so that unpredictable comparisons of interleaved values don't cost a
+// misprediction each; the intersection of 32-bit integers compares blocks of 4 against 4
+// with SSE2; and when one range is at least 32 times the size of the other, the smaller
+// one is walked while the larger one is galloped through, in O(m log(n/m)) instead of O(m + n).
+// The results are written to the start of a preallocated output, which has to have room
+// for the largest possible result, and the number of the values written is returned.
+// The _count variants compute only the size of the result, without writing it anywhere.
+
+namespace internal {
+    template<class R>
+    concept sorted_integer_range = std::ranges::contiguous_range<R> && std::ranges::sized_range<R>
+                                && std::integral<std::ranges::range_value_t<R>>;
+
+    template<class R, class T>
+    concept sorted_integer_output = std::ranges::contiguous_range<R> && std::ranges::sized_range<R>
+                                 && std::ranges::output_range<R, T>
+                                 && std::same_as<std::ranges::range_value_t<R>, T>;
+
+    // The size ratio from which galloping through the larger range beats merging
+    constexpr std::size_t gallop_skew = 32;
+
+    // Finds the first element not less than x in [first, last) by probing 1, 2, 4, 8...
+    // elements ahead, in O(log d) for the distance d to it rather than O(log(last - first))
+    template<class T>
+    const T* gallop(const T* first, const T* last, T x)
+    {
+        if (first == last || !(*first < x))
+            return first;
+
+        const std::size_t n = last - first;
+        std::size_t lo = 0, hi = 1; // first[lo] < x
+        while (hi < n && first[hi] < x) {
+            lo = hi;
+            hi *= 2;
+        }
+        return std::lower_bound(first + lo + 1, first + std::min(hi, n), x);
+    }
+
+    template<bool Count, class T>
+    std::size_t intersect(const T* a, std::size_t na, const T* b, std::size_t nb, T* out)
+    {
+        if (na > nb) { // the intersection is symmetric, so let a be the smaller one
+            std::swap(a, b);
+            std::swap(na, nb);
+        }
+
+        std::size_t n = 0;
+
+        if (nb / gallop_skew >= na) {
+            const T* p = b;
+            for (std::size_t i = 0; i != na; ++i) {
+                p = gallop(p, b + nb, a[i]);
+                if (p == b + nb)
+                    break;
+                if (*p == a[i]) {
+                    if constexpr (!Count) out[n] = a[i];
+                    ++n;
+                    ++p;
+                }
+            }
+            return n;
+        }
+
+        std::size_t i = 0, j = 0;
+
+#ifdef ZEN_SSE2
+        // Each block of 4 from a is compared against each rotation of a block of 4 from b,
+        // and the block with the smaller last element (or both) is then moved past
+        if constexpr (sizeof(T) == 4) {
+            while (i + 4 <= na && j + 4 <= nb) {
+                const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+                const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+
+                __m128i m =            _mm_cmpeq_epi32(va, vb);
+                m = _mm_or_si128(m, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1))));
+                m = _mm_or_si128(m, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))));
+                m = _mm_or_si128(m, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3))));
+
+                // Bit k is set if a[i + k] is in the block from b
+                unsigned mask = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(m)));
+                if constexpr (Count)
+                    n += std::popcount(mask);
+                else
+                    for (; mask; mask &= mask - 1)
+                        out[n++] = a[i + std::countr_zero(mask)];
+
+                const T amax = a[i + 3], bmax = b[j + 3];
+                i += (amax <= bmax) * 4;
+                j += (bmax <= amax) * 4;
+            }
+        }
+#endif
+
+        while (i < na && j < nb) {
+            const T x = a[i], y = b[j];
+            if constexpr (!Count) out[n] = x; // overwritten unless it's a match
+            n += x == y;
+            i += x <= y;
+            j += y <= x;
+        }
+        return n;
+    }
+
+    template<class T>
+    std::size_t unite(const T* a, std::size_t na, const T* b, std::size_t nb, T* out)
+    {
+        if (na > nb) { // the union is symmetric too
+            std::swap(a, b);
+            std::swap(na, nb);
+        }
+
+        T* o = out;
+
+        if (nb / gallop_skew >= na) {
+            const T* p = b;
+            for (std::size_t i = 0; i != na; ++i) {
+                const T* q = gallop(p, b + nb, a[i]);
+                o = std::copy(p, q, o);
+                *o++ = a[i];
+                p = q + (q != b + nb && *q == a[i]);
+            }
+            return std::copy(p, b + nb, o) - out;
+        }
+
+        std::size_t i = 0, j = 0;
+        while (i < na && j < nb) {
+            const T x = a[i], y = b[j];
+            *o++ = x < y ? x : y;
+            i += x <= y;
+            j += y <= x;
+        }
+        o = std::copy(a + i, a + na, o);
+        return std::copy(b + j, b + nb, o) - out;
+    }
+
+    template<class T>
+    std::size_t difference(const T* a, std::size_t na, const T* b, std::size_t nb, T* out)
+    {
+        T* o = out;
+
+        if (nb / gallop_skew >= na) { // few values to look up in b
+            const T* p = b;
+            for (std::size_t i = 0; i != na; ++i) {
+                p = gallop(p, b + nb, a[i]);
+                if (p == b + nb || *p != a[i])
+                    *o++ = a[i];
+                else
+                    ++p;
+            }
+            return o - out;
+        }
+
+        if (na / gallop_skew >= nb) { // few values to cut out of a
+            const T* p = a;
+            for (std::size_t j = 0; j != nb; ++j) {
+                const T* q = gallop(p, a + na, b[j]);
+                o = std::copy(p, q, o);
+                p = q + (q != a + na && *q == b[j]);
+            }
+            return std::copy(p, a + na, o) - out;
+        }
+
+        std::size_t i = 0, j = 0, n = 0;
+        while (i < na && j < nb) {
+            const T x = a[i], y = b[j];
+            out[n] = x; // overwritten unless it's only in a
+            n += x < y;
+            i += x <= y;
+            j += y <= x;
+        }
+        return std::copy(a + i, a + na, out + n) - out;
+    }
+} // namespace internal
+
+// Writes the values that are in both a and b to the start of out, which has
+// to have room for min(a.size(), b.size()) values, and returns their number
+// Example: zen::ints a = { 1, 3, 5, 7 }, b = { 3, 4, 5 }, out(3);
+//          out.resize(zen::intersect(a, b, out)); // out == { 3, 5 }
+template<internal::sorted_integer_range A, internal::sorted_integer_range B, class O>
+    requires std::same_as<std::ranges::range_value_t<A>, std::ranges::range_value_t<B>>
+          && internal::sorted_integer_output<O, std::ranges::range_value_t<A>>
+std::size_t intersect(const A& a, const B& b, O&& out)
+{
+    const std::size_t na = std::ranges::size(a), nb = std::ranges::size(b);
+    if (std::ranges::size(out) < std::min(na, nb))
+        throw std::invalid_argument("zen::intersect OUTPUT IS TOO SMALL");
+    return internal::intersect<false>(std::ranges::data(a), na, std::ranges::data(b), nb, std::ranges::data(out));
+}
+
+// Writes the values that are in a or b (or both) to the start of out, which has
+// to have room for a.size() + b.size() values, and returns their number
+// Example: zen::ints a = { 1, 3, 5, 7 }, b = { 3, 4, 5 }, out(7);
+//          out.resize(zen::unite(a, b, out)); // out == { 1, 3, 4, 5, 7 }
+template<internal::sorted_integer_range A, internal::sorted_integer_range B, class O>
+    requires std::same_as<std::ranges::range_value_t<A>, std::ranges::range_value_t<B>>
+          && internal::sorted_integer_output<O, std::ranges::range_value_t<A>>
+std::size_t unite(const A& a, const B& b, O&& out)
+{
+    const std::size_t na = std::ranges::size(a), nb = std::ranges::size(b);
+    if (std::ranges::size(out) < na + nb)
+        throw std::invalid_argument("zen::unite OUTPUT IS TOO SMALL");
+    return internal::unite(std::ranges::data(a), na, std::ranges::data(b), nb, std::ranges::data(out));
+}
+
+// Writes the values that are in a but not in b to the start of out, which has
+// to have room for a.size() values, and returns their number
+// Example: zen::ints a = { 1, 3, 5, 7 }, b = { 3, 4, 5 }, out(4);
+//          out.resize(zen::difference(a, b, out)); // out == { 1, 7 }
+template<internal::sorted_integer_range A, internal::sorted_integer_range B, class O>
+    requires std::same_as<std::ranges::range_value_t<A>, std::ranges::range_value_t<B>>
+          && internal::sorted_integer_output<O, std::ranges::range_value_t<A>>
+std::size_t difference(const A& a, const B& b, O&& out)
+{
+    const std::size_t na = std::ranges::size(a), nb = std::ranges::size(b);
+    if (std::ranges::size(out) < na)
+        throw std::invalid_argument("zen::difference OUTPUT IS TOO SMALL");
+    return internal::difference(std::ranges::data(a), na, std::ranges::data(b), nb, std::ranges::data(out));
+}
+
+// Example: zen::intersect_count(a, b); // 2, the number of values in both a and b
+template<internal::sorted_integer_range A, internal::sorted_integer_range B>
+    requires std::same_as<std::ranges::range_value_t<A>, std::ranges::range_value_t<B>>
+std::size_t intersect_count(const A& a, const B& b)
+{
+    using T = std::ranges::range_value_t<A>;
+    return internal::intersect<true, T>(std::ranges::data(a), std::ranges::size(a), std::ranges::data(b), std::ranges::size(b), nullptr);
+}
+
+// Example: zen::unite_count(a, b); // 5, the number of values in a or b
+template<internal::sorted_integer_range A, internal::sorted_integer_range B>
+    requires std::same_as<std::ranges::range_value_t<A>, std::ranges::range_value_t<B>>
+std::size_t unite_count(const A& a, const B& b)
+{
+    return std::ranges::size(a) + std::ranges::size(b) - zen::intersect_count(a, b);
+}
+
+// Example: zen::difference_count(a, b); // 2, the number of values in a but not in b
+template<internal::sorted_integer_range A, internal::sorted_integer_range B>
+    requires std::same_as<std::ranges::range_value_t<A>, std::ranges::range_value_t<B>>
+std::size_t difference_count(const A& a, const B& b)
+{
+    return std::ranges::size(a) - zen::intersect_count(a, b);
+}
+
+// The same on whole sets, which return a new set.
+// A zen::flat_set is contiguous, so it also works with all of the above as it is.
+// Example: zen::flat_set<int> a = { 1, 3, 5, 7 }, b = { 3, 4, 5 };
+//          zen::flat_set<int> c = zen::intersect(a, b); // { 3, 5 }
+template<std::integral T>
+zen::flat_set<T> intersect(const zen::flat_set<T>& a, const zen::flat_set<T>& b)
+{
+    std::vector<T> v(std::min(a.size(), b.size()));
+    v.resize(zen::intersect(a, b, v));
+    return zen::flat_set<T>(zen::presorted{}, std::move(v));
+}
+
+template<std::integral T>
+zen::flat_set<T> unite(const zen::flat_set<T>& a, const zen::flat_set<T>& b)
+{
+    std::vector<T> v(a.size() + b.size());
+    v.resize(zen::unite(a, b, v));
+    return zen::flat_set<T>(zen::presorted{}, std::move(v));
+}
+
+template<std::integral T>
+zen::flat_set<T> difference(const zen::flat_set<T>& a, const zen::flat_set<T>& b)
+{
+    std::vector<T> v(a.size());
+    v.resize(zen::difference(a, b, v));
+    return zen::flat_set<T>(zen::presorted{}, std::move(v));
+}
+
+// The nodes of a zen::set aren't contiguous, so with skewed sizes
+// the values of the smaller one are looked up in the larger one.
+// Example: zen::set<int> a = { 1, 3, 5, 7 }, b = { 3, 4, 5 };
+//          zen::set<int> c = zen::unite(a, b); // { 1, 3, 4, 5, 7 }
+template<std::integral T>
+zen::set<T> intersect(const zen::set<T>& a, const zen::set<T>& b)
+{
+    const zen::set<T>& small = a.size() <= b.size() ? a : b;
+    const zen::set<T>& large = a.size() <= b.size() ? b : a;
+
+    zen::set<T> r;
+    if (large.size() / internal::gallop_skew >= small.size()) {
+        for (const T& x : small)
+            if (large.contains(x))
+                r.insert(r.end(), x);
+    }
+    else std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::inserter(r, r.end()));
+    return r;
+}
+
+template<std::integral T>
+zen::set<T> unite(const zen::set<T>& a, const zen::set<T>& b)
+{
+    const zen::set<T>& small = a.size() <= b.size() ? a : b;
+    const zen::set<T>& large = a.size() <= b.size() ? b : a;
+
+    if (large.size() / internal::gallop_skew >= small.size()) {
+        zen::set<T> r = large;
+        r.insert(small.begin(), small.end());
+        return r;
+    }
+
+    zen::set<T> r;
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::inserter(r, r.end()));
+    return r;
+}
+
+template<std::integral T>
+zen::set<T> difference(const zen::set<T>& a, const zen::set<T>& b)
+{
+    zen::set<T> r;
+    if (b.size() / internal::gallop_skew >= a.size()) {
+        for (const T& x : a)
+            if (!b.contains(x))
+                r.insert(r.end(), x);
+    }
+    else if (a.size() / internal::gallop_skew >= b.size()) {
+        r = a;
+        for (const T& x : b)
+            r.erase(x);
+    }
+    else std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::inserter(r, r.end()));
+    return r;
+}
+
+template<std::integral T>
+std::size_t intersect_count(const zen::set<T>& a, const zen::set<T>& b)
+{
+    const zen::set<T>& small = a.size() <= b.size() ? a : b;
+    const zen::set<T>& large = a.size() <= b.size() ? b : a;
+
+    std::size_t n = 0;
+    if (large.size() / internal::gallop_skew >= small.size()) {
+        for (const T& x : small)
+            n += large.contains(x);
+        return n;
+    }
+
+    for (auto i = a.begin(), j = b.begin(); i != a.end() && j != b.end(); ) {
+        if      (*i < *j) ++i;
+        else if (*j < *i) ++j;
+        else { ++n; ++i; ++j; }
+    }
+    return n;
+}
+
+template<std::integral T>
+std::size_t unite_count(const zen::set<T>& a, const zen::set<T>& b)
+{
+    return a.size() + b.size() - zen::intersect_count(a, b);
+}
+
+template<std::integral T>
+std::size_t difference_count(const zen::set<T>& a, const zen::set<T>& b)
+{
+    return a.size() - zen::intersect_count(a, b);
+}
+
+} // namespace zen